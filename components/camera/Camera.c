@@ -2,8 +2,35 @@
 #include "Camera.h"
 #include "Logger.h"
 #include "OV5642.h"
+#include "FIFOReader.h"
+#include "FrameReader.h"
+#include "RegisterScript.h"
+#include "RegisterShadow.h"
+#include "JPEGScanner.h"
+#include "CameraTuning.h"
+#include "FramePool.h"
+#include "FrameBroker.h"
+#include "QualityController.h"
+#include "Histogram.h"
+#include "RegisterImage.h"
+#include "SensorWindow.h"
+#include "JPEGDCDecoder.h"
+#include "MotionDetector.h"
+#include "CaptureScheduler.h"
+#include "LiveDemand.h"
+#include "SPIClock.h"
+#include "List.h"
+#include "Settings.h"
+#include <stddef.h>
+#include <esp_timer.h>
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+#include "VirtualCamera.h"
+#include <esp_err.h>
+#else
+#include <esp_heap_caps.h>
 #include <driver/spi_master.h>
 #include "driver/i2c.h"
+#endif
 #include "TaskWatcher.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -13,40 +40,237 @@
 #define BYTE_TO_BITS 8
 
 #define I2C_MASTER_FREQ_HZ 400000
-#define SPI_MASTER_FREQ_HZ SPI_MASTER_FREQ_8M
-#define SPI_MAX_TRANSFER_SIZE SOC_SPI_MAXIMUM_BUFFER_SIZE
-#define I2C_DELAY_MILLIS 100
+#define SPI_MASTER_FREQ_HZ 8000000 // stock clock, camera_calibrateSPIClock() finds how much faster the board can go
+#define CAMERA_SPI_CLOCK_MARGIN_PERCENT 20
+#define CAMERA_SPI_CLOCK_TEST_FRAMES 3
+#define CAMERA_SENSOR_PROFILE_WARM_UP_FRAMES 2 // the first frames after a timing change can be torn or badly exposed
+#define SPI_DMA_BUFFER_SIZE 4096 // per ping-pong buffer, must be a multiple of 4 for DMA
+#define SPI_MAX_TRANSFER_SIZE SPI_DMA_BUFFER_SIZE
 
 #define CAMERA_TASK_NAME "cameraTask"
 #define CAMERA_TASK_STACK_SIZE 4000
 #define CAMERA_TASK_STACK_MIN (CAMERA_TASK_STACK_SIZE * 0.10)
 #define CAMERA_TASK_PRIORITY ((configMAX_PRIORITIES - 1)/2)
 #define CAMERA_LIVE_IMAGE_BUFFER_SIZE 4096
+#define CAMERA_PIPELINE_FRAMES_PER_TRIGGER 4
+#define CAMERA_MOTION_MAX_PENDING_EVENTS CAMERA_BURST_MAX_FRAMES_PER_TRIGGER // at most 1 per frame of a live capture
+#define CAMERA_FRAME_POOL_MAX_BYTES (128 * 1024) // no PSRAM, whole frames must fit in internal RAM
+#define CAMERA_FRAME_POOL_MIN_FRAMES 2 // the latest frame and the one being captured
+#define CAMERA_FRAME_POOL_MAX_FRAMES 4
+#define CAMERA_FRAME_BROKER_CAPACITY 2 // must be a power of 2, consumers only ever want the newest frames
+#define CAMERA_LIVE_LINGER_MILLIS 5000 // long enough for a page reload to resubscribe before the sensor sleeps
+#define CAMERA_IDLE_WAIT_MILLIS 1000
+#define OV5642_REGISTER_SYSTEM_CONTROL 0x3008
+#define OV5642_SYSTEM_CONTROL_ACTIVE 0x02
+#define OV5642_SYSTEM_CONTROL_STANDBY 0x42 // software power down, registers are kept and I2C still works
 
 /*
  * Arducam & Sensor are LSB so bits are in the order 76543210, so 1 in bit 1 is 00000010 or 0x02
  */
 
+typedef struct CameraBurstContext {
+    CameraBurstCallback *burstCallback;
+    void *userArg;
+    CameraBurst *burst;
+    int64_t startMicros;
+} CameraBurstContext;
+
+typedef struct CameraRequest {
+    uint ticket;
+    /** Made by the task already holding the camera, so it was never queued */
+    bool isNested;
+    /** Served without a capture of its own */
+    bool isCoalesced;
+} CameraRequest;
+
 private struct {
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+    /** Stands in for the Arducam on both buses */
+    VirtualCamera *virtualCamera;
+#else
     spi_device_handle_t spiDeviceHandle;
+#endif
+    uint32_t spiClockHz;
     SemaphoreHandle_t semaphoreHandle;
+    RegisterShadow *registerShadow;
+    CameraSettings settings;
+    /** [profile][from][to] scripts that switch between image sizes at a sensor profile, created on first use */
+    OV5642RegisterEntry *imageSizeDeltas[CAMERA_SENSOR_PROFILE_COUNT][CAMERA_IMAGE_SIZE_COUNT][CAMERA_IMAGE_SIZE_COUNT];
+    /** [profile][imageSize] each image size's table followed by the profile's timing, created on first use */
+    OV5642RegisterEntry *sensorScripts[CAMERA_SENSOR_PROFILE_COUNT][CAMERA_IMAGE_SIZE_COUNT];
+    /** [imageSize] the still restore followed by each image size's table, created on first use */
+    OV5642RegisterEntry *stillRestoreScripts[CAMERA_IMAGE_SIZE_COUNT];
+    struct {
+        FIFOReader *fifoReader;
+        uint8_t *buffers[FIFO_READER_BUFFER_COUNT];
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+        /** Reads the virtual device already did when they were queued, awaited in the order they were queued */
+        struct {
+            uint8_t *buffer;
+            size_t length;
+        } transactions[FIFO_READER_BUFFER_COUNT];
+        uint queuedTransactions;
+#else
+        spi_transaction_t transactions[FIFO_READER_BUFFER_COUNT];
+#endif
+        uint nextTransaction;
+    } dma;
+    struct {
+        JPEGScanner *jpegScanner;
+        /** FIFO bytes not yet read in the current readout */
+        size_t fifoBytesUnread;
+        /** FIFO bytes after an EOI that were never read over SPI */
+        uint32_t fifoBytesNotRead;
+        /** JPEG bytes of every live frame completed, SOI to EOI */
+        uint32_t frameBytesTotal;
+        /** Frames the ArduChip's frame count register was last set to, 0 before it is first set */
+        uint8_t framesPerTrigger;
+    } frames;
+    struct {
+        /** NULL when frames at the current image size and quality are too large to pool */
+        FramePool *framePool;
+        /** Image size and quality the pool was sized for */
+        CameraImageSize imageSize;
+        CameraImageQuality imageQuality;
+        /** Bytes of every frame in the pool, 0 before the pool is first sized */
+        size_t frameBytes;
+        /** Raised when a frame did not fit, so the pool is resized before the next capture */
+        size_t frameBytesMinimum;
+        /** Whether frames in the current readout go to the pool or are streamed to the live capture callback */
+        bool isPooling;
+        /** Frame being captured, NULL between frames or while the rest of a frame is discarded */
+        CameraFrame *writing;
+        bool isFrameTooLarge;
+        /** Latest complete frame, the camera holds a reference to it while it is the latest */
+        CameraFrame *latest;
+        SemaphoreHandle_t latestMutex;
+        uint32_t sequence;
+        uint32_t framesTooLarge;
+        CameraLiveFrameCallback *liveFrameCallback;
+    } pool;
+    struct {
+        /** Hands pooled frames to consumers on other tasks without the camera ever waiting for them */
+        FrameBroker *frameBroker;
+        /** Given after every publish so a consumer waiting for a frame wakes up */
+        SemaphoreHandle_t frameSemaphores[FRAME_BROKER_MAX_CONSUMERS];
+        uint consumerCount;
+    } broker;
+    struct {
+        Histogram *captureMicros;
+        Histogram *readoutMicros;
+        Histogram *chunkMicros;
+        Histogram *frameMicros;
+        Histogram *frameBytes;
+        uint32_t framesCompleted;
+        uint32_t framesDropped;
+        uint32_t sinceMillis;
+        /** SPI transfers other than FIFO burst reads since camera_init() */
+        uint32_t controlTransfers;
+    } stats;
+    struct {
+        QualityController *qualityController;
+        /** Frames dropped by every consumer when the controller was last fed */
+        uint32_t framesDropped;
+    } quality;
+    /** The user's values of the fields a quality step or camera_applyTransientSettings() replaced, written back
+     * before a register image is saved */
+    CameraSettings userSettings;
+    struct {
+        /** Checksum of every table a cold start can write, a stored image built from other tables is never used */
+        uint32_t scriptsChecksum;
+        /** The register image last stored in settings, NULL if there is none */
+        uint8_t *image;
+        size_t imageLength;
+        /** Registers written since camera_init(), for counting the ones camera_start() writes */
+        uint32_t registersWritten;
+        uint32_t startedMillis;
+        bool isFirstFrameDone;
+        CameraStartStats stats;
+    } start;
+    struct {
+        /** Created when motion detection is first enabled, the detector's maps alone are ~19KB */
+        JPEGDCDecoder *jpegDCDecoder;
+        MotionDetector *motionDetector;
+        Histogram *frameMicros;
+        bool isEnabled;
+        /** The live frame being read out has been begun in the decoder */
+        bool isFrameBegun;
+        /** The frame's luma map has been begun in the detector, which needs the frame's size from its SOF */
+        bool isMapBegun;
+        bool isFrameFailed;
+        /** Decoding the frame so far, over every chunk it has been read in */
+        int64_t frameMicrosSoFar;
+        uint32_t frameSequence;
+        uint32_t framesAnalysed;
+        uint32_t framesFailed;
+        uint32_t motionEvents;
+        MotionDetectorResult result;
+        /** Found while the mutex is held, given to callbacks on the camera task once it is released */
+        CameraMotionEvent pendingEvents[CAMERA_MOTION_MAX_PENDING_EVENTS];
+        uint pendingEventCount;
+        List *callbacks;
+        /** Guards callbacks, which are called on the camera task and added or removed on any other */
+        SemaphoreHandle_t callbacksMutex;
+    } motion;
     struct {
         TaskHandle_t handle;
         bool isRunning;
         bool isPaused;
+        /** The sensor is in software standby, it outputs no frames until it is woken */
+        bool isStandby;
+        /** The standby is only because nobody subscribed to live capture, any request for the camera wakes it */
+        bool isIdleStandby;
         uint32_t delayMillis;
+        CameraLiveCaptureMode mode;
         uint8_t *liveImageBuffer;
         size_t liveImageBufferLength;
         CameraLiveCaptureCallback *liveCaptureCallback;
+        /** Whether live capture should run, from the consumers subscribed to it */
+        LiveDemand *liveDemand;
+        SemaphoreHandle_t demandMutex;
+        /** Given by the first subscriber so the task doesn't finish its idle wait first */
+        SemaphoreHandle_t wakeSemaphore;
     } task;
+    struct {
+        CameraVideoProfile profile;
+        /** Set by a recording benchmark, live frames go only to its callback, up to recordFrameCount frames */
+        CameraBurstContext *recordContext;
+        uint32_t recordFrameCount;
+    } video;
+    struct {
+        /** Orders the requests for the camera, the mutex is still taken for every access by the request holding it */
+        CaptureScheduler *captureScheduler;
+        /** Guards the scheduler, only held while it is told about a request, never while the camera is in use */
+        SemaphoreHandle_t mutex;
+        /** Given to a request's task when the scheduler grants the request the camera */
+        SemaphoreHandle_t grantSemaphores[CAPTURE_SCHEDULER_MAX_REQUESTS];
+        /** Task of the request holding the camera, the requests it makes meanwhile nest inside that one */
+        TaskHandle_t holder;
+        /** Bytes in the FIFO of the still shared with other still requests */
+        uint32_t sharedImageSize;
+    } scheduler;
+    struct {
+        /** Reads stills out of the FIFO into the caller's buffers */
+        FrameReader *frameReader;
+        /** Of the frame opened by camera_openFrame(), NULL while none is open */
+        CameraFrameCursor *cursor;
+        /** Held from camera_openFrame() until camera_closeFrame() */
+        CameraRequest request;
+    } reader;
 } this;
 
 #define obtainMutex() xSemaphoreTake(this.semaphoreHandle, portMAX_DELAY)
 #define releaseMutex() xSemaphoreGive(this.semaphoreHandle)
+#define obtainSchedulerMutex() xSemaphoreTake(this.scheduler.mutex, portMAX_DELAY)
+#define releaseSchedulerMutex() xSemaphoreGive(this.scheduler.mutex)
 
 private void spiSend(const uint16_t command,
                      const uint8_t *const sendData, const size_t sendDataLength,
                      uint8_t *const receiveData, const size_t receiveDataLength) {
+    if ((command & ~SPI_WRITE) != 0x03C) this.stats.controlTransfers++;
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+    virtualCamera_spiTransfer(this.virtualCamera, command, sendData, sendDataLength, receiveData, receiveDataLength);
+#else
     spi_transaction_t tx = {
             .cmd = command,
             .tx_buffer = sendData,
@@ -58,13 +282,18 @@ private void spiSend(const uint16_t command,
     }
 
     spi_device_polling_transmit(this.spiDeviceHandle, &tx);
+#endif
 }
 
 #define spiSendOnly(command, sendData, sendDataLength) spiSend(command, sendData, sendDataLength, NULL, 0)
 #define spiReceiveOnly(command, receiveData, receiveDataLength) spiSend(command, NULL, 0, receiveData, receiveDataLength)
 
-private void i2cWrite(const uint16_t registerAddress,
-                      const uint8_t *const sendData, const size_t sendDataLength) {
+private esp_err_t i2cWrite(const uint16_t registerAddress,
+                           const uint8_t *const sendData, const size_t sendDataLength) {
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+    return virtualCamera_i2cWrite(this.virtualCamera, registerAddress, sendData, sendDataLength) == ERROR_NONE ?
+           ESP_OK : ESP_FAIL;
+#else
     const uint8_t firstByte = registerAddress >> 8;
     const uint8_t secondByte = registerAddress & 0x00FF;
     i2c_cmd_handle_t cmdHandle = i2c_cmd_link_create();
@@ -76,12 +305,17 @@ private void i2cWrite(const uint16_t registerAddress,
         i2c_master_write(cmdHandle, sendData, sendDataLength, true);
     }
     i2c_master_stop(cmdHandle);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(i2c_master_cmd_begin(I2C_NUM_0, cmdHandle, 1000 / portTICK_RATE_MS));
+    esp_err_t err = ESP_ERROR_CHECK_WITHOUT_ABORT(i2c_master_cmd_begin(I2C_NUM_0, cmdHandle, 1000 / portTICK_RATE_MS));
     i2c_cmd_link_delete(cmdHandle);
+    return err;
+#endif
 }
 
 private void i2cRead(const uint16_t registerAddress,
                      uint8_t *const receiveData, const size_t receiveDataLength) {
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+    virtualCamera_i2cRead(this.virtualCamera, registerAddress, receiveData, receiveDataLength);
+#else
     const uint8_t firstByte = registerAddress >> 8;
     const uint8_t secondByte = registerAddress & 0x00FF;
     i2c_cmd_handle_t cmdHandle = i2c_cmd_link_create();
@@ -96,28 +330,136 @@ private void i2cRead(const uint16_t registerAddress,
     i2c_master_start(cmdHandle);
     i2c_master_write_byte(cmdHandle, OV5642_I2C_DEVICE_ADDRESS_READ, true);
     if (receiveDataLength > 0 && receiveData != NULL) {
-        i2c_master_read(cmdHandle, receiveData, receiveDataLength, I2C_MASTER_NACK);
+        i2c_master_read(cmdHandle, receiveData, receiveDataLength, I2C_MASTER_LAST_NACK);
     }
     i2c_master_stop(cmdHandle);
     ESP_ERROR_CHECK_WITHOUT_ABORT(i2c_master_cmd_begin(I2C_NUM_0, cmdHandle, 1000 / portTICK_RATE_MS));
     i2c_cmd_link_delete(cmdHandle);
+#endif
+}
+
+/** RegisterScriptWriter function, one I2C transaction using the sensor's address auto-increment */
+private Error camera_registerScriptWrite(void *context, const uint16_t address,
+                                         const uint8_t *values, const size_t length) {
+    this.start.registersWritten += length;
+    esp_err_t err = i2cWrite(address, values, length);
+    if (err != ESP_OK) {
+        throw(ERROR_LIBRARY_FAILURE, "I2C write of %u registers at 0x%04x returned: %i: %s",
+              length, address, err, esp_err_to_name(err));
+    }
+    return ERROR_NONE;
+}
+
+private void camera_registerScriptDelay(void *context, const uint32_t millis) {
+    delayMillis(millis);
+}
+
+private const RegisterScriptWriter CAMERA_REGISTER_SCRIPT_WRITER = {
+        .context = NULL,
+        .write = camera_registerScriptWrite,
+        .delay = camera_registerScriptDelay,
+};
+
+/** RegisterImageReader function, one I2C read using the sensor's address auto-increment */
+private Error camera_registerImageRead(void *context, const uint16_t address, uint8_t *values, const size_t length) {
+    i2cRead(address, values, length);
+    return ERROR_NONE;
+}
+
+private const RegisterImageReader CAMERA_REGISTER_IMAGE_READER = {
+        .context = NULL,
+        .read = camera_registerImageRead,
+};
+
+private Error camera_runRegisterScript(const OV5642RegisterEntry *entries, RegisterScriptStats *stats) {
+    return registerScript_run(&CAMERA_REGISTER_SCRIPT_WRITER, this.registerShadow, entries, stats);
+}
+
+private Error camera_writeRegisterScript(const char *name, const OV5642RegisterEntry *entries) {
+    RegisterScriptStats stats;
+    const uint32_t startMillis = esp_log_early_timestamp();
+    const Error err = camera_runRegisterScript(entries, &stats);
+    const uint32_t elapsedMillis = esp_log_early_timestamp() - startMillis;
+    INFO("%s: %u registers (%u unchanged) in %u writes, %u ms (%u ms delays)",
+         name, stats.entryCount, stats.skippedCount, stats.writeCount, elapsedMillis, stats.delayMillis);
+    return err;
+}
+
+/** Write a single register, skipped if the shadow shows it already holds value */
+private Error camera_writeRegister(const uint16_t address, const uint8_t value) {
+    const OV5642RegisterEntry entries[] = {
+            {address, value},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    return camera_runRegisterScript(entries, NULL);
+}
+
+#define i2cWriteByte(registerAddress, byte) camera_writeRegister(registerAddress, byte)
+
+#define writeRegisterScript(entries) camera_writeRegisterScript(#entries, entries)
+
+/** Put the sensor into or out of software standby, must hold a request for the camera */
+private Error camera_writeStandby(const bool standby) {
+    obtainMutex(); // between frames, the live task must not be waiting on a frame the sensor will never output
+    const Error err = camera_writeRegister(OV5642_REGISTER_SYSTEM_CONTROL,
+                                           standby ? OV5642_SYSTEM_CONTROL_STANDBY : OV5642_SYSTEM_CONTROL_ACTIVE);
+    if (err == ERROR_NONE) this.task.isStandby = standby;
+    releaseMutex();
+    return err;
 }
 
-#define i2cWriteByte(registerAddress, byte) \
-do{                                         \
-const uint8_t value = byte;                 \
-i2cWrite(registerAddress, &value, sizeof(value)); \
-delayMillis(I2C_DELAY_MILLIS);                    \
-} while(0)
+/** Queue a request of requestClass and wait until the scheduler grants it the camera, deadlineMillis (0 for the
+ * class's default) is how long it should wait at most, a request made by the task already holding the camera nests
+ * inside the request it holds, every granted request must be ended with camera_endRequest() */
+private Error camera_beginRequest(const CameraRequestClass requestClass, const uint32_t deadlineMillis,
+                                  CameraRequest *request) {
+    requireNotNull(this.scheduler.captureScheduler, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    *request = (CameraRequest) {.isNested = false};
+    obtainSchedulerMutex();
+    if (this.scheduler.holder == task) {
+        request->isNested = true;
+        releaseSchedulerMutex();
+        return ERROR_NONE;
+    }
+    const int64_t nowMicros = esp_timer_get_time();
+    const Error err = captureScheduler_enqueue(this.scheduler.captureScheduler, requestClass, deadlineMillis,
+                                               nowMicros, &request->ticket);
+    uint granted = 0;
+    if (err == ERROR_NONE && captureScheduler_grantNext(this.scheduler.captureScheduler, nowMicros, &granted)) {
+        xSemaphoreGive(this.scheduler.grantSemaphores[granted]); // the camera was free so this is the only request
+    }
+    releaseSchedulerMutex();
+    throwIfError(err, "Too many requests are waiting for the camera");
+    xSemaphoreTake(this.scheduler.grantSemaphores[request->ticket], portMAX_DELAY);
+    obtainSchedulerMutex();
+    this.scheduler.holder = task;
+    releaseSchedulerMutex();
+    if (requestClass != CAMERA_REQUEST_CLASS_LIVE && this.task.isIdleStandby) {
+        this.task.isIdleStandby = false; // the live task puts it back once this request is done
+        camera_writeStandby(false);
+    }
+    return ERROR_NONE;
+}
 
-private void i2cWriteRegistryEntries(const OV5642RegisterEntry *registerEntries) {
-    OV5642RegisterEntry *next = registerEntries;
-    OV5642RegisterEntry entry = *registerEntries;
-    while (entry.address != 0xFFFF && entry.value != 0xFF) {
-        i2cWriteByte(entry.address, entry.value);
-        next++;
-        entry = *next;
+/** Done with the camera, it is granted to the next request waiting for it */
+private void camera_endRequest(const CameraRequest *request) {
+    if (request->isNested) return;
+    obtainSchedulerMutex();
+    this.scheduler.holder = NULL;
+    captureScheduler_release(this.scheduler.captureScheduler, request->ticket, request->isCoalesced);
+    uint next = 0;
+    if (captureScheduler_grantNext(this.scheduler.captureScheduler, esp_timer_get_time(), &next)) {
+        xSemaphoreGive(this.scheduler.grantSemaphores[next]);
     }
+    releaseSchedulerMutex();
+}
+
+/** Whatever the request holding the camera left in the FIFO can't be shared with still requests */
+private void camera_forgetSharedCapture() {
+    obtainSchedulerMutex();
+    captureScheduler_forgetCapture(this.scheduler.captureScheduler);
+    releaseSchedulerMutex();
 }
 
 private Error camera_setTestRegister(const uint8_t value) {
@@ -131,9 +473,12 @@ private Error camera_getTestRegister(uint8_t *const value) {
     return ERROR_NONE;
 }
 
+/** Only written when it changes, so it can be set before every trigger at no cost */
 private Error camera_setFramesToCapture(uint8_t framesCount) {
     framesCount--;
     if (framesCount > 7) framesCount = 7;
+    if (framesCount + 1 == this.frames.framesPerTrigger) return ERROR_NONE;
+    this.frames.framesPerTrigger = framesCount + 1;
 
     spiSendOnly(0x01 | SPI_WRITE, &framesCount, sizeof(framesCount));
 
@@ -188,16 +533,17 @@ private Error camera_resetFIFORead() {
     return ERROR_NONE;
 }
 
+/** Clears the FIFO write done flag and resets both FIFO pointers in a single transfer, each is its own bit */
+private Error camera_rearmFIFO() {
+    uint8_t data = 0x01 | 0x10 | 0x20;
+    spiSendOnly(0x04 | SPI_WRITE, &data, sizeof(data));
+    return ERROR_NONE;
+}
+
 private Error camera_burstFIFORead(uint8_t *const byteBuffer, const int bufferLength) {
-    spi_transaction_t tx = {
-            .cmd = 0x03C | SPI_READ,
-            .tx_buffer = NULL,
-    };
     for (int bytesRemaining = bufferLength, bytesRead = 0; bytesRemaining > 0;) {
-        const int bytesToRead = bufferLength > SPI_MAX_TRANSFER_SIZE ? SPI_MAX_TRANSFER_SIZE : bufferLength;
-        tx.rxlength = (size_t) bytesToRead * BYTE_TO_BITS;
-        tx.rx_buffer = byteBuffer + bytesRead;
-        spi_device_polling_transmit(this.spiDeviceHandle, &tx);
+        const int bytesToRead = bytesRemaining > SPI_MAX_TRANSFER_SIZE ? SPI_MAX_TRANSFER_SIZE : bytesRemaining;
+        spiReceiveOnly(0x03C | SPI_READ, byteBuffer + bytesRead, bytesToRead);
 
         bytesRemaining -= bytesToRead;
         bytesRead += bytesToRead;
@@ -206,6 +552,92 @@ private Error camera_burstFIFORead(uint8_t *const byteBuffer, const int bufferLe
     return ERROR_NONE;
 }
 
+/** FrameReaderFIFORead function, reads straight into the caller's buffer */
+private Error camera_frameReaderFIFORead(void *context, uint8_t *buffer, const size_t length) {
+    return camera_burstFIFORead(buffer, (int) length);
+}
+
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+
+/** FIFOReaderTransport function, the virtual device has no DMA so the read is done before it is "queued" */
+private Error camera_dmaQueueFIFORead(void *context, uint8_t *buffer, const size_t length) {
+    typeof(this.dma) *dma = (typeof(this.dma) *) context;
+    const Error err = virtualCamera_spiTransfer(this.virtualCamera, 0x03C | SPI_READ, NULL, 0, buffer, length);
+    if (err != ERROR_NONE) return err;
+    dma->transactions[dma->nextTransaction].buffer = buffer;
+    dma->transactions[dma->nextTransaction].length = length;
+    dma->nextTransaction = (dma->nextTransaction + 1) % FIFO_READER_BUFFER_COUNT;
+    dma->queuedTransactions++;
+    return ERROR_NONE;
+}
+
+/** FIFOReaderTransport function, hands back the oldest read done by camera_dmaQueueFIFORead */
+private Error camera_dmaAwaitFIFORead(void *context, uint8_t **buffer, size_t *length) {
+    typeof(this.dma) *dma = (typeof(this.dma) *) context;
+    require(dma->queuedTransactions > 0, ERROR_ILLEGAL_STATE, "No FIFO read was queued");
+    const uint oldest = (dma->nextTransaction + FIFO_READER_BUFFER_COUNT - dma->queuedTransactions) %
+                        FIFO_READER_BUFFER_COUNT;
+    dma->queuedTransactions--;
+    *buffer = dma->transactions[oldest].buffer;
+    *length = dma->transactions[oldest].length;
+    return ERROR_NONE;
+}
+
+#else
+
+/** FIFOReaderTransport function, queues a DMA burst read without waiting for it to complete */
+private Error camera_dmaQueueFIFORead(void *context, uint8_t *buffer, const size_t length) {
+    typeof(this.dma) *dma = (typeof(this.dma) *) context;
+    spi_transaction_t *tx = &dma->transactions[dma->nextTransaction];
+    dma->nextTransaction = (dma->nextTransaction + 1) % FIFO_READER_BUFFER_COUNT;
+    *tx = (spi_transaction_t) {
+            .cmd = 0x03C | SPI_READ,
+            .tx_buffer = NULL,
+            .rxlength = length * BYTE_TO_BITS,
+            .rx_buffer = buffer,
+    };
+    esp_err_t err = spi_device_queue_trans(this.spiDeviceHandle, tx, portMAX_DELAY);
+    if (err != ESP_OK) {
+        throwESPError(spi_device_queue_trans, err);
+    }
+    return ERROR_NONE;
+}
+
+/** FIFOReaderTransport function, waits for the oldest queued DMA burst read */
+private Error camera_dmaAwaitFIFORead(void *context, uint8_t **buffer, size_t *length) {
+    spi_transaction_t *tx = NULL;
+    esp_err_t err = spi_device_get_trans_result(this.spiDeviceHandle, &tx, portMAX_DELAY);
+    if (err != ESP_OK) {
+        throwESPError(spi_device_get_trans_result, err);
+    }
+    *buffer = tx->rx_buffer;
+    *length = tx->rxlength / BYTE_TO_BITS;
+    return ERROR_NONE;
+}
+
+#endif // CONFIG_CAMERA_VIRTUAL_DEVICE
+
+private Error camera_initDMA() {
+    for (int i = 0; i < FIFO_READER_BUFFER_COUNT; i++) {
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+        this.dma.buffers[i] = alloc(SPI_DMA_BUFFER_SIZE);
+#else
+        this.dma.buffers[i] = heap_caps_malloc(SPI_DMA_BUFFER_SIZE, MALLOC_CAP_DMA);
+#endif
+        requireNotNull(this.dma.buffers[i], ERROR_LIBRARY_FAILURE,
+                       "Could not allocate %u bytes of DMA capable memory", SPI_DMA_BUFFER_SIZE);
+    }
+    const FIFOReaderTransport transport = {
+            .context = &this.dma,
+            .queueRead = camera_dmaQueueFIFORead,
+            .awaitRead = camera_dmaAwaitFIFORead,
+    };
+    this.dma.nextTransaction = 0;
+    this.dma.fifoReader = fifoReader_create(&transport, this.dma.buffers, SPI_DMA_BUFFER_SIZE);
+    requireNotNull(this.dma.fifoReader, ERROR_ILLEGAL_STATE, "Could not create FIFO reader");
+    return ERROR_NONE;
+}
+
 private Error camera_singleFIFORead(uint8_t *const byteReceived) {
     uint8_t receivedData = 0;
     spiReceiveOnly(0x03D | SPI_READ, &receivedData, sizeof(receivedData));
@@ -257,513 +689,558 @@ private Error camera_waitForFIFODone() {
     return ERROR_NONE;
 }
 
-public Error camera_setImageSize(const CameraImageSize imageSize) {
-    obtainMutex();
-    switch (imageSize) {
-        case CAMERA_IMAGE_SIZE_320x240:
-            i2cWriteRegistryEntries(OV5642_320x240);
-            break;
-        case CAMERA_IMAGE_SIZE_640x480:
-            i2cWriteRegistryEntries(OV5642_640x480);
-            break;
-        case CAMERA_IMAGE_SIZE_1024x768:
-            i2cWriteRegistryEntries(OV5642_1024x768);
-            break;
-        case CAMERA_IMAGE_SIZE_1280x960:
-            i2cWriteRegistryEntries(OV5642_1280x960);
-            break;
-        case CAMERA_IMAGE_SIZE_1600x1200:
-            i2cWriteRegistryEntries(OV5642_1600x1200);
-            break;
-        case CAMERA_IMAGE_SIZE_2048x1536:
-            i2cWriteRegistryEntries(OV5642_2048x1536);
-            break;
-        case CAMERA_IMAGE_SIZE_2592x1944:
-            i2cWriteRegistryEntries(OV5642_2592x1944);
-            break;
-        default:
-            break;
+private const OV5642RegisterEntry *const CAMERA_IMAGE_SIZE_SCRIPTS[] = {
+        [CAMERA_IMAGE_SIZE_320x240] = OV5642_320x240,
+        [CAMERA_IMAGE_SIZE_640x480] = OV5642_640x480,
+        [CAMERA_IMAGE_SIZE_1024x768] = OV5642_1024x768,
+        [CAMERA_IMAGE_SIZE_1280x960] = OV5642_1280x960,
+        [CAMERA_IMAGE_SIZE_1600x1200] = OV5642_1600x1200,
+        [CAMERA_IMAGE_SIZE_2048x1536] = OV5642_2048x1536,
+        [CAMERA_IMAGE_SIZE_2592x1944] = OV5642_2592x1944,
+};
+
+/*
+ * The streaming profile's timings, written after an image size's table. Every timing writes the same registers so
+ * switching between any 2 streaming sizes leaves none of them behind. The still profile is the size tables unmodified
+ */
+
+/** What the Arducam tables and CAMERA_START_SETTINGS leave the registers the streaming timings write at, checked
+ * against every image size's table, written before the table when switching back to the still profile so the size's
+ * own writes come after it and win */
+private const OV5642RegisterEntry CAMERA_STILL_TIMING_RESTORE[] = {
+        {0x3011, 0x08}, // PLL multiplier
+        {0x3010, 0x10}, // PLL system clock divider 2
+        {0x3621, 0x10}, // mirror function, no horizontal binning
+        {0x3818, 0xa8}, // compression, vertical flip, no vertical subsampling
+        {0x3800, 0x01}, {0x3801, 0xb0}, {0x3802, 0x00}, {0x3803, 0x0a}, // window start
+        {0x3804, 0x0a}, {0x3805, 0x20}, {0x3806, 0x07}, {0x3807, 0x98}, // window 2592x1944
+        {0x380c, 0x0c}, {0x380d, 0x80}, // HTS 3200
+        {0x380e, 0x07}, {0x380f, 0xd0}, // VTS 2000
+        {0x3810, 0xc2},
+        {0x3824, 0x01},
+        {0x3827, 0x0a},
+        {0x5682, 0x0a}, {0x5683, 0x20}, {0x5686, 0x07}, {0x5687, 0x98}, // AVG window 2592x1944
+        {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+};
+
+/** The array is binned 2x2 to 1280x960 and scaled down from there, the binning and window are the QVGA preview's,
+ * the PLL the 1080p video table's and the HTS the 720p video table's, the VTS is the least for 960 lines */
+private const OV5642RegisterEntry CAMERA_STREAMING_BINNED_TIMING[] = {
+        {0x3011, 0x07}, // PLL multiplier
+        {0x3010, 0x00}, // PLL system clock undivided
+        {0x3621, 0x97}, // mirror function, horizontal binning
+        {0x3818, 0xa9}, // compression, vertical flip, vertical subsampling
+        {0x3800, 0x01}, {0x3801, 0x50}, {0x3802, 0x00}, {0x3803, 0x08}, // window start
+        {0x3804, 0x05}, {0x3805, 0x00}, {0x3806, 0x03}, {0x3807, 0xc0}, // window 1280x960 binned
+        {0x380c, 0x08}, {0x380d, 0x72}, // HTS 2162
+        {0x380e, 0x03}, {0x380f, 0xe8}, // VTS 1000
+        {0x3810, 0x40},
+        {0x3824, 0x11},
+        {0x3827, 0x08},
+        {0x5682, 0x05}, {0x5683, 0x00}, {0x5686, 0x03}, {0x5687, 0xbc}, // AVG window 1280x956
+        {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+};
+
+/** Above 1280x960 binning would lose detail the image size keeps, so the whole array is read at the 1080p video
+ * table's PLL and the VTS trimmed to the least for 1944 lines */
+private const OV5642RegisterEntry CAMERA_STREAMING_FULL_TIMING[] = {
+        {0x3011, 0x07}, // PLL multiplier
+        {0x3010, 0x00}, // PLL system clock undivided
+        {0x3621, 0x10}, // mirror function, no horizontal binning
+        {0x3818, 0xa8}, // compression, vertical flip, no vertical subsampling
+        {0x3800, 0x01}, {0x3801, 0xb0}, {0x3802, 0x00}, {0x3803, 0x0a}, // window start
+        {0x3804, 0x0a}, {0x3805, 0x20}, {0x3806, 0x07}, {0x3807, 0x98}, // window 2592x1944
+        {0x380c, 0x0c}, {0x380d, 0x80}, // HTS 3200, the least the full width line fits in
+        {0x380e, 0x07}, {0x380f, 0xa8}, // VTS 1960
+        {0x3810, 0xc2},
+        {0x3824, 0x01},
+        {0x3827, 0x0a},
+        {0x5682, 0x0a}, {0x5683, 0x20}, {0x5686, 0x07}, {0x5687, 0x98}, // AVG window 2592x1944
+        {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+};
+
+private const OV5642RegisterEntry *const CAMERA_SENSOR_PROFILE_TIMINGS[][CAMERA_IMAGE_SIZE_COUNT] = {
+        [CAMERA_SENSOR_PROFILE_STILL] = {NULL}, // the size tables unmodified
+        [CAMERA_SENSOR_PROFILE_STREAMING] = {
+                [CAMERA_IMAGE_SIZE_320x240] = CAMERA_STREAMING_BINNED_TIMING,
+                [CAMERA_IMAGE_SIZE_640x480] = CAMERA_STREAMING_BINNED_TIMING,
+                [CAMERA_IMAGE_SIZE_1024x768] = CAMERA_STREAMING_BINNED_TIMING,
+                [CAMERA_IMAGE_SIZE_1280x960] = CAMERA_STREAMING_BINNED_TIMING,
+                [CAMERA_IMAGE_SIZE_1600x1200] = CAMERA_STREAMING_FULL_TIMING,
+                [CAMERA_IMAGE_SIZE_2048x1536] = CAMERA_STREAMING_FULL_TIMING,
+                [CAMERA_IMAGE_SIZE_2592x1944] = CAMERA_STREAMING_FULL_TIMING,
+        },
+};
+
+/** Whole sensor configurations, each starts with a software reset and sets its own size and frame timing */
+private const OV5642RegisterEntry *const CAMERA_VIDEO_PROFILE_SCRIPTS[CAMERA_VIDEO_PROFILE_COUNT] = {
+        [CAMERA_VIDEO_PROFILE_NONE] = NULL,
+        [CAMERA_VIDEO_PROFILE_720P] = OV5642_720P_Video_setting,
+        [CAMERA_VIDEO_PROFILE_1080P] = OV5642_1080P_Video_setting,
+};
+
+/** The smallest still image size at least as large as each video profile, the frame pool is sized from it and the
+ * benchmark compares the profile to it */
+private const CameraImageSize CAMERA_VIDEO_PROFILE_STILL_IMAGE_SIZES[CAMERA_VIDEO_PROFILE_COUNT] = {
+        [CAMERA_VIDEO_PROFILE_NONE] = CAMERA_IMAGE_SIZE_DEFAULT,
+        [CAMERA_VIDEO_PROFILE_720P] = CAMERA_IMAGE_SIZE_1280x960,
+        [CAMERA_VIDEO_PROFILE_1080P] = CAMERA_IMAGE_SIZE_2048x1536,
+};
+
+/** Applied after a video profile's table so its frames are compressed to JPEG the way the still tables set it up,
+ * the table leaves the sensor free-running at its own frame rate */
+private const OV5642RegisterEntry CAMERA_VIDEO_JPEG_SETTINGS[] = {
+        {0x4300, 0x30}, // YUV422 into the compression engine
+        {0x501f, 0x00}, // ISP output YUV
+        {0x4713, 0x03}, // compression mode 3, as for stills
+        {0x460b, 0x35}, // VFIFO control, as for stills
+        {0x471d, 0x00}, // DVP control, as for stills
+        {0x3818, 0xa8}, // enable compression, vertical flip on, as for stills
+        {0x3002, 0x0c}, // reset SFIFO and compression so the first frame starts clean
+        {0x3002, 0x00},
+        {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+};
+
+/** The image size's table followed by the profile's timing, the table alone for the still profile, NULL if it could
+ * not be created */
+private const OV5642RegisterEntry *camera_sensorScript(const CameraSensorProfile profile,
+                                                       const CameraImageSize imageSize) {
+    const OV5642RegisterEntry *timing = CAMERA_SENSOR_PROFILE_TIMINGS[profile][imageSize];
+    if (!timing) return CAMERA_IMAGE_SIZE_SCRIPTS[imageSize];
+    OV5642RegisterEntry **script = &this.sensorScripts[profile][imageSize];
+    if (*script == NULL && registerScript_concat(CAMERA_IMAGE_SIZE_SCRIPTS[imageSize], timing, script) != ERROR_NONE) {
+        return NULL;
     }
-    releaseMutex();
-    return ERROR_NONE;
+    return *script;
 }
 
-public Error camera_setSaturation(const int saturationLevel) {
-    obtainMutex();
-    switch (saturationLevel) {
-        case 4:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x80);
-            i2cWriteByte(0x5584, 0x80);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case 3:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x70);
-            i2cWriteByte(0x5584, 0x70);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case 2:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x60);
-            i2cWriteByte(0x5584, 0x60);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case 1:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x50);
-            i2cWriteByte(0x5584, 0x50);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case 0:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x40);
-            i2cWriteByte(0x5584, 0x40);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case -1:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x30);
-            i2cWriteByte(0x5584, 0x30);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case -2:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x20);
-            i2cWriteByte(0x5584, 0x20);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case -3:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x10);
-            i2cWriteByte(0x5584, 0x10);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        case -4:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5583, 0x00);
-            i2cWriteByte(0x5584, 0x00);
-            i2cWriteByte(0x5580, 0x02);
-            break;
-        default:
-            break;
+/** The still restore followed by the image size's table, NULL if it could not be created */
+private const OV5642RegisterEntry *camera_stillRestoreScript(const CameraImageSize imageSize) {
+    OV5642RegisterEntry **script = &this.stillRestoreScripts[imageSize];
+    if (*script == NULL && registerScript_concat(CAMERA_STILL_TIMING_RESTORE,
+                                                 CAMERA_IMAGE_SIZE_SCRIPTS[imageSize], script) != ERROR_NONE) {
+        return NULL;
     }
-    releaseMutex();
+    return *script;
+}
+
+/** The script that takes the sensor from its current image size to imageSize at profile, only the registers that
+ * differ between the 2 scripts when the current size is known and the profile is not changing, else the whole
+ * script, NULL if it could not be created, must hold the mutex */
+private const OV5642RegisterEntry *camera_imageSizeScript(const CameraSensorProfile profile,
+                                                          const CameraImageSize imageSize) {
+    const OV5642RegisterEntry *script = camera_sensorScript(profile, imageSize);
+    const uint32_t knownFields = CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_SENSOR_PROFILE;
+    // a region's window is only written again after a size change, a profile change must write every timing register
+    if (!script || (this.settings.fields & knownFields) != knownFields || this.settings.sensorProfile != profile) {
+        return profile == CAMERA_SENSOR_PROFILE_STILL ? camera_stillRestoreScript(imageSize) : script;
+    }
+    const CameraImageSize currentImageSize = this.settings.imageSize;
+    OV5642RegisterEntry **delta = &this.imageSizeDeltas[profile][currentImageSize][imageSize];
+    if (*delta == NULL) {
+        const OV5642RegisterEntry *currentScript = camera_sensorScript(profile, currentImageSize);
+        if (!currentScript || registerScript_createDelta(currentScript, script, delta) != ERROR_NONE) {
+            WARN("Could not create image size delta %i -> %i, writing the whole table", currentImageSize, imageSize);
+            return script;
+        }
+    }
+    return *delta;
+}
+
+/** The settings fields that are tuning tables and the CameraTuningSetting each one compiles with */
+private const struct {
+    CameraSettingsField field;
+    CameraTuningSetting setting;
+    size_t levelOffset;
+} CAMERA_SETTINGS_TUNING_FIELDS[] = {
+        {CAMERA_SETTINGS_FIELD_SATURATION, CAMERA_TUNING_SATURATION, offsetof(CameraSettings, saturation)},
+        {CAMERA_SETTINGS_FIELD_BRIGHTNESS, CAMERA_TUNING_BRIGHTNESS, offsetof(CameraSettings, brightness)},
+        {CAMERA_SETTINGS_FIELD_CONTRAST, CAMERA_TUNING_CONTRAST, offsetof(CameraSettings, contrast)},
+        {CAMERA_SETTINGS_FIELD_HUE, CAMERA_TUNING_HUE, offsetof(CameraSettings, hue)},
+        {CAMERA_SETTINGS_FIELD_EXPOSURE, CAMERA_TUNING_EXPOSURE, offsetof(CameraSettings, exposure)},
+        {CAMERA_SETTINGS_FIELD_SHARPNESS, CAMERA_TUNING_SHARPNESS, offsetof(CameraSettings, sharpness)},
+        {CAMERA_SETTINGS_FIELD_IMAGE_QUALITY, CAMERA_TUNING_IMAGE_QUALITY, offsetof(CameraSettings, imageQuality)},
+};
+
+#define CAMERA_SETTINGS_TUNING_FIELD_COUNT \
+(sizeof(CAMERA_SETTINGS_TUNING_FIELDS) / sizeof(CAMERA_SETTINGS_TUNING_FIELDS[0]))
+
+#define camera_settingsLevel(settings, index) \
+(*((const int *) (((const uint8_t *) (settings)) + CAMERA_SETTINGS_TUNING_FIELDS[index].levelOffset)))
+
+/** Copy the fields set in from into to */
+private void camera_mergeSettings(CameraSettings *to, const CameraSettings *from) {
+    if (from->fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE) to->imageSize = from->imageSize;
+    if (from->fields & CAMERA_SETTINGS_FIELD_SATURATION) to->saturation = from->saturation;
+    if (from->fields & CAMERA_SETTINGS_FIELD_BRIGHTNESS) to->brightness = from->brightness;
+    if (from->fields & CAMERA_SETTINGS_FIELD_CONTRAST) to->contrast = from->contrast;
+    if (from->fields & CAMERA_SETTINGS_FIELD_HUE) to->hue = from->hue;
+    if (from->fields & CAMERA_SETTINGS_FIELD_EXPOSURE) to->exposure = from->exposure;
+    if (from->fields & CAMERA_SETTINGS_FIELD_SHARPNESS) to->sharpness = from->sharpness;
+    if (from->fields & CAMERA_SETTINGS_FIELD_IMAGE_QUALITY) to->imageQuality = from->imageQuality;
+    if (from->fields & CAMERA_SETTINGS_FIELD_REGION) to->region = from->region;
+    if (from->fields & CAMERA_SETTINGS_FIELD_SENSOR_PROFILE) to->sensorProfile = from->sensorProfile;
+    to->fields |= from->fields;
+}
+
+/** CAMERA_START_SETTINGS turns on both, the window is mirrored and flipped into array coordinates to match */
+#define CAMERA_SENSOR_IS_MIRRORED true
+#define CAMERA_SENSOR_IS_FLIPPED true
+
+/** The window script for the region and image size the sensor will have once settings are applied, the image size
+ * tables write the whole array window so a region is written again after every image size change, entries is left
+ * empty when there is no region to write, must hold the mutex */
+private Error camera_sensorWindowScript(const CameraSettings *settings, OV5642RegisterEntry *entries) {
+    entries[0] = (OV5642RegisterEntry) {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END};
+    const bool hasRegion = settings->fields & CAMERA_SETTINGS_FIELD_REGION;
+    const bool hasImageSize = settings->fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE;
+    const bool isRegionKnown = hasRegion || (this.settings.fields & CAMERA_SETTINGS_FIELD_REGION);
+    if (!hasRegion && !(hasImageSize && isRegionKnown)) return ERROR_NONE;
+    const bool isImageSizeKnown = hasImageSize || (this.settings.fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE);
+    if (!isImageSizeKnown) {
+        throw(ERROR_ILLEGAL_STATE, "Cannot set a region before the image size is known");
+    }
+    const CameraRegion *region = hasRegion ? &settings->region : &this.settings.region;
+    const CameraImageSize imageSize = hasImageSize ? settings->imageSize : this.settings.imageSize;
+    CameraRegion window;
+    Error err = sensorWindow_fit(region, imageSize, &window);
+    throwIfError(err, "Could not fit region (%u, %u) %ux%u", region->x, region->y, region->width, region->height);
+    err = sensorWindow_compile(&window, CAMERA_SENSOR_IS_MIRRORED, CAMERA_SENSOR_IS_FLIPPED, entries);
+    throwIfError(err, "Could not compile sensor window");
+    VERBOSE("Sensor window (%u, %u) %ux%u", window.x, window.y, window.width, window.height);
     return ERROR_NONE;
 }
 
-public Error camera_setBrightness(const int brightnessLevel) {
+/** Apply settings without storing them in the register image, for changes that should not outlive a restart */
+private Error camera_writeSettings(const CameraSettings *settings, CameraSettings *effectiveSettings) {
+    requireArgNotNull(settings);
+    const bool hasImageSize = settings->fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE;
+    const bool hasProfile = settings->fields & CAMERA_SETTINGS_FIELD_SENSOR_PROFILE;
+    require(this.video.profile == CAMERA_VIDEO_PROFILE_NONE ||
+            !(settings->fields & (CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_REGION |
+                                  CAMERA_SETTINGS_FIELD_SENSOR_PROFILE)),
+            ERROR_ILLEGAL_STATE, "Image size, region and sensor profile are fixed by video profile %i",
+            this.video.profile);
+    require(!hasImageSize || (settings->imageSize >= 0 && settings->imageSize < CAMERA_IMAGE_SIZE_COUNT),
+            ERROR_OUT_OF_BOUNDS, "Invalid image size: %i", settings->imageSize);
+    require(!hasProfile || (settings->sensorProfile >= 0 && settings->sensorProfile < CAMERA_SENSOR_PROFILE_COUNT),
+            ERROR_OUT_OF_BOUNDS, "Invalid sensor profile: %i", settings->sensorProfile);
+    require(!(settings->fields & CAMERA_SETTINGS_FIELD_REGION) || sensorWindow_isValidRegion(&settings->region),
+            ERROR_OUT_OF_BOUNDS, "Invalid region: (%u, %u) %ux%u", settings->region.x, settings->region.y,
+            settings->region.width, settings->region.height);
+
+    CameraTuningLevel levels[CAMERA_SETTINGS_TUNING_FIELD_COUNT];
+    size_t levelCount = 0;
+    for (size_t i = 0; i < CAMERA_SETTINGS_TUNING_FIELD_COUNT; i++) {
+        if (settings->fields & CAMERA_SETTINGS_TUNING_FIELDS[i].field) {
+            levels[levelCount++] = (CameraTuningLevel) {
+                    .setting = CAMERA_SETTINGS_TUNING_FIELDS[i].setting,
+                    .level = camera_settingsLevel(settings, i)
+            };
+        }
+    }
+    OV5642RegisterEntry tuningEntries[CAMERA_TUNING_MAX_BATCH_ENTRIES];
+    const Error compileErr = cameraTuning_compileBatch(levels, levelCount, tuningEntries);
+    if (compileErr != ERROR_NONE) return compileErr;
+
+    // the live capture task holds the mutex for a whole frame so the batch always lands between 2 frames
     obtainMutex();
-    switch (brightnessLevel) {
-        case 4:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x40);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 3:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x30);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 2:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x20);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 1:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x10);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 0:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x00);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case -1:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x10);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x08);
-            break;
-        case -2:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x20);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x08);
-            break;
-        case -3:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x30);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x08);
-            break;
-        case -4:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5589, 0x40);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x558a, 0x08);
-            break;
-        default:
-            break;
+    const bool isProfileKnown = this.settings.fields & CAMERA_SETTINGS_FIELD_SENSOR_PROFILE;
+    const CameraSensorProfile profile = hasProfile ? settings->sensorProfile :
+                                        isProfileKnown ? this.settings.sensorProfile : CAMERA_SENSOR_PROFILE_STILL;
+    // a profile change writes the image size's table again, with the new timing after it
+    const bool isProfileChange = hasProfile && (!isProfileKnown || profile != this.settings.sensorProfile);
+    const bool isSizeWrite = hasImageSize || isProfileChange;
+    CameraSettings sizeSettings = *settings;
+    if (isSizeWrite && !hasImageSize) {
+        if (!(this.settings.fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE)) {
+            releaseMutex();
+            throw(ERROR_ILLEGAL_STATE, "Cannot set a sensor profile before the image size is known");
+        }
+        sizeSettings.fields |= CAMERA_SETTINGS_FIELD_IMAGE_SIZE;
+        sizeSettings.imageSize = this.settings.imageSize;
+    }
+    if (profile != CAMERA_SENSOR_PROFILE_STILL && (settings->fields & CAMERA_SETTINGS_FIELD_REGION)) {
+        releaseMutex();
+        throw(ERROR_ILLEGAL_STATE, "A region cannot be set with sensor profile %i", profile);
+    }
+    OV5642RegisterEntry windowEntries[SENSOR_WINDOW_MAX_ENTRIES] = {
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    // a streaming timing writes its own window and any region was dropped when it was set
+    const Error windowErr = profile == CAMERA_SENSOR_PROFILE_STILL ?
+                            camera_sensorWindowScript(&sizeSettings, windowEntries) : ERROR_NONE;
+    if (windowErr != ERROR_NONE) {
+        releaseMutex();
+        return windowErr;
     }
+    // image size script goes first so any tuning or window register it also touches ends up with the set value
+    OV5642RegisterEntry *batch = tuningEntries;
+    const size_t windowLength = registerScript_length(windowEntries);
+    if (isSizeWrite || windowLength > 0) {
+        const OV5642RegisterEntry *sizeEntries = isSizeWrite ?
+                                                 camera_imageSizeScript(profile, sizeSettings.imageSize) : NULL;
+        if (isSizeWrite && !sizeEntries) {
+            releaseMutex();
+            throw(ERROR_LIBRARY_FAILURE, "Could not create the script for image size %i at sensor profile %i",
+                  sizeSettings.imageSize, profile);
+        }
+        const size_t sizeLength = sizeEntries ? registerScript_length(sizeEntries) : 0;
+        const size_t tuningLength = registerScript_length(tuningEntries);
+        batch = alloc((sizeLength + tuningLength + windowLength + 1) * sizeof(OV5642RegisterEntry));
+        if (batch == NULL) {
+            releaseMutex();
+            throw(ERROR_LIBRARY_FAILURE, "Could not allocate register batch of %u entries",
+                  sizeLength + tuningLength + windowLength + 1);
+        }
+        if (sizeEntries) memcpy(batch, sizeEntries, sizeLength * sizeof(OV5642RegisterEntry));
+        memcpy(batch + sizeLength, tuningEntries, tuningLength * sizeof(OV5642RegisterEntry));
+        memcpy(batch + sizeLength + tuningLength, windowEntries, (windowLength + 1) * sizeof(OV5642RegisterEntry));
+    }
+    const Error err = camera_writeRegisterScript("settings", batch);
+    if (err == ERROR_NONE) {
+        camera_mergeSettings(&this.settings, settings);
+        if (isSizeWrite) {
+            this.settings.fields |= CAMERA_SETTINGS_FIELD_SENSOR_PROFILE;
+            this.settings.sensorProfile = profile;
+        }
+        if (profile != CAMERA_SENSOR_PROFILE_STILL) this.settings.fields &= ~CAMERA_SETTINGS_FIELD_REGION;
+    } else { // a failed batch may have been partially written, these fields are no longer known
+        this.settings.fields &= ~(isSizeWrite ? sizeSettings.fields | CAMERA_SETTINGS_FIELD_SENSOR_PROFILE :
+                                  settings->fields);
+    }
+    if (effectiveSettings) *effectiveSettings = this.settings;
     releaseMutex();
-    return ERROR_NONE;
+
+    if (batch != tuningEntries) free(batch);
+    return err;
 }
 
-public Error camera_setContrast(const int contrastLevel) {
+/** Compile the sensor's current registers and settings into a register image and store it in settings for the next
+ * camera_start(), only when it differs from the image already stored since every store is a flash write */
+private Error camera_saveRegisterImage() {
+    uint8_t *image = NULL;
+    size_t imageLength = 0;
     obtainMutex();
-    switch (contrastLevel) {
-        case 4:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x30);
-            i2cWriteByte(0x5588, 0x30);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 3:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x2c);
-            i2cWriteByte(0x5588, 0x2c);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 2:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x28);
-            i2cWriteByte(0x5588, 0x28);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 1:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x24);
-            i2cWriteByte(0x5588, 0x24);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case 0:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x20);
-            i2cWriteByte(0x5588, 0x20);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case -1:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x1c);
-            i2cWriteByte(0x5588, 0x1c);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case -2:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x18);
-            i2cWriteByte(0x5588, 0x18);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case -3:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x14);
-            i2cWriteByte(0x5588, 0x14);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        case -4:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x04);
-            i2cWriteByte(0x5587, 0x10);
-            i2cWriteByte(0x5588, 0x10);
-            i2cWriteByte(0x558a, 0x00);
-            break;
-        default:
-            break;
-    }
+    const Error err = registerImage_create(this.registerShadow, this.start.scriptsChecksum,
+                                           &this.settings, sizeof(CameraSettings), &image, &imageLength);
     releaseMutex();
+    throwIfError(err, "Could not create register image");
+    if (this.start.image && this.start.imageLength == imageLength && memcmp(this.start.image, image, imageLength) == 0) {
+        free(image);
+        return ERROR_NONE;
+    }
+    if (settings_putBlob(SETTINGS_KEY_CAMERA_REGISTER_IMAGE, image, imageLength) != SETTINGS_ERROR_NONE) {
+        free(image);
+        throw(ERROR_LIBRARY_FAILURE, "Could not store register image of %u bytes", imageLength);
+    }
+    free(this.start.image);
+    this.start.image = image;
+    this.start.imageLength = imageLength;
+    VERBOSE("Stored register image, %u bytes", imageLength);
     return ERROR_NONE;
 }
 
-public Error camera_setHue(const int hueLevel) {
+/** Remember the user's values of fields before a transient write replaces them, fields already replaced keep the
+ * value from before the first replacement, an unknown size, quality or region is remembered as what the sensor has
+ * without one, must hold the mutex */
+private void camera_rememberUserSettings(const uint32_t fields) {
+    const uint32_t newFields = fields & ~this.userSettings.fields;
+    CameraSettings known = this.settings;
+    known.fields &= newFields;
+    camera_mergeSettings(&this.userSettings, &known);
+    const uint32_t unknownFields = newFields & ~known.fields;
+    if (unknownFields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE) this.userSettings.imageSize = CAMERA_IMAGE_SIZE_DEFAULT;
+    if (unknownFields & CAMERA_SETTINGS_FIELD_IMAGE_QUALITY) {
+        this.userSettings.imageQuality = CAMERA_IMAGE_QUALITY_NORMAL;
+    }
+    if (unknownFields & CAMERA_SETTINGS_FIELD_REGION) {
+        this.userSettings.region = (CameraRegion) {0, 0, CAMERA_SENSOR_WIDTH, CAMERA_SENSOR_HEIGHT};
+    }
+    this.userSettings.fields |= unknownFields & (CAMERA_SETTINGS_FIELD_IMAGE_SIZE |
+                                                 CAMERA_SETTINGS_FIELD_IMAGE_QUALITY | CAMERA_SETTINGS_FIELD_REGION);
+}
+
+/** Write back the user's values of the fields transient writes replaced, except those in applied which replace
+ * them, so a register image is only ever of the user's own settings */
+private void camera_restoreUserSettings(const CameraSettings *applied) {
     obtainMutex();
-    switch (hueLevel) {
-        case -180:
-        case 180:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x80);
-            i2cWriteByte(0x5582, 0x00);
-            i2cWriteByte(0x558a, 0x32);
-            break;
-        case -150:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x6f);
-            i2cWriteByte(0x5582, 0x40);
-            i2cWriteByte(0x558a, 0x32);
-            break;
-        case -120:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x40);
-            i2cWriteByte(0x5582, 0x6f);
-            i2cWriteByte(0x558a, 0x32);
-            break;
-        case -90:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x00);
-            i2cWriteByte(0x5582, 0x80);
-            i2cWriteByte(0x558a, 0x02);
-            break;
-        case -60:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x40);
-            i2cWriteByte(0x5582, 0x6f);
-            i2cWriteByte(0x558a, 0x02);
-            break;
-        case -30:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x6f);
-            i2cWriteByte(0x5582, 0x40);
-            i2cWriteByte(0x558a, 0x02);
-            break;
-        case 0:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x80);
-            i2cWriteByte(0x5582, 0x00);
-            i2cWriteByte(0x558a, 0x01);
-            break;
-        case 30:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x6f);
-            i2cWriteByte(0x5582, 0x40);
-            i2cWriteByte(0x558a, 0x01);
-            break;
-        case 60:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x40);
-            i2cWriteByte(0x5582, 0x6f);
-            i2cWriteByte(0x558a, 0x01);
-            break;
-        case 90:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x00);
-            i2cWriteByte(0x5582, 0x80);
-            i2cWriteByte(0x558a, 0x31);
-            break;
-        case 120:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x40);
-            i2cWriteByte(0x5582, 0x6f);
-            i2cWriteByte(0x558a, 0x31);
-            break;
-        case 150:
-            i2cWriteByte(0x5001, 0xff);
-            i2cWriteByte(0x5580, 0x01);
-            i2cWriteByte(0x5581, 0x6f);
-            i2cWriteByte(0x5582, 0x40);
-            i2cWriteByte(0x558a, 0x31);
-            break;
-        default:
-            break;
+    CameraSettings userSettings = this.userSettings;
+    this.userSettings.fields = 0;
+    releaseMutex();
+    userSettings.fields &= ~applied->fields;
+    // the quality controller steps again if it must, a transient setting's owner writes it again when it needs it
+    if (userSettings.fields != 0) camera_writeSettings(&userSettings, NULL);
+}
+
+public Error camera_applySettings(const CameraSettings *settings, CameraSettings *effectiveSettings) {
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_SETTINGS, 0, &request), "");
+    const Error err = camera_writeSettings(settings, effectiveSettings);
+    // the register image is of the still tables, a video profile's registers must never be warm started
+    if (err == ERROR_NONE && this.video.profile == CAMERA_VIDEO_PROFILE_NONE) {
+        camera_restoreUserSettings(settings);
+        camera_saveRegisterImage(); // the settings are applied even if they could not be kept
+        if (effectiveSettings) camera_getSettings(effectiveSettings);
     }
+    camera_endRequest(&request);
+    return err;
+}
+
+public Error camera_applyTransientSettings(const CameraSettings *settings, CameraSettings *effectiveSettings) {
+    requireArgNotNull(settings);
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_SETTINGS, 0, &request), "");
+    obtainMutex();
+    camera_rememberUserSettings(settings->fields);
     releaseMutex();
+    const Error err = camera_writeSettings(settings, effectiveSettings);
+    camera_endRequest(&request);
+    return err;
+}
+
+public Error camera_restoreTransientSettings() {
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_SETTINGS, 0, &request), "");
+    const CameraSettings applied = {.fields = 0};
+    camera_restoreUserSettings(&applied);
+    camera_endRequest(&request);
     return ERROR_NONE;
 }
 
-public Error camera_setExposure(const int exposureLevel) {
+public Error camera_getSettings(CameraSettings *settings) {
+    requireArgNotNull(settings);
     obtainMutex();
-    switch (exposureLevel) {
-        case -5:
-            i2cWriteByte(0x3a0f, 0x10);
-            i2cWriteByte(0x3a10, 0x08);
-            i2cWriteByte(0x3a1b, 0x10);
-            i2cWriteByte(0x3a1e, 0x08);
-            i2cWriteByte(0x3a11, 0x20);
-            i2cWriteByte(0x3a1f, 0x10);
-            break;
-        case -4:
-            i2cWriteByte(0x3a0f, 0x18);
-            i2cWriteByte(0x3a10, 0x10);
-            i2cWriteByte(0x3a1b, 0x18);
-            i2cWriteByte(0x3a1e, 0x10);
-            i2cWriteByte(0x3a11, 0x30);
-            i2cWriteByte(0x3a1f, 0x10);
-            break;
-        case -3:
-            i2cWriteByte(0x3a0f, 0x20);
-            i2cWriteByte(0x3a10, 0x18);
-            i2cWriteByte(0x3a11, 0x41);
-            i2cWriteByte(0x3a1b, 0x20);
-            i2cWriteByte(0x3a1e, 0x18);
-            i2cWriteByte(0x3a1f, 0x10);
-            break;
-        case -2:
-            i2cWriteByte(0x3a0f, 0x28);
-            i2cWriteByte(0x3a10, 0x20);
-            i2cWriteByte(0x3a11, 0x51);
-            i2cWriteByte(0x3a1b, 0x28);
-            i2cWriteByte(0x3a1e, 0x20);
-            i2cWriteByte(0x3a1f, 0x10);
-            break;
-        case -1:
-            i2cWriteByte(0x3a0f, 0x30);
-            i2cWriteByte(0x3a10, 0x28);
-            i2cWriteByte(0x3a11, 0x61);
-            i2cWriteByte(0x3a1b, 0x30);
-            i2cWriteByte(0x3a1e, 0x28);
-            i2cWriteByte(0x3a1f, 0x10);
-            break;
-        case 0:
-            i2cWriteByte(0x3a0f, 0x38);
-            i2cWriteByte(0x3a10, 0x30);
-            i2cWriteByte(0x3a11, 0x61);
-            i2cWriteByte(0x3a1b, 0x38);
-            i2cWriteByte(0x3a1e, 0x30);
-            i2cWriteByte(0x3a1f, 0x10);
-            break;
-        case 1:
-            i2cWriteByte(0x3a0f, 0x40);
-            i2cWriteByte(0x3a10, 0x38);
-            i2cWriteByte(0x3a11, 0x71);
-            i2cWriteByte(0x3a1b, 0x40);
-            i2cWriteByte(0x3a1e, 0x38);
-            i2cWriteByte(0x3a1f, 0x10);
-            break;
-        case 2:
-            i2cWriteByte(0x3a0f, 0x48);
-            i2cWriteByte(0x3a10, 0x40);
-            i2cWriteByte(0x3a11, 0x80);
-            i2cWriteByte(0x3a1b, 0x48);
-            i2cWriteByte(0x3a1e, 0x40);
-            i2cWriteByte(0x3a1f, 0x20);
-            break;
-        case 3:
-            i2cWriteByte(0x3a0f, 0x50);
-            i2cWriteByte(0x3a10, 0x48);
-            i2cWriteByte(0x3a11, 0x90);
-            i2cWriteByte(0x3a1b, 0x50);
-            i2cWriteByte(0x3a1e, 0x48);
-            i2cWriteByte(0x3a1f, 0x20);
-            break;
-        case 4:
-            i2cWriteByte(0x3a0f, 0x58);
-            i2cWriteByte(0x3a10, 0x50);
-            i2cWriteByte(0x3a11, 0x91);
-            i2cWriteByte(0x3a1b, 0x58);
-            i2cWriteByte(0x3a1e, 0x50);
-            i2cWriteByte(0x3a1f, 0x20);
-            break;
-        case 5:
-            i2cWriteByte(0x3a0f, 0x60);
-            i2cWriteByte(0x3a10, 0x58);
-            i2cWriteByte(0x3a11, 0xa0);
-            i2cWriteByte(0x3a1b, 0x60);
-            i2cWriteByte(0x3a1e, 0x58);
-            i2cWriteByte(0x3a1f, 0x20);
-            break;
-        default:
-            break;
-    }
+    *settings = this.settings;
     releaseMutex();
     return ERROR_NONE;
 }
 
-public Error camera_setSharpness(const int sharpnessLevel) {
-    obtainMutex();
-    // TODO: 12-Nov-2022 @basshelal: Implement!
-    switch (sharpnessLevel) {
-        case 4:
+public Error camera_setImageSize(const CameraImageSize imageSize) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_IMAGE_SIZE, .imageSize = imageSize};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case 3:
+public Error camera_setSaturation(const int saturationLevel) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_SATURATION, .saturation = saturationLevel};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case 2:
+public Error camera_setBrightness(const int brightnessLevel) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_BRIGHTNESS, .brightness = brightnessLevel};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case 1:
+public Error camera_setContrast(const int contrastLevel) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_CONTRAST, .contrast = contrastLevel};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case 0:
+public Error camera_setHue(const int hueLevel) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_HUE, .hue = hueLevel};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case -1:
+public Error camera_setExposure(const int exposureLevel) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_EXPOSURE, .exposure = exposureLevel};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case -2:
+public Error camera_setSharpness(const int sharpnessLevel) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_SHARPNESS, .sharpness = sharpnessLevel};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case -3:
+public Error camera_setImageQuality(const CameraImageQuality imageQuality) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_IMAGE_QUALITY, .imageQuality = imageQuality};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        case -4:
+public Error camera_setSensorProfile(const CameraSensorProfile sensorProfile) {
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_SENSOR_PROFILE, .sensorProfile = sensorProfile};
+    return camera_applySettings(&settings, NULL);
+}
 
-            break;
-        default:
-            break;
-    }
-    releaseMutex();
+public Error camera_setRegion(const CameraRegion *region) {
+    requireArgNotNull(region);
+    const CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_REGION, .region = *region};
+    return camera_applySettings(&settings, NULL);
+}
+
+public Error camera_zoomRegion(const float centreX, const float centreY, const float zoom, CameraRegion *region) {
+    requireArgNotNull(region);
+    throwIfError(sensorWindow_fromZoom(centreX, centreY, zoom, region),
+                 "Invalid zoom %.2f at (%.2f, %.2f)", zoom, centreX, centreY);
     return ERROR_NONE;
 }
 
-public Error camera_setImageQuality(const CameraImageQuality imageQuality) {
+public Error camera_setZoom(const float centreX, const float centreY, const float zoom) {
+    CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_REGION};
+    const Error err = camera_zoomRegion(centreX, centreY, zoom, &settings.region);
+    if (err != ERROR_NONE) return err;
+    return camera_applySettings(&settings, NULL);
+}
+
+public Error camera_getSensorWindow(CameraRegion *window) {
+    requireArgNotNull(window);
     obtainMutex();
-    switch (imageQuality) {
-        case CAMERA_IMAGE_QUALITY_NORMAL:
-            i2cWriteByte(0x4407, 0x04); // average, default
-            break;
-        case CAMERA_IMAGE_QUALITY_LOW:
-            i2cWriteByte(0x4407, 0x08); // high compression, low quality image
-            break;
-        case CAMERA_IMAGE_QUALITY_HIGH:
-            i2cWriteByte(0x4407, 0x02); // low compression, high quality image
-            break;
-        default:
-            break;
-    }
+    const CameraRegion region = (this.settings.fields & CAMERA_SETTINGS_FIELD_REGION) ? this.settings.region :
+                                (CameraRegion) {.width = CAMERA_SENSOR_WIDTH, .height = CAMERA_SENSOR_HEIGHT};
+    const CameraImageSize imageSize = (this.settings.fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE) ?
+                                      this.settings.imageSize : CAMERA_IMAGE_SIZE_DEFAULT;
     releaseMutex();
-    return ERROR_NONE;
+    return sensorWindow_fit(&region, imageSize, window);
 }
 
-private Error camera_initBuses() {
-    spi_bus_config_t spiBusConfig = {
-            .miso_io_num = 19,
-            .mosi_io_num = 23,
-            .sclk_io_num = 18,
-            .quadwp_io_num = -1,
-            .quadhd_io_num = -1,
-            .max_transfer_sz = SPI_MAX_TRANSFER_SIZE,
-            .flags = SPICOMMON_BUSFLAG_MASTER
-    };
-    esp_err_t err = spi_bus_initialize(VSPI_HOST, &spiBusConfig, SPI_DMA_DISABLED);
-    ESP_ERROR_CHECK(err);
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
 
-    spi_device_interface_config_t spiDeviceConfig = {
+private Error camera_initBuses() {
+    // the frames are loaded by the first capture, the SD card they are on may not be mounted yet
+    const VirtualCameraOptions options = {.captureMicros = CONFIG_CAMERA_VIRTUAL_DEVICE_CAPTURE_MICROS,
+                                          .framesPath = CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH};
+    this.virtualCamera = virtualCamera_create(&options);
+    requireNotNull(this.virtualCamera, ERROR_LIBRARY_FAILURE, "Could not create virtual camera");
+    INFO("Virtual camera serving frames from %s, %u us per capture", CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH,
+         CONFIG_CAMERA_VIRTUAL_DEVICE_CAPTURE_MICROS);
+    this.spiClockHz = SPI_MASTER_FREQ_HZ;
+    return ERROR_NONE;
+}
+
+#else
+
+private Error camera_addSPIDevice(const uint32_t clockHz) {
+    spi_device_interface_config_t spiDeviceConfig = {
             .command_bits = 8,
             .address_bits = 0,
-            .clock_speed_hz = SPI_MASTER_FREQ_HZ,
+            .clock_speed_hz = (int) clockHz,
             .mode = 0,
             .spics_io_num = 5,
             .queue_size = 32,
             .flags = SPI_DEVICE_HALFDUPLEX
     };
-    err = spi_bus_add_device(VSPI_HOST, &spiDeviceConfig, &this.spiDeviceHandle);
+    esp_err_t err = spi_bus_add_device(VSPI_HOST, &spiDeviceConfig, &this.spiDeviceHandle);
+    if (err != ESP_OK) {
+        throwESPError(spi_bus_add_device, err);
+    }
+    this.spiClockHz = clockHz;
+    return ERROR_NONE;
+}
+
+private Error camera_initBuses() {
+    spi_bus_config_t spiBusConfig = {
+            .miso_io_num = 19,
+            .mosi_io_num = 23,
+            .sclk_io_num = 18,
+            .quadwp_io_num = -1,
+            .quadhd_io_num = -1,
+            .max_transfer_sz = SPI_MAX_TRANSFER_SIZE,
+            .flags = SPICOMMON_BUSFLAG_MASTER
+    };
+    esp_err_t err = spi_bus_initialize(VSPI_HOST, &spiBusConfig, SPI_DMA_CH_AUTO);
     ESP_ERROR_CHECK(err);
 
+    throwIfError(camera_addSPIDevice(SPI_MASTER_FREQ_HZ), "");
+
     i2c_config_t i2cConfig = {
             .mode = I2C_MODE_MASTER,
             .sda_io_num = 21,
@@ -785,6 +1262,36 @@ private Error camera_initBuses() {
     return ERROR_NONE;
 }
 
+#endif // CONFIG_CAMERA_VIRTUAL_DEVICE
+
+#if CONFIG_CAMERA_VIRTUAL_DEVICE
+
+/** The virtual device has no clock to change, it is only recorded */
+private Error camera_setSPIClock(const uint32_t clockHz) {
+    this.spiClockHz = clockHz;
+    return ERROR_NONE;
+}
+
+#else
+
+/** Swap the ArduChip's SPI device for one at clockHz, no transfers may be queued. The device at the previous clock is
+ * put back if the new one can't be added */
+private Error camera_setSPIClock(const uint32_t clockHz) {
+    if (clockHz == this.spiClockHz) return ERROR_NONE;
+    esp_err_t err = spi_bus_remove_device(this.spiDeviceHandle);
+    if (err != ESP_OK) {
+        throwESPError(spi_bus_remove_device, err);
+    }
+    const uint32_t previousClockHz = this.spiClockHz;
+    if (camera_addSPIDevice(clockHz) != ERROR_NONE) {
+        throwIfError(camera_addSPIDevice(previousClockHz), "Lost the SPI device");
+        throw(ERROR_LIBRARY_FAILURE, "Could not set SPI clock to %u Hz", clockHz);
+    }
+    return ERROR_NONE;
+}
+
+#endif // CONFIG_CAMERA_VIRTUAL_DEVICE
+
 private Error camera_testArduchipSPI() {
     const uint8_t testValue = 0x69;
     camera_setTestRegister(testValue);
@@ -822,43 +1329,631 @@ private void camera_showOV5642TestColorBar() {
     i2cWriteByte(0x503e, 0x00);
 }
 
+private void camera_hideOV5642TestColorBar() {
+    i2cWriteByte(0x503d, 0x00);
+}
+
+/** Put back the clock camera_calibrateSPIClock() stored, the stock clock is kept if the ArduChip can't be read at it */
+private void camera_loadSPIClock() {
+    uint32_t clockHz;
+    if (settings_getUInt32(SETTINGS_KEY_CAMERA_SPI_CLOCK, &clockHz) != SETTINGS_ERROR_NONE) return;
+    if (clockHz == this.spiClockHz || camera_setSPIClock(clockHz) != ERROR_NONE) return;
+    if (camera_testArduchipSPI() != ERROR_NONE) {
+        WARN("Stored SPI clock of %u Hz failed, keeping %u Hz", clockHz, SPI_MASTER_FREQ_HZ);
+        camera_setSPIClock(SPI_MASTER_FREQ_HZ);
+        return;
+    }
+    INFO("SPI clock: %u Hz", clockHz);
+}
+
+/** Expected bytes of a JPEG frame at each image size at CAMERA_IMAGE_QUALITY_NORMAL, a frame that turns out larger
+ * raises the pool's frameBytesMinimum */
+private const size_t CAMERA_FRAME_POOL_FRAME_BYTES[CAMERA_IMAGE_SIZE_COUNT] = {
+        [CAMERA_IMAGE_SIZE_320x240] = 12 * 1024,
+        [CAMERA_IMAGE_SIZE_640x480] = 36 * 1024,
+        [CAMERA_IMAGE_SIZE_1024x768] = 80 * 1024,
+        [CAMERA_IMAGE_SIZE_1280x960] = 120 * 1024,
+        [CAMERA_IMAGE_SIZE_1600x1200] = 180 * 1024,
+        [CAMERA_IMAGE_SIZE_2048x1536] = 280 * 1024,
+        [CAMERA_IMAGE_SIZE_2592x1944] = 440 * 1024,
+};
+
+private const size_t CAMERA_FRAME_POOL_QUALITY_PERCENT[] = {
+        [CAMERA_IMAGE_QUALITY_LOW] = 75,
+        [CAMERA_IMAGE_QUALITY_NORMAL] = 100,
+        [CAMERA_IMAGE_QUALITY_HIGH] = 150,
+};
+
+/** Replace the latest frame with frame, taking over the caller's reference to it, frame may be NULL */
+private void camera_setLatestFrame(typeof(this) *thisPtr, CameraFrame *frame) {
+    xSemaphoreTake(thisPtr->pool.latestMutex, portMAX_DELAY);
+    CameraFrame *previous = thisPtr->pool.latest;
+    thisPtr->pool.latest = frame;
+    xSemaphoreGive(thisPtr->pool.latestMutex);
+    if (previous) framePool_release(previous);
+}
+
+/** The latest frame with a reference held for the caller if it is at most maxAgeMillis old and newer than
+ * afterSequence, else NULL */
+private CameraFrame *camera_retainLatestFrame(typeof(this) *thisPtr, const uint32_t maxAgeMillis,
+                                              const uint32_t afterSequence) {
+    CameraFrame *frame = NULL;
+    xSemaphoreTake(thisPtr->pool.latestMutex, portMAX_DELAY);
+    CameraFrame *latest = thisPtr->pool.latest;
+    if (latest && latest->sequence > afterSequence &&
+        esp_log_early_timestamp() - latest->timestampMillis <= maxAgeMillis) {
+        frame = framePool_retain(latest);
+    }
+    xSemaphoreGive(thisPtr->pool.latestMutex);
+    return frame;
+}
+
+/** Makes sure the pool's frames fit frames at the current image size and quality, recreating the pool when they
+ * changed, must hold the mutex
+ * @return whether frames can be captured into the pool */
+private bool camera_updateFramePool(typeof(this) *thisPtr) {
+    typeof(thisPtr->pool) *pool = &thisPtr->pool;
+    CameraImageSize imageSize = (thisPtr->settings.fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE) ?
+                                thisPtr->settings.imageSize : CAMERA_IMAGE_SIZE_DEFAULT;
+    if (thisPtr->video.profile != CAMERA_VIDEO_PROFILE_NONE) {
+        imageSize = CAMERA_VIDEO_PROFILE_STILL_IMAGE_SIZES[thisPtr->video.profile];
+    }
+    const CameraImageQuality imageQuality = (thisPtr->settings.fields & CAMERA_SETTINGS_FIELD_IMAGE_QUALITY) ?
+                                            thisPtr->settings.imageQuality : CAMERA_IMAGE_QUALITY_NORMAL;
+    if (imageSize != pool->imageSize || imageQuality != pool->imageQuality) {
+        pool->imageSize = imageSize;
+        pool->imageQuality = imageQuality;
+        pool->frameBytesMinimum = 0;
+    }
+    size_t frameBytes = (CAMERA_FRAME_POOL_FRAME_BYTES[imageSize] * CAMERA_FRAME_POOL_QUALITY_PERCENT[imageQuality]) / 100;
+    if (frameBytes < pool->frameBytesMinimum) frameBytes = pool->frameBytesMinimum;
+    if (frameBytes == pool->frameBytes) return pool->framePool != NULL;
+
+    if (pool->framePool) {
+        camera_setLatestFrame(thisPtr, NULL);
+        frameBroker_dropAll(thisPtr->broker.frameBroker);
+        // readers are still holding frames, keep streaming without the pool and try again next capture
+        if (framePool_destroy(pool->framePool) != ERROR_NONE) return false;
+        pool->framePool = NULL;
+    }
+    pool->frameBytes = frameBytes;
+    size_t frameCount = CAMERA_FRAME_POOL_MAX_BYTES / frameBytes;
+    if (frameCount > CAMERA_FRAME_POOL_MAX_FRAMES) frameCount = CAMERA_FRAME_POOL_MAX_FRAMES;
+    if (frameCount < CAMERA_FRAME_POOL_MIN_FRAMES) {
+        INFO("Frames of %u bytes are too large to pool, live frames will be streamed", frameBytes);
+        return false;
+    }
+    pool->framePool = framePool_create(frameCount, frameBytes);
+    if (!pool->framePool) {
+        WARN("Could not allocate %u frames of %u bytes, live frames will be streamed", frameCount, frameBytes);
+        return false;
+    }
+    INFO("Frame pool: %u frames of %u bytes", frameCount, frameBytes);
+    return true;
+}
+
+/** Copies the frame bytes the JPEG scanner finds into a frame from the pool, a complete frame becomes the latest
+ * frame and is passed to the live frame callback */
+private void camera_poolJPEGSegment(typeof(this) *thisPtr, const uint8_t *segment, const size_t segmentLength,
+                                    const size_t frameBytesRead, const JPEGScannerSegmentType segmentType) {
+    typeof(thisPtr->pool) *pool = &thisPtr->pool;
+    if (segmentType == JPEG_SCANNER_SEGMENT_DROPPED) {
+        framePool_release(pool->writing);
+        pool->writing = NULL;
+        pool->isFrameTooLarge = false;
+        return;
+    }
+    if (frameBytesRead == segmentLength) { // first segment of a new frame
+        pool->writing = framePool_acquire(pool->framePool);
+        pool->isFrameTooLarge = false;
+    }
+    CameraFrame *frame = pool->writing;
+    if (frame) {
+        size_t capacity = 0;
+        uint8_t *buffer = framePool_getBuffer(frame, &capacity);
+        if (frameBytesRead > capacity) { // discard the rest of this frame, the next pool will fit it
+            framePool_release(frame);
+            pool->writing = NULL;
+            pool->isFrameTooLarge = true;
+            pool->framesTooLarge++;
+        } else {
+            memcpy(buffer + frameBytesRead - segmentLength, segment, segmentLength);
+        }
+    }
+    if (segmentType != JPEG_SCANNER_SEGMENT_END) return;
+    if (pool->isFrameTooLarge) {
+        const size_t frameBytesWithHeadroom = frameBytesRead + (frameBytesRead / 8);
+        if (frameBytesWithHeadroom > pool->frameBytesMinimum) pool->frameBytesMinimum = frameBytesWithHeadroom;
+        pool->isFrameTooLarge = false;
+        return;
+    }
+    frame = pool->writing;
+    if (!frame) return;
+    pool->writing = NULL;
+    frame->length = frameBytesRead;
+    frame->sequence = ++pool->sequence;
+    frame->timestampMillis = esp_log_early_timestamp();
+    camera_setLatestFrame(thisPtr, frame); // the camera's reference now keeps it alive as the latest frame
+    frameBroker_publish(thisPtr->broker.frameBroker, frame);
+    for (uint i = 0; i < thisPtr->broker.consumerCount; i++) {
+        xSemaphoreGive(thisPtr->broker.frameSemaphores[i]);
+    }
+    if (pool->liveFrameCallback) pool->liveFrameCallback(frame);
+}
+
+/** Adds a decoded block's mean luma to the detector's map, which is begun on the first block as only the decoder
+ * knows the frame's size by then */
+private void camera_motionBlockCallback(const JPEGDCDecoderBlock *block, void *userArg) {
+    typeof(this) *thisPtr = (typeof(this) *) userArg;
+    if (!thisPtr->motion.isMapBegun) {
+        const JPEGDCDecoderComponent *luma = &block->info->components[0];
+        if (motionDetector_beginFrame(thisPtr->motion.motionDetector, luma->blocksWide, luma->blocksHigh) !=
+            ERROR_NONE) {
+            thisPtr->motion.isFrameFailed = true;
+            return;
+        }
+        thisPtr->motion.isMapBegun = true;
+    }
+    // DC is 8 times the block's mean sample, centred on 0
+    const int32_t luma = ((block->coefficients[0] + 4) >> 3) + 128;
+    motionDetector_addBlock(thisPtr->motion.motionDetector, block->x, block->y,
+                            luma < 0 ? 0 : (luma > UINT8_MAX ? UINT8_MAX : luma));
+}
+
+/** Decodes the DC coefficients of a live frame as it is read, the segment callback runs while the next chunk is
+ * read by DMA so decoding takes no time from the readout as long as it is faster than SPI */
+private void camera_detectMotion(typeof(this) *thisPtr, const uint8_t *segment, const size_t segmentLength,
+                                 const JPEGScannerSegmentType segmentType) {
+    const int64_t startMicros = esp_timer_get_time();
+    if (!thisPtr->motion.isFrameBegun) {
+        jpegDCDecoder_begin(thisPtr->motion.jpegDCDecoder, JPEG_DC_DECODER_COMPONENT_LUMA, 1,
+                            camera_motionBlockCallback, thisPtr);
+        thisPtr->motion.isFrameBegun = true;
+        thisPtr->motion.isMapBegun = false;
+        thisPtr->motion.isFrameFailed = false;
+        thisPtr->motion.frameMicrosSoFar = 0;
+    }
+    if (segmentType != JPEG_SCANNER_SEGMENT_DROPPED && !thisPtr->motion.isFrameFailed &&
+        jpegDCDecoder_decode(thisPtr->motion.jpegDCDecoder, segment, segmentLength) != ERROR_NONE) {
+        thisPtr->motion.isFrameFailed = true;
+    }
+    thisPtr->motion.frameMicrosSoFar += esp_timer_get_time() - startMicros;
+    if (segmentType == JPEG_SCANNER_SEGMENT_DATA) return;
+    thisPtr->motion.isFrameBegun = false;
+    if (segmentType == JPEG_SCANNER_SEGMENT_DROPPED) return; // the detector begins its map again with the next frame
+    const uint32_t frameSequence = thisPtr->motion.frameSequence++;
+    if (thisPtr->motion.isFrameFailed || !thisPtr->motion.isMapBegun ||
+        !jpegDCDecoder_isDone(thisPtr->motion.jpegDCDecoder)) {
+        thisPtr->motion.framesFailed++;
+        return;
+    }
+    MotionDetectorResult *result = &thisPtr->motion.result;
+    motionDetector_endFrame(thisPtr->motion.motionDetector, result);
+    thisPtr->motion.framesAnalysed++;
+    histogram_record(thisPtr->motion.frameMicros,
+                     (uint32_t) (thisPtr->motion.frameMicrosSoFar + esp_timer_get_time() - startMicros));
+    if (!result->isChanged) return;
+    if (result->isMotion) thisPtr->motion.motionEvents++;
+    if (thisPtr->motion.pendingEventCount < CAMERA_MOTION_MAX_PENDING_EVENTS) {
+        thisPtr->motion.pendingEvents[thisPtr->motion.pendingEventCount++] = (CameraMotionEvent) {
+                .isMotion = result->isMotion,
+                .frameSequence = frameSequence,
+                .timestampMillis = esp_log_early_timestamp(),
+                .score = result->score,
+                .zoneMask = result->zoneMask,
+        };
+    }
+}
+
+/** Gives the motion events found by the last live capture to every motion callback, must not hold the mutex so
+ * callbacks can use the camera */
+private void camera_publishMotionEvents(typeof(this) *thisPtr) {
+    CameraMotionEvent events[CAMERA_MOTION_MAX_PENDING_EVENTS];
+    obtainMutex();
+    const uint eventCount = thisPtr->motion.pendingEventCount;
+    memcpy(events, thisPtr->motion.pendingEvents, eventCount * sizeof(CameraMotionEvent));
+    thisPtr->motion.pendingEventCount = 0;
+    releaseMutex();
+    for (uint i = 0; i < eventCount; i++) {
+        INFO("Motion %s, frame %u, score %u%%", events[i].isMotion ? "started" : "ended", events[i].frameSequence,
+             events[i].score);
+        xSemaphoreTake(thisPtr->motion.callbacksMutex, portMAX_DELAY);
+        for (int j = 0; j < list_getSize(thisPtr->motion.callbacks); j++) {
+            const CameraMotionCallback *callback = list_getItem(thisPtr->motion.callbacks, j);
+            callback(&events[i]);
+        }
+        xSemaphoreGive(thisPtr->motion.callbacksMutex);
+    }
+}
+
+private void camera_burstJPEGSegmentCallback(const uint8_t *segment, const size_t segmentLength,
+                                             const size_t frameBytesRead, const JPEGScannerSegmentType segmentType,
+                                             void *userArg) {
+    CameraBurstContext *context = (CameraBurstContext *) userArg;
+    CameraBurst *burst = context->burst;
+    const CameraBurstFrame frame = {
+            .index = burst->frameCount,
+            .bytes = frameBytesRead,
+            .timestampMicros = segmentType == JPEG_SCANNER_SEGMENT_END ?
+                               (uint32_t) (esp_timer_get_time() - context->startMicros) : 0,
+            .isComplete = segmentType == JPEG_SCANNER_SEGMENT_END,
+            .isDropped = segmentType == JPEG_SCANNER_SEGMENT_DROPPED,
+    };
+    if (frame.isComplete) {
+        if (burst->frameCount >= CAMERA_BURST_MAX_FRAMES) return;
+        burst->frames[burst->frameCount++] = frame;
+    } else if (frame.isDropped) {
+        WARN("Burst frame %u ended without EOI after %u bytes", frame.index, frameBytesRead);
+        burst->framesDropped++;
+    }
+    if (!context->burstCallback) return;
+    if (frame.isDropped) {
+        context->burstCallback(&frame, NULL, 0, context->userArg);
+    } else {
+        context->burstCallback(&frame, segment, segmentLength, context->userArg);
+    }
+}
+
+/** Passes the frame bytes the JPEG scanner finds on to the frame pool, or to the live capture callback when frames
+ * are not being pooled */
+private void camera_liveJPEGSegmentCallback(const uint8_t *segment, const size_t segmentLength,
+                                            const size_t frameBytesRead, const JPEGScannerSegmentType segmentType,
+                                            void *userArg) {
+    typeof(this) *thisPtr = (typeof(this) *) userArg;
+    if (segmentType == JPEG_SCANNER_SEGMENT_END) {
+        if (!thisPtr->start.isFirstFrameDone) {
+            thisPtr->start.isFirstFrameDone = true;
+            thisPtr->start.stats.firstFrameMillis = esp_log_early_timestamp() - thisPtr->start.startedMillis;
+            INFO("First frame %u ms after a %s start", thisPtr->start.stats.firstFrameMillis,
+                 thisPtr->start.stats.isWarm ? "warm" : "cold");
+        }
+        thisPtr->frames.frameBytesTotal += frameBytesRead;
+        histogram_record(thisPtr->stats.frameBytes, frameBytesRead);
+        thisPtr->stats.framesCompleted++;
+    } else if (segmentType == JPEG_SCANNER_SEGMENT_DROPPED) {
+        thisPtr->stats.framesDropped++;
+    }
+    if (thisPtr->motion.isEnabled) camera_detectMotion(thisPtr, segment, segmentLength, segmentType);
+    if (thisPtr->video.recordContext) { // frames past the ones asked for are read out of the FIFO but not recorded
+        if (thisPtr->video.recordContext->burst->frameCount < thisPtr->video.recordFrameCount) {
+            camera_burstJPEGSegmentCallback(segment, segmentLength, frameBytesRead, segmentType,
+                                            thisPtr->video.recordContext);
+        }
+        return;
+    }
+    if (thisPtr->pool.isPooling) {
+        camera_poolJPEGSegment(thisPtr, segment, segmentLength, frameBytesRead, segmentType);
+        return;
+    }
+    CameraLiveCaptureCallback *liveCaptureCallback = thisPtr->task.liveCaptureCallback;
+    if (!liveCaptureCallback) return;
+    // the frame size is unknown until its EOI so bytesRemaining is only a lower bound, but exactly 0 at the end
+    const size_t bytesRemaining = thisPtr->frames.fifoBytesUnread > 0 ? thisPtr->frames.fifoBytesUnread : 1;
+    static uint8_t emptySegment[1];
+    switch (segmentType) {
+        case JPEG_SCANNER_SEGMENT_DATA:
+            liveCaptureCallback((uint8_t *) segment, segmentLength, frameBytesRead, bytesRemaining);
+            break;
+        case JPEG_SCANNER_SEGMENT_END:
+            liveCaptureCallback((uint8_t *) segment, segmentLength, frameBytesRead, 0);
+            break;
+        case JPEG_SCANNER_SEGMENT_DROPPED: // end what was already sent so consumers are not left mid-frame
+            if (frameBytesRead > 0) liveCaptureCallback(emptySegment, 0, frameBytesRead, 0);
+            break;
+    }
+}
+
+private bool camera_liveFIFOReaderCallback(uint8_t *buffer, const size_t bufferLength,
+                                           const size_t bytesRead, const size_t bytesRemaining, void *userArg) {
+    typeof(this) *thisPtr = (typeof(this) *) userArg;
+    thisPtr->frames.fifoBytesUnread = bytesRemaining;
+    const int64_t chunkStartMicros = esp_timer_get_time();
+    const uint32_t framesCompleted = jpegScanner_scan(thisPtr->frames.jpegScanner, buffer, bufferLength,
+                                                      camera_liveJPEGSegmentCallback, thisPtr);
+    histogram_record(thisPtr->stats.chunkMicros, (uint32_t) (esp_timer_get_time() - chunkStartMicros));
+    if (framesCompleted > 0) { // anything after the EOI is padding, don't waste SPI time reading it
+        // the other buffer's read is already in flight so only what comes after it is saved
+        const size_t bytesInFlight = bytesRemaining < SPI_DMA_BUFFER_SIZE ? bytesRemaining : SPI_DMA_BUFFER_SIZE;
+        thisPtr->frames.fifoBytesNotRead += bytesRemaining - bytesInFlight;
+        return false;
+    }
+    return true;
+}
+
+/** What camera_chaseFIFOReaderCallback keeps across the chunks of one read of the bytes a capture has written */
+typedef struct CameraFIFOChase {
+    typeof(this) *thisPtr;
+    /** The read stops once this many frames have been completed */
+    uint32_t frameLimit;
+    uint32_t framesCompleted;
+    /** Bytes of the read never transferred because the frame limit was reached */
+    uint32_t bytesSkipped;
+} CameraFIFOChase;
+
+/** FIFOReaderCallback for the bytes written so far by a capture that may still be writing more, scans each chunk
+ * while the next one is read by DMA and stops once the chase's frame limit is reached */
+private bool camera_chaseFIFOReaderCallback(uint8_t *buffer, const size_t bufferLength,
+                                            const size_t bytesRead, const size_t bytesRemaining, void *userArg) {
+    CameraFIFOChase *chase = (CameraFIFOChase *) userArg;
+    typeof(this) *thisPtr = chase->thisPtr;
+    thisPtr->frames.fifoBytesUnread = bytesRemaining;
+    const int64_t chunkStartMicros = esp_timer_get_time();
+    chase->framesCompleted += jpegScanner_scan(thisPtr->frames.jpegScanner, buffer, bufferLength,
+                                               camera_liveJPEGSegmentCallback, thisPtr);
+    histogram_record(thisPtr->stats.chunkMicros, (uint32_t) (esp_timer_get_time() - chunkStartMicros));
+    if (chase->framesCompleted < chase->frameLimit) return true;
+    // the other buffer's read is already in flight so only what comes after it is skipped
+    const size_t bytesInFlight = bytesRemaining < SPI_DMA_BUFFER_SIZE ? bytesRemaining : SPI_DMA_BUFFER_SIZE;
+    chase->bytesSkipped = (uint32_t) (bytesRemaining - bytesInFlight);
+    return false;
+}
+
+/** Records the trigger to frame time for each of frameCount frames sharing elapsedMicros, must hold the mutex */
+private void camera_recordFrameMicros(typeof(this) *thisPtr, const uint32_t frameCount, const int64_t elapsedMicros) {
+    for (uint32_t i = 0; i < frameCount; i++) {
+        histogram_record(thisPtr->stats.frameMicros, (uint32_t) (elapsedMicros / frameCount));
+    }
+}
+
+/** Captures and reads a single frame, capture and read are done one after the other,
+ * the read itself is DMA double buffered so the callback runs while the next chunk is transferred,
+ * and stops as soon as the frame's EOI has been read
+ * @return the number of frames delivered to the live capture callback */
+private uint32_t camera_liveCaptureSerial(typeof(this) *thisPtr, uint32_t *bytesReadIn) {
+    uint32_t imageSize;
+    JPEGScannerStats statsBefore;
+    JPEGScannerStats statsAfter;
+    const int64_t frameStartMicros = esp_timer_get_time();
+    camera_captureImage(&imageSize);
+    const int64_t captureMicros = esp_timer_get_time() - frameStartMicros;
+    obtainMutex();
+    thisPtr->pool.isPooling = camera_updateFramePool(thisPtr);
+    const int64_t readStartMicros = esp_timer_get_time();
+    const uint32_t bytesNotReadBefore = thisPtr->frames.fifoBytesNotRead;
+    jpegScanner_getStats(thisPtr->frames.jpegScanner, &statsBefore);
+    fifoReader_read(thisPtr->dma.fifoReader, imageSize, camera_liveFIFOReaderCallback, thisPtr);
+    jpegScanner_finish(thisPtr->frames.jpegScanner, camera_liveJPEGSegmentCallback, thisPtr);
+    jpegScanner_getStats(thisPtr->frames.jpegScanner, &statsAfter);
+    const uint32_t bytesRead = imageSize - (thisPtr->frames.fifoBytesNotRead - bytesNotReadBefore);
+    const int64_t frameEndMicros = esp_timer_get_time();
+    const uint32_t framesCompleted = statsAfter.framesCompleted - statsBefore.framesCompleted;
+    histogram_record(thisPtr->stats.captureMicros, (uint32_t) captureMicros);
+    histogram_record(thisPtr->stats.readoutMicros, (uint32_t) (frameEndMicros - readStartMicros));
+    camera_recordFrameMicros(thisPtr, framesCompleted, frameEndMicros - frameStartMicros);
+    releaseMutex();
+    if (bytesReadIn) *bytesReadIn = bytesRead;
+    return framesCompleted;
+}
+
+/** Starts the capture of frameCount frames back to back into an empty FIFO, must hold the mutex */
+private void camera_triggerFrames(const uint8_t frameCount) {
+    camera_setFramesToCapture(frameCount);
+    camera_resetFIFOWrite();
+    camera_resetFIFORead();
+    camera_clearFIFOWriteDoneFlag();
+    camera_startCapture();
+}
+
+/** Triggers CAMERA_PIPELINE_FRAMES_PER_TRIGGER frames and drains the FIFO while the ArduChip is still writing
+ * to it, the read pointer chases the write pointer so frame N is read out over SPI while the sensor is exposing
+ * and JPEG encoding frame N+1, instead of waiting for the FIFO done flag before reading anything. Whatever has been
+ * written is read through the DMA ping-pong buffers so each chunk is scanned while the next one is transferred
+ * @return the number of frames delivered to the live capture callback */
+private uint32_t camera_liveCapturePipelined(typeof(this) *thisPtr, uint32_t *bytesReadIn) {
+    uint32_t bytesWritten = 0;
+    uint32_t bytesRead = 0;
+    int64_t readoutMicros = 0;
+    bool isDone = false;
+    bool wasDone = false;
+    CameraFIFOChase chase = {.thisPtr = thisPtr, .frameLimit = CAMERA_PIPELINE_FRAMES_PER_TRIGGER};
+
+    obtainMutex();
+    thisPtr->pool.isPooling = camera_updateFramePool(thisPtr);
+    const int64_t triggerMicros = esp_timer_get_time();
+    camera_triggerFrames(CAMERA_PIPELINE_FRAMES_PER_TRIGGER);
+    while (true) {
+        camera_getFIFOWriteDoneFlag(&isDone);
+        if (isDone && !wasDone) {
+            histogram_record(thisPtr->stats.captureMicros, (uint32_t) (esp_timer_get_time() - triggerMicros));
+            wasDone = true;
+        }
+        camera_getWriteFIFOSize(&bytesWritten);
+        const uint32_t bytesAvailable = bytesWritten > bytesRead ? bytesWritten - bytesRead : 0;
+        // only read once a whole DMA buffer is waiting while the capture is ongoing, once done read whatever is left
+        if (bytesAvailable >= SPI_DMA_BUFFER_SIZE || (isDone && bytesAvailable > 0)) {
+            const int64_t readStartMicros = esp_timer_get_time();
+            fifoReader_read(thisPtr->dma.fifoReader, bytesAvailable, camera_chaseFIFOReaderCallback, &chase);
+            readoutMicros += esp_timer_get_time() - readStartMicros;
+            bytesRead += bytesAvailable - chase.bytesSkipped;
+            if (chase.framesCompleted >= CAMERA_PIPELINE_FRAMES_PER_TRIGGER) { // the rest is padding, skip reading it
+                camera_waitForFIFODone();
+                if (!wasDone) {
+                    histogram_record(thisPtr->stats.captureMicros, (uint32_t) (esp_timer_get_time() - triggerMicros));
+                }
+                camera_getWriteFIFOSize(&bytesWritten);
+                thisPtr->frames.fifoBytesNotRead += bytesWritten - bytesRead;
+                break;
+            }
+        } else if (isDone) {
+            break;
+        }
+    }
+    jpegScanner_finish(thisPtr->frames.jpegScanner, camera_liveJPEGSegmentCallback, thisPtr);
+    camera_setFramesToCapture(1);
+    const uint32_t framesCompleted = chase.framesCompleted;
+    for (uint32_t i = 0; i < framesCompleted; i++) {
+        histogram_record(thisPtr->stats.readoutMicros, (uint32_t) (readoutMicros / framesCompleted));
+    }
+    camera_recordFrameMicros(thisPtr, framesCompleted, esp_timer_get_time() - triggerMicros);
+    releaseMutex();
+    if (bytesReadIn) *bytesReadIn = bytesRead;
+    return framesCompleted;
+}
+
+/** Re-arms the FIFO for the next CAMERA_BURST_MAX_FRAMES_PER_TRIGGER frames of the free-running video profile and
+ * reads each frame out while the ArduChip writes the next. Per trigger the control traffic is 1 rearm and 1 start,
+ * the frame count register is only written when a still capture changed it, while the frames keep coming only the
+ * FIFO size is polled and once the last frame's EOI is read the FIFO is not waited on, so its padding is not counted
+ * in fifoBytesNotRead. A trigger waits for the next frame to start, so that wait is paid once per
+ * CAMERA_BURST_MAX_FRAMES_PER_TRIGGER frames instead of once per frame
+ * @return the number of frames delivered to the live capture callback */
+private uint32_t camera_liveCaptureVideo(typeof(this) *thisPtr, uint32_t *bytesReadIn) {
+    uint32_t bytesWritten = 0;
+    uint32_t bytesRead = 0;
+    int64_t readoutMicros = 0;
+    bool isDone = false;
+    CameraFIFOChase chase = {.thisPtr = thisPtr, .frameLimit = CAMERA_BURST_MAX_FRAMES_PER_TRIGGER};
+
+    obtainMutex();
+    thisPtr->pool.isPooling = camera_updateFramePool(thisPtr);
+    const int64_t triggerMicros = esp_timer_get_time();
+    camera_setFramesToCapture(CAMERA_BURST_MAX_FRAMES_PER_TRIGGER);
+    camera_rearmFIFO();
+    camera_startCapture();
+    while (chase.framesCompleted < CAMERA_BURST_MAX_FRAMES_PER_TRIGGER) {
+        camera_getWriteFIFOSize(&bytesWritten);
+        uint32_t bytesAvailable = bytesWritten > bytesRead ? bytesWritten - bytesRead : 0;
+        // only worth asking whether the capture ended when a whole chunk isn't ready
+        if (bytesAvailable < SPI_DMA_BUFFER_SIZE) {
+            camera_getFIFOWriteDoneFlag(&isDone);
+            if (!isDone) continue;
+            camera_getWriteFIFOSize(&bytesWritten); // the last bytes can land between the 2 reads
+            bytesAvailable = bytesWritten > bytesRead ? bytesWritten - bytesRead : 0;
+            if (bytesAvailable == 0) break;
+        }
+        const int64_t readStartMicros = esp_timer_get_time();
+        fifoReader_read(thisPtr->dma.fifoReader, bytesAvailable, camera_chaseFIFOReaderCallback, &chase);
+        readoutMicros += esp_timer_get_time() - readStartMicros;
+        bytesRead += bytesAvailable - chase.bytesSkipped;
+    }
+    histogram_record(thisPtr->stats.captureMicros, (uint32_t) (esp_timer_get_time() - triggerMicros));
+    jpegScanner_finish(thisPtr->frames.jpegScanner, camera_liveJPEGSegmentCallback, thisPtr);
+    const uint32_t framesCompleted = chase.framesCompleted;
+    for (uint32_t i = 0; i < framesCompleted; i++) {
+        histogram_record(thisPtr->stats.readoutMicros, (uint32_t) (readoutMicros / framesCompleted));
+    }
+    camera_recordFrameMicros(thisPtr, framesCompleted, esp_timer_get_time() - triggerMicros);
+    releaseMutex();
+    if (bytesReadIn) *bytesReadIn = bytesRead;
+    return framesCompleted;
+}
+
+private uint32_t camera_liveCapture(typeof(this) *thisPtr, const CameraLiveCaptureMode mode, uint32_t *bytesReadIn) {
+    switch (mode) {
+        case CAMERA_LIVE_CAPTURE_MODE_VIDEO:
+            return camera_liveCaptureVideo(thisPtr, bytesReadIn);
+        case CAMERA_LIVE_CAPTURE_MODE_PIPELINED:
+            return camera_liveCapturePipelined(thisPtr, bytesReadIn);
+        case CAMERA_LIVE_CAPTURE_MODE_SERIAL:
+        default:
+            return camera_liveCaptureSerial(thisPtr, bytesReadIn);
+    }
+}
+
+/** Feeds a live capture's measurements to the quality controller and applies any step it decides on */
+private void camera_adaptQuality(typeof(this) *thisPtr, const uint32_t frameCount, const uint32_t elapsedMillis,
+                                 const uint32_t frameBytes) {
+    uint32_t framesDropped = 0;
+    for (uint i = 0; i < thisPtr->broker.consumerCount; i++) {
+        CameraFrameConsumerStats consumerStats;
+        if (frameBroker_getStats(thisPtr->broker.frameBroker, i, &consumerStats) == ERROR_NONE) {
+            framesDropped += consumerStats.framesDropped;
+        }
+    }
+    CameraQualityDecision decision;
+    obtainMutex();
+    qualityController_addFrames(thisPtr->quality.qualityController, frameCount, elapsedMillis, frameBytes,
+                                framesDropped - thisPtr->quality.framesDropped);
+    thisPtr->quality.framesDropped = framesDropped;
+    const CameraImageSize imageSize = (thisPtr->settings.fields & CAMERA_SETTINGS_FIELD_IMAGE_SIZE) ?
+                                      thisPtr->settings.imageSize : CAMERA_IMAGE_SIZE_DEFAULT;
+    const CameraImageQuality imageQuality = (thisPtr->settings.fields & CAMERA_SETTINGS_FIELD_IMAGE_QUALITY) ?
+                                            thisPtr->settings.imageQuality : CAMERA_IMAGE_QUALITY_NORMAL;
+    const bool isChanged = qualityController_decide(thisPtr->quality.qualityController,
+                                                    imageSize, imageQuality, &decision);
+    if (isChanged) camera_rememberUserSettings(CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_IMAGE_QUALITY);
+    releaseMutex();
+    if (!isChanged) return;
+    CameraSettings settings = {.fields = 0};
+    if (decision.imageSize != imageSize) {
+        settings.fields |= CAMERA_SETTINGS_FIELD_IMAGE_SIZE;
+        settings.imageSize = decision.imageSize;
+    }
+    if (decision.imageQuality != imageQuality) {
+        settings.fields |= CAMERA_SETTINGS_FIELD_IMAGE_QUALITY;
+        settings.imageQuality = decision.imageQuality;
+    }
+    INFO("Quality step %i (reason %i), fps: %.2f, kbps: %.0f, size: %i -> %i, quality: %i -> %i",
+         decision.action, decision.reason, decision.measuredFps, decision.measuredKbps,
+         imageSize, decision.imageSize, imageQuality, decision.imageQuality);
+    camera_writeSettings(&settings, NULL); // quality steps follow the conditions of the moment, they are not kept
+}
+
+/** One live capture, queued behind the requests for the camera that go before it */
+private void camera_taskCapture(typeof(this) *thisPtr) {
+    CameraRequest request;
+    if (camera_beginRequest(CAMERA_REQUEST_CLASS_LIVE, 0, &request) != ERROR_NONE) return;
+    if (!thisPtr->task.isPaused && !thisPtr->task.isStandby) { // either could have been set while it waited
+        const uint32_t startMillis = esp_log_early_timestamp();
+        const uint32_t frameBytesBefore = thisPtr->frames.frameBytesTotal;
+        const bool isVideo = thisPtr->video.profile != CAMERA_VIDEO_PROFILE_NONE;
+        const CameraLiveCaptureMode mode = isVideo ? CAMERA_LIVE_CAPTURE_MODE_VIDEO : thisPtr->task.mode;
+        const uint32_t framesCaptured = camera_liveCapture(thisPtr, mode, NULL);
+        if (framesCaptured > 0) {
+            xSemaphoreTake(thisPtr->task.demandMutex, portMAX_DELAY);
+            liveDemand_recordFrame(thisPtr->task.liveDemand, esp_log_early_timestamp());
+            xSemaphoreGive(thisPtr->task.demandMutex);
+        }
+        if (!isVideo) { // a video profile's image size is fixed so there is nothing to step
+            camera_adaptQuality(thisPtr, framesCaptured, esp_log_early_timestamp() - startMillis,
+                                thisPtr->frames.frameBytesTotal - frameBytesBefore);
+        }
+    }
+    camera_endRequest(&request);
+}
+
+private bool camera_isLiveDemanded(typeof(this) *thisPtr) {
+    xSemaphoreTake(thisPtr->task.demandMutex, portMAX_DELAY);
+    const bool isDemanded = liveDemand_isRunning(thisPtr->task.liveDemand, esp_log_early_timestamp());
+    xSemaphoreGive(thisPtr->task.demandMutex);
+    return isDemanded;
+}
+
+/** Put the sensor into standby while nobody is subscribed to live capture, or wake it from that standby */
+private void camera_setIdle(typeof(this) *thisPtr, const bool isIdle) {
+    CameraRequest request;
+    if (camera_beginRequest(CAMERA_REQUEST_CLASS_LIVE, 0, &request) != ERROR_NONE) return;
+    if (isIdle && !thisPtr->task.isPaused && !thisPtr->task.isStandby) {
+        if (camera_writeStandby(true) == ERROR_NONE) {
+            thisPtr->task.isIdleStandby = true;
+            INFO("Live capture is idle, nobody is subscribed to it");
+        }
+    } else if (!isIdle && thisPtr->task.isIdleStandby) {
+        thisPtr->task.isIdleStandby = false;
+        camera_writeStandby(false);
+    }
+    camera_endRequest(&request);
+}
+
 private void camera_taskFunction(void *arg) {
     typeof(this) *thisPtr = (typeof(this) *) arg;
     uint32_t stackMinBytes = 0;
-    uint32_t imageSize;
-    uint32_t frameDelay;
-    uint32_t captureDelay;
-    uint32_t readDelay;
     while (thisPtr->task.isRunning) {
         if ((taskWatcher_getTaskStackMinFreeBytes(CAMERA_TASK_NAME, &stackMinBytes) == ERROR_NONE) &&
             stackMinBytes < CAMERA_TASK_STACK_MIN) { // quit task if we run out of stack to avoid program crash
             ERROR("Camera task ran out of stack, most bytes used: %u", stackMinBytes);
             break;
         }
-        if (!thisPtr->task.isPaused) {
-            if (thisPtr->task.liveCaptureCallback && thisPtr->task.liveImageBuffer) {
-                frameDelay = esp_log_early_timestamp();
-                captureDelay = esp_log_early_timestamp();
-                camera_captureImage(&imageSize);
-                captureDelay = esp_log_early_timestamp() - captureDelay;
-                obtainMutex();
-                uint8_t *buffer = thisPtr->task.liveImageBuffer;
-                const int bufferLength = (int) thisPtr->task.liveImageBufferLength;
-                readDelay = esp_log_early_timestamp();
-                for (int bytesRemaining = (int) imageSize; bytesRemaining > 0;) {
-                    const int bytesToRead = bytesRemaining > bufferLength ? bufferLength : (int) bytesRemaining;
-                    camera_burstFIFORead(buffer, bytesToRead);
-                    bytesRemaining -= bytesToRead;
-                    if (thisPtr->task.liveCaptureCallback) {
-                        thisPtr->task.liveCaptureCallback(buffer, bytesToRead,
-                                                          imageSize - bytesRemaining, bytesRemaining);
-                    }
-                }
-                readDelay = esp_log_early_timestamp() - readDelay;
-                releaseMutex();
-                frameDelay = esp_log_early_timestamp() - frameDelay;
-                INFO("cap: %u ms, read: %u ms, tot: %u ms, fps: %.2f",
-                     captureDelay, readDelay, frameDelay, 1000.0F / (float) frameDelay);
+        if (!thisPtr->task.isPaused && thisPtr->task.liveImageBuffer) {
+            if (!camera_isLiveDemanded(thisPtr)) {
+                if (!thisPtr->task.isStandby) camera_setIdle(thisPtr, true);
+                xSemaphoreTake(thisPtr->task.wakeSemaphore, pdMS_TO_TICKS(CAMERA_IDLE_WAIT_MILLIS));
+                continue;
+            }
+            if (thisPtr->task.isIdleStandby) camera_setIdle(thisPtr, false);
+            if (!thisPtr->task.isStandby) {
+                camera_taskCapture(thisPtr);
+                if (thisPtr->motion.pendingEventCount > 0) camera_publishMotionEvents(thisPtr);
             }
         }
         delayMillis(thisPtr->task.delayMillis);
@@ -866,55 +1961,168 @@ private void camera_taskFunction(void *arg) {
     taskWatcher_restartTask(CAMERA_TASK_NAME);
 }
 
-public Error camera_start() {
-    this.semaphoreHandle = xSemaphoreCreateBinary();
-    releaseMutex(); // FreeRTOS always starts it as obtained so we must release first
+/** Applied by camera_start() after the Arducam tables */
+private const OV5642RegisterEntry CAMERA_START_SETTINGS[] = {
+        {0x3818, 0xa8}, // enable compression, vertical flip on
+        {0x3621, 0x10}, // enable mirror function
+        {0x3801, 0xb0}, // ? something to do with enable mirror function as well
+        {0x5888, 0x00}, // ? something to do with lens correction
+        {0x5000, 0xFF}, // General functions all enabled
+        {0x5001, 0x7f}, // Disable special effects like filters
+        {0x5580, 0x00}, // same as above
+        // Advanced AWB Light mode
+        {0x3406, 0x00},
+        {0x5192, 0x04},
+        {0x5191, 0xf8},
+        {0x518d, 0x26},
+        {0x518f, 0x42},
+        {0x518e, 0x2b},
+        {0x5190, 0x42},
+        {0x518b, 0xd0},
+        {0x518c, 0xbd},
+        {0x5187, 0x18},
+        {0x5188, 0x18},
+        {0x5189, 0x56},
+        {0x518a, 0x5c},
+        {0x5186, 0x1c},
+        {0x5181, 0x50},
+        {0x5184, 0x20},
+        {0x5182, 0x11},
+        {0x5183, 0x00},
+        {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+};
+
+/** Checksum of every table a cold start or a later settings change can write, any change to them makes a stored
+ * register image stale */
+private uint32_t camera_scriptsChecksum() {
+    uint32_t checksum = REGISTER_IMAGE_CHECKSUM_SEED;
+    checksum = registerImage_checksumScript(checksum, OV5642_QVGA_Preview);
+    checksum = registerImage_checksumScript(checksum, OV5642_JPEG_Capture_QSXGA);
+    checksum = registerImage_checksumScript(checksum, CAMERA_START_SETTINGS);
+    checksum = registerImage_checksumScript(checksum, CAMERA_STILL_TIMING_RESTORE);
+    for (CameraImageSize imageSize = 0; imageSize < CAMERA_IMAGE_SIZE_COUNT; imageSize++) {
+        checksum = registerImage_checksumScript(checksum, CAMERA_IMAGE_SIZE_SCRIPTS[imageSize]);
+        for (CameraSensorProfile profile = 0; profile < CAMERA_SENSOR_PROFILE_COUNT; profile++) {
+            checksum = registerImage_checksumScript(checksum, CAMERA_SENSOR_PROFILE_TIMINGS[profile][imageSize]);
+        }
+    }
+    return checksum;
+}
+
+/** Read the register image stored by the last camera_saveRegisterImage() into this.start.image */
+private Error camera_loadRegisterImage() {
+    free(this.start.image);
+    this.start.image = NULL;
+    this.start.imageLength = 0;
+    size_t imageLength = 0;
+    if (settings_getBlob(SETTINGS_KEY_CAMERA_REGISTER_IMAGE, NULL, &imageLength) != SETTINGS_ERROR_NONE) {
+        return ERROR_NOT_FOUND;
+    }
+    uint8_t *image = alloc(imageLength);
+    requireNotNull(image, ERROR_LIBRARY_FAILURE, "Could not allocate register image of %u bytes", imageLength);
+    if (settings_getBlob(SETTINGS_KEY_CAMERA_REGISTER_IMAGE, image, &imageLength) != SETTINGS_ERROR_NONE) {
+        free(image);
+        return ERROR_NOT_FOUND;
+    }
+    this.start.image = image;
+    this.start.imageLength = imageLength;
+    return ERROR_NONE;
+}
+
+/** Reset the sensor and write the stored register image in one batch, then read it back to check the sensor took it,
+ * every register the tables and the last settings wrote is written once, none of the tables are replayed */
+private Error camera_warmStart() {
+    requireNotNull(this.start.image, ERROR_NOT_FOUND, "No stored register image");
+    RegisterImageInfo info;
+    throwIfError(registerImage_getInfo(this.start.image, this.start.imageLength, &info),
+                 "Stored register image is corrupt");
+    require(info.scriptsChecksum == this.start.scriptsChecksum && info.userDataLength == sizeof(CameraSettings),
+            ERROR_ILLEGAL_STATE, "Stored register image is from different tables");
+    throwIfError(camera_testOV5642SensorI2C(), "");
+    i2cWriteByte(0x3008, 0x80); // Full sensor reset
+    this.settings = (CameraSettings) {.fields = 0};
+    throwIfError(registerImage_apply(this.start.image, this.start.imageLength, &CAMERA_REGISTER_SCRIPT_WRITER,
+                                     this.registerShadow, NULL), "Could not write register image");
+    throwIfError(registerImage_verify(this.start.image, this.start.imageLength, &CAMERA_REGISTER_IMAGE_READER),
+                 "Sensor registers do not match the stored register image");
+    memcpy(&this.settings, info.userData, sizeof(CameraSettings));
+    return ERROR_NONE;
+}
+
+/** Reset the sensor and replay every table */
+private void camera_coldStart() {
     i2cWriteByte(0x3008, 0x80); // Full sensor reset
+    this.settings = (CameraSettings) {.fields = 0}; // nothing is known about the sensor after a reset
+
+    writeRegisterScript(OV5642_QVGA_Preview);
+    writeRegisterScript(OV5642_JPEG_Capture_QSXGA);
+    writeRegisterScript(OV5642_320x240);
+    writeRegisterScript(CAMERA_START_SETTINGS);
+    // the still profile is the size tables as they are, which is what was just written
+    this.settings = (CameraSettings) {
+            .fields = CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_SENSOR_PROFILE,
+            .imageSize = CAMERA_IMAGE_SIZE_320x240,
+            .sensorProfile = CAMERA_SENSOR_PROFILE_STILL
+    };
+}
 
-    i2cWriteRegistryEntries(OV5642_QVGA_Preview);
-    i2cWriteRegistryEntries(OV5642_JPEG_Capture_QSXGA);
-    i2cWriteRegistryEntries(OV5642_320x240);
-
-    i2cWriteByte(0x3818, 0xa8); // enable compression, vertical flip on
-    i2cWriteByte(0x3621, 0x10); // enable mirror function
-    i2cWriteByte(0x3801, 0xb0); // ? something to do with enable mirror function as well
-    i2cWriteByte(0x5888, 0x00); // ? something to do with lens correction
-    i2cWriteByte(0x5000, 0xFF); // General functions all enabled
-    i2cWriteByte(0x5001, 0x7f); // Disable special effects like filters
-    i2cWriteByte(0x5580, 0x00); // same as above
-    // Advanced AWB Light mode
-    i2cWriteByte(0x3406, 0x00);
-    i2cWriteByte(0x5192, 0x04);
-    i2cWriteByte(0x5191, 0xf8);
-    i2cWriteByte(0x518d, 0x26);
-    i2cWriteByte(0x518f, 0x42);
-    i2cWriteByte(0x518e, 0x2b);
-    i2cWriteByte(0x5190, 0x42);
-    i2cWriteByte(0x518b, 0xd0);
-    i2cWriteByte(0x518c, 0xbd);
-    i2cWriteByte(0x5187, 0x18);
-    i2cWriteByte(0x5188, 0x18);
-    i2cWriteByte(0x5189, 0x56);
-    i2cWriteByte(0x518a, 0x5c);
-    i2cWriteByte(0x5186, 0x1c);
-    i2cWriteByte(0x5181, 0x50);
-    i2cWriteByte(0x5184, 0x20);
-    i2cWriteByte(0x5182, 0x11);
-    i2cWriteByte(0x5183, 0x00);
-    camera_setImageSize(CAMERA_IMAGE_SIZE_DEFAULT);
+public Error camera_start() {
+    if (!this.semaphoreHandle) {
+        this.semaphoreHandle = xSemaphoreCreateBinary();
+        releaseMutex(); // FreeRTOS always starts it as obtained so we must release first
+    }
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_SETTINGS, 0, &request), "");
+    const uint32_t startMillis = esp_log_early_timestamp();
+    const uint32_t registersWrittenBefore = this.start.registersWritten;
+    this.start.startedMillis = startMillis;
+    this.start.isFirstFrameDone = false;
+    this.start.stats = (CameraStartStats) {.isWarm = false};
+    if (this.start.scriptsChecksum == 0) this.start.scriptsChecksum = camera_scriptsChecksum();
+
+    if (!this.start.image) camera_loadRegisterImage();
+    obtainMutex();
+    const bool isWarm = camera_warmStart() == ERROR_NONE;
+    if (!isWarm) camera_coldStart();
+    this.task.isStandby = false; // both starts reset the sensor which wakes it
+    this.task.isIdleStandby = false;
+    this.video.profile = CAMERA_VIDEO_PROFILE_NONE; // and replace a video profile's table with the still tables
+    this.userSettings.fields = 0; // and any quality step or transient setting with the stored settings
+    releaseMutex();
+    if (!isWarm) {
+        // settings kept in a stale or corrupt image are still good even though its registers are not
+        RegisterImageInfo info;
+        CameraSettings settings = {.fields = CAMERA_SETTINGS_FIELD_IMAGE_SIZE, .imageSize = CAMERA_IMAGE_SIZE_DEFAULT};
+        if (this.start.image && registerImage_getInfo(this.start.image, this.start.imageLength, &info) == ERROR_NONE &&
+            info.userDataLength == sizeof(CameraSettings)) {
+            memcpy(&settings, info.userData, sizeof(CameraSettings));
+        }
+        camera_applySettings(&settings, NULL); // stores the image the next start will use
+    }
 
     camera_setVSyncPolarity(true);
     camera_setFramesToCapture(1);
     camera_resetFIFOWrite();
     camera_resetFIFORead();
+    camera_endRequest(&request);
 
-    INFO("Camera started successfully");
+    this.start.stats.isWarm = isWarm;
+    this.start.stats.registersWritten = this.start.registersWritten - registersWrittenBefore;
+    this.start.stats.configureMillis = esp_log_early_timestamp() - startMillis;
+    INFO("Camera %s started successfully in %u ms, %u registers written", isWarm ? "warm" : "cold",
+         this.start.stats.configureMillis, this.start.stats.registersWritten);
 
     return ERROR_NONE;
 }
 
-public Error camera_captureImage(uint32_t *imageSize) {
+/** Capture one still into the FIFO, must hold a request for the camera */
+private Error camera_captureStillImage(uint32_t *imageSize) {
     obtainMutex();
+    if (this.task.isStandby) { // no frame would ever reach the FIFO so the wait for FIFO done would never end
+        releaseMutex();
+        throw(ERROR_ILLEGAL_STATE, "Camera is in standby");
+    }
+    camera_setFramesToCapture(1); // a video profile's live capture leaves it at more
     camera_resetFIFOWrite();
     camera_resetFIFORead();
     camera_clearFIFOWriteDoneFlag();
@@ -928,13 +2136,155 @@ public Error camera_captureImage(uint32_t *imageSize) {
     return ERROR_NONE;
 }
 
+public Error camera_captureImage(uint32_t *imageSize) {
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_STILL, 0, &request), "");
+    const Error err = camera_captureStillImage(imageSize);
+    camera_forgetSharedCapture(); // the caller reads it out after the request has ended
+    camera_endRequest(&request);
+    return err;
+}
+
+public Error camera_openFrame(const uint32_t deadlineMillis, CameraFrameCursor *cursor) {
+    requireArgNotNull(cursor);
+    requireNotNull(this.reader.frameReader, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_STILL, deadlineMillis, &request), "");
+    if (this.reader.cursor) { // only the task holding the camera gets here, its own request nested
+        camera_endRequest(&request);
+        throw(ERROR_ILLEGAL_STATE, "A frame is already open");
+    }
+    obtainSchedulerMutex();
+    request.isCoalesced = !request.isNested &&
+                          captureScheduler_canShareCapture(this.scheduler.captureScheduler, request.ticket);
+    releaseSchedulerMutex();
+    if (request.isCoalesced) { // the FIFO keeps a frame until the next capture, it can be read out again
+        obtainMutex();
+        camera_resetFIFORead();
+        releaseMutex();
+    } else {
+        const Error err = camera_captureStillImage(&this.scheduler.sharedImageSize);
+        if (err != ERROR_NONE) {
+            camera_forgetSharedCapture();
+            camera_endRequest(&request);
+            return err;
+        }
+        obtainSchedulerMutex();
+        if (!request.isNested) { // a nested request's holder may capture again before it ends
+            captureScheduler_shareCapture(this.scheduler.captureScheduler, esp_timer_get_time());
+        } else {
+            captureScheduler_forgetCapture(this.scheduler.captureScheduler);
+        }
+        releaseSchedulerMutex();
+    }
+    obtainMutex();
+    frameReader_open(this.reader.frameReader, this.scheduler.sharedImageSize, cursor);
+    releaseMutex();
+    this.reader.request = request;
+    this.reader.cursor = cursor;
+    return ERROR_NONE;
+}
+
+public Error camera_readFrame(CameraFrameCursor *cursor, uint8_t *buffer, const size_t length, size_t *bytesRead) {
+    requireArgNotNull(cursor);
+    requireArgNotNull(buffer);
+    requireArgNotNull(bytesRead);
+    require(cursor == this.reader.cursor, ERROR_ILLEGAL_STATE, "Frame is not open");
+    obtainMutex();
+    const Error err = frameReader_read(this.reader.frameReader, cursor, buffer, length, bytesRead);
+    releaseMutex();
+    return err;
+}
+
+public Error camera_closeFrame(CameraFrameCursor *cursor) {
+    requireArgNotNull(cursor);
+    require(cursor == this.reader.cursor, ERROR_ILLEGAL_STATE, "Frame is not open");
+    obtainMutex();
+    this.frames.fifoBytesNotRead += frameReader_close(this.reader.frameReader, cursor);
+    releaseMutex();
+    if (cursor->isFailed && !this.reader.request.isCoalesced) camera_forgetSharedCapture(); // nothing to share
+    this.reader.cursor = NULL;
+    camera_endRequest(&this.reader.request);
+    return ERROR_NONE;
+}
+
+/** Reads the frame at cursor out to readCallback buffered through buffer, up to its EOI, the mutex must be held */
+private Error camera_readFrameWithCallback(CameraFrameCursor *cursor, char *buffer, const int bufferLength,
+                                           CameraReadCallback readCallback, void *userArg) {
+    Error err = ERROR_NONE;
+    while (err == ERROR_NONE && !cursor->isComplete) {
+        size_t bytesRead = 0;
+        err = frameReader_read(this.reader.frameReader, cursor, (uint8_t *) buffer, (size_t) bufferLength,
+                               &bytesRead);
+        if (err == ERROR_NONE && bytesRead > 0) readCallback(buffer, (int) bytesRead, userArg);
+    }
+    if (err == ERROR_NOT_FOUND) WARN("Image ended without EOI after %u bytes", cursor->bytesRead);
+    return err;
+}
+
+public Error camera_captureStill(const uint32_t deadlineMillis, char *buffer, const int bufferLength,
+                                 CameraReadCallback readCallback, void *userArg) {
+    requireArgNotNull(buffer);
+    requireArgNotNull(readCallback);
+    require(bufferLength > 0, ERROR_ILLEGAL_ARGUMENT, "bufferLength must be greater than 0");
+    CameraFrameCursor cursor;
+    throwIfError(camera_openFrame(deadlineMillis, &cursor), "");
+    obtainMutex();
+    const Error err = camera_readFrameWithCallback(&cursor, buffer, bufferLength, readCallback, userArg);
+    releaseMutex();
+    camera_closeFrame(&cursor);
+    return err;
+}
+
 public Error camera_init() {
     throwIfError(camera_initBuses(), "");
+    camera_loadSPIClock();
+    throwIfError(camera_initDMA(), "");
+    this.registerShadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    requireNotNull(this.registerShadow, ERROR_LIBRARY_FAILURE, "Could not create register shadow");
+    this.frames.jpegScanner = jpegScanner_create();
+    requireNotNull(this.frames.jpegScanner, ERROR_LIBRARY_FAILURE, "Could not create JPEG scanner");
+    this.reader.frameReader = frameReader_create(this.frames.jpegScanner, camera_frameReaderFIFORead, NULL);
+    requireNotNull(this.reader.frameReader, ERROR_LIBRARY_FAILURE, "Could not create frame reader");
+    this.pool.latestMutex = xSemaphoreCreateMutex();
+    requireNotNull(this.pool.latestMutex, ERROR_LIBRARY_FAILURE, "Could not create latest frame mutex");
+    this.broker.frameBroker = frameBroker_create(CAMERA_FRAME_BROKER_CAPACITY);
+    requireNotNull(this.broker.frameBroker, ERROR_LIBRARY_FAILURE, "Could not create frame broker");
+    this.stats.captureMicros = histogram_create();
+    this.stats.readoutMicros = histogram_create();
+    this.stats.chunkMicros = histogram_create();
+    this.stats.frameMicros = histogram_create();
+    this.stats.frameBytes = histogram_create();
+    require(this.stats.captureMicros && this.stats.readoutMicros && this.stats.chunkMicros &&
+            this.stats.frameMicros && this.stats.frameBytes,
+            ERROR_LIBRARY_FAILURE, "Could not create capture stats histograms");
+    this.stats.sinceMillis = esp_log_early_timestamp();
+    this.quality.qualityController = qualityController_create();
+    requireNotNull(this.quality.qualityController, ERROR_LIBRARY_FAILURE, "Could not create quality controller");
+    this.motion.callbacks = list_create();
+    requireNotNull(this.motion.callbacks, ERROR_LIBRARY_FAILURE, "Could not create motion callbacks list");
+    this.motion.callbacksMutex = xSemaphoreCreateMutex();
+    requireNotNull(this.motion.callbacksMutex, ERROR_LIBRARY_FAILURE, "Could not create motion callbacks mutex");
+    this.scheduler.mutex = xSemaphoreCreateMutex();
+    requireNotNull(this.scheduler.mutex, ERROR_LIBRARY_FAILURE, "Could not create scheduler mutex");
+    for (uint i = 0; i < CAPTURE_SCHEDULER_MAX_REQUESTS; i++) {
+        this.scheduler.grantSemaphores[i] = xSemaphoreCreateBinary();
+        requireNotNull(this.scheduler.grantSemaphores[i], ERROR_LIBRARY_FAILURE, "Could not create grant semaphore");
+    }
+    this.scheduler.captureScheduler = captureScheduler_create();
+    requireNotNull(this.scheduler.captureScheduler, ERROR_LIBRARY_FAILURE, "Could not create capture scheduler");
+    this.task.demandMutex = xSemaphoreCreateMutex();
+    requireNotNull(this.task.demandMutex, ERROR_LIBRARY_FAILURE, "Could not create live demand mutex");
+    this.task.wakeSemaphore = xSemaphoreCreateBinary();
+    requireNotNull(this.task.wakeSemaphore, ERROR_LIBRARY_FAILURE, "Could not create live capture wake semaphore");
+    this.task.liveDemand = liveDemand_create(CAMERA_LIVE_LINGER_MILLIS, esp_log_early_timestamp());
+    requireNotNull(this.task.liveDemand, ERROR_LIBRARY_FAILURE, "Could not create live demand");
     throwIfError(camera_start(), "");
 
     this.task.liveImageBufferLength = CAMERA_LIVE_IMAGE_BUFFER_SIZE;
     this.task.liveImageBuffer = alloc(this.task.liveImageBufferLength);
     this.task.delayMillis = 10;
+    this.task.mode = CAMERA_LIVE_CAPTURE_MODE_SERIAL;
     this.task.isRunning = true;
     this.task.isPaused = false;
     TaskInfo taskInfo = {
@@ -951,26 +2301,905 @@ public Error camera_init() {
     return ERROR_NONE;
 }
 
+public Error camera_pauseLiveCapture(bool pause) {
+    this.task.isPaused = pause;
+    if (pause && this.semaphoreHandle) { // wait for any in-flight frame to finish with the hardware
+        obtainMutex();
+        releaseMutex();
+    }
+    return ERROR_NONE;
+}
+
+public Error camera_setStandby(const bool standby) {
+    requireNotNull(this.semaphoreHandle, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_SETTINGS, 0, &request), "");
+    const Error err = camera_writeStandby(standby);
+    camera_endRequest(&request);
+    return err;
+}
+
+public bool camera_isStandby() {
+    return this.task.isStandby && !this.task.isIdleStandby;
+}
+
+public bool camera_isLiveCapturePaused() {
+    return this.task.isPaused;
+}
+
 public Error camera_destroy() {
     return ERROR_NONE;
 }
 
+public Error camera_setLiveCaptureMode(const CameraLiveCaptureMode liveCaptureMode) {
+    require(liveCaptureMode == CAMERA_LIVE_CAPTURE_MODE_SERIAL || liveCaptureMode == CAMERA_LIVE_CAPTURE_MODE_PIPELINED,
+            ERROR_ILLEGAL_ARGUMENT, "Unknown live capture mode: %i", liveCaptureMode);
+    this.task.mode = liveCaptureMode;
+    return ERROR_NONE;
+}
+
+private const char *const CAMERA_IMAGE_SIZE_NAMES[CAMERA_IMAGE_SIZE_COUNT] = {
+        "320x240", "640x480", "1024x768", "1280x960", "1600x1200", "2048x1536", "2592x1944"
+};
+
+private const char *const CAMERA_VIDEO_PROFILE_NAMES[CAMERA_VIDEO_PROFILE_COUNT] = {"none", "720p", "1080p"};
+
+private Error camera_writeVideoProfile(const CameraVideoProfile profile) {
+    require(profile >= 0 && profile < CAMERA_VIDEO_PROFILE_COUNT, ERROR_ILLEGAL_ARGUMENT,
+            "Unknown video profile: %i", profile);
+    requireNotNull(this.semaphoreHandle, ERROR_NOT_INITIALIZED, "Camera was not started");
+    if (profile == this.video.profile) return ERROR_NONE;
+    if (profile == CAMERA_VIDEO_PROFILE_NONE) return camera_start(); // the register image has the stills and settings
+    const uint32_t startMillis = esp_log_early_timestamp();
+    obtainMutex();
+    if (this.task.isStandby) { // the table's reset would wake the sensor behind standby's back
+        releaseMutex();
+        throw(ERROR_ILLEGAL_STATE, "Camera is in standby");
+    }
+    // the table resets the sensor, settings that don't fight the table's image size are written again after it
+    CameraSettings settings = this.settings;
+    settings.fields &= ~(CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_REGION |
+                         CAMERA_SETTINGS_FIELD_SENSOR_PROFILE);
+    Error err = camera_writeRegisterScript(CAMERA_VIDEO_PROFILE_NAMES[profile], CAMERA_VIDEO_PROFILE_SCRIPTS[profile]);
+    if (err == ERROR_NONE) err = writeRegisterScript(CAMERA_VIDEO_JPEG_SETTINGS);
+    this.settings = (CameraSettings) {.fields = 0}; // nothing is known about the sensor after a reset
+    this.video.profile = profile; // even a partly written table has replaced the stills, only a start puts them back
+    releaseMutex();
+    if (err == ERROR_NONE && settings.fields != 0) err = camera_writeSettings(&settings, NULL);
+    throwIfError(err, "Could not set video profile %s", CAMERA_VIDEO_PROFILE_NAMES[profile]);
+    INFO("Video profile %s set in %u ms", CAMERA_VIDEO_PROFILE_NAMES[profile], esp_log_early_timestamp() - startMillis);
+    return ERROR_NONE;
+}
+
+public Error camera_setVideoProfile(const CameraVideoProfile profile) {
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_SETTINGS, 0, &request), "");
+    const Error err = camera_writeVideoProfile(profile);
+    camera_endRequest(&request);
+    return err;
+}
+
+public CameraVideoProfile camera_getVideoProfile() {
+    return this.video.profile;
+}
+
+private Error camera_benchmarkLiveCaptureMode(const CameraLiveCaptureMode mode, const uint32_t frameCount,
+                                              CameraCaptureBenchmark *benchmark) {
+    benchmark->mode = mode;
+    benchmark->frameCount = 0;
+    benchmark->bytesRead = 0;
+    const uint32_t controlTransfersBefore = this.stats.controlTransfers;
+    const uint32_t startMillis = esp_log_early_timestamp();
+    while (benchmark->frameCount < frameCount) {
+        uint32_t bytesRead = 0;
+        const uint32_t framesCaptured = camera_liveCapture(&this, mode, &bytesRead);
+        benchmark->bytesRead += bytesRead;
+        if (framesCaptured == 0) {
+            throw(ERROR_ILLEGAL_STATE, "Live capture mode %i produced no frames", mode);
+        }
+        benchmark->frameCount += framesCaptured;
+    }
+    benchmark->elapsedMillis = esp_log_early_timestamp() - startMillis;
+    benchmark->fps = benchmark->elapsedMillis > 0 ?
+                     (1000.0F * (float) benchmark->frameCount) / (float) benchmark->elapsedMillis : 0.0F;
+    benchmark->controlTransfers = this.stats.controlTransfers - controlTransfersBefore;
+    return ERROR_NONE;
+}
+
+public Error camera_benchmarkLiveCapture(const uint32_t frameCount,
+                                         CameraCaptureBenchmark *serial, CameraCaptureBenchmark *pipelined) {
+    requireArgNotNull(serial);
+    requireArgNotNull(pipelined);
+    require(frameCount > 0, ERROR_ILLEGAL_ARGUMENT, "frameCount must be greater than 0");
+    requireNotNull(this.task.liveImageBuffer, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_BURST, 0, &request), "");
+    const bool wasPaused = this.task.isPaused;
+    camera_pauseLiveCapture(true);
+    Error err = camera_benchmarkLiveCaptureMode(CAMERA_LIVE_CAPTURE_MODE_SERIAL, frameCount, serial);
+    if (err == ERROR_NONE) {
+        err = camera_benchmarkLiveCaptureMode(CAMERA_LIVE_CAPTURE_MODE_PIPELINED, frameCount, pipelined);
+    }
+    camera_pauseLiveCapture(wasPaused);
+    camera_endRequest(&request);
+    if (err != ERROR_NONE) return err;
+    INFO("serial: %u frames in %u ms, fps: %.2f, pipelined: %u frames in %u ms, fps: %.2f",
+         serial->frameCount, serial->elapsedMillis, serial->fps,
+         pipelined->frameCount, pipelined->elapsedMillis, pipelined->fps);
+    return ERROR_NONE;
+}
+
+/** SPI clocks camera_calibrateSPIClock() steps through, each divides the 80 MHz APB clock evenly */
+private const uint32_t CAMERA_SPI_CLOCKS_HZ[] = {
+        SPI_MASTER_FREQ_HZ, 10000000, 80000000 / 6, 16000000, 20000000, 80000000 / 3, 40000000
+};
+#define CAMERA_SPI_CLOCK_COUNT (sizeof(CAMERA_SPI_CLOCKS_HZ) / sizeof(CAMERA_SPI_CLOCKS_HZ[0]))
+
+/** Written to the test register and read back, every bit both ways and alternating neighbours */
+private const uint8_t CAMERA_SPI_CLOCK_TEST_PATTERNS[] = {0x00, 0xFF, 0x55, 0xAA, 0x69};
+#define CAMERA_SPI_CLOCK_TEST_ROUNDS 8
+
+/** Write and read back every test pattern at the current clock */
+private bool camera_testSPIClockRegister() {
+    obtainMutex();
+    bool isOk = true;
+    for (uint round = 0; round < CAMERA_SPI_CLOCK_TEST_ROUNDS && isOk; round++) {
+        for (uint i = 0; i < sizeof(CAMERA_SPI_CLOCK_TEST_PATTERNS) && isOk; i++) {
+            uint8_t value = ~CAMERA_SPI_CLOCK_TEST_PATTERNS[i];
+            camera_setTestRegister(CAMERA_SPI_CLOCK_TEST_PATTERNS[i]);
+            camera_getTestRegister(&value);
+            isOk = value == CAMERA_SPI_CLOCK_TEST_PATTERNS[i];
+        }
+    }
+    releaseMutex();
+    return isOk;
+}
+
+/** Read the frame captured into the FIFO out through the frame reader into the live image buffer and throw it away,
+ * checksumming it into checksum when it isn't NULL, must hold the mutex
+ * @return the FIFO bytes read */
+private uint32_t camera_readOutFrame(const uint32_t imageSize, CameraFrameCursor *cursor, uint32_t *checksum) {
+    frameReader_open(this.reader.frameReader, imageSize, cursor);
+    while (!cursor->isComplete && !cursor->isFailed) {
+        size_t bytesRead = 0;
+        frameReader_read(this.reader.frameReader, cursor, this.task.liveImageBuffer, this.task.liveImageBufferLength,
+                         &bytesRead);
+        if (checksum) *checksum = spiClock_checksum(*checksum, this.task.liveImageBuffer, bytesRead);
+    }
+    return cursor->fifoBytes - frameReader_close(this.reader.frameReader, cursor);
+}
+
+/** Capture the test bar and read it out of the FIFO CAMERA_SPI_CLOCK_TEST_FRAMES times at the current clock, a frame
+ * not read from its SOI to its EOI fails the step, a failed capture is returned */
+private Error camera_testSPIClockFrames(CameraSPIClockStep *step, uint32_t checksums[CAMERA_SPI_CLOCK_TEST_FRAMES]) {
+    step->isFrameOk = true;
+    uint32_t fifoBytesRead = 0;
+    int64_t readoutMicros = 0;
+    for (uint frame = 0; frame < CAMERA_SPI_CLOCK_TEST_FRAMES; frame++) {
+        uint32_t imageSize = 0;
+        throwIfError(camera_captureStillImage(&imageSize), "");
+        obtainMutex();
+        const int64_t startMicros = esp_timer_get_time();
+        CameraFrameCursor cursor;
+        checksums[frame] = SPI_CLOCK_CHECKSUM_SEED;
+        fifoBytesRead += camera_readOutFrame(imageSize, &cursor, &checksums[frame]);
+        readoutMicros += esp_timer_get_time() - startMicros;
+        releaseMutex();
+        step->isFrameOk = step->isFrameOk && cursor.isComplete;
+        step->frameBytes = cursor.bytesRead;
+    }
+    step->readoutMBps = readoutMicros > 0 ? (float) fifoBytesRead / (float) readoutMicros : 0;
+    return ERROR_NONE;
+}
+
+/** Steps through the clocks until one fails, the test bar must be showing, must hold a request for the camera */
+private Error camera_stepSPIClocks(CameraSPIClockCalibration *calibration) {
+    uint32_t referenceChecksum = 0;
+    for (uint i = 0; i < CAMERA_SPI_CLOCK_COUNT && i < CAMERA_SPI_CLOCK_MAX_STEPS; i++) {
+        CameraSPIClockStep *step = &calibration->steps[i];
+        *step = (CameraSPIClockStep) {.clockHz = CAMERA_SPI_CLOCKS_HZ[i]};
+        calibration->stepCount++;
+        obtainMutex();
+        Error err = camera_setSPIClock(step->clockHz);
+        releaseMutex();
+        if (err != ERROR_NONE) return err;
+        step->isRegisterOk = camera_testSPIClockRegister();
+        // a garbled FIFO done flag could keep a capture waiting forever, so frames only follow a working register
+        uint32_t checksums[CAMERA_SPI_CLOCK_TEST_FRAMES] = {0};
+        if (step->isRegisterOk) throwIfError(camera_testSPIClockFrames(step, checksums), "");
+        if (i == 0) { // the JPEG encoder may not make the same bytes twice, then only SOI to EOI is checked
+            calibration->isTestBarStable = step->isFrameOk;
+            for (uint frame = 1; frame < CAMERA_SPI_CLOCK_TEST_FRAMES; frame++) {
+                calibration->isTestBarStable = calibration->isTestBarStable && checksums[frame] == checksums[0];
+            }
+            referenceChecksum = checksums[0];
+        } else if (calibration->isTestBarStable) {
+            for (uint frame = 0; frame < CAMERA_SPI_CLOCK_TEST_FRAMES; frame++) {
+                step->isFrameOk = step->isFrameOk && checksums[frame] == referenceChecksum;
+            }
+        }
+        INFO("SPI clock %u Hz: register %s, frames %s, %u bytes, %.2f MB/s", step->clockHz,
+             step->isRegisterOk ? "ok" : "failed", step->isFrameOk ? "ok" : "failed", step->frameBytes,
+             step->readoutMBps);
+        if (!spiClock_isStepOk(step)) break;
+    }
+    return ERROR_NONE;
+}
+
+public Error camera_calibrateSPIClock(CameraSPIClockCalibration *calibration) {
+    requireArgNotNull(calibration);
+    requireNotNull(this.task.liveImageBuffer, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    require(!camera_isStandby(), ERROR_ILLEGAL_STATE, "Camera is in standby");
+    *calibration = (CameraSPIClockCalibration) {0};
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_BURST, 0, &request), "");
+    const bool wasPaused = this.task.isPaused;
+    camera_pauseLiveCapture(true);
+    obtainMutex();
+    camera_showOV5642TestColorBar();
+    releaseMutex();
+    Error err = camera_stepSPIClocks(calibration);
+    if (err == ERROR_NONE) {
+        err = spiClock_choose(calibration->steps, calibration->stepCount, CAMERA_SPI_CLOCK_MARGIN_PERCENT,
+                              &calibration->fastestReliableHz, &calibration->clockHz);
+    }
+    if (err != ERROR_NONE) calibration->clockHz = SPI_MASTER_FREQ_HZ;
+    obtainMutex();
+    const Error setErr = camera_setSPIClock(calibration->clockHz);
+    camera_hideOV5642TestColorBar();
+    releaseMutex();
+    camera_forgetSharedCapture(); // the FIFO is left holding the test bar
+    camera_pauseLiveCapture(wasPaused);
+    camera_endRequest(&request);
+    if (err == ERROR_NOT_FOUND) {
+        throw(ERROR_ILLEGAL_STATE, "SPI failed even at %u Hz", SPI_MASTER_FREQ_HZ);
+    }
+    if (err != ERROR_NONE) return err;
+    throwIfError(setErr, "");
+    if (settings_putUInt32(SETTINGS_KEY_CAMERA_SPI_CLOCK, calibration->clockHz) != SETTINGS_ERROR_NONE) {
+        WARN("Could not store SPI clock of %u Hz", calibration->clockHz);
+    }
+    INFO("SPI clock: %u Hz, fastest reliable: %u Hz, test bar %s", calibration->clockHz,
+         calibration->fastestReliableHz, calibration->isTestBarStable ? "stable" : "not stable");
+    return ERROR_NONE;
+}
+
+public uint32_t camera_getSPIClock() {
+    return this.spiClockHz;
+}
+
+/** One run of camera_benchmarkVideo(), recording to context when it has a callback */
+private Error camera_benchmarkVideoRun(const CameraLiveCaptureMode mode, const uint32_t frameCount,
+                                       CameraBurstContext *context, CameraCaptureBenchmark *benchmark) {
+    obtainMutex();
+    if (context->burstCallback) {
+        context->startMicros = esp_timer_get_time();
+        this.video.recordContext = context;
+        this.video.recordFrameCount = context->burst->frameCount + frameCount;
+    }
+    releaseMutex();
+    const Error err = camera_benchmarkLiveCaptureMode(mode, frameCount, benchmark);
+    obtainMutex();
+    this.video.recordContext = NULL;
+    releaseMutex();
+    return err;
+}
+
+public Error camera_benchmarkVideo(const CameraVideoProfile profile, const uint32_t frameCount,
+                                   CameraBurstCallback recordCallback, void *userArg, CameraVideoBenchmark *benchmark) {
+    requireArgNotNull(benchmark);
+    require(profile > CAMERA_VIDEO_PROFILE_NONE && profile < CAMERA_VIDEO_PROFILE_COUNT, ERROR_ILLEGAL_ARGUMENT,
+            "Unknown video profile: %i", profile);
+    // a recording's frames are indexed across both runs so the files of one run don't overwrite the other's
+    const uint32_t maxFrameCount = recordCallback ? CAMERA_BURST_MAX_FRAMES / 2 : CAMERA_VIDEO_BENCHMARK_MAX_FRAMES;
+    require(frameCount > 0 && frameCount <= maxFrameCount, ERROR_OUT_OF_BOUNDS,
+            "frameCount must be between 1 and %u, was %u", maxFrameCount, frameCount);
+    requireNotNull(this.task.liveImageBuffer, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    require(!camera_isStandby(), ERROR_ILLEGAL_STATE, "Camera is in standby");
+    *benchmark = (CameraVideoBenchmark) {
+            .profile = profile,
+            .stillImageSize = CAMERA_VIDEO_PROFILE_STILL_IMAGE_SIZES[profile],
+            .isRecording = recordCallback != NULL
+    };
+    CameraBurstContext context = {.burstCallback = recordCallback, .userArg = userArg, .burst = NULL};
+    if (recordCallback) {
+        context.burst = new(CameraBurst);
+        requireNotNull(context.burst, ERROR_LIBRARY_FAILURE, "Could not allocate recording");
+    }
+    CameraRequest request;
+    Error err = camera_beginRequest(CAMERA_REQUEST_CLASS_BURST, 0, &request);
+    if (err != ERROR_NONE) {
+        delete(context.burst);
+        return err;
+    }
+    const CameraVideoProfile previousProfile = this.video.profile;
+    const bool wasPaused = this.task.isPaused;
+    camera_pauseLiveCapture(true);
+    err = camera_setVideoProfile(CAMERA_VIDEO_PROFILE_NONE);
+    const CameraSettings stillSettings = {
+            .fields = CAMERA_SETTINGS_FIELD_IMAGE_SIZE,
+            .imageSize = benchmark->stillImageSize
+    };
+    if (err == ERROR_NONE) err = camera_writeSettings(&stillSettings, NULL);
+    if (err == ERROR_NONE) {
+        err = camera_benchmarkVideoRun(CAMERA_LIVE_CAPTURE_MODE_SERIAL, frameCount, &context, &benchmark->still);
+    }
+    if (err == ERROR_NONE) err = camera_setVideoProfile(profile);
+    if (err == ERROR_NONE) {
+        err = camera_benchmarkVideoRun(CAMERA_LIVE_CAPTURE_MODE_VIDEO, frameCount, &context, &benchmark->video);
+    }
+    // a start also puts back the image size the still run changed, it was never stored
+    const Error restoreErr = previousProfile == CAMERA_VIDEO_PROFILE_NONE ?
+                             camera_start() : camera_setVideoProfile(previousProfile);
+    camera_pauseLiveCapture(wasPaused);
+    camera_endRequest(&request);
+    delete(context.burst);
+    if (err != ERROR_NONE) return err;
+    INFO("%s, still %s: %u frames in %u ms, fps: %.2f, %u control transfers, "
+         "video: %u frames in %u ms, fps: %.2f, %u control transfers",
+         CAMERA_VIDEO_PROFILE_NAMES[profile], CAMERA_IMAGE_SIZE_NAMES[benchmark->stillImageSize],
+         benchmark->still.frameCount, benchmark->still.elapsedMillis, benchmark->still.fps,
+         benchmark->still.controlTransfers, benchmark->video.frameCount, benchmark->video.elapsedMillis,
+         benchmark->video.fps, benchmark->video.controlTransfers);
+    return restoreErr;
+}
+
+/** Triggers frameCount frames and reads them out of the FIFO as they are written, the same way as a pipelined live
+ * capture, must hold the mutex
+ * @return the number of frames completed */
+private uint32_t camera_captureBurstTrigger(typeof(this) *thisPtr, const uint8_t frameCount,
+                                            CameraBurstContext *context) {
+    uint8_t *buffer = thisPtr->task.liveImageBuffer;
+    const uint32_t bufferLength = (uint32_t) thisPtr->task.liveImageBufferLength;
+    uint32_t bytesWritten = 0;
+    uint32_t bytesRead = 0;
+    uint32_t framesCompleted = 0;
+    bool isDone = false;
+    camera_triggerFrames(frameCount);
+    while (true) {
+        camera_getFIFOWriteDoneFlag(&isDone);
+        camera_getWriteFIFOSize(&bytesWritten);
+        const uint32_t bytesAvailable = bytesWritten > bytesRead ? bytesWritten - bytesRead : 0;
+        if (bytesAvailable >= bufferLength || (isDone && bytesAvailable > 0)) {
+            const uint32_t bytesToRead = bytesAvailable > bufferLength ? bufferLength : bytesAvailable;
+            camera_burstFIFORead(buffer, (int) bytesToRead);
+            bytesRead += bytesToRead;
+            framesCompleted += jpegScanner_scan(thisPtr->frames.jpegScanner, buffer, bytesToRead,
+                                                camera_burstJPEGSegmentCallback, context);
+            if (framesCompleted >= frameCount) { // the rest is padding, skip reading it
+                camera_waitForFIFODone();
+                camera_getWriteFIFOSize(&bytesWritten);
+                thisPtr->frames.fifoBytesNotRead += bytesWritten - bytesRead;
+                break;
+            }
+        } else if (isDone) {
+            break;
+        }
+    }
+    jpegScanner_finish(thisPtr->frames.jpegScanner, camera_burstJPEGSegmentCallback, context);
+    camera_setFramesToCapture(1);
+    return framesCompleted;
+}
+
+public Error camera_captureBurst(const uint32_t frameCount, const uint32_t intervalMillis,
+                                 CameraBurstCallback burstCallback, void *userArg, CameraBurst *burst) {
+    requireArgNotNull(burst);
+    require(frameCount > 0 && frameCount <= CAMERA_BURST_MAX_FRAMES, ERROR_OUT_OF_BOUNDS,
+            "frameCount must be between 1 and %u, was %u", CAMERA_BURST_MAX_FRAMES, frameCount);
+    requireNotNull(this.task.liveImageBuffer, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    require(!camera_isStandby(), ERROR_ILLEGAL_STATE, "Camera is in standby");
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_BURST, 0, &request), "");
+    *burst = (CameraBurst) {.frameCount = 0};
+    CameraBurstContext context = {
+            .burstCallback = burstCallback,
+            .userArg = userArg,
+            .burst = burst,
+            .startMicros = esp_timer_get_time()
+    };
+    const bool wasPaused = this.task.isPaused;
+    camera_pauseLiveCapture(true);
+    Error err = ERROR_NONE;
+    while (burst->frameCount < frameCount) {
+        const uint32_t framesRemaining = frameCount - burst->frameCount;
+        uint8_t framesToTrigger = framesRemaining > CAMERA_BURST_MAX_FRAMES_PER_TRIGGER ?
+                                  CAMERA_BURST_MAX_FRAMES_PER_TRIGGER : framesRemaining;
+        if (intervalMillis > 0) { // the ArduChip can't space the frames of one trigger, so each is its own trigger
+            framesToTrigger = 1;
+            const int64_t dueMicros = context.startMicros + ((int64_t) burst->triggerCount * intervalMillis * 1000);
+            const int64_t waitMicros = dueMicros - esp_timer_get_time();
+            if (waitMicros > 0) delayMillis((uint32_t) (waitMicros / 1000));
+        }
+        obtainMutex();
+        const uint32_t framesCompleted = camera_captureBurstTrigger(&this, framesToTrigger, &context);
+        releaseMutex();
+        burst->triggerCount++;
+        if (framesCompleted == 0) {
+            err = ERROR_ILLEGAL_STATE;
+            ERROR("Burst trigger %u produced no frames", burst->triggerCount);
+            break;
+        }
+    }
+    camera_pauseLiveCapture(wasPaused);
+    camera_endRequest(&request);
+    const int64_t elapsedMicros = esp_timer_get_time() - context.startMicros;
+    burst->elapsedMillis = (uint32_t) (elapsedMicros / 1000);
+    burst->fps = elapsedMicros > 0 ? (1000000.0F * (float) burst->frameCount) / (float) elapsedMicros : 0.0F;
+    INFO("Burst of %u frames (%u dropped) from %u triggers in %u ms, fps: %.2f", burst->frameCount,
+         burst->framesDropped, burst->triggerCount, burst->elapsedMillis, burst->fps);
+    return err;
+}
+
+/** Time script written with shadow (NULL to write every register) and report the registers it has */
+private Error camera_timeRegisterScript(const OV5642RegisterEntry *entries, RegisterShadow *shadow,
+                                        uint32_t *registerCount, uint32_t *micros) {
+    RegisterScriptStats stats;
+    const int64_t startMicros = esp_timer_get_time();
+    const Error err = registerScript_run(&CAMERA_REGISTER_SCRIPT_WRITER, shadow, entries, &stats);
+    *micros = (uint32_t) (esp_timer_get_time() - startMicros);
+    *registerCount = stats.entryCount;
+    return err;
+}
+
+public Error camera_benchmarkImageSizeSwitch(CameraImageSizeSwitchBenchmark *results) {
+    requireArgNotNull(results);
+    requireNotNull(this.registerShadow, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_BURST, 0, &request), "");
+    const bool wasPaused = this.task.isPaused;
+    camera_pauseLiveCapture(true);
+    obtainMutex();
+    const CameraSettings originalSettings = this.settings;
+    Error err = ERROR_NONE;
+    for (CameraImageSize from = 0; from < CAMERA_IMAGE_SIZE_COUNT && err == ERROR_NONE; from++) {
+        for (CameraImageSize to = 0; to < CAMERA_IMAGE_SIZE_COUNT && err == ERROR_NONE; to++) {
+            CameraImageSizeSwitchBenchmark *result = &results[(from * CAMERA_IMAGE_SIZE_COUNT) + to];
+            *result = (CameraImageSizeSwitchBenchmark) {.from = from, .to = to};
+            // the old way, the whole table with no shadow, the shadow is stale after so start over without it
+            if ((err = camera_runRegisterScript(CAMERA_IMAGE_SIZE_SCRIPTS[from], NULL))) break;
+            if ((err = camera_timeRegisterScript(CAMERA_IMAGE_SIZE_SCRIPTS[to], NULL,
+                                                 &result->fullRegisterCount, &result->fullMicros))) break;
+            registerShadow_clear(this.registerShadow);
+            if ((err = camera_runRegisterScript(CAMERA_IMAGE_SIZE_SCRIPTS[from], NULL))) break;
+            this.settings.fields |= CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_SENSOR_PROFILE;
+            this.settings.imageSize = from;
+            this.settings.sensorProfile = CAMERA_SENSOR_PROFILE_STILL;
+            if ((err = camera_timeRegisterScript(camera_imageSizeScript(CAMERA_SENSOR_PROFILE_STILL, to),
+                                                 this.registerShadow, &result->deltaRegisterCount,
+                                                 &result->deltaMicros))) break;
+            this.settings.imageSize = to;
+            INFO("%s -> %s: full: %u registers in %u us, delta: %u registers in %u us",
+                 CAMERA_IMAGE_SIZE_NAMES[from], CAMERA_IMAGE_SIZE_NAMES[to],
+                 result->fullRegisterCount, result->fullMicros, result->deltaRegisterCount, result->deltaMicros);
+        }
+    }
+    // the sensor is left at the last size benchmarked, put the original size and tuning back from there
+    this.settings.fields = err == ERROR_NONE ? CAMERA_SETTINGS_FIELD_IMAGE_SIZE : 0;
+    releaseMutex();
+    if (err == ERROR_NONE) {
+        err = camera_writeSettings(&originalSettings, NULL);
+    }
+    camera_pauseLiveCapture(wasPaused);
+    camera_endRequest(&request);
+    return err;
+}
+
+private const char *const CAMERA_SENSOR_PROFILE_NAMES[CAMERA_SENSOR_PROFILE_COUNT] = {"still", "streaming"};
+
+/** Capture and read out frameCount frames at the current settings, after CAMERA_SENSOR_PROFILE_WARM_UP_FRAMES that
+ * are not counted, must hold a request for the camera */
+private Error camera_benchmarkSensorProfile(const uint32_t frameCount, CameraSensorProfileBenchmark *result) {
+    int64_t captureMicros = 0;
+    uint64_t fifoBytes = 0;
+    int64_t startMicros = esp_timer_get_time();
+    for (uint32_t frame = 0; frame < CAMERA_SENSOR_PROFILE_WARM_UP_FRAMES + frameCount; frame++) {
+        if (frame == CAMERA_SENSOR_PROFILE_WARM_UP_FRAMES) startMicros = esp_timer_get_time();
+        const int64_t captureStartMicros = esp_timer_get_time();
+        uint32_t imageSize = 0;
+        throwIfError(camera_captureStillImage(&imageSize), "");
+        const int64_t captureEndMicros = esp_timer_get_time();
+        obtainMutex();
+        CameraFrameCursor cursor;
+        camera_readOutFrame(imageSize, &cursor, NULL);
+        releaseMutex();
+        if (frame < CAMERA_SENSOR_PROFILE_WARM_UP_FRAMES) continue;
+        if (!cursor.isComplete) WARN("Frame %u ended without EOI after %u bytes", frame, cursor.bytesRead);
+        captureMicros += captureEndMicros - captureStartMicros;
+        fifoBytes += imageSize;
+    }
+    const int64_t elapsedMicros = esp_timer_get_time() - startMicros;
+    result->frameCount = frameCount;
+    result->captureMillis = (float) captureMicros / 1000.0F / (float) frameCount;
+    result->fifoBytes = (uint32_t) (fifoBytes / frameCount);
+    result->fps = elapsedMicros > 0 ? (1000000.0F * (float) frameCount) / (float) elapsedMicros : 0.0F;
+    return ERROR_NONE;
+}
+
+public Error camera_benchmarkSensorProfiles(const uint32_t frameCount, CameraSensorProfileBenchmark *results) {
+    requireArgNotNull(results);
+    require(frameCount > 0 && frameCount <= CAMERA_SENSOR_PROFILE_BENCHMARK_MAX_FRAMES, ERROR_OUT_OF_BOUNDS,
+            "frameCount must be between 1 and %u, was %u", CAMERA_SENSOR_PROFILE_BENCHMARK_MAX_FRAMES, frameCount);
+    requireNotNull(this.task.liveImageBuffer, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    require(!camera_isStandby(), ERROR_ILLEGAL_STATE, "Camera is in standby");
+    require(this.video.profile == CAMERA_VIDEO_PROFILE_NONE, ERROR_ILLEGAL_STATE,
+            "Sensor profiles are replaced by video profile %i", this.video.profile);
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_BURST, 0, &request), "");
+    const bool wasPaused = this.task.isPaused;
+    camera_pauseLiveCapture(true);
+    obtainMutex();
+    CameraSettings originalSettings = this.settings;
+    releaseMutex();
+    // a region only goes back with the still profile, which is what an unknown profile is written as
+    if (!(originalSettings.fields & CAMERA_SETTINGS_FIELD_SENSOR_PROFILE)) {
+        originalSettings.fields |= CAMERA_SETTINGS_FIELD_SENSOR_PROFILE;
+        originalSettings.sensorProfile = CAMERA_SENSOR_PROFILE_STILL;
+    }
+    Error err = ERROR_NONE;
+    for (CameraSensorProfile profile = 0; profile < CAMERA_SENSOR_PROFILE_COUNT && err == ERROR_NONE; profile++) {
+        for (CameraImageSize imageSize = 0; imageSize < CAMERA_IMAGE_SIZE_COUNT && err == ERROR_NONE; imageSize++) {
+            CameraSensorProfileBenchmark *result = &results[(profile * CAMERA_IMAGE_SIZE_COUNT) + imageSize];
+            *result = (CameraSensorProfileBenchmark) {.profile = profile, .imageSize = imageSize};
+            const CameraSettings settings = {
+                    .fields = CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_SENSOR_PROFILE,
+                    .imageSize = imageSize,
+                    .sensorProfile = profile
+            };
+            err = camera_writeSettings(&settings, NULL);
+            if (err == ERROR_NONE) err = camera_benchmarkSensorProfile(frameCount, result);
+            if (err == ERROR_NONE) {
+                INFO("%s %s: %u frames, capture: %.1f ms, FIFO: %u bytes, fps: %.2f",
+                     CAMERA_SENSOR_PROFILE_NAMES[profile], CAMERA_IMAGE_SIZE_NAMES[imageSize], result->frameCount,
+                     result->captureMillis, result->fifoBytes, result->fps);
+            }
+        }
+    }
+    const Error restoreErr = camera_writeSettings(&originalSettings, NULL);
+    camera_forgetSharedCapture(); // the FIFO is left holding the last frame benchmarked
+    camera_pauseLiveCapture(wasPaused);
+    camera_endRequest(&request);
+    if (err != ERROR_NONE) return err;
+    return restoreErr;
+}
+
+public Error camera_getFrameStats(CameraFrameStats *frameStats) {
+    requireArgNotNull(frameStats);
+    requireNotNull(this.frames.jpegScanner, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    JPEGScannerStats jpegScannerStats;
+    obtainMutex();
+    jpegScanner_getStats(this.frames.jpegScanner, &jpegScannerStats);
+    frameStats->fifoBytesNotRead = this.frames.fifoBytesNotRead;
+    releaseMutex();
+    frameStats->framesCompleted = jpegScannerStats.framesCompleted;
+    frameStats->framesDropped = jpegScannerStats.framesDropped;
+    frameStats->lastFrameBytes = jpegScannerStats.lastFrameBytes;
+    frameStats->largestFrameBytes = jpegScannerStats.largestFrameBytes;
+    frameStats->fifoBytesSkipped = jpegScannerStats.bytesSkipped;
+    return ERROR_NONE;
+}
+
+public Error camera_getCaptureStats(CameraCaptureStats *captureStats) {
+    requireArgNotNull(captureStats);
+    requireNotNull(this.stats.frameBytes, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    histogram_getSummary(this.stats.captureMicros, &captureStats->captureMicros);
+    histogram_getSummary(this.stats.readoutMicros, &captureStats->readoutMicros);
+    histogram_getSummary(this.stats.chunkMicros, &captureStats->chunkMicros);
+    histogram_getSummary(this.stats.frameMicros, &captureStats->frameMicros);
+    histogram_getSummary(this.stats.frameBytes, &captureStats->frameBytes);
+    captureStats->framesCompleted = this.stats.framesCompleted;
+    captureStats->framesDropped = this.stats.framesDropped;
+    captureStats->elapsedMillis = esp_log_early_timestamp() - this.stats.sinceMillis;
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public Error camera_resetCaptureStats() {
+    requireNotNull(this.stats.frameBytes, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    histogram_reset(this.stats.captureMicros);
+    histogram_reset(this.stats.readoutMicros);
+    histogram_reset(this.stats.chunkMicros);
+    histogram_reset(this.stats.frameMicros);
+    histogram_reset(this.stats.frameBytes);
+    this.stats.framesCompleted = 0;
+    this.stats.framesDropped = 0;
+    this.stats.sinceMillis = esp_log_early_timestamp();
+    releaseMutex();
+    obtainSchedulerMutex();
+    captureScheduler_resetStats(this.scheduler.captureScheduler);
+    releaseSchedulerMutex();
+    xSemaphoreTake(this.task.demandMutex, portMAX_DELAY);
+    liveDemand_resetStats(this.task.liveDemand, esp_log_early_timestamp());
+    xSemaphoreGive(this.task.demandMutex);
+    return ERROR_NONE;
+}
+
+public Error camera_getSchedulerStats(CameraSchedulerStats *schedulerStats) {
+    requireArgNotNull(schedulerStats);
+    requireNotNull(this.scheduler.captureScheduler, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainSchedulerMutex();
+    captureScheduler_getStats(this.scheduler.captureScheduler, schedulerStats);
+    releaseSchedulerMutex();
+    return ERROR_NONE;
+}
+
+public Error camera_getStartStats(CameraStartStats *startStats) {
+    requireArgNotNull(startStats);
+    requireNotNull(this.semaphoreHandle, ERROR_NOT_INITIALIZED, "Camera was not started");
+    obtainMutex();
+    *startStats = this.start.stats;
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public Error camera_forEachKnownRegister(CameraRegisterCallback registerCallback, void *userArg) {
+    requireArgNotNull(registerCallback);
+    requireNotNull(this.registerShadow, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    registerShadow_forEach(this.registerShadow, registerCallback, userArg);
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public Error camera_subscribeLiveCapture() {
+    requireNotNull(this.task.liveDemand, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    xSemaphoreTake(this.task.demandMutex, portMAX_DELAY);
+    const bool isStarted = liveDemand_subscribe(this.task.liveDemand, esp_log_early_timestamp());
+    xSemaphoreGive(this.task.demandMutex);
+    if (isStarted) xSemaphoreGive(this.task.wakeSemaphore);
+    return ERROR_NONE;
+}
+
+public Error camera_unsubscribeLiveCapture() {
+    requireNotNull(this.task.liveDemand, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    xSemaphoreTake(this.task.demandMutex, portMAX_DELAY);
+    const Error err = liveDemand_unsubscribe(this.task.liveDemand, esp_log_early_timestamp());
+    xSemaphoreGive(this.task.demandMutex);
+    require(err == ERROR_NONE, err, "Live capture has no subscribers");
+    return ERROR_NONE;
+}
+
+public Error camera_getLiveDemandStats(CameraLiveDemandStats *liveDemandStats) {
+    requireArgNotNull(liveDemandStats);
+    requireNotNull(this.task.liveDemand, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    xSemaphoreTake(this.task.demandMutex, portMAX_DELAY);
+    liveDemand_getStats(this.task.liveDemand, esp_log_early_timestamp(), liveDemandStats);
+    xSemaphoreGive(this.task.demandMutex);
+    return ERROR_NONE;
+}
+
 public Error camera_setCameraLiveCaptureCallback(CameraLiveCaptureCallback cameraLiveCaptureCallback) {
     this.task.liveCaptureCallback = cameraLiveCaptureCallback;
     return ERROR_NONE;
 }
 
+public Error camera_setLiveFrameCallback(CameraLiveFrameCallback liveFrameCallback) {
+    this.pool.liveFrameCallback = liveFrameCallback;
+    return ERROR_NONE;
+}
+
+public Error camera_acquireFrame(const uint32_t maxAgeMillis, CameraFrame **frame) {
+    requireArgNotNull(frame);
+    requireNotNull(this.pool.latestMutex, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    *frame = camera_retainLatestFrame(&this, maxAgeMillis, 0);
+    if (*frame) return ERROR_NONE;
+    // too old or none yet, capture a new one which every other reader gets to share too
+    const uint32_t sequenceBefore = this.pool.sequence;
+    CameraRequest request;
+    throwIfError(camera_beginRequest(CAMERA_REQUEST_CLASS_STILL, 0, &request), "");
+    // a frame captured while the request waited, live or for another reader, is as new as one captured now
+    *frame = camera_retainLatestFrame(&this, UINT32_MAX, sequenceBefore);
+    request.isCoalesced = *frame != NULL;
+    if (!request.isCoalesced) {
+        camera_liveCaptureSerial(&this, NULL);
+        camera_forgetSharedCapture();
+        *frame = camera_retainLatestFrame(&this, UINT32_MAX, sequenceBefore);
+    }
+    camera_endRequest(&request);
+    requireNotNull(*frame, ERROR_ILLEGAL_STATE, "Could not capture a frame into the frame pool");
+    return ERROR_NONE;
+}
+
+public CameraFrame *camera_retainFrame(CameraFrame *frame) {
+    return framePool_retain(frame);
+}
+
+public Error camera_releaseFrame(CameraFrame *frame) {
+    requireArgNotNull(frame);
+    framePool_release(frame);
+    return ERROR_NONE;
+}
+
+public Error camera_getFramePoolStats(CameraFramePoolStats *framePoolStats) {
+    requireArgNotNull(framePoolStats);
+    obtainMutex(); // the pool is only recreated while the mutex is held
+    const Error err = framePool_getStats(this.pool.framePool, framePoolStats);
+    framePoolStats->framesTooLarge = this.pool.framesTooLarge;
+    releaseMutex();
+    require(err == ERROR_NONE, ERROR_ILLEGAL_STATE, "There is no frame pool at the current image size");
+    return ERROR_NONE;
+}
+
+public Error camera_addFrameConsumer(uint32_t *consumer) {
+    requireArgNotNull(consumer);
+    requireNotNull(this.broker.frameBroker, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    SemaphoreHandle_t frameSemaphore = xSemaphoreCreateBinary();
+    requireNotNull(frameSemaphore, ERROR_LIBRARY_FAILURE, "Could not create frame consumer semaphore");
+    obtainMutex(); // frames are only published while the mutex is held
+    uint brokerConsumer = 0;
+    const Error err = frameBroker_addConsumer(this.broker.frameBroker, &brokerConsumer);
+    if (err == ERROR_NONE) {
+        this.broker.frameSemaphores[brokerConsumer] = frameSemaphore;
+        this.broker.consumerCount = brokerConsumer + 1;
+    }
+    releaseMutex();
+    if (err != ERROR_NONE) {
+        vSemaphoreDelete(frameSemaphore);
+        throw(err, "Could not add frame consumer, there are already %u", FRAME_BROKER_MAX_CONSUMERS);
+    }
+    *consumer = brokerConsumer;
+    return ERROR_NONE;
+}
+
+public Error camera_takeFrame(const uint32_t consumer, const uint32_t timeoutMillis, CameraFrame **frame) {
+    requireArgNotNull(frame);
+    require(consumer < this.broker.consumerCount, ERROR_ILLEGAL_ARGUMENT, "Unknown frame consumer: %u", consumer);
+    const TickType_t timeoutTicks = pdMS_TO_TICKS(timeoutMillis);
+    const TickType_t startTicks = xTaskGetTickCount();
+    while (!frameBroker_take(this.broker.frameBroker, consumer, frame)) {
+        const TickType_t elapsedTicks = xTaskGetTickCount() - startTicks;
+        if (elapsedTicks >= timeoutTicks ||
+            xSemaphoreTake(this.broker.frameSemaphores[consumer], timeoutTicks - elapsedTicks) != pdTRUE) {
+            return ERROR_NOT_FOUND;
+        }
+    }
+    return ERROR_NONE;
+}
+
+public Error camera_getFrameConsumerStats(const uint32_t consumer, CameraFrameConsumerStats *consumerStats) {
+    requireArgNotNull(consumerStats);
+    requireNotNull(this.broker.frameBroker, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    const Error err = frameBroker_getStats(this.broker.frameBroker, consumer, consumerStats);
+    require(err == ERROR_NONE, ERROR_ILLEGAL_ARGUMENT, "Unknown frame consumer: %u", consumer);
+    return ERROR_NONE;
+}
+
+public Error camera_setQualityTarget(const CameraQualityTarget *target) {
+    requireArgNotNull(target);
+    requireNotNull(this.quality.qualityController, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    const Error err = qualityController_setTarget(this.quality.qualityController, target);
+    releaseMutex();
+    require(err == ERROR_NONE, err, "Invalid quality target, mode: %i, value: %.2f", target->mode, target->value);
+    return ERROR_NONE;
+}
+
+public Error camera_getQualityTarget(CameraQualityTarget *target) {
+    requireArgNotNull(target);
+    requireNotNull(this.quality.qualityController, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    qualityController_getTarget(this.quality.qualityController, target);
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public Error camera_getQualityDecision(CameraQualityDecision *decision) {
+    requireArgNotNull(decision);
+    requireNotNull(this.quality.qualityController, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    qualityController_getDecision(this.quality.qualityController, decision);
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public Error camera_setMotionDetection(const CameraMotionOptions *options) {
+    requireArgNotNull(options);
+    requireNotNull(this.semaphoreHandle, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    if (!this.motion.motionDetector) {
+        this.motion.jpegDCDecoder = jpegDCDecoder_create();
+        this.motion.motionDetector = motionDetector_create();
+        this.motion.frameMicros = histogram_create();
+        if (!this.motion.jpegDCDecoder || !this.motion.motionDetector || !this.motion.frameMicros) {
+            jpegDCDecoder_destroy(this.motion.jpegDCDecoder);
+            motionDetector_destroy(this.motion.motionDetector);
+            histogram_destroy(this.motion.frameMicros);
+            this.motion.jpegDCDecoder = NULL;
+            this.motion.motionDetector = NULL;
+            this.motion.frameMicros = NULL;
+            releaseMutex();
+            throw(ERROR_LIBRARY_FAILURE, "Could not create motion detector");
+        }
+    }
+    const Error err = motionDetector_setOptions(this.motion.motionDetector, options);
+    const bool wasEnabled = this.motion.isEnabled;
+    if (err == ERROR_NONE) {
+        this.motion.isEnabled = options->isEnabled;
+        this.motion.isFrameBegun = false;
+        this.motion.result = (MotionDetectorResult) {.isMotion = false};
+    }
+    releaseMutex();
+    require(err == ERROR_NONE, err, "Invalid motion detection options");
+    if (options->isEnabled != wasEnabled) { // the detector needs live frames to compare, whoever else is watching
+        if (options->isEnabled) camera_subscribeLiveCapture();
+        else camera_unsubscribeLiveCapture();
+    }
+    return ERROR_NONE;
+}
+
+public Error camera_getMotionDetection(CameraMotionOptions *options) {
+    requireArgNotNull(options);
+    requireNotNull(this.semaphoreHandle, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    obtainMutex();
+    if (this.motion.motionDetector) {
+        motionDetector_getOptions(this.motion.motionDetector, options);
+    } else {
+        *options = (CameraMotionOptions) {
+                .isEnabled = false,
+                .threshold = MOTION_DETECTOR_DEFAULT_THRESHOLD,
+                .triggerPercent = MOTION_DETECTOR_DEFAULT_TRIGGER_PERCENT,
+                .backgroundShift = MOTION_DETECTOR_DEFAULT_BACKGROUND_SHIFT,
+                .quietFrames = MOTION_DETECTOR_DEFAULT_QUIET_FRAMES
+        };
+    }
+    options->isEnabled = this.motion.isEnabled;
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public Error camera_getMotionStats(CameraMotionStats *motionStats) {
+    requireArgNotNull(motionStats);
+    requireNotNull(this.semaphoreHandle, ERROR_NOT_INITIALIZED, "Camera was not initialized");
+    *motionStats = (CameraMotionStats) {.isEnabled = false};
+    obtainMutex();
+    motionStats->isEnabled = this.motion.isEnabled;
+    motionStats->isMotion = this.motion.result.isMotion;
+    motionStats->framesAnalysed = this.motion.framesAnalysed;
+    motionStats->framesFailed = this.motion.framesFailed;
+    motionStats->motionEvents = this.motion.motionEvents;
+    motionStats->score = this.motion.result.score;
+    memcpy(motionStats->zoneScores, this.motion.result.zoneScores, sizeof(motionStats->zoneScores));
+    if (this.motion.motionDetector) {
+        motionDetector_getMapSize(this.motion.motionDetector, &motionStats->mapWidth, &motionStats->mapHeight);
+        histogram_getSummary(this.motion.frameMicros, &motionStats->frameMicros);
+    }
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public void camera_addMotionCallback(CameraMotionCallback motionCallback) {
+    if (!this.motion.callbacksMutex) return;
+    xSemaphoreTake(this.motion.callbacksMutex, portMAX_DELAY);
+    list_addItem(this.motion.callbacks, motionCallback);
+    xSemaphoreGive(this.motion.callbacksMutex);
+}
+
+public void camera_removeMotionCallback(CameraMotionCallback motionCallback) {
+    if (!this.motion.callbacksMutex) return;
+    xSemaphoreTake(this.motion.callbacksMutex, portMAX_DELAY);
+    list_removeItem(this.motion.callbacks, motionCallback);
+    xSemaphoreGive(this.motion.callbacksMutex);
+}
+
+/** Reads the captured image out of the FIFO, only the bytes from SOI to EOI reach readCallback and reading stops
+ * at the EOI, so FIFO padding is neither read over SPI nor sent on */
 public Error camera_readImageBufferedWithCallback(char *buffer, const int bufferLength,
                                                   const uint32_t imageSize,
                                                   CameraReadCallback readCallback, void *userArg) {
+    requireArgNotNull(buffer);
+    requireArgNotNull(readCallback);
+    require(bufferLength > 0, ERROR_ILLEGAL_ARGUMENT, "bufferLength must be greater than 0");
+    requireNotNull(this.reader.frameReader, ERROR_NOT_INITIALIZED, "Camera was not initialized");
     obtainMutex();
-    for (int i = (int) imageSize; i >= 0;) {
-        const int bytesToRead = imageSize > bufferLength ? bufferLength : (int) imageSize;
-        camera_burstFIFORead((uint8_t *) buffer, bytesToRead);
-        readCallback(buffer, bytesToRead, userArg);
-        i -= bytesToRead;
+    if (this.reader.cursor) { // the reader is reading that frame
+        releaseMutex();
+        throw(ERROR_ILLEGAL_STATE, "A frame is open");
     }
-
+    CameraFrameCursor cursor;
+    frameReader_open(this.reader.frameReader, imageSize, &cursor);
+    const Error err = camera_readFrameWithCallback(&cursor, buffer, bufferLength, readCallback, userArg);
+    this.frames.fifoBytesNotRead += frameReader_close(this.reader.frameReader, &cursor);
     releaseMutex();
-    return ERROR_NONE;
-}
\ No newline at end of file
+    return err;
+}
@@ -0,0 +1,198 @@
+#include "CameraTuning.h"
+#include "Logger.h"
+#include <string.h>
+
+typedef struct CameraTuningTable {
+    const char *name;
+    int minLevel;
+    int maxLevel;
+    /** Distance between 2 valid levels, hue goes up in 30 degree steps */
+    int levelStep;
+    uint8_t registerCount;
+    /** Ascending order */
+    uint16_t addresses[CAMERA_TUNING_MAX_REGISTERS];
+    /** One row of registerCount values per level, from minLevel to maxLevel */
+    const uint8_t (*values)[CAMERA_TUNING_MAX_REGISTERS];
+} CameraTuningTable;
+
+/* Values below are from the Arducam OV5642 driver, reordered by register address */
+
+private const uint8_t SATURATION_VALUES[][CAMERA_TUNING_MAX_REGISTERS] = {
+        //0x5001 0x5580 0x5583 0x5584
+        {0xff, 0x02, 0x00, 0x00}, // -4
+        {0xff, 0x02, 0x10, 0x10}, // -3
+        {0xff, 0x02, 0x20, 0x20}, // -2
+        {0xff, 0x02, 0x30, 0x30}, // -1
+        {0xff, 0x02, 0x40, 0x40}, //  0
+        {0xff, 0x02, 0x50, 0x50}, //  1
+        {0xff, 0x02, 0x60, 0x60}, //  2
+        {0xff, 0x02, 0x70, 0x70}, //  3
+        {0xff, 0x02, 0x80, 0x80}, //  4
+};
+
+private const uint8_t BRIGHTNESS_VALUES[][CAMERA_TUNING_MAX_REGISTERS] = {
+        //0x5001 0x5580 0x5589 0x558a
+        {0xff, 0x04, 0x40, 0x08}, // -4
+        {0xff, 0x04, 0x30, 0x08}, // -3
+        {0xff, 0x04, 0x20, 0x08}, // -2
+        {0xff, 0x04, 0x10, 0x08}, // -1
+        {0xff, 0x04, 0x00, 0x00}, //  0
+        {0xff, 0x04, 0x10, 0x00}, //  1
+        {0xff, 0x04, 0x20, 0x00}, //  2
+        {0xff, 0x04, 0x30, 0x00}, //  3
+        {0xff, 0x04, 0x40, 0x00}, //  4
+};
+
+private const uint8_t CONTRAST_VALUES[][CAMERA_TUNING_MAX_REGISTERS] = {
+        //0x5001 0x5580 0x5587 0x5588 0x558a
+        {0xff, 0x04, 0x10, 0x10, 0x00}, // -4
+        {0xff, 0x04, 0x14, 0x14, 0x00}, // -3
+        {0xff, 0x04, 0x18, 0x18, 0x00}, // -2
+        {0xff, 0x04, 0x1c, 0x1c, 0x00}, // -1
+        {0xff, 0x04, 0x20, 0x20, 0x00}, //  0
+        {0xff, 0x04, 0x24, 0x24, 0x00}, //  1
+        {0xff, 0x04, 0x28, 0x28, 0x00}, //  2
+        {0xff, 0x04, 0x2c, 0x2c, 0x00}, //  3
+        {0xff, 0x04, 0x30, 0x30, 0x00}, //  4
+};
+
+private const uint8_t HUE_VALUES[][CAMERA_TUNING_MAX_REGISTERS] = {
+        //0x5001 0x5580 0x5581 0x5582 0x558a
+        {0xff, 0x01, 0x80, 0x00, 0x32}, // -180
+        {0xff, 0x01, 0x6f, 0x40, 0x32}, // -150
+        {0xff, 0x01, 0x40, 0x6f, 0x32}, // -120
+        {0xff, 0x01, 0x00, 0x80, 0x02}, // -90
+        {0xff, 0x01, 0x40, 0x6f, 0x02}, // -60
+        {0xff, 0x01, 0x6f, 0x40, 0x02}, // -30
+        {0xff, 0x01, 0x80, 0x00, 0x01}, //  0
+        {0xff, 0x01, 0x6f, 0x40, 0x01}, //  30
+        {0xff, 0x01, 0x40, 0x6f, 0x01}, //  60
+        {0xff, 0x01, 0x00, 0x80, 0x31}, //  90
+        {0xff, 0x01, 0x40, 0x6f, 0x31}, //  120
+        {0xff, 0x01, 0x6f, 0x40, 0x31}, //  150
+        {0xff, 0x01, 0x80, 0x00, 0x32}, //  180
+};
+
+private const uint8_t EXPOSURE_VALUES[][CAMERA_TUNING_MAX_REGISTERS] = {
+        //0x3a0f 0x3a10 0x3a11 0x3a1b 0x3a1e 0x3a1f
+        {0x10, 0x08, 0x20, 0x10, 0x08, 0x10}, // -5
+        {0x18, 0x10, 0x30, 0x18, 0x10, 0x10}, // -4
+        {0x20, 0x18, 0x41, 0x20, 0x18, 0x10}, // -3
+        {0x28, 0x20, 0x51, 0x28, 0x20, 0x10}, // -2
+        {0x30, 0x28, 0x61, 0x30, 0x28, 0x10}, // -1
+        {0x38, 0x30, 0x61, 0x38, 0x30, 0x10}, //  0
+        {0x40, 0x38, 0x71, 0x40, 0x38, 0x10}, //  1
+        {0x48, 0x40, 0x80, 0x48, 0x40, 0x20}, //  2
+        {0x50, 0x48, 0x90, 0x50, 0x48, 0x20}, //  3
+        {0x58, 0x50, 0x91, 0x58, 0x50, 0x20}, //  4
+        {0x60, 0x58, 0xa0, 0x60, 0x58, 0x20}, //  5
+};
+
+private const uint8_t IMAGE_QUALITY_VALUES[][CAMERA_TUNING_MAX_REGISTERS] = {
+        //0x4407
+        {0x08}, // CAMERA_IMAGE_QUALITY_LOW, high compression
+        {0x04}, // CAMERA_IMAGE_QUALITY_NORMAL, average, default
+        {0x02}, // CAMERA_IMAGE_QUALITY_HIGH, low compression
+};
+
+private const CameraTuningTable TUNING_TABLES[CAMERA_TUNING_SETTING_COUNT] = {
+        [CAMERA_TUNING_SATURATION] = {
+                .name = "saturation", .minLevel = -4, .maxLevel = 4, .levelStep = 1,
+                .registerCount = 4, .addresses = {0x5001, 0x5580, 0x5583, 0x5584},
+                .values = SATURATION_VALUES
+        },
+        [CAMERA_TUNING_BRIGHTNESS] = {
+                .name = "brightness", .minLevel = -4, .maxLevel = 4, .levelStep = 1,
+                .registerCount = 4, .addresses = {0x5001, 0x5580, 0x5589, 0x558a},
+                .values = BRIGHTNESS_VALUES
+        },
+        [CAMERA_TUNING_CONTRAST] = {
+                .name = "contrast", .minLevel = -4, .maxLevel = 4, .levelStep = 1,
+                .registerCount = 5, .addresses = {0x5001, 0x5580, 0x5587, 0x5588, 0x558a},
+                .values = CONTRAST_VALUES
+        },
+        [CAMERA_TUNING_HUE] = {
+                .name = "hue", .minLevel = -180, .maxLevel = 180, .levelStep = 30,
+                .registerCount = 5, .addresses = {0x5001, 0x5580, 0x5581, 0x5582, 0x558a},
+                .values = HUE_VALUES
+        },
+        [CAMERA_TUNING_EXPOSURE] = {
+                .name = "exposure", .minLevel = -5, .maxLevel = 5, .levelStep = 1,
+                .registerCount = 6, .addresses = {0x3a0f, 0x3a10, 0x3a11, 0x3a1b, 0x3a1e, 0x3a1f},
+                .values = EXPOSURE_VALUES
+        },
+        // TODO: 12-Nov-2022 @basshelal: Implement! Levels are validated but no registers are written yet
+        [CAMERA_TUNING_SHARPNESS] = {
+                .name = "sharpness", .minLevel = -4, .maxLevel = 4, .levelStep = 1,
+                .registerCount = 0, .values = NULL
+        },
+        [CAMERA_TUNING_IMAGE_QUALITY] = {
+                .name = "imageQuality", .minLevel = 0, .maxLevel = 2, .levelStep = 1,
+                .registerCount = 1, .addresses = {0x4407},
+                .values = IMAGE_QUALITY_VALUES
+        },
+};
+
+public const char *cameraTuning_settingName(const CameraTuningSetting setting) {
+    if (setting < 0 || setting >= CAMERA_TUNING_SETTING_COUNT) return "unknown";
+    return TUNING_TABLES[setting].name;
+}
+
+public bool cameraTuning_isValidLevel(const CameraTuningSetting setting, const int level) {
+    if (setting < 0 || setting >= CAMERA_TUNING_SETTING_COUNT) return false;
+    const CameraTuningTable *table = &TUNING_TABLES[setting];
+    return level >= table->minLevel && level <= table->maxLevel && (level - table->minLevel) % table->levelStep == 0;
+}
+
+public Error cameraTuning_compile(const CameraTuningSetting setting, const int level, OV5642RegisterEntry *entries) {
+    requireArgNotNull(entries);
+    require(setting >= 0 && setting < CAMERA_TUNING_SETTING_COUNT, ERROR_ILLEGAL_ARGUMENT,
+            "Unknown tuning setting: %i", setting);
+    const CameraTuningTable *table = &TUNING_TABLES[setting];
+    require(cameraTuning_isValidLevel(setting, level), ERROR_OUT_OF_BOUNDS,
+            "Invalid %s level: %i, must be between %i and %i in steps of %i",
+            table->name, level, table->minLevel, table->maxLevel, table->levelStep);
+    const int row = (level - table->minLevel) / table->levelStep;
+    uint8_t i = 0;
+    for (; i < table->registerCount; i++) {
+        entries[i] = (OV5642RegisterEntry) {.address = table->addresses[i], .value = table->values[row][i]};
+    }
+    entries[i] = (OV5642RegisterEntry) {.address = OV5642_REGISTER_ADDRESS_END, .value = OV5642_REGISTER_VALUE_END};
+    return ERROR_NONE;
+}
+
+/** Insert or replace entry in the ascending sorted entries of length *length */
+private void cameraTuning_insertEntry(OV5642RegisterEntry *entries, size_t *length, const OV5642RegisterEntry entry) {
+    size_t index = 0;
+    while (index < *length && entries[index].address < entry.address) index++;
+    if (index < *length && entries[index].address == entry.address) {
+        entries[index].value = entry.value;
+        return;
+    }
+    memmove(&entries[index + 1], &entries[index], (*length - index) * sizeof(OV5642RegisterEntry));
+    entries[index] = entry;
+    (*length)++;
+}
+
+public Error cameraTuning_compileBatch(const CameraTuningLevel *levels, const size_t levelCount,
+                                       OV5642RegisterEntry *entries) {
+    requireArgNotNull(entries);
+    require(levels != NULL || levelCount == 0, ERROR_NULL_ARGUMENT, "levels cannot be NULL");
+    require(levelCount <= CAMERA_TUNING_SETTING_COUNT, ERROR_ILLEGAL_ARGUMENT,
+            "Too many levels: %u, max is %u", levelCount, CAMERA_TUNING_SETTING_COUNT);
+    for (size_t i = 0; i < levelCount; i++) {
+        require(cameraTuning_isValidLevel(levels[i].setting, levels[i].level), ERROR_OUT_OF_BOUNDS,
+                "Invalid %s level: %i", cameraTuning_settingName(levels[i].setting), levels[i].level);
+    }
+    size_t length = 0;
+    OV5642RegisterEntry settingEntries[CAMERA_TUNING_MAX_ENTRIES];
+    for (size_t i = 0; i < levelCount; i++) {
+        cameraTuning_compile(levels[i].setting, levels[i].level, settingEntries);
+        for (const OV5642RegisterEntry *entry = settingEntries;
+             entry->address != OV5642_REGISTER_ADDRESS_END; entry++) {
+            cameraTuning_insertEntry(entries, &length, *entry);
+        }
+    }
+    entries[length] = (OV5642RegisterEntry) {.address = OV5642_REGISTER_ADDRESS_END, .value = OV5642_REGISTER_VALUE_END};
+    return ERROR_NONE;
+}
@@ -0,0 +1,55 @@
+#ifndef ESP32_REMOTECAMERA_CAMERATUNING_H
+#define ESP32_REMOTECAMERA_CAMERATUNING_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "OV5642.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Level to register tables for every camera tuning setting (saturation, brightness etc),
+ * each setting writes the same fixed set of registers and only the values change per level,
+ * so a level is compiled into a short OV5642RegisterEntry script instead of a hand written switch case
+ */
+
+typedef enum CameraTuningSetting {
+    CAMERA_TUNING_SATURATION = 0,
+    CAMERA_TUNING_BRIGHTNESS,
+    CAMERA_TUNING_CONTRAST,
+    CAMERA_TUNING_HUE,
+    CAMERA_TUNING_EXPOSURE,
+    CAMERA_TUNING_SHARPNESS,
+    CAMERA_TUNING_IMAGE_QUALITY,
+    CAMERA_TUNING_SETTING_COUNT
+} CameraTuningSetting;
+
+typedef struct CameraTuningLevel {
+    CameraTuningSetting setting;
+    int level;
+} CameraTuningLevel;
+
+/** Most registers any single setting writes */
+#define CAMERA_TUNING_MAX_REGISTERS 6
+/** Size of the entries array to compile into, includes the end entry */
+#define CAMERA_TUNING_MAX_ENTRIES (CAMERA_TUNING_MAX_REGISTERS + 1)
+/** Size of the entries array to compile a batch into, enough for every setting at once plus the end entry */
+#define CAMERA_TUNING_MAX_BATCH_ENTRIES ((CAMERA_TUNING_SETTING_COUNT * CAMERA_TUNING_MAX_REGISTERS) + 1)
+
+extern const char *cameraTuning_settingName(const CameraTuningSetting setting);
+
+extern bool cameraTuning_isValidLevel(const CameraTuningSetting setting, const int level);
+
+/** Write the register script for setting at level into entries (at least CAMERA_TUNING_MAX_ENTRIES long),
+ * entries are in ascending address order so consecutive registers merge into one write,
+ * returns ERROR_OUT_OF_BOUNDS for a level the setting does not have */
+extern Error cameraTuning_compile(const CameraTuningSetting setting, const int level, OV5642RegisterEntry *entries);
+
+/** Compile several settings into one register script (entries at least CAMERA_TUNING_MAX_BATCH_ENTRIES long),
+ * registers shared between settings are written once with the value of the last level that sets them,
+ * all levels are validated before anything is compiled so either the whole batch compiles or none of it does */
+extern Error cameraTuning_compileBatch(const CameraTuningLevel *levels, const size_t levelCount,
+                                       OV5642RegisterEntry *entries);
+
+#endif //ESP32_REMOTECAMERA_CAMERATUNING_H
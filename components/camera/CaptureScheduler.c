@@ -0,0 +1,176 @@
+#include "CaptureScheduler.h"
+#include "Histogram.h"
+#include <stdlib.h>
+
+#define CAPTURE_SCHEDULER_NO_TICKET CAPTURE_SCHEDULER_MAX_REQUESTS
+
+/** Higher goes first */
+private const uint CAPTURE_SCHEDULER_PRIORITIES[CAMERA_REQUEST_CLASS_COUNT] = {
+        [CAMERA_REQUEST_CLASS_SETTINGS] = 3,
+        [CAMERA_REQUEST_CLASS_STILL] = 2,
+        [CAMERA_REQUEST_CLASS_BURST] = 1,
+        [CAMERA_REQUEST_CLASS_LIVE] = 0,
+};
+
+/** A live capture only has to be granted often enough that the stream doesn't stall behind a run of stills */
+private const uint32_t CAPTURE_SCHEDULER_DEFAULT_DEADLINE_MILLIS[CAMERA_REQUEST_CLASS_COUNT] = {
+        [CAMERA_REQUEST_CLASS_SETTINGS] = 500,
+        [CAMERA_REQUEST_CLASS_STILL] = 1000,
+        [CAMERA_REQUEST_CLASS_BURST] = 2000,
+        [CAMERA_REQUEST_CLASS_LIVE] = 1000,
+};
+
+typedef struct CaptureSchedulerRequest {
+    bool isQueued;
+    CameraRequestClass requestClass;
+    int64_t queuedMicros;
+    int64_t deadlineMicros;
+} CaptureSchedulerRequest;
+
+typedef struct CaptureSchedulerData {
+    CaptureSchedulerRequest requests[CAPTURE_SCHEDULER_MAX_REQUESTS];
+    /** CAPTURE_SCHEDULER_NO_TICKET when no request holds the camera */
+    uint holder;
+    bool isCaptureShared;
+    int64_t sharedMicros;
+    CameraSchedulerStats stats;
+    Histogram *queueMicros[CAMERA_REQUEST_CLASS_COUNT];
+} CaptureSchedulerData;
+
+public CaptureScheduler *captureScheduler_create() {
+    CaptureSchedulerData *this = new(CaptureSchedulerData);
+    if (!this) return NULL;
+    this->holder = CAPTURE_SCHEDULER_NO_TICKET;
+    for (uint i = 0; i < CAMERA_REQUEST_CLASS_COUNT; i++) {
+        this->queueMicros[i] = histogram_create();
+        if (!this->queueMicros[i]) {
+            captureScheduler_destroy(this);
+            return NULL;
+        }
+    }
+    return this;
+}
+
+public void captureScheduler_destroy(CaptureScheduler *captureScheduler) {
+    if (!captureScheduler) return;
+    CaptureSchedulerData *this = (CaptureSchedulerData *) captureScheduler;
+    for (uint i = 0; i < CAMERA_REQUEST_CLASS_COUNT; i++) {
+        histogram_destroy(this->queueMicros[i]);
+    }
+    delete(this);
+}
+
+public Error captureScheduler_enqueue(CaptureScheduler *captureScheduler, const CameraRequestClass requestClass,
+                                      const uint32_t deadlineMillis, const int64_t nowMicros, uint *ticket) {
+    if (!captureScheduler || !ticket) return ERROR_NULL_ARGUMENT;
+    if (requestClass < 0 || requestClass >= CAMERA_REQUEST_CLASS_COUNT) return ERROR_ILLEGAL_ARGUMENT;
+    CaptureSchedulerData *this = (CaptureSchedulerData *) captureScheduler;
+    for (uint i = 0; i < CAPTURE_SCHEDULER_MAX_REQUESTS; i++) {
+        CaptureSchedulerRequest *request = &this->requests[i];
+        if (request->isQueued) continue;
+        const uint32_t millis = deadlineMillis > 0 ? deadlineMillis :
+                                CAPTURE_SCHEDULER_DEFAULT_DEADLINE_MILLIS[requestClass];
+        *request = (CaptureSchedulerRequest) {
+                .isQueued = true,
+                .requestClass = requestClass,
+                .queuedMicros = nowMicros,
+                .deadlineMicros = nowMicros + ((int64_t) millis * 1000)
+        };
+        this->stats.classes[requestClass].requests++;
+        this->stats.classes[requestClass].waiting++;
+        *ticket = i;
+        return ERROR_NONE;
+    }
+    this->stats.requestsRefused++;
+    return ERROR_OUT_OF_BOUNDS;
+}
+
+/** Whether waiting request a goes before waiting request b at nowMicros */
+private bool captureScheduler_isBefore(const CaptureSchedulerRequest *a, const CaptureSchedulerRequest *b,
+                                       const int64_t nowMicros) {
+    const bool isAOverdue = nowMicros >= a->deadlineMicros;
+    const bool isBOverdue = nowMicros >= b->deadlineMicros;
+    if (isAOverdue != isBOverdue) return isAOverdue;
+    if (isAOverdue) return a->deadlineMicros < b->deadlineMicros;
+    const uint aPriority = CAPTURE_SCHEDULER_PRIORITIES[a->requestClass];
+    const uint bPriority = CAPTURE_SCHEDULER_PRIORITIES[b->requestClass];
+    if (aPriority != bPriority) return aPriority > bPriority;
+    return a->queuedMicros < b->queuedMicros;
+}
+
+public bool captureScheduler_grantNext(CaptureScheduler *captureScheduler, const int64_t nowMicros, uint *ticket) {
+    if (!captureScheduler || !ticket) return false;
+    CaptureSchedulerData *this = (CaptureSchedulerData *) captureScheduler;
+    if (this->holder != CAPTURE_SCHEDULER_NO_TICKET) return false;
+    uint next = CAPTURE_SCHEDULER_NO_TICKET;
+    for (uint i = 0; i < CAPTURE_SCHEDULER_MAX_REQUESTS; i++) {
+        if (!this->requests[i].isQueued) continue;
+        if (next == CAPTURE_SCHEDULER_NO_TICKET ||
+            captureScheduler_isBefore(&this->requests[i], &this->requests[next], nowMicros)) {
+            next = i;
+        }
+    }
+    if (next == CAPTURE_SCHEDULER_NO_TICKET) return false;
+    const CaptureSchedulerRequest *request = &this->requests[next];
+    CameraRequestClassStats *classStats = &this->stats.classes[request->requestClass];
+    classStats->waiting--;
+    if (nowMicros > request->deadlineMicros) classStats->deadlinesMissed++;
+    const int64_t queueMicros = nowMicros - request->queuedMicros;
+    histogram_record(this->queueMicros[request->requestClass], queueMicros > 0 ? (uint32_t) queueMicros : 0);
+    if (request->requestClass != CAMERA_REQUEST_CLASS_STILL) this->isCaptureShared = false;
+    this->holder = next;
+    *ticket = next;
+    return true;
+}
+
+public void captureScheduler_release(CaptureScheduler *captureScheduler, const uint ticket, const bool isCoalesced) {
+    if (!captureScheduler) return;
+    CaptureSchedulerData *this = (CaptureSchedulerData *) captureScheduler;
+    if (ticket != this->holder) return;
+    CaptureSchedulerRequest *request = &this->requests[ticket];
+    if (isCoalesced) this->stats.classes[request->requestClass].coalesced++;
+    request->isQueued = false;
+    this->holder = CAPTURE_SCHEDULER_NO_TICKET;
+}
+
+public void captureScheduler_shareCapture(CaptureScheduler *captureScheduler, const int64_t nowMicros) {
+    if (!captureScheduler) return;
+    CaptureSchedulerData *this = (CaptureSchedulerData *) captureScheduler;
+    this->isCaptureShared = true;
+    this->sharedMicros = nowMicros;
+}
+
+public void captureScheduler_forgetCapture(CaptureScheduler *captureScheduler) {
+    if (!captureScheduler) return;
+    ((CaptureSchedulerData *) captureScheduler)->isCaptureShared = false;
+}
+
+public bool captureScheduler_canShareCapture(const CaptureScheduler *captureScheduler, const uint ticket) {
+    if (!captureScheduler || ticket >= CAPTURE_SCHEDULER_MAX_REQUESTS) return false;
+    const CaptureSchedulerData *this = (const CaptureSchedulerData *) captureScheduler;
+    const CaptureSchedulerRequest *request = &this->requests[ticket];
+    // a still from before the request was queued could be older than the caller is willing to take
+    return ticket == this->holder && request->requestClass == CAMERA_REQUEST_CLASS_STILL && this->isCaptureShared &&
+           this->sharedMicros >= request->queuedMicros;
+}
+
+public void captureScheduler_getStats(const CaptureScheduler *captureScheduler, CameraSchedulerStats *stats) {
+    if (!captureScheduler || !stats) return;
+    const CaptureSchedulerData *this = (const CaptureSchedulerData *) captureScheduler;
+    *stats = this->stats;
+    for (uint i = 0; i < CAMERA_REQUEST_CLASS_COUNT; i++) {
+        histogram_getSummary(this->queueMicros[i], &stats->classes[i].queueMicros);
+    }
+}
+
+public void captureScheduler_resetStats(CaptureScheduler *captureScheduler) {
+    if (!captureScheduler) return;
+    CaptureSchedulerData *this = (CaptureSchedulerData *) captureScheduler;
+    for (uint i = 0; i < CAMERA_REQUEST_CLASS_COUNT; i++) {
+        CameraRequestClassStats *classStats = &this->stats.classes[i];
+        const uint32_t waiting = classStats->waiting; // still waiting, they are counted down when granted
+        *classStats = (CameraRequestClassStats) {.waiting = waiting};
+        histogram_reset(this->queueMicros[i]);
+    }
+    this->stats.requestsRefused = 0;
+}
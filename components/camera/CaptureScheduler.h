@@ -0,0 +1,53 @@
+#ifndef ESP32_REMOTECAMERA_CAPTURESCHEDULER_H
+#define ESP32_REMOTECAMERA_CAPTURESCHEDULER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Decides which request for the camera goes next, one request holds the camera at a time. Waiting requests go in
+ * order of their class's priority (settings, still, burst, then live) and in the order they were queued within a
+ * class, except that a request past its deadline goes ahead of every request that is not, earliest deadline first,
+ * so no class waits forever behind another. A still captured into the FIFO can be shared with the still requests
+ * queued before it was done, so they read it out instead of capturing their own. Knows nothing about the camera
+ * hardware or tasks, it is told when requests are queued and released and asked who to grant the camera to next
+ */
+typedef void CaptureScheduler;
+
+/** Most requests waiting for or holding the camera at once, a ticket is one of these slots */
+#define CAPTURE_SCHEDULER_MAX_REQUESTS 8
+
+extern CaptureScheduler *captureScheduler_create();
+
+extern void captureScheduler_destroy(CaptureScheduler *captureScheduler);
+
+/** Queue a request of requestClass made at nowMicros, that should be granted the camera within deadlineMillis
+ * (0 for the class's default), returns ERROR_OUT_OF_BOUNDS when CAPTURE_SCHEDULER_MAX_REQUESTS are already queued */
+extern Error captureScheduler_enqueue(CaptureScheduler *captureScheduler, const CameraRequestClass requestClass,
+                                      const uint32_t deadlineMillis, const int64_t nowMicros, uint *ticket);
+
+/** Grant the camera to the waiting request that goes next, false when a request holds the camera or none is
+ * waiting, granting a class other than still forgets the shared still */
+extern bool captureScheduler_grantNext(CaptureScheduler *captureScheduler, const int64_t nowMicros, uint *ticket);
+
+/** The request holding the camera is done with it, isCoalesced if it was served without a capture of its own */
+extern void captureScheduler_release(CaptureScheduler *captureScheduler, const uint ticket, const bool isCoalesced);
+
+/** The request holding the camera left a still in the FIFO at nowMicros that still requests queued before then
+ * can read out */
+extern void captureScheduler_shareCapture(CaptureScheduler *captureScheduler, const int64_t nowMicros);
+
+/** The request holding the camera replaced whatever was in the FIFO */
+extern void captureScheduler_forgetCapture(CaptureScheduler *captureScheduler);
+
+/** Whether the still request holding the camera with ticket can read out the shared still instead of capturing */
+extern bool captureScheduler_canShareCapture(const CaptureScheduler *captureScheduler, const uint ticket);
+
+extern void captureScheduler_getStats(const CaptureScheduler *captureScheduler, CameraSchedulerStats *stats);
+
+extern void captureScheduler_resetStats(CaptureScheduler *captureScheduler);
+
+#endif //ESP32_REMOTECAMERA_CAPTURESCHEDULER_H
@@ -0,0 +1,76 @@
+#include "FIFOReader.h"
+#include "Utils.h"
+#include <stdlib.h>
+
+typedef struct FIFOReaderData {
+    FIFOReaderTransport transport;
+    uint8_t *buffers[FIFO_READER_BUFFER_COUNT];
+    size_t bufferLength;
+} FIFOReaderData;
+
+public FIFOReader *fifoReader_create(const FIFOReaderTransport *transport,
+                                     uint8_t *const buffers[FIFO_READER_BUFFER_COUNT], const size_t bufferLength) {
+    if (!transport || !transport->queueRead || !transport->awaitRead || !buffers || bufferLength == 0) return NULL;
+    for (int i = 0; i < FIFO_READER_BUFFER_COUNT; i++) {
+        if (!buffers[i]) return NULL;
+    }
+    FIFOReaderData *this = new(FIFOReaderData);
+    this->transport = *transport;
+    for (int i = 0; i < FIFO_READER_BUFFER_COUNT; i++) {
+        this->buffers[i] = buffers[i];
+    }
+    this->bufferLength = bufferLength;
+    return this;
+}
+
+public void fifoReader_destroy(FIFOReader *fifoReader) {
+    if (!fifoReader) return;
+    FIFOReaderData *this = (FIFOReaderData *) fifoReader;
+    delete(this);
+}
+
+public Error fifoReader_read(FIFOReader *fifoReader, const size_t totalBytes,
+                             FIFOReaderCallback callback, void *userArg) {
+    if (!fifoReader || !callback) return ERROR_NULL_ARGUMENT;
+    FIFOReaderData *this = (FIFOReaderData *) fifoReader;
+    const FIFOReaderTransport *transport = &this->transport;
+    size_t bytesQueued = 0;
+    size_t bytesRead = 0;
+    uint inFlight = 0;
+    bool isStopped = false;
+    Error err = ERROR_NONE;
+
+    // prime the pipeline, fill every buffer we have
+    for (int i = 0; i < FIFO_READER_BUFFER_COUNT && bytesQueued < totalBytes; i++) {
+        const size_t remaining = totalBytes - bytesQueued;
+        const size_t length = remaining > this->bufferLength ? this->bufferLength : remaining;
+        err = transport->queueRead(transport->context, this->buffers[i], length);
+        if (err != ERROR_NONE) break;
+        bytesQueued += length;
+        inFlight++;
+    }
+
+    while (inFlight > 0) {
+        uint8_t *buffer = NULL;
+        size_t length = 0;
+        const Error awaitErr = transport->awaitRead(transport->context, &buffer, &length);
+        inFlight--;
+        if (awaitErr != ERROR_NONE) {
+            if (err == ERROR_NONE) err = awaitErr;
+            continue; // keep draining so nothing is left queued on the transport
+        }
+        if (err != ERROR_NONE || isStopped) continue;
+        bytesRead += length;
+        // the other buffer is being filled while the consumer works on this one
+        isStopped = !callback(buffer, length, bytesRead, totalBytes - bytesRead, userArg);
+        if (!isStopped && bytesQueued < totalBytes) {
+            const size_t remaining = totalBytes - bytesQueued;
+            const size_t nextLength = remaining > this->bufferLength ? this->bufferLength : remaining;
+            err = transport->queueRead(transport->context, buffer, nextLength);
+            if (err != ERROR_NONE) continue;
+            bytesQueued += nextLength;
+            inFlight++;
+        }
+    }
+    return err;
+}
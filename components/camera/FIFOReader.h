@@ -0,0 +1,49 @@
+#ifndef ESP32_REMOTECAMERA_FIFOREADER_H
+#define ESP32_REMOTECAMERA_FIFOREADER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Reads a known number of bytes out of the ArduChip FIFO using 2 alternating (ping-pong) buffers,
+ * while the consumer is processing one buffer the transport is already filling the other.
+ * Knows nothing about SPI, all transfers go through a FIFOReaderTransport so the chunk sequencing
+ * can be tested against a fake transport without any camera hardware
+ */
+typedef void FIFOReader;
+
+#define FIFO_READER_BUFFER_COUNT 2
+
+typedef struct FIFOReaderTransport {
+    /** Passed as the first argument to every transport function */
+    void *context;
+    /** Start (but don't wait for) a read of length bytes from the FIFO into buffer,
+     * at most FIFO_READER_BUFFER_COUNT reads will ever be queued at once */
+    Error (*queueRead)(void *context, uint8_t *buffer, const size_t length);
+    /** Block until the oldest queued read finishes and write its buffer and length */
+    Error (*awaitRead)(void *context, uint8_t **buffer, size_t *length);
+} FIFOReaderTransport;
+
+/** Called once per filled buffer in FIFO order, buffer is only valid until this returns since it will be
+ * refilled right after, bytesRead and bytesRemaining are the running totals including this buffer,
+ * return false to stop the read early, such as once the end of the image has been found */
+typedef bool FIFOReaderCallback(uint8_t *buffer, const size_t bufferLength,
+                                const size_t bytesRead, const size_t bytesRemaining, void *userArg);
+
+/** Create a reader over transport using the caller owned buffers, which must each be bufferLength bytes long and
+ * (for the SPI transport) DMA capable, the buffers must outlive the reader */
+extern FIFOReader *fifoReader_create(const FIFOReaderTransport *transport,
+                                     uint8_t *const buffers[FIFO_READER_BUFFER_COUNT], const size_t bufferLength);
+
+extern void fifoReader_destroy(FIFOReader *fifoReader);
+
+/** Read totalBytes from the FIFO calling callback for every chunk until callback returns false, after which no
+ * more reads are queued, only the one already in flight (if any) is waited for and its bytes are discarded,
+ * returns the first transport error if any, in which case no more reads will be outstanding */
+extern Error fifoReader_read(FIFOReader *fifoReader, const size_t totalBytes,
+                             FIFOReaderCallback callback, void *userArg);
+
+#endif //ESP32_REMOTECAMERA_FIFOREADER_H
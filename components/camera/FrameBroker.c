@@ -0,0 +1,139 @@
+#include "FrameBroker.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+typedef struct FrameBrokerConsumer {
+    /** Sequence of the next frame to take, a consumer owns its cursor unless it is a whole ring behind */
+    atomic_uint cursor;
+    atomic_uint framesTaken;
+    atomic_uint framesDropped;
+} FrameBrokerConsumer;
+
+typedef struct FrameBrokerData {
+    _Atomic(CameraFrame *) *slots;
+    size_t capacity;
+    /** Sequence of the next frame to publish, every sequence before it has been published */
+    atomic_uint head;
+    atomic_uint framesPublished;
+    atomic_uint consumerCount;
+    /** Once the head has gone round the ring every publish overwrites a slot */
+    bool hasWrapped;
+    FrameBrokerConsumer consumers[FRAME_BROKER_MAX_CONSUMERS];
+} FrameBrokerData;
+
+#define frameBroker_slot(this, sequence) (&(this)->slots[(sequence) & ((this)->capacity - 1)])
+
+public FrameBroker *frameBroker_create(const size_t capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return NULL;
+    FrameBrokerData *this = new(FrameBrokerData);
+    if (!this) return NULL;
+    this->slots = alloc(capacity * sizeof(_Atomic(CameraFrame *)));
+    if (!this->slots) {
+        delete(this);
+        return NULL;
+    }
+    this->capacity = capacity;
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&this->slots[i], NULL);
+    }
+    atomic_init(&this->head, 0);
+    atomic_init(&this->framesPublished, 0);
+    atomic_init(&this->consumerCount, 0);
+    this->hasWrapped = false;
+    return this;
+}
+
+public Error frameBroker_destroy(FrameBroker *frameBroker) {
+    if (!frameBroker) return ERROR_NULL_ARGUMENT;
+    FrameBrokerData *this = (FrameBrokerData *) frameBroker;
+    frameBroker_dropAll(frameBroker);
+    delete(this->slots);
+    delete(this);
+    return ERROR_NONE;
+}
+
+public Error frameBroker_addConsumer(FrameBroker *frameBroker, uint *consumer) {
+    if (!frameBroker || !consumer) return ERROR_NULL_ARGUMENT;
+    FrameBrokerData *this = (FrameBrokerData *) frameBroker;
+    const uint consumerCount = atomic_load(&this->consumerCount);
+    if (consumerCount >= FRAME_BROKER_MAX_CONSUMERS) return ERROR_OUT_OF_BOUNDS;
+    FrameBrokerConsumer *newConsumer = &this->consumers[consumerCount];
+    atomic_init(&newConsumer->cursor, atomic_load(&this->head));
+    atomic_init(&newConsumer->framesTaken, 0);
+    atomic_init(&newConsumer->framesDropped, 0);
+    atomic_store(&this->consumerCount, consumerCount + 1);
+    *consumer = consumerCount;
+    return ERROR_NONE;
+}
+
+/** Moves every consumer still waiting to take sequence past it, releasing the reference that was kept for them */
+private void frameBroker_retire(FrameBrokerData *this, const uint sequence) {
+    CameraFrame *frame = atomic_load(frameBroker_slot(this, sequence));
+    const uint consumerCount = atomic_load(&this->consumerCount);
+    for (uint i = 0; i < consumerCount; i++) {
+        FrameBrokerConsumer *consumer = &this->consumers[i];
+        uint expected = sequence;
+        // if the consumer is taking this frame right now only one of us wins, the other sees the cursor has moved
+        if (atomic_compare_exchange_strong(&consumer->cursor, &expected, sequence + 1)) {
+            framePool_release(frame);
+            atomic_fetch_add(&consumer->framesDropped, 1);
+        }
+    }
+}
+
+public void frameBroker_publish(FrameBroker *frameBroker, CameraFrame *frame) {
+    if (!frameBroker || !frame) return;
+    FrameBrokerData *this = (FrameBrokerData *) frameBroker;
+    const uint head = atomic_load(&this->head);
+    if (this->hasWrapped) frameBroker_retire(this, head - this->capacity);
+    const uint consumerCount = atomic_load(&this->consumerCount);
+    for (uint i = 0; i < consumerCount; i++) {
+        framePool_retain(frame);
+    }
+    atomic_store(frameBroker_slot(this, head), frame);
+    atomic_store(&this->head, head + 1); // the frame is only visible to consumers once the head is past it
+    atomic_fetch_add(&this->framesPublished, 1);
+    if (head + 1 - this->capacity == 0) this->hasWrapped = true;
+}
+
+public void frameBroker_dropAll(FrameBroker *frameBroker) {
+    if (!frameBroker) return;
+    FrameBrokerData *this = (FrameBrokerData *) frameBroker;
+    const uint head = atomic_load(&this->head);
+    const uint oldest = this->hasWrapped ? head - this->capacity : 0;
+    for (uint sequence = oldest; sequence != head; sequence++) {
+        frameBroker_retire(this, sequence);
+    }
+}
+
+public bool frameBroker_take(FrameBroker *frameBroker, const uint consumer, CameraFrame **frame) {
+    if (!frameBroker || !frame) return false;
+    FrameBrokerData *this = (FrameBrokerData *) frameBroker;
+    if (consumer >= atomic_load(&this->consumerCount)) return false;
+    FrameBrokerConsumer *brokerConsumer = &this->consumers[consumer];
+    while (true) {
+        uint cursor = atomic_load(&brokerConsumer->cursor);
+        if (cursor == atomic_load(&this->head)) return false;
+        // the producer moves the cursor before it overwrites this slot, so winning the exchange means the frame
+        // read here is still the one at cursor and its reference is ours
+        CameraFrame *taken = atomic_load(frameBroker_slot(this, cursor));
+        if (atomic_compare_exchange_strong(&brokerConsumer->cursor, &cursor, cursor + 1)) {
+            atomic_fetch_add(&brokerConsumer->framesTaken, 1);
+            *frame = taken;
+            return true;
+        }
+    }
+}
+
+public Error frameBroker_getStats(const FrameBroker *frameBroker, const uint consumer,
+                                  CameraFrameConsumerStats *stats) {
+    if (!frameBroker || !stats) return ERROR_NULL_ARGUMENT;
+    FrameBrokerData *this = (FrameBrokerData *) frameBroker;
+    if (consumer >= atomic_load(&this->consumerCount)) return ERROR_OUT_OF_BOUNDS;
+    FrameBrokerConsumer *brokerConsumer = &this->consumers[consumer];
+    stats->framesPublished = atomic_load(&this->framesPublished);
+    stats->framesTaken = atomic_load(&brokerConsumer->framesTaken);
+    stats->framesDropped = atomic_load(&brokerConsumer->framesDropped);
+    stats->framesPending = atomic_load(&this->head) - atomic_load(&brokerConsumer->cursor);
+    return ERROR_NONE;
+}
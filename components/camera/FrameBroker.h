@@ -0,0 +1,46 @@
+#ifndef ESP32_REMOTECAMERA_FRAMEBROKER_H
+#define ESP32_REMOTECAMERA_FRAMEBROKER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include "FramePool.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * A lock-free single producer, multiple consumer ring of frames, every consumer has its own read cursor and sees
+ * every frame published after it was added. Publishing never blocks, when a consumer falls a whole ring behind the
+ * producer overwrites its oldest unread frame and counts it as dropped for that consumer.
+ * The ring holds a frame reference for each consumer that has not taken the frame yet, a taken frame's reference
+ * belongs to the consumer who must framePool_release() it
+ */
+typedef void FrameBroker;
+
+#define FRAME_BROKER_MAX_CONSUMERS 4
+
+/** Create a ring of capacity frames, capacity must be a power of 2, NULL if it is not or could not be allocated */
+extern FrameBroker *frameBroker_create(const size_t capacity);
+
+/** Releases every frame still in the ring, nothing may be publishing or taking */
+extern Error frameBroker_destroy(FrameBroker *frameBroker);
+
+/** Add a consumer that sees frames published from now on, must not be called while a frame is being published,
+ * returns ERROR_OUT_OF_BOUNDS when there are already FRAME_BROKER_MAX_CONSUMERS */
+extern Error frameBroker_addConsumer(FrameBroker *frameBroker, uint *consumer);
+
+/** Producer only, adds frame with a reference for every consumer, overwriting any consumer's oldest unread frame
+ * if the ring is full */
+extern void frameBroker_publish(FrameBroker *frameBroker, CameraFrame *frame);
+
+/** Producer only, drops every unread frame for every consumer, such as before the frame pool is destroyed */
+extern void frameBroker_dropAll(FrameBroker *frameBroker);
+
+/** Take consumer's oldest unread frame, false if there is none, only one task may take for each consumer */
+extern bool frameBroker_take(FrameBroker *frameBroker, const uint consumer, CameraFrame **frame);
+
+extern Error frameBroker_getStats(const FrameBroker *frameBroker, const uint consumer,
+                                  CameraFrameConsumerStats *stats);
+
+#endif //ESP32_REMOTECAMERA_FRAMEBROKER_H
@@ -0,0 +1,126 @@
+#include "FramePool.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+struct FramePoolData;
+
+typedef struct FramePoolSlot {
+    /** Must be first so a CameraFrame pointer is also a slot pointer */
+    CameraFrame frame;
+    uint8_t *buffer;
+    atomic_uint referenceCount;
+    struct FramePoolData *pool;
+} FramePoolSlot;
+
+typedef struct FramePoolData {
+    FramePoolSlot *slots;
+    size_t frameCount;
+    size_t frameBytes;
+    atomic_uint framesInUse;
+    atomic_uint framesInUseHighWater;
+    atomic_uint acquireCount;
+    atomic_uint acquireFailures;
+} FramePoolData;
+
+public FramePool *framePool_create(const size_t frameCount, const size_t frameBytes) {
+    if (frameCount == 0 || frameBytes == 0) return NULL;
+    FramePoolData *this = new(FramePoolData);
+    if (!this) return NULL;
+    this->slots = alloc(frameCount * sizeof(FramePoolSlot));
+    if (!this->slots) {
+        delete(this);
+        return NULL;
+    }
+    this->frameCount = frameCount;
+    this->frameBytes = frameBytes;
+    for (size_t i = 0; i < frameCount; i++) {
+        FramePoolSlot *slot = &this->slots[i];
+        slot->buffer = malloc(frameBytes); // not zeroed, a frame is always written before it is read
+        if (!slot->buffer) {
+            for (size_t j = 0; j < i; j++) delete(this->slots[j].buffer);
+            delete(this->slots);
+            delete(this);
+            return NULL;
+        }
+        slot->frame.data = slot->buffer;
+        slot->pool = this;
+        atomic_init(&slot->referenceCount, 0);
+    }
+    atomic_init(&this->framesInUse, 0);
+    atomic_init(&this->framesInUseHighWater, 0);
+    atomic_init(&this->acquireCount, 0);
+    atomic_init(&this->acquireFailures, 0);
+    return this;
+}
+
+public Error framePool_destroy(FramePool *framePool) {
+    if (!framePool) return ERROR_NULL_ARGUMENT;
+    FramePoolData *this = (FramePoolData *) framePool;
+    if (atomic_load(&this->framesInUse) > 0) return ERROR_ILLEGAL_STATE;
+    for (size_t i = 0; i < this->frameCount; i++) {
+        delete(this->slots[i].buffer);
+    }
+    delete(this->slots);
+    delete(this);
+    return ERROR_NONE;
+}
+
+public CameraFrame *framePool_acquire(FramePool *framePool) {
+    if (!framePool) return NULL;
+    FramePoolData *this = (FramePoolData *) framePool;
+    atomic_fetch_add(&this->acquireCount, 1);
+    for (size_t i = 0; i < this->frameCount; i++) {
+        FramePoolSlot *slot = &this->slots[i];
+        unsigned int expected = 0;
+        if (atomic_compare_exchange_strong(&slot->referenceCount, &expected, 1)) {
+            slot->frame.length = 0;
+            const unsigned int framesInUse = atomic_fetch_add(&this->framesInUse, 1) + 1;
+            unsigned int highWater = atomic_load(&this->framesInUseHighWater);
+            while (framesInUse > highWater &&
+                   !atomic_compare_exchange_weak(&this->framesInUseHighWater, &highWater, framesInUse)) {}
+            return &slot->frame;
+        }
+    }
+    atomic_fetch_add(&this->acquireFailures, 1);
+    return NULL;
+}
+
+public uint8_t *framePool_getBuffer(CameraFrame *frame, size_t *capacity) {
+    if (!frame) return NULL;
+    FramePoolSlot *slot = (FramePoolSlot *) frame;
+    if (capacity) *capacity = slot->pool->frameBytes;
+    return slot->buffer;
+}
+
+public CameraFrame *framePool_retain(CameraFrame *frame) {
+    if (!frame) return NULL;
+    FramePoolSlot *slot = (FramePoolSlot *) frame;
+    atomic_fetch_add(&slot->referenceCount, 1);
+    return frame;
+}
+
+public void framePool_release(CameraFrame *frame) {
+    if (!frame) return;
+    FramePoolSlot *slot = (FramePoolSlot *) frame;
+    if (atomic_fetch_sub(&slot->referenceCount, 1) == 1) {
+        atomic_fetch_sub(&slot->pool->framesInUse, 1);
+    }
+}
+
+public bool framePool_isFull(const FramePool *framePool) {
+    if (!framePool) return true;
+    FramePoolData *this = (FramePoolData *) framePool;
+    return atomic_load(&this->framesInUse) >= this->frameCount;
+}
+
+public Error framePool_getStats(const FramePool *framePool, CameraFramePoolStats *stats) {
+    if (!framePool || !stats) return ERROR_NULL_ARGUMENT;
+    FramePoolData *this = (FramePoolData *) framePool;
+    stats->frameCount = this->frameCount;
+    stats->frameBytes = this->frameBytes;
+    stats->framesInUse = atomic_load(&this->framesInUse);
+    stats->framesInUseHighWater = atomic_load(&this->framesInUseHighWater);
+    stats->acquireCount = atomic_load(&this->acquireCount);
+    stats->acquireFailures = atomic_load(&this->acquireFailures);
+    return ERROR_NONE;
+}
@@ -0,0 +1,40 @@
+#ifndef ESP32_REMOTECAMERA_FRAMEPOOL_H
+#define ESP32_REMOTECAMERA_FRAMEPOOL_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * A fixed number of whole-frame buffers allocated up front, a frame is written once by the camera and then shared
+ * read-only by any number of readers, each holding a reference, it goes back to the pool when the last reference
+ * is released. Reference counts are atomic so frames can be retained and released from any task without a lock
+ */
+typedef void FramePool;
+
+/** Create a pool of frameCount frames of frameBytes each, NULL if they could not be allocated */
+extern FramePool *framePool_create(const size_t frameCount, const size_t frameBytes);
+
+/** Frees every frame, the pool must not have any frames in use */
+extern Error framePool_destroy(FramePool *framePool);
+
+/** Take a free frame to write into, its length is 0 and its reference count 1, NULL if every frame is in use */
+extern CameraFrame *framePool_acquire(FramePool *framePool);
+
+/** The writable buffer behind frame and its capacity, only for the writer before the frame is shared */
+extern uint8_t *framePool_getBuffer(CameraFrame *frame, size_t *capacity);
+
+/** Add a reference to frame, returns frame */
+extern CameraFrame *framePool_retain(CameraFrame *frame);
+
+/** Remove a reference from frame, the last release returns the frame to its pool */
+extern void framePool_release(CameraFrame *frame);
+
+extern bool framePool_isFull(const FramePool *framePool);
+
+extern Error framePool_getStats(const FramePool *framePool, CameraFramePoolStats *stats);
+
+#endif //ESP32_REMOTECAMERA_FRAMEPOOL_H
@@ -0,0 +1,125 @@
+#include "FrameReader.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct FrameReaderData {
+    JPEGScanner *jpegScanner;
+    FrameReaderFIFORead *fifoRead;
+    void *context;
+    /** The 0xFF of a SOI split across 2 reads, it goes in front of the next segment */
+    bool isPrefixPending;
+    /** A frame byte that did not fit in the last read's buffer, it goes first in the next */
+    bool hasCarry;
+    uint8_t carry;
+    bool isEOIRead;
+} FrameReaderData;
+
+/** Where one read is writing the frame */
+typedef struct FrameReaderWrite {
+    FrameReaderData *reader;
+    CameraFrameCursor *cursor;
+    uint8_t *buffer;
+    size_t length;
+    size_t written;
+} FrameReaderWrite;
+
+public FrameReader *frameReader_create(JPEGScanner *jpegScanner, FrameReaderFIFORead *fifoRead, void *context) {
+    if (!jpegScanner || !fifoRead) return NULL;
+    FrameReaderData *this = new(FrameReaderData);
+    if (!this) return NULL;
+    this->jpegScanner = jpegScanner;
+    this->fifoRead = fifoRead;
+    this->context = context;
+    return this;
+}
+
+public void frameReader_destroy(FrameReader *frameReader) {
+    if (!frameReader) return;
+    delete(frameReader);
+}
+
+private void frameReader_segmentCallback(const uint8_t *segment, const size_t segmentLength,
+                                         const size_t frameBytesRead, const JPEGScannerSegmentType segmentType,
+                                         void *userArg) {
+    FrameReaderWrite *write = (FrameReaderWrite *) userArg;
+    FrameReaderData *this = write->reader;
+    if (this->isEOIRead || write->cursor->isFailed) return; // padding after the EOI that looked like a frame
+    if (segmentType == JPEG_SCANNER_SEGMENT_DROPPED) {
+        write->cursor->isFailed = true;
+        return;
+    }
+    if (segment < write->buffer || segment >= write->buffer + write->length) { // the scanner's own 0xFF
+        this->isPrefixPending = true;
+        return;
+    }
+    // segments only ever move down, over padding already scanned, so the bytes still to scan are never overwritten
+    uint8_t *to = write->buffer + write->written;
+    size_t length = segmentLength;
+    if (this->isPrefixPending) { // the segment starts the read's chunk, which is where the 0xFF must go
+        this->isPrefixPending = false;
+        if (write->written + segmentLength + 1 > write->length) {
+            length--;
+            this->carry = segment[length];
+            this->hasCarry = true;
+        }
+        memmove(to + 1, segment, length);
+        *to = JPEG_MARKER_PREFIX;
+        write->written += length + 1;
+    } else {
+        memmove(to, segment, length);
+        write->written += length;
+    }
+    if (segmentType == JPEG_SCANNER_SEGMENT_END) this->isEOIRead = true;
+}
+
+public void frameReader_open(FrameReader *frameReader, const uint32_t fifoBytes, CameraFrameCursor *cursor) {
+    if (!frameReader || !cursor) return;
+    FrameReaderData *this = (FrameReaderData *) frameReader;
+    this->isPrefixPending = false;
+    this->hasCarry = false;
+    this->isEOIRead = false;
+    *cursor = (CameraFrameCursor) {.fifoBytes = fifoBytes, .bytesRemaining = fifoBytes};
+}
+
+public Error frameReader_read(FrameReader *frameReader, CameraFrameCursor *cursor, uint8_t *buffer,
+                              const size_t length, size_t *bytesRead) {
+    if (!frameReader || !cursor || !buffer || !bytesRead) return ERROR_NULL_ARGUMENT;
+    FrameReaderData *this = (FrameReaderData *) frameReader;
+    *bytesRead = 0;
+    if (cursor->isFailed) return ERROR_NOT_FOUND;
+    FrameReaderWrite write = {.reader = this, .cursor = cursor, .buffer = buffer, .length = length};
+    if (this->hasCarry && length > 0) {
+        buffer[0] = this->carry;
+        this->hasCarry = false;
+        write.written = 1;
+    }
+    Error err = ERROR_NONE;
+    while (write.written < length && !this->isEOIRead && !cursor->isFailed && cursor->bytesRemaining > 0) {
+        uint8_t *chunk = buffer + write.written;
+        const size_t chunkLength = length - write.written < cursor->bytesRemaining ?
+                                   length - write.written : cursor->bytesRemaining;
+        err = this->fifoRead(this->context, chunk, chunkLength);
+        if (err != ERROR_NONE) {
+            cursor->isFailed = true;
+            break;
+        }
+        cursor->bytesRemaining -= chunkLength;
+        jpegScanner_scan(this->jpegScanner, chunk, chunkLength, frameReader_segmentCallback, &write);
+    }
+    if (!this->isEOIRead && cursor->bytesRemaining == 0) cursor->isFailed = true; // the FIFO ran out first
+    cursor->bytesRead += write.written;
+    cursor->isComplete = this->isEOIRead && !this->hasCarry;
+    *bytesRead = write.written;
+    if (err != ERROR_NONE) return err;
+    return cursor->isFailed ? ERROR_NOT_FOUND : ERROR_NONE;
+}
+
+public uint32_t frameReader_close(FrameReader *frameReader, const CameraFrameCursor *cursor) {
+    if (!frameReader || !cursor) return 0;
+    FrameReaderData *this = (FrameReaderData *) frameReader;
+    jpegScanner_finish(this->jpegScanner, NULL, NULL);
+    this->isPrefixPending = false;
+    this->hasCarry = false;
+    this->isEOIRead = false;
+    return cursor->bytesRemaining;
+}
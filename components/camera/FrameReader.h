@@ -0,0 +1,38 @@
+#ifndef ESP32_REMOTECAMERA_FRAMEREADER_H
+#define ESP32_REMOTECAMERA_FRAMEREADER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include "JPEGScanner.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Reads one JPEG out of the FIFO into the caller's buffers in reads of any length, each read goes straight into the
+ * caller's buffer and is scanned there, the padding before the SOI is trimmed by moving the frame's bytes down in
+ * place and nothing after the EOI is given out. A SOI split across 2 reads leaves one byte over, which is carried
+ * into the next read. Knows nothing about SPI, the FIFO is read through fifoRead so it can be tested against a fake
+ */
+typedef void FrameReader;
+
+/** Read length bytes out of the FIFO into buffer */
+typedef Error FrameReaderFIFORead(void *context, uint8_t *buffer, const size_t length);
+
+/** The scanner is the caller's, so frames read here count in its stats */
+extern FrameReader *frameReader_create(JPEGScanner *jpegScanner, FrameReaderFIFORead *fifoRead, void *context);
+
+extern void frameReader_destroy(FrameReader *frameReader);
+
+/** Start reading a frame out of a FIFO holding fifoBytes, one frame is read at a time */
+extern void frameReader_open(FrameReader *frameReader, const uint32_t fifoBytes, CameraFrameCursor *cursor);
+
+/** Read up to length of the frame's next bytes into buffer, see camera_readFrame() */
+extern Error frameReader_read(FrameReader *frameReader, CameraFrameCursor *cursor, uint8_t *buffer,
+                              const size_t length, size_t *bytesRead);
+
+/** Done with the frame however far it was read, returns the FIFO bytes that were never read */
+extern uint32_t frameReader_close(FrameReader *frameReader, const CameraFrameCursor *cursor);
+
+#endif //ESP32_REMOTECAMERA_FRAMEREADER_H
@@ -0,0 +1,87 @@
+#include "Histogram.h"
+#include <stdlib.h>
+
+typedef struct HistogramData {
+    uint32_t buckets[HISTOGRAM_BUCKET_COUNT];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} HistogramData;
+
+private uint histogram_bucketIndex(const uint32_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) return value;
+    const uint exponent = 31 - __builtin_clz(value); // >= HISTOGRAM_SUB_BUCKET_BITS
+    const uint shift = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+    const uint subBucket = (value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return ((shift + 1) * HISTOGRAM_SUB_BUCKETS) + subBucket;
+}
+
+/** Highest value that falls in bucket index */
+private uint32_t histogram_bucketUpperBound(const uint index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) return index;
+    const uint shift = (index / HISTOGRAM_SUB_BUCKETS) - 1;
+    const uint subBucket = index % HISTOGRAM_SUB_BUCKETS;
+    const uint64_t lowerBound = ((uint64_t) (HISTOGRAM_SUB_BUCKETS + subBucket)) << shift;
+    return (uint32_t) (lowerBound + (((uint64_t) 1) << shift) - 1);
+}
+
+public Histogram *histogram_create() {
+    HistogramData *this = new(HistogramData);
+    if (!this) return NULL;
+    histogram_reset(this);
+    return this;
+}
+
+public void histogram_destroy(Histogram *histogram) {
+    delete(histogram);
+}
+
+public void histogram_record(Histogram *histogram, const uint32_t value) {
+    if (!histogram) return;
+    HistogramData *this = (HistogramData *) histogram;
+    this->buckets[histogram_bucketIndex(value)]++;
+    if (value < this->min) this->min = value;
+    if (value > this->max) this->max = value;
+    this->sum += value;
+    this->count++;
+}
+
+public void histogram_reset(Histogram *histogram) {
+    if (!histogram) return;
+    HistogramData *this = (HistogramData *) histogram;
+    *this = (HistogramData) {.min = UINT32_MAX};
+}
+
+public uint32_t histogram_getPercentile(const Histogram *histogram, const uint32_t percentile) {
+    if (!histogram) return 0;
+    const HistogramData *this = (const HistogramData *) histogram;
+    if (this->count == 0) return 0;
+    // the rank of the value at percentile, rounded up so p100 is the last value and p0 the first
+    uint64_t rank = (((uint64_t) this->count * (percentile > 100 ? 100 : percentile)) + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (uint i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        seen += this->buckets[i];
+        if (seen >= rank) {
+            const uint32_t upperBound = histogram_bucketUpperBound(i);
+            if (upperBound > this->max) return this->max;
+            return upperBound < this->min ? this->min : upperBound;
+        }
+    }
+    return this->max;
+}
+
+public void histogram_getSummary(const Histogram *histogram, CameraStatsSummary *summary) {
+    if (!histogram || !summary) return;
+    const HistogramData *this = (const HistogramData *) histogram;
+    *summary = (CameraStatsSummary) {
+            .count = this->count,
+            .min = this->count > 0 ? this->min : 0,
+            .max = this->max,
+            .mean = this->count > 0 ? (uint32_t) (this->sum / this->count) : 0,
+            .p50 = histogram_getPercentile(histogram, 50),
+            .p95 = histogram_getPercentile(histogram, 95),
+            .p99 = histogram_getPercentile(histogram, 99),
+    };
+}
@@ -0,0 +1,36 @@
+#ifndef ESP32_REMOTECAMERA_HISTOGRAM_H
+#define ESP32_REMOTECAMERA_HISTOGRAM_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Fixed bucket histogram of uint32_t values, every power of 2 is split into HISTOGRAM_SUB_BUCKETS equal buckets so
+ * a bucket is never wider than a quarter of its lowest value, recording is a few shifts and an increment with no
+ * allocation, formatting or locking, so it can be done on every frame of the capture hot path
+ */
+typedef void Histogram;
+
+#define HISTOGRAM_SUB_BUCKET_BITS 2
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+/** Values below HISTOGRAM_SUB_BUCKETS get a bucket each, then HISTOGRAM_SUB_BUCKETS for every power of 2 above */
+#define HISTOGRAM_BUCKET_COUNT ((32 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+extern Histogram *histogram_create();
+
+extern void histogram_destroy(Histogram *histogram);
+
+extern void histogram_record(Histogram *histogram, const uint32_t value);
+
+extern void histogram_reset(Histogram *histogram);
+
+/** The value at percentile (0 to 100), an upper bound of the bucket it falls in but never more than the max,
+ * 0 when nothing was recorded */
+extern uint32_t histogram_getPercentile(const Histogram *histogram, const uint32_t percentile);
+
+extern void histogram_getSummary(const Histogram *histogram, CameraStatsSummary *summary);
+
+#endif //ESP32_REMOTECAMERA_HISTOGRAM_H
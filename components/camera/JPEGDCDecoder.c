@@ -0,0 +1,616 @@
+#include "JPEGDCDecoder.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JPEG_MARKER_PREFIX 0xFF
+#define JPEG_MARKER_SOF0 0xC0
+#define JPEG_MARKER_SOF1 0xC1
+#define JPEG_MARKER_DHT 0xC4
+#define JPEG_MARKER_JPG 0xC8
+#define JPEG_MARKER_DAC 0xCC
+#define JPEG_MARKER_RST0 0xD0
+#define JPEG_MARKER_RST7 0xD7
+#define JPEG_MARKER_SOI 0xD8
+#define JPEG_MARKER_EOI 0xD9
+#define JPEG_MARKER_SOS 0xDA
+#define JPEG_MARKER_DQT 0xDB
+#define JPEG_MARKER_DRI 0xDD
+#define JPEG_MARKER_TEM 0x01
+#define JPEG_STUFFED_ZERO 0x00
+
+#define JPEG_BLOCK_COEFFICIENTS 64
+#define JPEG_MAX_CODE_LENGTH 16
+#define JPEG_MAX_BLOCKS_PER_MCU 10
+#define JPEG_MAX_SAMPLING 4
+#define JPEG_HUFFMAN_TABLES 2 // per class, baseline only allows 2 DC and 2 AC tables
+#define JPEG_QUANT_TABLES 4
+
+/** Only the segments the decoder reads are kept, DHT is the largest, the OV5642's is 418 bytes */
+#define JPEG_DC_DECODER_SEGMENT_BYTES 1024
+/** Codes this long or shorter are decoded with one table lookup, nearly all codes in practice */
+#define JPEG_DC_DECODER_LOOKUP_BITS 9
+/** Enough bits for the longest step, a 16 bit code and 11 bits of value */
+#define JPEG_DC_DECODER_STEP_BITS 32
+
+typedef enum JPEGDCDecoderState {
+    JPEG_DC_DECODER_STATE_MARKER_PREFIX = 0,
+    JPEG_DC_DECODER_STATE_MARKER,
+    JPEG_DC_DECODER_STATE_LENGTH_HIGH,
+    JPEG_DC_DECODER_STATE_LENGTH_LOW,
+    JPEG_DC_DECODER_STATE_SEGMENT,
+    JPEG_DC_DECODER_STATE_ENTROPY,
+    JPEG_DC_DECODER_STATE_ENTROPY_MARKER,
+    JPEG_DC_DECODER_STATE_DONE,
+    JPEG_DC_DECODER_STATE_FAILED,
+} JPEGDCDecoderState;
+
+typedef struct HuffmanTable {
+    bool isDefined;
+    /** (code length << 8) | symbol for every code of at most JPEG_DC_DECODER_LOOKUP_BITS, 0 for longer codes */
+    uint16_t lookup[1 << JPEG_DC_DECODER_LOOKUP_BITS];
+    /** Largest code of each length, -1 when there are no codes of that length */
+    int32_t maxCode[JPEG_MAX_CODE_LENGTH + 1];
+    /** Added to a code of each length to get its index into values */
+    int32_t valueOffset[JPEG_MAX_CODE_LENGTH + 1];
+    uint8_t values[256];
+} HuffmanTable;
+
+/** Where the decoder is in the entropy coded data of a scan */
+typedef struct EntropyState {
+    uint64_t bits;
+    uint32_t bitCount;
+    /** 1 bits added after the scan's last byte so its last symbols can be decoded, none may be used */
+    uint32_t paddingBits;
+    uint32_t mcuIndex;
+    /** MCU the next restart marker or the end of the scan comes after */
+    uint32_t mcuTarget;
+    uint32_t block;
+    uint32_t coefficientIndex;
+    int32_t dcPredictors[JPEG_DC_DECODER_MAX_COMPONENTS];
+    JPEGDCDecoderBlock output;
+} EntropyState;
+
+typedef struct JPEGDCDecoderData {
+    JPEGDCDecoderState state;
+    uint8_t marker;
+    size_t segmentLength;
+    size_t segmentPosition;
+    uint8_t segment[JPEG_DC_DECODER_SEGMENT_BYTES];
+    JPEGDCDecoderStats stats;
+    JPEGDCDecoderInfo info;
+    bool hasSOI;
+    bool hasFrame;
+    uint8_t componentQuantTables[JPEG_DC_DECODER_MAX_COMPONENTS];
+    uint16_t quantTables[JPEG_QUANT_TABLES][JPEG_BLOCK_COEFFICIENTS]; // zigzag order, as in DQT
+    HuffmanTable dcTables[JPEG_HUFFMAN_TABLES];
+    HuffmanTable acTables[JPEG_HUFFMAN_TABLES];
+    struct {
+        /** Every block of an MCU in decode order, the block's component and its position within the MCU */
+        uint8_t blockComponents[JPEG_MAX_BLOCKS_PER_MCU];
+        uint8_t blockX[JPEG_MAX_BLOCKS_PER_MCU];
+        uint8_t blockY[JPEG_MAX_BLOCKS_PER_MCU];
+        const HuffmanTable *dcTables[JPEG_MAX_BLOCKS_PER_MCU];
+        const HuffmanTable *acTables[JPEG_MAX_BLOCKS_PER_MCU];
+        uint32_t blockCount;
+        uint32_t mcusWide;
+        uint32_t mcuCount;
+        bool isInterleaved;
+    } scan;
+    EntropyState entropy;
+    uint32_t componentMask;
+    uint32_t coefficientCount;
+    JPEGDCDecoderCallback *callback;
+    void *userArg;
+} JPEGDCDecoderData;
+
+private uint16_t getUInt16(const uint8_t *bytes) {
+    return (bytes[0] << 8) | bytes[1];
+}
+
+private uint32_t divideRoundingUp(const uint32_t dividend, const uint32_t divisor) {
+    return (dividend + divisor - 1) / divisor;
+}
+
+private bool jpegDCDecoder_isBufferedSegment(const uint8_t marker) {
+    return marker == JPEG_MARKER_SOF0 || marker == JPEG_MARKER_SOF1 || marker == JPEG_MARKER_DHT ||
+           marker == JPEG_MARKER_DQT || marker == JPEG_MARKER_DRI || marker == JPEG_MARKER_SOS;
+}
+
+/** Every other SOF is progressive, lossless, hierarchical or arithmetic coded */
+private bool jpegDCDecoder_isUnsupportedFrame(const uint8_t marker) {
+    return marker > JPEG_MARKER_SOF1 && marker <= 0xCF && marker != JPEG_MARKER_DHT && marker != JPEG_MARKER_JPG &&
+           marker != JPEG_MARKER_DAC;
+}
+
+private bool jpegDCDecoder_buildHuffmanTable(HuffmanTable *table, const uint8_t *counts, const uint8_t *values,
+                                             const uint32_t valueCount) {
+    memset(table, 0, sizeof(HuffmanTable));
+    memcpy(table->values, values, valueCount);
+    uint32_t code = 0;
+    uint32_t index = 0;
+    for (uint32_t length = 1; length <= JPEG_MAX_CODE_LENGTH; length++) {
+        const uint32_t count = counts[length - 1];
+        table->valueOffset[length] = (int32_t) index - (int32_t) code;
+        for (uint32_t i = 0; i < count; i++, code++, index++) {
+            if (length <= JPEG_DC_DECODER_LOOKUP_BITS) {
+                const uint32_t shift = JPEG_DC_DECODER_LOOKUP_BITS - length;
+                for (uint32_t fill = 0; fill < (1U << shift); fill++) {
+                    table->lookup[(code << shift) | fill] = (length << 8) | values[index];
+                }
+            }
+        }
+        if (code > (1U << length)) return false; // more codes than there are of this length
+        table->maxCode[length] = count > 0 ? (int32_t) code - 1 : -1;
+        code <<= 1;
+    }
+    table->isDefined = true;
+    return true;
+}
+
+private bool jpegDCDecoder_readDHT(JPEGDCDecoderData *this) {
+    size_t position = 0;
+    while (position < this->segmentLength) {
+        if (position + 1 + JPEG_MAX_CODE_LENGTH > this->segmentLength) return false;
+        const uint8_t tableClass = this->segment[position] >> 4;
+        const uint8_t tableIndex = this->segment[position] & 0x0F;
+        if (tableClass > 1 || tableIndex >= JPEG_HUFFMAN_TABLES) return false;
+        const uint8_t *counts = this->segment + position + 1;
+        uint32_t valueCount = 0;
+        for (uint32_t i = 0; i < JPEG_MAX_CODE_LENGTH; i++) valueCount += counts[i];
+        position += 1 + JPEG_MAX_CODE_LENGTH;
+        if (valueCount > 256 || position + valueCount > this->segmentLength) return false;
+        HuffmanTable *table = tableClass == 0 ? &this->dcTables[tableIndex] : &this->acTables[tableIndex];
+        if (!jpegDCDecoder_buildHuffmanTable(table, counts, this->segment + position, valueCount)) return false;
+        position += valueCount;
+    }
+    return true;
+}
+
+private bool jpegDCDecoder_readDQT(JPEGDCDecoderData *this) {
+    size_t position = 0;
+    while (position < this->segmentLength) {
+        const bool is16Bit = (this->segment[position] >> 4) != 0;
+        const uint8_t tableIndex = this->segment[position] & 0x0F;
+        const size_t tableBytes = JPEG_BLOCK_COEFFICIENTS * (is16Bit ? 2 : 1);
+        if (tableIndex >= JPEG_QUANT_TABLES || position + 1 + tableBytes > this->segmentLength) return false;
+        const uint8_t *values = this->segment + position + 1;
+        for (uint32_t i = 0; i < JPEG_BLOCK_COEFFICIENTS; i++) {
+            this->quantTables[tableIndex][i] = is16Bit ? getUInt16(values + (i * 2)) : values[i];
+        }
+        position += 1 + tableBytes;
+    }
+    return true;
+}
+
+private bool jpegDCDecoder_readSOF(JPEGDCDecoderData *this) {
+    if (this->segmentLength < 6) return false;
+    const uint8_t precision = this->segment[0];
+    const uint32_t height = getUInt16(this->segment + 1);
+    const uint32_t width = getUInt16(this->segment + 3);
+    const uint32_t componentCount = this->segment[5];
+    if (precision != 8 || width == 0 || height == 0 || componentCount == 0 ||
+        componentCount > JPEG_DC_DECODER_MAX_COMPONENTS || this->segmentLength < 6 + (componentCount * 3)) {
+        return false; // a height of 0 would come in a DNL, which the OV5642 never sends
+    }
+    uint32_t maxHorizontal = 1;
+    uint32_t maxVertical = 1;
+    for (uint32_t i = 0; i < componentCount; i++) {
+        const uint8_t *bytes = this->segment + 6 + (i * 3);
+        JPEGDCDecoderComponent *component = &this->info.components[i];
+        component->id = bytes[0];
+        component->horizontalSampling = bytes[1] >> 4;
+        component->verticalSampling = bytes[1] & 0x0F;
+        this->componentQuantTables[i] = bytes[2];
+        if (component->horizontalSampling == 0 || component->horizontalSampling > JPEG_MAX_SAMPLING ||
+            component->verticalSampling == 0 || component->verticalSampling > JPEG_MAX_SAMPLING ||
+            bytes[2] >= JPEG_QUANT_TABLES) {
+            return false;
+        }
+        if (component->horizontalSampling > maxHorizontal) maxHorizontal = component->horizontalSampling;
+        if (component->verticalSampling > maxVertical) maxVertical = component->verticalSampling;
+    }
+    for (uint32_t i = 0; i < componentCount; i++) {
+        JPEGDCDecoderComponent *component = &this->info.components[i];
+        component->blocksWide = divideRoundingUp(
+                divideRoundingUp(width * component->horizontalSampling, maxHorizontal), 8);
+        component->blocksHigh = divideRoundingUp(
+                divideRoundingUp(height * component->verticalSampling, maxVertical), 8);
+    }
+    this->info.width = width;
+    this->info.height = height;
+    this->info.componentCount = componentCount;
+    this->hasFrame = true;
+    return true;
+}
+
+private bool jpegDCDecoder_readSOS(JPEGDCDecoderData *this) {
+    if (!this->hasFrame || this->segmentLength < 1) return false;
+    const uint32_t scanComponentCount = this->segment[0];
+    if (scanComponentCount == 0 || scanComponentCount > this->info.componentCount ||
+        this->segmentLength < 1 + (scanComponentCount * 2) + 3) {
+        return false;
+    }
+    uint32_t maxHorizontal = 1;
+    uint32_t maxVertical = 1;
+    for (uint32_t i = 0; i < this->info.componentCount; i++) {
+        if (this->info.components[i].horizontalSampling > maxHorizontal) {
+            maxHorizontal = this->info.components[i].horizontalSampling;
+        }
+        if (this->info.components[i].verticalSampling > maxVertical) {
+            maxVertical = this->info.components[i].verticalSampling;
+        }
+    }
+    this->scan.isInterleaved = scanComponentCount > 1;
+    this->scan.blockCount = 0;
+    for (uint32_t i = 0; i < scanComponentCount; i++) {
+        const uint8_t *bytes = this->segment + 1 + (i * 2);
+        uint32_t componentIndex = 0;
+        while (componentIndex < this->info.componentCount && this->info.components[componentIndex].id != bytes[0]) {
+            componentIndex++;
+        }
+        const uint8_t dcTable = bytes[1] >> 4;
+        const uint8_t acTable = bytes[1] & 0x0F;
+        if (componentIndex == this->info.componentCount || dcTable >= JPEG_HUFFMAN_TABLES ||
+            acTable >= JPEG_HUFFMAN_TABLES || !this->dcTables[dcTable].isDefined ||
+            !this->acTables[acTable].isDefined) {
+            return false;
+        }
+        const JPEGDCDecoderComponent *component = &this->info.components[componentIndex];
+        // a component alone in its scan has an MCU of 1 block, whatever its sampling
+        const uint32_t blocksWide = this->scan.isInterleaved ? component->horizontalSampling : 1;
+        const uint32_t blocksHigh = this->scan.isInterleaved ? component->verticalSampling : 1;
+        for (uint32_t y = 0; y < blocksHigh; y++) {
+            for (uint32_t x = 0; x < blocksWide; x++) {
+                if (this->scan.blockCount == JPEG_MAX_BLOCKS_PER_MCU) return false;
+                const uint32_t block = this->scan.blockCount++;
+                this->scan.blockComponents[block] = componentIndex;
+                this->scan.blockX[block] = x;
+                this->scan.blockY[block] = y;
+                this->scan.dcTables[block] = &this->dcTables[dcTable];
+                this->scan.acTables[block] = &this->acTables[acTable];
+            }
+        }
+        if (!this->scan.isInterleaved) {
+            this->scan.mcusWide = component->blocksWide;
+            this->scan.mcuCount = component->blocksWide * component->blocksHigh;
+        }
+    }
+    if (this->scan.isInterleaved) {
+        this->scan.mcusWide = divideRoundingUp(this->info.width, 8 * maxHorizontal);
+        this->scan.mcuCount = this->scan.mcusWide * divideRoundingUp(this->info.height, 8 * maxVertical);
+    }
+    memset(&this->entropy, 0, sizeof(this->entropy));
+    this->entropy.output.info = &this->info;
+    this->entropy.mcuTarget = this->info.restartInterval > 0 && this->info.restartInterval < this->scan.mcuCount ?
+                              this->info.restartInterval : this->scan.mcuCount;
+    return true;
+}
+
+private bool jpegDCDecoder_readSegment(JPEGDCDecoderData *this) {
+    switch (this->marker) {
+        case JPEG_MARKER_SOF0:
+        case JPEG_MARKER_SOF1:
+            return jpegDCDecoder_readSOF(this);
+        case JPEG_MARKER_DHT:
+            return jpegDCDecoder_readDHT(this);
+        case JPEG_MARKER_DQT:
+            return jpegDCDecoder_readDQT(this);
+        case JPEG_MARKER_DRI:
+            if (this->segmentLength < 2) return false;
+            this->info.restartInterval = getUInt16(this->segment);
+            return true;
+        case JPEG_MARKER_SOS:
+            return jpegDCDecoder_readSOS(this);
+        default:
+            return true;
+    }
+}
+
+private uint32_t jpegDCDecoder_peekBits(const JPEGDCDecoderData *this, const uint32_t count) {
+    return (uint32_t) (this->entropy.bits >> (this->entropy.bitCount - count)) & ((1U << count) - 1);
+}
+
+private int32_t jpegDCDecoder_decodeHuffman(JPEGDCDecoderData *this, const HuffmanTable *table) {
+    const uint16_t entry = table->lookup[jpegDCDecoder_peekBits(this, JPEG_DC_DECODER_LOOKUP_BITS)];
+    if (entry != 0) {
+        this->entropy.bitCount -= entry >> 8;
+        return entry & 0xFF;
+    }
+    for (uint32_t length = JPEG_DC_DECODER_LOOKUP_BITS + 1; length <= JPEG_MAX_CODE_LENGTH; length++) {
+        const int32_t code = (int32_t) jpegDCDecoder_peekBits(this, length);
+        if (code <= table->maxCode[length]) {
+            this->entropy.bitCount -= length;
+            return table->values[code + table->valueOffset[length]];
+        }
+    }
+    return -1;
+}
+
+/** The value of a size bit magnitude category, a leading 0 bit means negative */
+private int32_t jpegDCDecoder_receiveExtend(JPEGDCDecoderData *this, const uint32_t size) {
+    if (size == 0) return 0;
+    const int32_t value = (int32_t) jpegDCDecoder_peekBits(this, size);
+    this->entropy.bitCount -= size;
+    return value < (1 << (size - 1)) ? value - (1 << size) + 1 : value;
+}
+
+private void jpegDCDecoder_finishBlock(JPEGDCDecoderData *this) {
+    EntropyState *entropy = &this->entropy;
+    const uint32_t block = entropy->block;
+    const uint32_t component = this->scan.blockComponents[block];
+    if (this->callback && (this->componentMask & (1U << component))) {
+        const JPEGDCDecoderComponent *info = &this->info.components[component];
+        const uint32_t mcuX = entropy->mcuIndex % this->scan.mcusWide;
+        const uint32_t mcuY = entropy->mcuIndex / this->scan.mcusWide;
+        const uint32_t x = this->scan.isInterleaved ?
+                           (mcuX * info->horizontalSampling) + this->scan.blockX[block] : mcuX;
+        const uint32_t y = this->scan.isInterleaved ?
+                           (mcuY * info->verticalSampling) + this->scan.blockY[block] : mcuY;
+        if (x < info->blocksWide && y < info->blocksHigh) { // not an MCU's padding past the image's edge
+            const uint16_t *quantTable = this->quantTables[this->componentQuantTables[component]];
+            entropy->output.component = component;
+            entropy->output.x = x;
+            entropy->output.y = y;
+            for (uint32_t i = 0; i < this->coefficientCount; i++) entropy->output.coefficients[i] *= quantTable[i];
+            this->callback(&entropy->output, this->userArg);
+        }
+    }
+    memset(entropy->output.coefficients, 0, sizeof(entropy->output.coefficients));
+    this->stats.blocksDecoded++;
+    entropy->coefficientIndex = 0;
+    if (++entropy->block == this->scan.blockCount) {
+        entropy->block = 0;
+        entropy->mcuIndex++;
+    }
+}
+
+/** Decodes one Huffman symbol and its value, a DC difference or an AC run and coefficient */
+private bool jpegDCDecoder_step(JPEGDCDecoderData *this) {
+    EntropyState *entropy = &this->entropy;
+    const uint32_t block = entropy->block;
+    if (entropy->coefficientIndex == 0) {
+        const int32_t size = jpegDCDecoder_decodeHuffman(this, this->scan.dcTables[block]);
+        if (size < 0 || size > 11) return false;
+        const uint32_t component = this->scan.blockComponents[block];
+        entropy->dcPredictors[component] += jpegDCDecoder_receiveExtend(this, size);
+        entropy->output.coefficients[0] = entropy->dcPredictors[component];
+        entropy->coefficientIndex = 1;
+        return true;
+    }
+    const int32_t symbol = jpegDCDecoder_decodeHuffman(this, this->scan.acTables[block]);
+    if (symbol < 0) return false;
+    const uint32_t run = symbol >> 4;
+    const uint32_t size = symbol & 0x0F;
+    if (size == 0) {
+        if (run == 15) { // 16 zeros
+            entropy->coefficientIndex += 16;
+            if (entropy->coefficientIndex > JPEG_BLOCK_COEFFICIENTS) return false;
+        } else { // end of block, every coefficient left is 0
+            entropy->coefficientIndex = JPEG_BLOCK_COEFFICIENTS;
+        }
+    } else {
+        entropy->coefficientIndex += run;
+        if (entropy->coefficientIndex >= JPEG_BLOCK_COEFFICIENTS) return false;
+        const int32_t value = jpegDCDecoder_receiveExtend(this, size);
+        if (entropy->coefficientIndex < this->coefficientCount) {
+            entropy->output.coefficients[entropy->coefficientIndex] = value;
+        }
+        entropy->coefficientIndex++;
+    }
+    if (entropy->coefficientIndex == JPEG_BLOCK_COEFFICIENTS) jpegDCDecoder_finishBlock(this);
+    return true;
+}
+
+/** Decode the rest of the MCUs before a restart marker or the end of the scan, the last symbols can be shorter
+ * than a step so the bits are padded with 1s like the encoder pads the last byte, decoding into the padding means
+ * the scan ended early */
+private bool jpegDCDecoder_drain(JPEGDCDecoderData *this) {
+    EntropyState *entropy = &this->entropy;
+    while (entropy->mcuIndex < entropy->mcuTarget) {
+        while (entropy->bitCount < JPEG_DC_DECODER_STEP_BITS) {
+            entropy->bits = (entropy->bits << 8) | 0xFF;
+            entropy->bitCount += 8;
+            entropy->paddingBits += 8;
+        }
+        if (!jpegDCDecoder_step(this) || entropy->bitCount < entropy->paddingBits) return false;
+    }
+    return true;
+}
+
+private bool jpegDCDecoder_restart(JPEGDCDecoderData *this) {
+    EntropyState *entropy = &this->entropy;
+    if (!jpegDCDecoder_drain(this)) return false;
+    entropy->bits = 0;
+    entropy->bitCount = 0;
+    entropy->paddingBits = 0;
+    memset(entropy->dcPredictors, 0, sizeof(entropy->dcPredictors));
+    entropy->mcuTarget += this->info.restartInterval;
+    if (entropy->mcuTarget > this->scan.mcuCount) entropy->mcuTarget = this->scan.mcuCount;
+    return true;
+}
+
+/** Entropy coded byte, decoding as many symbols as there are enough bits for */
+private bool jpegDCDecoder_pushByte(JPEGDCDecoderData *this, const uint8_t byte) {
+    EntropyState *entropy = &this->entropy;
+    if (entropy->mcuIndex >= entropy->mcuTarget) return true; // past the target is the last byte's padding
+    entropy->bits = (entropy->bits << 8) | byte;
+    entropy->bitCount += 8;
+    while (entropy->bitCount >= JPEG_DC_DECODER_STEP_BITS && entropy->mcuIndex < entropy->mcuTarget) {
+        if (!jpegDCDecoder_step(this)) return false;
+    }
+    return true;
+}
+
+/** Entropy coded bytes of the scan, returns how many were used, stops at a 0xFF which may start a marker */
+private size_t jpegDCDecoder_decodeEntropy(JPEGDCDecoderData *this, const uint8_t *bytes, const size_t length,
+                                           bool *isFailed) {
+    size_t i = 0;
+    while (i < length && bytes[i] != JPEG_MARKER_PREFIX) {
+        if (!jpegDCDecoder_pushByte(this, bytes[i++])) {
+            *isFailed = true;
+            break;
+        }
+    }
+    return i;
+}
+
+private void jpegDCDecoder_fail(JPEGDCDecoderData *this) {
+    this->state = JPEG_DC_DECODER_STATE_FAILED;
+    this->stats.framesFailed++;
+}
+
+/** A marker byte after 0xFF, in the headers or ending the entropy coded data */
+private void jpegDCDecoder_onMarker(JPEGDCDecoderData *this, const uint8_t marker) {
+    if (marker == JPEG_MARKER_PREFIX) return; // fill byte, the marker is still to come
+    const bool isInScan = this->state == JPEG_DC_DECODER_STATE_ENTROPY_MARKER;
+    if (isInScan && marker == JPEG_STUFFED_ZERO) {
+        this->state = JPEG_DC_DECODER_STATE_ENTROPY;
+        if (!jpegDCDecoder_pushByte(this, JPEG_MARKER_PREFIX)) jpegDCDecoder_fail(this);
+        return;
+    }
+    if (isInScan && marker >= JPEG_MARKER_RST0 && marker <= JPEG_MARKER_RST7) {
+        this->state = JPEG_DC_DECODER_STATE_ENTROPY;
+        if (this->info.restartInterval == 0 || !jpegDCDecoder_restart(this)) jpegDCDecoder_fail(this);
+        return;
+    }
+    if (isInScan) { // any other marker ends the scan, a frame with one scan per component has more to come
+        this->entropy.mcuTarget = this->scan.mcuCount;
+        if (!jpegDCDecoder_drain(this)) {
+            jpegDCDecoder_fail(this);
+            return;
+        }
+    }
+    if (!this->hasSOI && marker != JPEG_MARKER_SOI) { // the middle of a frame, or not a JPEG
+        jpegDCDecoder_fail(this);
+    } else if (marker == JPEG_MARKER_EOI) {
+        this->state = JPEG_DC_DECODER_STATE_DONE;
+        this->stats.framesDecoded++;
+    } else if (marker == JPEG_MARKER_SOI) {
+        this->hasSOI = true;
+        this->state = JPEG_DC_DECODER_STATE_MARKER_PREFIX;
+    } else if (marker == JPEG_MARKER_TEM ||
+               (marker >= JPEG_MARKER_RST0 && marker <= JPEG_MARKER_RST7)) {
+        this->state = JPEG_DC_DECODER_STATE_MARKER_PREFIX; // markers with no segment
+    } else if (jpegDCDecoder_isUnsupportedFrame(marker) || marker == JPEG_STUFFED_ZERO) {
+        jpegDCDecoder_fail(this);
+    } else {
+        this->marker = marker;
+        this->state = JPEG_DC_DECODER_STATE_LENGTH_HIGH;
+    }
+}
+
+public JPEGDCDecoder *jpegDCDecoder_create() {
+    JPEGDCDecoderData *this = new(JPEGDCDecoderData);
+    if (!this) return NULL;
+    this->state = JPEG_DC_DECODER_STATE_DONE;
+    return this;
+}
+
+public void jpegDCDecoder_destroy(JPEGDCDecoder *jpegDCDecoder) {
+    delete(jpegDCDecoder);
+}
+
+public Error jpegDCDecoder_begin(JPEGDCDecoder *jpegDCDecoder, const uint32_t componentMask,
+                                 const uint32_t coefficientCount, JPEGDCDecoderCallback callback, void *userArg) {
+    if (!jpegDCDecoder) return ERROR_NULL_ARGUMENT;
+    if (coefficientCount == 0 || coefficientCount > JPEG_DC_DECODER_MAX_COEFFICIENTS) return ERROR_OUT_OF_BOUNDS;
+    JPEGDCDecoderData *this = (JPEGDCDecoderData *) jpegDCDecoder;
+    // tables are kept, a stream of frames from the same encoder defines the same ones in every frame anyway
+    this->state = JPEG_DC_DECODER_STATE_MARKER_PREFIX;
+    this->info = (JPEGDCDecoderInfo) {.width = 0};
+    this->hasSOI = false;
+    this->hasFrame = false;
+    this->componentMask = componentMask;
+    this->coefficientCount = coefficientCount;
+    this->callback = callback;
+    this->userArg = userArg;
+    return ERROR_NONE;
+}
+
+public Error jpegDCDecoder_decode(JPEGDCDecoder *jpegDCDecoder, const uint8_t *bytes, const size_t length) {
+    if (!jpegDCDecoder) return ERROR_NULL_ARGUMENT;
+    if (length > 0 && !bytes) return ERROR_NULL_ARGUMENT;
+    JPEGDCDecoderData *this = (JPEGDCDecoderData *) jpegDCDecoder;
+    size_t i = 0;
+    while (i < length) {
+        switch (this->state) {
+            case JPEG_DC_DECODER_STATE_MARKER_PREFIX:
+                if (bytes[i++] != JPEG_MARKER_PREFIX) jpegDCDecoder_fail(this);
+                else this->state = JPEG_DC_DECODER_STATE_MARKER;
+                break;
+            case JPEG_DC_DECODER_STATE_MARKER:
+            case JPEG_DC_DECODER_STATE_ENTROPY_MARKER:
+                jpegDCDecoder_onMarker(this, bytes[i++]);
+                break;
+            case JPEG_DC_DECODER_STATE_LENGTH_HIGH:
+                this->segmentLength = bytes[i++] << 8;
+                this->state = JPEG_DC_DECODER_STATE_LENGTH_LOW;
+                break;
+            case JPEG_DC_DECODER_STATE_LENGTH_LOW:
+                this->segmentLength |= bytes[i++];
+                if (this->segmentLength < 2 || (jpegDCDecoder_isBufferedSegment(this->marker) &&
+                                                this->segmentLength - 2 > JPEG_DC_DECODER_SEGMENT_BYTES)) {
+                    jpegDCDecoder_fail(this);
+                    break;
+                }
+                this->segmentLength -= 2; // the length counts itself
+                this->segmentPosition = 0;
+                this->state = JPEG_DC_DECODER_STATE_SEGMENT;
+                if (this->segmentLength > 0) break;
+                // an empty segment is already complete
+                // fall through
+            case JPEG_DC_DECODER_STATE_SEGMENT: {
+                size_t count = this->segmentLength - this->segmentPosition;
+                if (count > length - i) count = length - i;
+                if (jpegDCDecoder_isBufferedSegment(this->marker)) {
+                    memcpy(this->segment + this->segmentPosition, bytes + i, count);
+                }
+                this->segmentPosition += count;
+                i += count;
+                if (this->segmentPosition < this->segmentLength) break;
+                if (!jpegDCDecoder_readSegment(this)) {
+                    jpegDCDecoder_fail(this);
+                } else {
+                    this->state = this->marker == JPEG_MARKER_SOS ? JPEG_DC_DECODER_STATE_ENTROPY :
+                                  JPEG_DC_DECODER_STATE_MARKER_PREFIX;
+                }
+                break;
+            }
+            case JPEG_DC_DECODER_STATE_ENTROPY: {
+                bool isFailed = false;
+                i += jpegDCDecoder_decodeEntropy(this, bytes + i, length - i, &isFailed);
+                if (isFailed) {
+                    jpegDCDecoder_fail(this);
+                } else if (i < length) { // stopped at a 0xFF
+                    this->state = JPEG_DC_DECODER_STATE_ENTROPY_MARKER;
+                    i++;
+                }
+                break;
+            }
+            case JPEG_DC_DECODER_STATE_DONE:
+                return ERROR_NONE;
+            case JPEG_DC_DECODER_STATE_FAILED:
+                return ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+    return this->state == JPEG_DC_DECODER_STATE_FAILED ? ERROR_ILLEGAL_ARGUMENT : ERROR_NONE;
+}
+
+public bool jpegDCDecoder_isDone(const JPEGDCDecoder *jpegDCDecoder) {
+    if (!jpegDCDecoder) return false;
+    return ((const JPEGDCDecoderData *) jpegDCDecoder)->state == JPEG_DC_DECODER_STATE_DONE;
+}
+
+public Error jpegDCDecoder_getInfo(const JPEGDCDecoder *jpegDCDecoder, JPEGDCDecoderInfo *info) {
+    if (!jpegDCDecoder || !info) return ERROR_NULL_ARGUMENT;
+    const JPEGDCDecoderData *this = (const JPEGDCDecoderData *) jpegDCDecoder;
+    if (!this->hasFrame) return ERROR_NOT_FOUND;
+    *info = this->info;
+    return ERROR_NONE;
+}
+
+public Error jpegDCDecoder_getStats(const JPEGDCDecoder *jpegDCDecoder, JPEGDCDecoderStats *stats) {
+    if (!jpegDCDecoder || !stats) return ERROR_NULL_ARGUMENT;
+    *stats = ((const JPEGDCDecoderData *) jpegDCDecoder)->stats;
+    return ERROR_NONE;
+}
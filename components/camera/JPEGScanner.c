@@ -0,0 +1,131 @@
+#include "JPEGScanner.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Non-zero if any byte of word is 0xFF, the classic has-zero-byte test on the inverted word */
+#define wordHasMarkerPrefix(word) (((~(word)) - 0x01010101U) & (word) & 0x80808080U)
+
+typedef struct JPEGScannerData {
+    bool isInFrame;
+    /** Last byte scanned was 0xFF, so the next byte is a marker code */
+    bool isPreviousFF;
+    /** A SOI has been seen since the last finish */
+    bool isFrameSeen;
+    size_t bytesScanned;
+    size_t frameBytesRead;
+    JPEGScannerStats stats;
+} JPEGScannerData;
+
+private const uint8_t MARKER_PREFIX = JPEG_MARKER_PREFIX;
+
+public JPEGScanner *jpegScanner_create() {
+    JPEGScannerData *this = new(JPEGScannerData);
+    return this;
+}
+
+public void jpegScanner_destroy(JPEGScanner *jpegScanner) {
+    if (!jpegScanner) return;
+    JPEGScannerData *this = (JPEGScannerData *) jpegScanner;
+    delete(this);
+}
+
+private void jpegScanner_deliver(JPEGScannerData *this, const uint8_t *segment, const size_t segmentLength,
+                                 const JPEGScannerSegmentType segmentType,
+                                 JPEGScannerCallback callback, void *userArg) {
+    this->frameBytesRead += segmentLength;
+    if (callback) callback(segment, segmentLength, this->frameBytesRead, segmentType, userArg);
+}
+
+private void jpegScanner_drop(JPEGScannerData *this, JPEGScannerCallback callback, void *userArg) {
+    this->stats.framesDropped++;
+    if (callback) callback(NULL, 0, this->frameBytesRead, JPEG_SCANNER_SEGMENT_DROPPED, userArg);
+    this->isInFrame = false;
+    this->frameBytesRead = 0;
+}
+
+public uint32_t jpegScanner_scan(JPEGScanner *jpegScanner, const uint8_t *chunk, const size_t chunkLength,
+                                 JPEGScannerCallback callback, void *userArg) {
+    if (!jpegScanner || !chunk) return 0;
+    JPEGScannerData *this = (JPEGScannerData *) jpegScanner;
+    uint32_t framesCompleted = 0;
+    size_t segmentStart = 0;
+    size_t bytesInFrames = 0;
+    size_t i = 0;
+    this->bytesScanned += chunkLength;
+    while (i < chunkLength) {
+        if (!this->isPreviousFF) { // skip whole words that cannot hold a marker
+            while (i + sizeof(uint32_t) <= chunkLength) {
+                uint32_t word;
+                memcpy(&word, chunk + i, sizeof(word));
+                if (wordHasMarkerPrefix(word)) break;
+                i += sizeof(word);
+            }
+            if (i >= chunkLength) break;
+        }
+        const uint8_t byte = chunk[i];
+        const bool isMarker = this->isPreviousFF;
+        this->isPreviousFF = byte == JPEG_MARKER_PREFIX;
+        if (isMarker && byte == JPEG_MARKER_SOI) {
+            if (this->isInFrame) { // a new frame before this one ended
+                if (i > segmentStart) bytesInFrames += (i - 1) - segmentStart;
+                jpegScanner_drop(this, callback, userArg);
+            }
+            this->isInFrame = true;
+            this->isFrameSeen = true;
+            this->frameBytesRead = 0;
+            if (i == 0) { // the 0xFF was the last byte of the previous chunk
+                jpegScanner_deliver(this, &MARKER_PREFIX, sizeof(MARKER_PREFIX), JPEG_SCANNER_SEGMENT_DATA,
+                                    callback, userArg);
+                if (this->stats.bytesSkipped > 0) this->stats.bytesSkipped--; // counted skipped in that chunk
+                segmentStart = 0;
+            } else {
+                segmentStart = i - 1;
+            }
+        } else if (isMarker && byte == JPEG_MARKER_EOI && this->isInFrame) {
+            jpegScanner_deliver(this, chunk + segmentStart, i + 1 - segmentStart, JPEG_SCANNER_SEGMENT_END,
+                                callback, userArg);
+            bytesInFrames += i + 1 - segmentStart;
+            this->stats.framesCompleted++;
+            this->stats.lastFrameBytes = this->frameBytesRead;
+            if (this->frameBytesRead > this->stats.largestFrameBytes) {
+                this->stats.largestFrameBytes = this->frameBytesRead;
+            }
+            this->isInFrame = false;
+            this->isPreviousFF = false;
+            this->frameBytesRead = 0;
+            framesCompleted++;
+        }
+        i++;
+    }
+    if (this->isInFrame && segmentStart < chunkLength) {
+        jpegScanner_deliver(this, chunk + segmentStart, chunkLength - segmentStart, JPEG_SCANNER_SEGMENT_DATA,
+                            callback, userArg);
+        bytesInFrames += chunkLength - segmentStart;
+    }
+    this->stats.bytesSkipped += chunkLength - bytesInFrames;
+    return framesCompleted;
+}
+
+public bool jpegScanner_isInFrame(const JPEGScanner *jpegScanner) {
+    if (!jpegScanner) return false;
+    return ((const JPEGScannerData *) jpegScanner)->isInFrame;
+}
+
+public void jpegScanner_finish(JPEGScanner *jpegScanner, JPEGScannerCallback callback, void *userArg) {
+    if (!jpegScanner) return;
+    JPEGScannerData *this = (JPEGScannerData *) jpegScanner;
+    if (this->isInFrame) {
+        jpegScanner_drop(this, callback, userArg);
+    } else if (!this->isFrameSeen && this->bytesScanned > 0) { // the whole readout was garbage
+        this->stats.framesDropped++;
+    }
+    this->isPreviousFF = false;
+    this->isFrameSeen = false;
+    this->bytesScanned = 0;
+}
+
+public Error jpegScanner_getStats(const JPEGScanner *jpegScanner, JPEGScannerStats *stats) {
+    if (!jpegScanner || !stats) return ERROR_NULL_ARGUMENT;
+    *stats = ((const JPEGScannerData *) jpegScanner)->stats;
+    return ERROR_NONE;
+}
@@ -0,0 +1,64 @@
+#ifndef ESP32_REMOTECAMERA_JPEGSCANNER_H
+#define ESP32_REMOTECAMERA_JPEGSCANNER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Finds JPEG frames in a stream of FIFO chunks by their SOI (FF D8) and EOI (FF D9) markers, chunks are scanned
+ * a 32-bit word at a time since only words containing a 0xFF byte can hold a marker, and a marker split across
+ * 2 chunks is still found. Only the bytes from SOI to EOI inclusive are passed on, padding the ArduChip leaves
+ * before or after a frame in the FIFO is dropped and counted
+ */
+typedef void JPEGScanner;
+
+#define JPEG_MARKER_PREFIX 0xFF
+#define JPEG_MARKER_SOI 0xD8
+#define JPEG_MARKER_EOI 0xD9
+
+typedef enum JPEGScannerSegmentType {
+    /** Frame bytes, more will follow */
+    JPEG_SCANNER_SEGMENT_DATA = 0,
+    /** Final frame bytes, ending with the EOI marker */
+    JPEG_SCANNER_SEGMENT_END = 1,
+    /** The frame was malformed (a new SOI or the end of the readout came before its EOI), segment is empty and
+     * anything already passed on for this frame should be discarded */
+    JPEG_SCANNER_SEGMENT_DROPPED = 2,
+} JPEGScannerSegmentType;
+
+typedef struct JPEGScannerStats {
+    uint32_t framesCompleted;
+    uint32_t framesDropped;
+    /** Size of the last completed frame from SOI to EOI */
+    uint32_t lastFrameBytes;
+    uint32_t largestFrameBytes;
+    /** Bytes scanned that were not part of any frame */
+    uint32_t bytesSkipped;
+} JPEGScannerStats;
+
+/** Called for every run of frame bytes in a chunk, segment points into the chunk (or at a static byte for a SOI
+ * split across chunks), frameBytesRead is the running total of the frame including this segment */
+typedef void JPEGScannerCallback(const uint8_t *segment, const size_t segmentLength, const size_t frameBytesRead,
+                                 const JPEGScannerSegmentType segmentType, void *userArg);
+
+extern JPEGScanner *jpegScanner_create();
+
+extern void jpegScanner_destroy(JPEGScanner *jpegScanner);
+
+/** Scan the next chunk of the readout, returns the number of frames completed in this chunk */
+extern uint32_t jpegScanner_scan(JPEGScanner *jpegScanner, const uint8_t *chunk, const size_t chunkLength,
+                                 JPEGScannerCallback callback, void *userArg);
+
+/** true if a SOI has been seen but not yet its EOI */
+extern bool jpegScanner_isInFrame(const JPEGScanner *jpegScanner);
+
+/** End of the readout, a frame still missing its EOI is dropped, as is a readout that held no frame at all,
+ * the scanner is then ready for the next readout */
+extern void jpegScanner_finish(JPEGScanner *jpegScanner, JPEGScannerCallback callback, void *userArg);
+
+extern Error jpegScanner_getStats(const JPEGScanner *jpegScanner, JPEGScannerStats *stats);
+
+#endif //ESP32_REMOTECAMERA_JPEGSCANNER_H
@@ -0,0 +1,118 @@
+#include "LiveDemand.h"
+#include <stdlib.h>
+
+typedef struct LiveDemandData {
+    uint32_t lingerMillis;
+    uint32_t subscribers;
+    bool isRunning;
+    /** When live capture last started or went idle, or when the stats were reset since */
+    uint32_t sinceMillis;
+    /** When the last subscriber left */
+    uint32_t leftMillis;
+    uint32_t startedMillis;
+    /** Started and has not completed a frame yet */
+    bool isWarmingUp;
+    uint32_t starts;
+    uint32_t runningMillis;
+    uint32_t idleMillis;
+    uint32_t lastWarmUpMillis;
+} LiveDemandData;
+
+public LiveDemand *liveDemand_create(const uint32_t lingerMillis, const uint32_t nowMillis) {
+    LiveDemandData *this = new(LiveDemandData);
+    if (!this) return NULL;
+    this->lingerMillis = lingerMillis;
+    this->sinceMillis = nowMillis;
+    return this;
+}
+
+public void liveDemand_destroy(LiveDemand *liveDemand) {
+    if (!liveDemand) return;
+    delete(liveDemand);
+}
+
+/** Count the time since the last change as running or idle and change to isRunning at nowMillis */
+private void liveDemand_setRunning(LiveDemandData *this, const bool isRunning, const uint32_t nowMillis) {
+    const uint32_t elapsedMillis = nowMillis - this->sinceMillis;
+    if (this->isRunning) this->runningMillis += elapsedMillis;
+    else this->idleMillis += elapsedMillis;
+    this->sinceMillis = nowMillis;
+    this->isRunning = isRunning;
+    if (isRunning) {
+        this->starts++;
+        this->startedMillis = nowMillis;
+        this->isWarmingUp = true;
+    }
+}
+
+/** Go idle if the linger after the last subscriber is over by nowMillis, from when it ended */
+private void liveDemand_update(LiveDemandData *this, const uint32_t nowMillis) {
+    if (!this->isRunning || this->subscribers > 0) return;
+    if (nowMillis - this->leftMillis < this->lingerMillis) return;
+    liveDemand_setRunning(this, false, this->leftMillis + this->lingerMillis);
+}
+
+public bool liveDemand_subscribe(LiveDemand *liveDemand, const uint32_t nowMillis) {
+    if (!liveDemand) return false;
+    LiveDemandData *this = (LiveDemandData *) liveDemand;
+    liveDemand_update(this, nowMillis);
+    this->subscribers++;
+    if (this->isRunning) return false;
+    liveDemand_setRunning(this, true, nowMillis);
+    return true;
+}
+
+public Error liveDemand_unsubscribe(LiveDemand *liveDemand, const uint32_t nowMillis) {
+    if (!liveDemand) return ERROR_NULL_ARGUMENT;
+    LiveDemandData *this = (LiveDemandData *) liveDemand;
+    if (this->subscribers == 0) return ERROR_ILLEGAL_STATE;
+    this->subscribers--;
+    if (this->subscribers == 0) this->leftMillis = nowMillis;
+    return ERROR_NONE;
+}
+
+public bool liveDemand_isRunning(LiveDemand *liveDemand, const uint32_t nowMillis) {
+    if (!liveDemand) return false;
+    LiveDemandData *this = (LiveDemandData *) liveDemand;
+    liveDemand_update(this, nowMillis);
+    return this->isRunning;
+}
+
+public void liveDemand_recordFrame(LiveDemand *liveDemand, const uint32_t nowMillis) {
+    if (!liveDemand) return;
+    LiveDemandData *this = (LiveDemandData *) liveDemand;
+    if (!this->isWarmingUp) return;
+    this->isWarmingUp = false;
+    this->lastWarmUpMillis = nowMillis - this->startedMillis;
+}
+
+public void liveDemand_getStats(LiveDemand *liveDemand, const uint32_t nowMillis, CameraLiveDemandStats *stats) {
+    if (!liveDemand || !stats) return;
+    LiveDemandData *this = (LiveDemandData *) liveDemand;
+    liveDemand_update(this, nowMillis);
+    const uint32_t elapsedMillis = nowMillis - this->sinceMillis;
+    const uint32_t runningMillis = this->runningMillis + (this->isRunning ? elapsedMillis : 0);
+    const uint32_t idleMillis = this->idleMillis + (this->isRunning ? 0 : elapsedMillis);
+    const uint32_t totalMillis = runningMillis + idleMillis;
+    *stats = (CameraLiveDemandStats) {
+            .subscribers = this->subscribers,
+            .isRunning = this->isRunning,
+            .starts = this->starts,
+            .runningMillis = runningMillis,
+            .idleMillis = idleMillis,
+            .dutyCyclePercent = totalMillis > 0 ? (100.0f * (float) runningMillis) / (float) totalMillis : 0,
+            .lastWarmUpMillis = this->lastWarmUpMillis,
+            .lingerMillis = this->lingerMillis
+    };
+}
+
+public void liveDemand_resetStats(LiveDemand *liveDemand, const uint32_t nowMillis) {
+    if (!liveDemand) return;
+    LiveDemandData *this = (LiveDemandData *) liveDemand;
+    liveDemand_update(this, nowMillis);
+    this->sinceMillis = nowMillis;
+    this->starts = 0;
+    this->runningMillis = 0;
+    this->idleMillis = 0;
+    this->lastWarmUpMillis = 0;
+}
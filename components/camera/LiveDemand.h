@@ -0,0 +1,40 @@
+#ifndef ESP32_REMOTECAMERA_LIVEDEMAND_H
+#define ESP32_REMOTECAMERA_LIVEDEMAND_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Decides whether live capture should run from the consumers subscribed to it. It starts when the first consumer
+ * subscribes and keeps running for lingerMillis after the last one leaves, so a page reload or a consumer that
+ * reconnects doesn't stop and restart the sensor. Counts how long live capture ran and sat idle for the duty cycle.
+ * Knows nothing about the camera or the clock, every call is told the time in milliseconds
+ */
+typedef void LiveDemand;
+
+/** Starts idle at nowMillis with no subscribers */
+extern LiveDemand *liveDemand_create(const uint32_t lingerMillis, const uint32_t nowMillis);
+
+extern void liveDemand_destroy(LiveDemand *liveDemand);
+
+/** Add a subscriber at nowMillis, true if this started live capture from idle */
+extern bool liveDemand_subscribe(LiveDemand *liveDemand, const uint32_t nowMillis);
+
+/** Remove a subscriber at nowMillis, returns ERROR_ILLEGAL_STATE when there are none */
+extern Error liveDemand_unsubscribe(LiveDemand *liveDemand, const uint32_t nowMillis);
+
+/** Whether live capture should run at nowMillis, it goes idle once the linger after the last subscriber is over */
+extern bool liveDemand_isRunning(LiveDemand *liveDemand, const uint32_t nowMillis);
+
+/** Live capture completed a frame at nowMillis, the first since it started is its warm up */
+extern void liveDemand_recordFrame(LiveDemand *liveDemand, const uint32_t nowMillis);
+
+extern void liveDemand_getStats(LiveDemand *liveDemand, const uint32_t nowMillis, CameraLiveDemandStats *stats);
+
+/** Running and idle time are counted from nowMillis */
+extern void liveDemand_resetStats(LiveDemand *liveDemand, const uint32_t nowMillis);
+
+#endif //ESP32_REMOTECAMERA_LIVEDEMAND_H
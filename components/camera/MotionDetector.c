@@ -0,0 +1,204 @@
+#include "MotionDetector.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MOTION_DETECTOR_MAP_CELLS (MOTION_DETECTOR_MAX_MAP_WIDTH * MOTION_DETECTOR_MAX_MAP_HEIGHT)
+/** The background is kept in 8.8 fixed point so slow backgrounds still move on small differences */
+#define MOTION_DETECTOR_BACKGROUND_FRACTION_BITS 8
+#define MOTION_DETECTOR_MAX_BACKGROUND_SHIFT 8
+
+/** A zone in map cells, right and bottom are exclusive */
+typedef struct CellZone {
+    uint32_t left;
+    uint32_t top;
+    uint32_t right;
+    uint32_t bottom;
+} CellZone;
+
+typedef struct MotionDetectorData {
+    CameraMotionOptions options;
+    uint32_t blocksWide;
+    uint32_t blocksHigh;
+    /** Blocks averaged into a cell are 2^cellShift across and down */
+    uint32_t cellShift;
+    uint32_t mapWidth;
+    uint32_t mapHeight;
+    bool isFrameBegun;
+    bool hasBackground;
+    bool isMotion;
+    uint32_t quietFrames;
+    CellZone zones[CAMERA_MOTION_MAX_ZONES];
+    uint32_t zoneCount;
+    /** Luma of every block of the frame added up per cell, 2^(2 * MAX_CELL_SHIFT) * 255 fits */
+    uint16_t sums[MOTION_DETECTOR_MAP_CELLS];
+    uint16_t background[MOTION_DETECTOR_MAP_CELLS];
+} MotionDetectorData;
+
+private void motionDetector_fillDefaults(CameraMotionOptions *options) {
+    if (options->threshold == 0) options->threshold = MOTION_DETECTOR_DEFAULT_THRESHOLD;
+    if (options->triggerPercent == 0) options->triggerPercent = MOTION_DETECTOR_DEFAULT_TRIGGER_PERCENT;
+    if (options->backgroundShift == 0) options->backgroundShift = MOTION_DETECTOR_DEFAULT_BACKGROUND_SHIFT;
+    if (options->quietFrames == 0) options->quietFrames = MOTION_DETECTOR_DEFAULT_QUIET_FRAMES;
+}
+
+/** Zones are kept in percent so they hold at any image size, they are turned into cells for every new map size */
+private void motionDetector_mapZones(MotionDetectorData *this) {
+    this->zoneCount = this->options.zoneCount > 0 ? this->options.zoneCount : 1;
+    for (uint32_t i = 0; i < this->zoneCount; i++) {
+        const CameraMotionZone zone = this->options.zoneCount > 0 ? this->options.zones[i] :
+                                      (CameraMotionZone) {.left = 0, .top = 0, .width = 100, .height = 100};
+        CellZone *cells = &this->zones[i];
+        cells->left = (zone.left * this->mapWidth) / 100;
+        cells->top = (zone.top * this->mapHeight) / 100;
+        cells->right = (((zone.left + zone.width) * this->mapWidth) + 99) / 100;
+        cells->bottom = (((zone.top + zone.height) * this->mapHeight) + 99) / 100;
+        // a zone narrower than a cell still watches the cell it is in
+        if (cells->right <= cells->left) cells->right = cells->left + 1;
+        if (cells->bottom <= cells->top) cells->bottom = cells->top + 1;
+    }
+}
+
+/** Blocks of the frame in cell number index along a side of blockCount blocks */
+private uint32_t motionDetector_cellBlocks(const MotionDetectorData *this, const uint32_t index,
+                                           const uint32_t blockCount) {
+    const uint32_t first = index << this->cellShift;
+    const uint32_t end = (index + 1) << this->cellShift;
+    return (end < blockCount ? end : blockCount) - first;
+}
+
+public MotionDetector *motionDetector_create() {
+    MotionDetectorData *this = new(MotionDetectorData);
+    if (!this) return NULL;
+    motionDetector_fillDefaults(&this->options);
+    return this;
+}
+
+public void motionDetector_destroy(MotionDetector *motionDetector) {
+    delete(motionDetector);
+}
+
+public Error motionDetector_setOptions(MotionDetector *motionDetector, const CameraMotionOptions *options) {
+    if (!motionDetector || !options) return ERROR_NULL_ARGUMENT;
+    MotionDetectorData *this = (MotionDetectorData *) motionDetector;
+    if (options->zoneCount > CAMERA_MOTION_MAX_ZONES || options->triggerPercent > 100 ||
+        options->backgroundShift > MOTION_DETECTOR_MAX_BACKGROUND_SHIFT) {
+        return ERROR_ILLEGAL_ARGUMENT;
+    }
+    for (uint32_t i = 0; i < options->zoneCount; i++) {
+        const CameraMotionZone *zone = &options->zones[i];
+        if (zone->width == 0 || zone->height == 0 || zone->left + zone->width > 100 ||
+            zone->top + zone->height > 100) {
+            return ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+    this->options = *options;
+    motionDetector_fillDefaults(&this->options);
+    motionDetector_mapZones(this);
+    this->hasBackground = false;
+    this->isMotion = false;
+    this->quietFrames = 0;
+    return ERROR_NONE;
+}
+
+public void motionDetector_getOptions(const MotionDetector *motionDetector, CameraMotionOptions *options) {
+    if (!motionDetector || !options) return;
+    *options = ((const MotionDetectorData *) motionDetector)->options;
+}
+
+public Error motionDetector_beginFrame(MotionDetector *motionDetector, const uint32_t blocksWide,
+                                      const uint32_t blocksHigh) {
+    if (!motionDetector) return ERROR_NULL_ARGUMENT;
+    if (blocksWide == 0 || blocksHigh == 0) return ERROR_ILLEGAL_ARGUMENT;
+    MotionDetectorData *this = (MotionDetectorData *) motionDetector;
+    uint32_t cellShift = 0;
+    while (((blocksWide - 1) >> cellShift) >= MOTION_DETECTOR_MAX_MAP_WIDTH ||
+           ((blocksHigh - 1) >> cellShift) >= MOTION_DETECTOR_MAX_MAP_HEIGHT) {
+        if (++cellShift > MOTION_DETECTOR_MAX_CELL_SHIFT) return ERROR_OUT_OF_BOUNDS;
+    }
+    const uint32_t mapWidth = ((blocksWide - 1) >> cellShift) + 1;
+    const uint32_t mapHeight = ((blocksHigh - 1) >> cellShift) + 1;
+    if (mapWidth != this->mapWidth || mapHeight != this->mapHeight || blocksWide != this->blocksWide ||
+        blocksHigh != this->blocksHigh) { // cells at the edges cover different blocks so the background is stale
+        this->blocksWide = blocksWide;
+        this->blocksHigh = blocksHigh;
+        this->cellShift = cellShift;
+        this->mapWidth = mapWidth;
+        this->mapHeight = mapHeight;
+        this->hasBackground = false;
+        motionDetector_mapZones(this);
+    }
+    memset(this->sums, 0, mapWidth * mapHeight * sizeof(uint16_t));
+    this->isFrameBegun = true;
+    return ERROR_NONE;
+}
+
+public void motionDetector_addBlock(MotionDetector *motionDetector, const uint32_t x, const uint32_t y,
+                                    const uint8_t luma) {
+    if (!motionDetector) return;
+    MotionDetectorData *this = (MotionDetectorData *) motionDetector;
+    if (!this->isFrameBegun || x >= this->blocksWide || y >= this->blocksHigh) return;
+    this->sums[((y >> this->cellShift) * this->mapWidth) + (x >> this->cellShift)] += luma;
+}
+
+public Error motionDetector_endFrame(MotionDetector *motionDetector, MotionDetectorResult *result) {
+    if (!motionDetector || !result) return ERROR_NULL_ARGUMENT;
+    MotionDetectorData *this = (MotionDetectorData *) motionDetector;
+    if (!this->isFrameBegun) return ERROR_ILLEGAL_STATE;
+    this->isFrameBegun = false;
+    *result = (MotionDetectorResult) {.isMotion = this->isMotion};
+    const bool isLearning = !this->hasBackground;
+    uint32_t changed[CAMERA_MOTION_MAX_ZONES] = {0};
+    for (uint32_t y = 0; y < this->mapHeight; y++) {
+        const uint32_t rowBlocks = motionDetector_cellBlocks(this, y, this->blocksHigh);
+        for (uint32_t x = 0; x < this->mapWidth; x++) {
+            const uint32_t cell = (y * this->mapWidth) + x;
+            const uint32_t blocks = rowBlocks * motionDetector_cellBlocks(this, x, this->blocksWide);
+            const int32_t luma = (int32_t) ((this->sums[cell] << MOTION_DETECTOR_BACKGROUND_FRACTION_BITS) / blocks);
+            if (isLearning) {
+                this->background[cell] = luma;
+                continue;
+            }
+            const int32_t difference = luma - (int32_t) this->background[cell];
+            const uint32_t distance = abs(difference) >> MOTION_DETECTOR_BACKGROUND_FRACTION_BITS;
+            if (distance >= this->options.threshold) {
+                for (uint32_t i = 0; i < this->zoneCount; i++) {
+                    const CellZone *zone = &this->zones[i];
+                    if (x >= zone->left && x < zone->right && y >= zone->top && y < zone->bottom) changed[i]++;
+                }
+            }
+            this->background[cell] = (int32_t) this->background[cell] + (difference >> this->options.backgroundShift);
+        }
+    }
+    if (isLearning) {
+        this->hasBackground = true;
+        result->isLearning = true;
+        return ERROR_NONE;
+    }
+    bool isTriggered = false;
+    for (uint32_t i = 0; i < this->zoneCount; i++) {
+        const CellZone *zone = &this->zones[i];
+        const uint32_t cells = (zone->right - zone->left) * (zone->bottom - zone->top);
+        result->zoneScores[i] = (changed[i] * 100) / cells;
+        if (result->zoneScores[i] > result->score) result->score = result->zoneScores[i];
+        if (result->zoneScores[i] >= this->options.triggerPercent) {
+            result->zoneMask |= 1U << i;
+            isTriggered = true;
+        }
+    }
+    if (isTriggered) {
+        this->quietFrames = 0;
+        if (!this->isMotion) this->isMotion = result->isChanged = true;
+    } else if (this->isMotion && ++this->quietFrames >= this->options.quietFrames) {
+        this->isMotion = false;
+        result->isChanged = true;
+    }
+    result->isMotion = this->isMotion;
+    return ERROR_NONE;
+}
+
+public void motionDetector_getMapSize(const MotionDetector *motionDetector, uint32_t *width, uint32_t *height) {
+    if (!motionDetector) return;
+    const MotionDetectorData *this = (const MotionDetectorData *) motionDetector;
+    if (width) *width = this->mapWidth;
+    if (height) *height = this->mapHeight;
+}
@@ -0,0 +1,68 @@
+#ifndef ESP32_REMOTECAMERA_MOTIONDETECTOR_H
+#define ESP32_REMOTECAMERA_MOTIONDETECTOR_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Finds motion by comparing a map of every frame's luma, one cell per 8x8 block, against a running background.
+ * A cell has changed when its luma is more than the threshold from the background's, and a zone has motion when
+ * enough of its cells have changed. Frames larger than the map are averaged down, 2x2 or 4x4 blocks to a cell.
+ * Knows nothing about JPEG, it is fed the blocks' mean luma, from their DC coefficients, in any order
+ */
+typedef void MotionDetector;
+
+/** 1/8 of 640x480, larger frames are averaged down to fit */
+#define MOTION_DETECTOR_MAX_MAP_WIDTH 80
+#define MOTION_DETECTOR_MAX_MAP_HEIGHT 60
+/** Most blocks averaged into one cell are 2^MAX_CELL_SHIFT across and down, enough for 2592x1944 */
+#define MOTION_DETECTOR_MAX_CELL_SHIFT 3
+#define MOTION_DETECTOR_DEFAULT_THRESHOLD 24
+#define MOTION_DETECTOR_DEFAULT_TRIGGER_PERCENT 4
+#define MOTION_DETECTOR_DEFAULT_BACKGROUND_SHIFT 4
+#define MOTION_DETECTOR_DEFAULT_QUIET_FRAMES 8
+
+typedef struct MotionDetectorResult {
+    bool isMotion;
+    /** Motion started or ended with this frame */
+    bool isChanged;
+    /** The frame was taken as the background and not compared, the first frame or the first at a new size */
+    bool isLearning;
+    /** Highest of zoneScores */
+    uint8_t score;
+    uint32_t zoneMask;
+    /** Percent of each zone's cells that changed */
+    uint8_t zoneScores[CAMERA_MOTION_MAX_ZONES];
+} MotionDetectorResult;
+
+extern MotionDetector *motionDetector_create();
+
+extern void motionDetector_destroy(MotionDetector *motionDetector);
+
+/** Replace the options and forget the background, returns ERROR_ILLEGAL_ARGUMENT for a zone outside the image or
+ * with no area */
+extern Error motionDetector_setOptions(MotionDetector *motionDetector, const CameraMotionOptions *options);
+
+/** The options with defaults filled in */
+extern void motionDetector_getOptions(const MotionDetector *motionDetector, CameraMotionOptions *options);
+
+/** Start a frame blocksWide by blocksHigh luma blocks, an unfinished frame is thrown away, returns
+ * ERROR_OUT_OF_BOUNDS for a frame too large to average down to the map */
+extern Error motionDetector_beginFrame(MotionDetector *motionDetector, const uint32_t blocksWide,
+                                      const uint32_t blocksHigh);
+
+/** Add the mean luma (0 to 255) of the block at (x, y), blocks outside the frame are ignored */
+extern void motionDetector_addBlock(MotionDetector *motionDetector, const uint32_t x, const uint32_t y,
+                                    const uint8_t luma);
+
+/** Compare the frame to the background then move the background towards it, ERROR_ILLEGAL_STATE when no frame was
+ * begun */
+extern Error motionDetector_endFrame(MotionDetector *motionDetector, MotionDetectorResult *result);
+
+/** The map's size, 0 by 0 before the first frame */
+extern void motionDetector_getMapSize(const MotionDetector *motionDetector, uint32_t *width, uint32_t *height);
+
+#endif //ESP32_REMOTECAMERA_MOTIONDETECTOR_H
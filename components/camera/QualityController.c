@@ -0,0 +1,189 @@
+#include "QualityController.h"
+#include <stdlib.h>
+
+#define QUALITY_COUNT (CAMERA_IMAGE_QUALITY_HIGH + 1)
+/** Windows a step up is held off for after it had to be undone by the next decision */
+#define QUALITY_CONTROLLER_UP_BACKOFF_WINDOWS 8
+
+typedef struct QualityControllerData {
+    CameraQualityTarget target;
+    CameraQualityDecision decision;
+    struct {
+        uint32_t frameCount;
+        uint32_t elapsedMillis;
+        uint32_t frameBytes;
+        uint32_t framesDropped;
+    } window;
+    uint32_t settlingWindows;
+    uint32_t upBackoffWindows;
+    CameraQualityAction lastStep;
+} QualityControllerData;
+
+#define ladderPosition(imageSize, imageQuality) ((int) ((imageSize) * QUALITY_COUNT) + (int) (imageQuality))
+#define ladderImageSize(position) ((CameraImageSize) ((position) / QUALITY_COUNT))
+#define ladderImageQuality(position) ((CameraImageQuality) ((position) % QUALITY_COUNT))
+
+public QualityController *qualityController_create() {
+    QualityControllerData *this = new(QualityControllerData);
+    if (!this) return NULL;
+    this->target = (CameraQualityTarget) {
+            .mode = CAMERA_QUALITY_TARGET_MODE_NONE,
+            .hysteresisPercent = QUALITY_CONTROLLER_DEFAULT_HYSTERESIS_PERCENT,
+            .minImageSize = CAMERA_IMAGE_SIZE_320x240,
+            .maxImageSize = CAMERA_IMAGE_SIZE_2592x1944
+    };
+    this->decision.reason = CAMERA_QUALITY_REASON_DISABLED;
+    return this;
+}
+
+public void qualityController_destroy(QualityController *qualityController) {
+    delete(qualityController);
+}
+
+private void qualityController_resetWindow(QualityControllerData *this) {
+    this->window.frameCount = 0;
+    this->window.elapsedMillis = 0;
+    this->window.frameBytes = 0;
+    this->window.framesDropped = 0;
+}
+
+public Error qualityController_setTarget(QualityController *qualityController, const CameraQualityTarget *target) {
+    if (!qualityController || !target) return ERROR_NULL_ARGUMENT;
+    QualityControllerData *this = (QualityControllerData *) qualityController;
+    if (target->mode != CAMERA_QUALITY_TARGET_MODE_NONE) {
+        if (target->mode != CAMERA_QUALITY_TARGET_MODE_FPS && target->mode != CAMERA_QUALITY_TARGET_MODE_KBPS) {
+            return ERROR_ILLEGAL_ARGUMENT;
+        }
+        if (!(target->value > 0.0F) || target->hysteresisPercent >= 100) return ERROR_ILLEGAL_ARGUMENT;
+        if (target->minImageSize < 0 || target->maxImageSize >= CAMERA_IMAGE_SIZE_COUNT ||
+            target->minImageSize > target->maxImageSize) {
+            return ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+    this->target = *target;
+    qualityController_resetWindow(this);
+    this->settlingWindows = 0;
+    this->upBackoffWindows = 0;
+    this->lastStep = CAMERA_QUALITY_ACTION_HOLD;
+    this->decision.action = CAMERA_QUALITY_ACTION_HOLD;
+    this->decision.isAtLimit = false;
+    this->decision.reason = target->mode == CAMERA_QUALITY_TARGET_MODE_NONE ?
+                            CAMERA_QUALITY_REASON_DISABLED : CAMERA_QUALITY_REASON_MEASURING;
+    return ERROR_NONE;
+}
+
+public void qualityController_getTarget(const QualityController *qualityController, CameraQualityTarget *target) {
+    if (!qualityController || !target) return;
+    *target = ((const QualityControllerData *) qualityController)->target;
+}
+
+public void qualityController_addFrames(QualityController *qualityController, const uint32_t frameCount,
+                                        const uint32_t elapsedMillis, const uint32_t frameBytes,
+                                        const uint32_t framesDropped) {
+    if (!qualityController) return;
+    QualityControllerData *this = (QualityControllerData *) qualityController;
+    if (this->target.mode == CAMERA_QUALITY_TARGET_MODE_NONE) return;
+    this->window.frameCount += frameCount;
+    this->window.elapsedMillis += elapsedMillis;
+    this->window.frameBytes += frameBytes;
+    this->window.framesDropped += framesDropped;
+}
+
+/** Which way the window's measurements want the ladder to go and why */
+private CameraQualityAction qualityController_wantedAction(const QualityControllerData *this,
+                                                           CameraQualityReason *reason) {
+    const CameraQualityDecision *decision = &this->decision;
+    if (decision->framesDropped * 100 >= this->window.frameCount * QUALITY_CONTROLLER_BACKLOG_DROP_PERCENT) {
+        *reason = CAMERA_QUALITY_REASON_SEND_BACKLOG;
+        return CAMERA_QUALITY_ACTION_STEP_DOWN;
+    }
+    const float low = this->target.value * (float) (100 - this->target.hysteresisPercent) / 100.0F;
+    const float high = this->target.value * (float) (100 + this->target.hysteresisPercent) / 100.0F;
+    if (this->target.mode == CAMERA_QUALITY_TARGET_MODE_FPS) {
+        if (decision->measuredFps < low) {
+            *reason = CAMERA_QUALITY_REASON_FPS_BELOW_TARGET;
+            return CAMERA_QUALITY_ACTION_STEP_DOWN;
+        } else if (decision->measuredFps > high) {
+            *reason = CAMERA_QUALITY_REASON_FPS_ABOVE_TARGET;
+            return CAMERA_QUALITY_ACTION_STEP_UP;
+        }
+    } else {
+        if (decision->measuredKbps > high) {
+            *reason = CAMERA_QUALITY_REASON_KBPS_ABOVE_TARGET;
+            return CAMERA_QUALITY_ACTION_STEP_DOWN;
+        } else if (decision->measuredKbps < low) {
+            *reason = CAMERA_QUALITY_REASON_KBPS_BELOW_TARGET;
+            return CAMERA_QUALITY_ACTION_STEP_UP;
+        }
+    }
+    *reason = CAMERA_QUALITY_REASON_TARGET_MET;
+    return CAMERA_QUALITY_ACTION_HOLD;
+}
+
+public bool qualityController_decide(QualityController *qualityController, const CameraImageSize imageSize,
+                                     const CameraImageQuality imageQuality, CameraQualityDecision *decision) {
+    if (!qualityController) return false;
+    QualityControllerData *this = (QualityControllerData *) qualityController;
+    CameraQualityDecision *current = &this->decision;
+    bool isChanged = false;
+    if (this->target.mode == CAMERA_QUALITY_TARGET_MODE_NONE) {
+        current->action = CAMERA_QUALITY_ACTION_HOLD;
+        current->reason = CAMERA_QUALITY_REASON_DISABLED;
+        current->imageSize = imageSize;
+        current->imageQuality = imageQuality;
+    } else if (this->window.frameCount >= QUALITY_CONTROLLER_WINDOW_FRAMES) {
+        const uint32_t elapsedMillis = this->window.elapsedMillis > 0 ? this->window.elapsedMillis : 1;
+        current->measuredFps = (1000.0F * (float) this->window.frameCount) / (float) elapsedMillis;
+        current->measuredKbps = ((float) this->window.frameBytes * 8.0F) / (float) elapsedMillis; // bits/ms = kbit/s
+        current->measuredFrameBytes = this->window.frameBytes / this->window.frameCount;
+        current->framesDropped = this->window.framesDropped;
+
+        const int minPosition = ladderPosition(this->target.minImageSize, CAMERA_IMAGE_QUALITY_LOW);
+        const int maxPosition = ladderPosition(this->target.maxImageSize, CAMERA_IMAGE_QUALITY_HIGH);
+        const int position = ladderPosition(imageSize, imageQuality);
+        int newPosition = position < minPosition ? minPosition : position > maxPosition ? maxPosition : position;
+
+        CameraQualityReason reason;
+        CameraQualityAction action = qualityController_wantedAction(this, &reason);
+        if (this->upBackoffWindows > 0) this->upBackoffWindows--;
+        if (this->settlingWindows > 0) {
+            this->settlingWindows--;
+            action = CAMERA_QUALITY_ACTION_HOLD;
+            reason = CAMERA_QUALITY_REASON_SETTLING;
+        } else if (action == CAMERA_QUALITY_ACTION_STEP_UP && this->upBackoffWindows > 0) {
+            action = CAMERA_QUALITY_ACTION_HOLD; // the last step up did not hold, don't keep bouncing off the target
+        }
+        current->isAtLimit = false;
+        if (action == CAMERA_QUALITY_ACTION_STEP_DOWN) {
+            if (newPosition > minPosition) newPosition--;
+            else current->isAtLimit = true;
+        } else if (action == CAMERA_QUALITY_ACTION_STEP_UP) {
+            if (newPosition < maxPosition) newPosition++;
+            else current->isAtLimit = true;
+        }
+        if (current->isAtLimit) action = CAMERA_QUALITY_ACTION_HOLD;
+
+        if (action == CAMERA_QUALITY_ACTION_STEP_DOWN && this->lastStep == CAMERA_QUALITY_ACTION_STEP_UP) {
+            this->upBackoffWindows = QUALITY_CONTROLLER_UP_BACKOFF_WINDOWS;
+        }
+        if (newPosition != position) {
+            this->settlingWindows = QUALITY_CONTROLLER_SETTLING_WINDOWS;
+            current->stepCount++;
+            isChanged = true;
+        }
+        if (action != CAMERA_QUALITY_ACTION_HOLD) this->lastStep = action;
+        current->action = action;
+        current->reason = reason;
+        current->imageSize = ladderImageSize(newPosition);
+        current->imageQuality = ladderImageQuality(newPosition);
+        qualityController_resetWindow(this);
+    }
+    if (decision) *decision = *current;
+    return isChanged;
+}
+
+public void qualityController_getDecision(const QualityController *qualityController,
+                                          CameraQualityDecision *decision) {
+    if (!qualityController || !decision) return;
+    *decision = ((const QualityControllerData *) qualityController)->decision;
+}
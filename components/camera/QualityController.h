@@ -0,0 +1,50 @@
+#ifndef ESP32_REMOTECAMERA_QUALITYCONTROLLER_H
+#define ESP32_REMOTECAMERA_QUALITYCONTROLLER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Closed loop controller that steps image size and quality to hold a frame rate or bandwidth target.
+ * Image size and quality form one ladder, (320x240, LOW), (320x240, NORMAL), (320x240, HIGH), (640x480, LOW)...
+ * and every decision moves at most one rung, only once a whole window of frames has been measured, and only when
+ * the measurement is outside the target's hysteresis band, the window after a step is discarded while the sensor
+ * settles. Knows nothing about the camera hardware, it is fed measurements and asked for decisions
+ */
+typedef void QualityController;
+
+/** Frames measured before each decision */
+#define QUALITY_CONTROLLER_WINDOW_FRAMES 8
+/** Windows discarded after a step */
+#define QUALITY_CONTROLLER_SETTLING_WINDOWS 1
+/** Percent of a window's frames consumers must drop before it counts as a send backlog */
+#define QUALITY_CONTROLLER_BACKLOG_DROP_PERCENT 25
+#define QUALITY_CONTROLLER_DEFAULT_HYSTERESIS_PERCENT 15
+
+extern QualityController *qualityController_create();
+
+extern void qualityController_destroy(QualityController *qualityController);
+
+/** Replace the target and start measuring again, returns ERROR_ILLEGAL_ARGUMENT for a target that cannot be held */
+extern Error qualityController_setTarget(QualityController *qualityController, const CameraQualityTarget *target);
+
+extern void qualityController_getTarget(const QualityController *qualityController, CameraQualityTarget *target);
+
+/** Add frameCount frames captured in elapsedMillis totalling frameBytes, during which frame consumers dropped
+ * framesDropped frames */
+extern void qualityController_addFrames(QualityController *qualityController, const uint32_t frameCount,
+                                        const uint32_t elapsedMillis, const uint32_t frameBytes,
+                                        const uint32_t framesDropped);
+
+/** Decide from the current image size and quality, returns true if decision's image size or quality differ from
+ * the current ones and should be applied */
+extern bool qualityController_decide(QualityController *qualityController, const CameraImageSize imageSize,
+                                     const CameraImageQuality imageQuality, CameraQualityDecision *decision);
+
+extern void qualityController_getDecision(const QualityController *qualityController,
+                                          CameraQualityDecision *decision);
+
+#endif //ESP32_REMOTECAMERA_QUALITYCONTROLLER_H
@@ -0,0 +1,219 @@
+#include "RegisterImage.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define REGISTER_IMAGE_HEADER_BYTES 24
+#define REGISTER_IMAGE_RUN_HEADER_BYTES 3
+#define REGISTER_IMAGE_MAX_RUN_LENGTH 0xFF
+#define REGISTER_IMAGE_CHECKSUM_PRIME 0x01000193
+
+/** Offsets into the header */
+#define OFFSET_MAGIC 0
+#define OFFSET_VERSION 4
+#define OFFSET_USER_DATA_LENGTH 6
+#define OFFSET_ENTRY_COUNT 8
+#define OFFSET_RUN_COUNT 10
+#define OFFSET_SCRIPTS_CHECKSUM 12
+#define OFFSET_REGISTERS_CHECKSUM 16
+#define OFFSET_IMAGE_CHECKSUM 20
+
+#define OV5642_REGISTER_AWB_GAIN_FIRST 0x3400
+#define OV5642_REGISTER_AWB_GAIN_LAST 0x3405
+#define OV5642_REGISTER_AEC_AGC_FIRST 0x3500
+#define OV5642_REGISTER_AEC_AGC_LAST 0x350D
+
+private void putUInt16(uint8_t *bytes, const uint16_t value) {
+    bytes[0] = value & 0xFF;
+    bytes[1] = value >> 8;
+}
+
+private void putUInt32(uint8_t *bytes, const uint32_t value) {
+    putUInt16(bytes, value & 0xFFFF);
+    putUInt16(bytes + 2, value >> 16);
+}
+
+private uint16_t getUInt16(const uint8_t *bytes) {
+    return bytes[0] | (bytes[1] << 8);
+}
+
+private uint32_t getUInt32(const uint8_t *bytes) {
+    return getUInt16(bytes) | ((uint32_t) getUInt16(bytes + 2) << 16);
+}
+
+/** FNV-1a, small and good enough to catch a corrupt or stale image */
+private uint32_t registerImage_checksumBytes(uint32_t checksum, const uint8_t *bytes, const size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        checksum = (checksum ^ bytes[i]) * REGISTER_IMAGE_CHECKSUM_PRIME;
+    }
+    return checksum;
+}
+
+private uint32_t registerImage_checksumRegister(const uint32_t checksum, const uint16_t address, const uint8_t value) {
+    const uint8_t bytes[] = {address >> 8, address & 0xFF, value};
+    return registerImage_checksumBytes(checksum, bytes, sizeof(bytes));
+}
+
+public uint32_t registerImage_checksumScript(uint32_t checksum, const OV5642RegisterEntry *entries) {
+    if (!entries) return checksum;
+    for (const OV5642RegisterEntry *entry = entries; !registerScript_isEnd(entry); entry++) {
+        checksum = registerImage_checksumRegister(checksum, entry->address, entry->value);
+    }
+    return checksum;
+}
+
+public bool registerImage_isVerifiable(const uint16_t address) {
+    return !(address >= OV5642_REGISTER_AWB_GAIN_FIRST && address <= OV5642_REGISTER_AWB_GAIN_LAST) &&
+           !(address >= OV5642_REGISTER_AEC_AGC_FIRST && address <= OV5642_REGISTER_AEC_AGC_LAST);
+}
+
+typedef struct {
+    OV5642RegisterEntry *entries;
+    size_t count;
+} ShadowCopy;
+
+private void registerImage_copyShadowEntry(const uint16_t address, const uint8_t value, void *userArg) {
+    ShadowCopy *copy = (ShadowCopy *) userArg;
+    copy->entries[copy->count++] = (OV5642RegisterEntry) {.address = address, .value = value};
+}
+
+public Error registerImage_create(const RegisterShadow *shadow, const uint32_t scriptsChecksum,
+                                  const void *userData, const size_t userDataLength,
+                                  uint8_t **image, size_t *imageLength) {
+    if (!shadow || !image || !imageLength) return ERROR_NULL_ARGUMENT;
+    if (userDataLength > UINT16_MAX || (userDataLength > 0 && !userData)) return ERROR_ILLEGAL_ARGUMENT;
+    const capacity_t size = registerShadow_getSize(shadow);
+    if (size == 0 || size > UINT16_MAX) return ERROR_ILLEGAL_ARGUMENT;
+    ShadowCopy copy = {.entries = alloc(size * sizeof(OV5642RegisterEntry)), .count = 0};
+    if (!copy.entries) return ERROR_LIBRARY_FAILURE;
+    registerShadow_forEach(shadow, registerImage_copyShadowEntry, &copy); // ascending address order
+
+    // a run header for every gap or full run, which can't be more than one per entry
+    uint8_t *bytes = alloc(REGISTER_IMAGE_HEADER_BYTES + userDataLength +
+                           (copy.count * (REGISTER_IMAGE_RUN_HEADER_BYTES + 1)));
+    if (!bytes) {
+        free(copy.entries);
+        return ERROR_LIBRARY_FAILURE;
+    }
+    if (userDataLength > 0) memcpy(bytes + REGISTER_IMAGE_HEADER_BYTES, userData, userDataLength);
+    size_t length = REGISTER_IMAGE_HEADER_BYTES + userDataLength;
+    uint8_t *run = NULL;
+    uint32_t runCount = 0;
+    uint32_t registersChecksum = REGISTER_IMAGE_CHECKSUM_SEED;
+    for (size_t i = 0; i < copy.count; i++) {
+        const OV5642RegisterEntry *entry = &copy.entries[i];
+        const bool isConsecutive = run != NULL && run[2] < REGISTER_IMAGE_MAX_RUN_LENGTH &&
+                                   entry->address == getUInt16(run) + run[2];
+        if (!isConsecutive) {
+            run = bytes + length;
+            putUInt16(run, entry->address);
+            run[2] = 0;
+            length += REGISTER_IMAGE_RUN_HEADER_BYTES;
+            runCount++;
+        }
+        bytes[length++] = entry->value;
+        run[2]++;
+        if (registerImage_isVerifiable(entry->address)) {
+            registersChecksum = registerImage_checksumRegister(registersChecksum, entry->address, entry->value);
+        }
+    }
+    putUInt32(bytes + OFFSET_MAGIC, REGISTER_IMAGE_MAGIC);
+    putUInt16(bytes + OFFSET_VERSION, REGISTER_IMAGE_VERSION);
+    putUInt16(bytes + OFFSET_USER_DATA_LENGTH, userDataLength);
+    putUInt16(bytes + OFFSET_ENTRY_COUNT, copy.count);
+    putUInt16(bytes + OFFSET_RUN_COUNT, runCount);
+    putUInt32(bytes + OFFSET_SCRIPTS_CHECKSUM, scriptsChecksum);
+    putUInt32(bytes + OFFSET_REGISTERS_CHECKSUM, registersChecksum);
+    putUInt32(bytes + OFFSET_IMAGE_CHECKSUM,
+              registerImage_checksumBytes(REGISTER_IMAGE_CHECKSUM_SEED, bytes + REGISTER_IMAGE_HEADER_BYTES,
+                                          length - REGISTER_IMAGE_HEADER_BYTES));
+    free(copy.entries);
+    *image = bytes;
+    *imageLength = length;
+    return ERROR_NONE;
+}
+
+public Error registerImage_getInfo(const uint8_t *image, const size_t imageLength, RegisterImageInfo *info) {
+    if (!image || !info) return ERROR_NULL_ARGUMENT;
+    if (imageLength < REGISTER_IMAGE_HEADER_BYTES) return ERROR_ILLEGAL_ARGUMENT;
+    if (getUInt32(image + OFFSET_MAGIC) != REGISTER_IMAGE_MAGIC ||
+        getUInt16(image + OFFSET_VERSION) != REGISTER_IMAGE_VERSION) {
+        return ERROR_ILLEGAL_ARGUMENT;
+    }
+    const uint32_t imageChecksum = registerImage_checksumBytes(REGISTER_IMAGE_CHECKSUM_SEED,
+                                                               image + REGISTER_IMAGE_HEADER_BYTES,
+                                                               imageLength - REGISTER_IMAGE_HEADER_BYTES);
+    if (imageChecksum != getUInt32(image + OFFSET_IMAGE_CHECKSUM)) return ERROR_ILLEGAL_ARGUMENT;
+    const size_t userDataLength = getUInt16(image + OFFSET_USER_DATA_LENGTH);
+    const uint32_t runCount = getUInt16(image + OFFSET_RUN_COUNT);
+    // walk the runs so every later reader of the image can trust the lengths in it
+    size_t position = REGISTER_IMAGE_HEADER_BYTES + userDataLength;
+    uint32_t entryCount = 0;
+    for (uint32_t i = 0; i < runCount; i++) {
+        if (position + REGISTER_IMAGE_RUN_HEADER_BYTES > imageLength) return ERROR_ILLEGAL_ARGUMENT;
+        const size_t runLength = image[position + 2];
+        if (runLength == 0 || getUInt16(image + position) + runLength > OV5642_REGISTER_ADDRESS_DELAY) {
+            return ERROR_ILLEGAL_ARGUMENT;
+        }
+        position += REGISTER_IMAGE_RUN_HEADER_BYTES + runLength;
+        entryCount += runLength;
+    }
+    if (position != imageLength || entryCount != getUInt16(image + OFFSET_ENTRY_COUNT)) return ERROR_ILLEGAL_ARGUMENT;
+    *info = (RegisterImageInfo) {
+            .entryCount = entryCount,
+            .runCount = runCount,
+            .scriptsChecksum = getUInt32(image + OFFSET_SCRIPTS_CHECKSUM),
+            .registersChecksum = getUInt32(image + OFFSET_REGISTERS_CHECKSUM),
+            .userData = image + REGISTER_IMAGE_HEADER_BYTES,
+            .userDataLength = userDataLength,
+    };
+    return ERROR_NONE;
+}
+
+public Error registerImage_apply(const uint8_t *image, const size_t imageLength, const RegisterScriptWriter *writer,
+                                 RegisterShadow *shadow, RegisterScriptStats *stats) {
+    if (!writer) return ERROR_NULL_ARGUMENT;
+    RegisterImageInfo info;
+    const Error infoErr = registerImage_getInfo(image, imageLength, &info);
+    if (infoErr != ERROR_NONE) return infoErr;
+    // back into a table so registerScript_run merges it into as few writes as the image has runs
+    OV5642RegisterEntry *entries = alloc((info.entryCount + 1) * sizeof(OV5642RegisterEntry));
+    if (!entries) return ERROR_LIBRARY_FAILURE;
+    size_t entryCount = 0;
+    const uint8_t *run = info.userData + info.userDataLength;
+    for (uint32_t i = 0; i < info.runCount; i++) {
+        const uint16_t address = getUInt16(run);
+        const size_t runLength = run[2];
+        for (size_t j = 0; j < runLength; j++) {
+            entries[entryCount++] = (OV5642RegisterEntry) {.address = address + j,
+                    .value = run[REGISTER_IMAGE_RUN_HEADER_BYTES + j]};
+        }
+        run += REGISTER_IMAGE_RUN_HEADER_BYTES + runLength;
+    }
+    entries[entryCount] = (OV5642RegisterEntry) {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END};
+    const Error err = registerScript_run(writer, shadow, entries, stats);
+    free(entries);
+    return err;
+}
+
+public Error registerImage_verify(const uint8_t *image, const size_t imageLength, const RegisterImageReader *reader) {
+    if (!reader || !reader->read) return ERROR_NULL_ARGUMENT;
+    RegisterImageInfo info;
+    const Error infoErr = registerImage_getInfo(image, imageLength, &info);
+    if (infoErr != ERROR_NONE) return infoErr;
+    uint8_t values[REGISTER_IMAGE_MAX_RUN_LENGTH];
+    uint32_t checksum = REGISTER_IMAGE_CHECKSUM_SEED;
+    const uint8_t *run = info.userData + info.userDataLength;
+    for (uint32_t i = 0; i < info.runCount; i++) {
+        const uint16_t address = getUInt16(run);
+        const size_t runLength = run[2];
+        const Error err = reader->read(reader->context, address, values, runLength);
+        if (err != ERROR_NONE) return err;
+        for (size_t j = 0; j < runLength; j++) {
+            if (registerImage_isVerifiable(address + j)) {
+                checksum = registerImage_checksumRegister(checksum, address + j, values[j]);
+            }
+        }
+        run += REGISTER_IMAGE_RUN_HEADER_BYTES + runLength;
+    }
+    return checksum == info.registersChecksum ? ERROR_NONE : ERROR_ILLEGAL_STATE;
+}
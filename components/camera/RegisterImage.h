@@ -0,0 +1,69 @@
+#ifndef ESP32_REMOTECAMERA_REGISTERIMAGE_H
+#define ESP32_REMOTECAMERA_REGISTERIMAGE_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "OV5642.h"
+#include "RegisterShadow.h"
+#include "RegisterScript.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The final value of every register a configuration wrote, compiled from a RegisterShadow into a byte image that can
+ * be stored (such as an NVS blob) and written back to a freshly reset sensor in one batch, with every register
+ * written once instead of replaying the tables that built it. The image carries a checksum of the tables it was
+ * built from so it is never used with different tables, a checksum of itself so a corrupt image is never written,
+ * and a checksum of its register values so the sensor can be read back to check it took the image.
+ * The image is little endian and made of a header, opaque user data then runs of consecutive registers
+ */
+
+#define REGISTER_IMAGE_MAGIC 0x4952564F // "OVRI"
+#define REGISTER_IMAGE_VERSION 1
+/** Starting value for registerImage_checksumScript() */
+#define REGISTER_IMAGE_CHECKSUM_SEED 0x811C9DC5
+
+typedef struct RegisterImageReader {
+    /** Passed as the first argument to every reader function */
+    void *context;
+    /** Read length values from consecutive registers starting at address */
+    Error (*read)(void *context, const uint16_t address, uint8_t *values, const size_t length);
+} RegisterImageReader;
+
+typedef struct RegisterImageInfo {
+    uint32_t entryCount;
+    uint32_t runCount;
+    uint32_t scriptsChecksum;
+    uint32_t registersChecksum;
+    /** Points into the image */
+    const uint8_t *userData;
+    size_t userDataLength;
+} RegisterImageInfo;
+
+/** Continue checksum over every entry of a table, including delays, chain calls to checksum several tables */
+extern uint32_t registerImage_checksumScript(const uint32_t checksum, const OV5642RegisterEntry *entries);
+
+/** false for registers the sensor changes by itself (auto exposure, gain and white balance), these are written but
+ * not verified since their read back value depends on the scene */
+extern bool registerImage_isVerifiable(const uint16_t address);
+
+/** Compile every register known to shadow into an image, *image is allocated and must be freed by the caller,
+ * userData (can be NULL) is copied into the image as is */
+extern Error registerImage_create(const RegisterShadow *shadow, const uint32_t scriptsChecksum,
+                                  const void *userData, const size_t userDataLength,
+                                  uint8_t **image, size_t *imageLength);
+
+/** Check image is whole and uncorrupted and describe it, ERROR_ILLEGAL_ARGUMENT when it is not */
+extern Error registerImage_getInfo(const uint8_t *image, const size_t imageLength, RegisterImageInfo *info);
+
+/** Write every register of image through writer as one batch of sequential writes, shadow and stats can be NULL,
+ * the image is checked first so nothing is written if it is corrupt */
+extern Error registerImage_apply(const uint8_t *image, const size_t imageLength, const RegisterScriptWriter *writer,
+                                 RegisterShadow *shadow, RegisterScriptStats *stats);
+
+/** Read every verifiable register of image back through reader, ERROR_ILLEGAL_STATE if their checksum does not
+ * match the image's */
+extern Error registerImage_verify(const uint8_t *image, const size_t imageLength, const RegisterImageReader *reader);
+
+#endif //ESP32_REMOTECAMERA_REGISTERIMAGE_H
@@ -0,0 +1,173 @@
+#include "RegisterScript.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OV5642_REGISTER_SYSTEM_CONTROL 0x3008
+#define OV5642_SYSTEM_CONTROL_SOFTWARE_RESET 0x80 // bit 7
+#define OV5642_REGISTER_GROUP_ACCESS 0x3212
+
+typedef struct {
+    uint16_t startAddress;
+    uint8_t values[REGISTER_SCRIPT_MAX_WRITE_LENGTH];
+    size_t length;
+} PendingWrite;
+
+private Error registerScript_flush(const RegisterScriptWriter *writer, RegisterShadow *shadow,
+                                   PendingWrite *pending, RegisterScriptStats *stats) {
+    if (pending->length == 0) return ERROR_NONE;
+    const Error err = writer->write(writer->context, pending->startAddress, pending->values, pending->length);
+    const size_t length = pending->length;
+    pending->length = 0;
+    if (err != ERROR_NONE) return err;
+    stats->writeCount++;
+    for (size_t i = 0; shadow && i < length; i++) {
+        const uint16_t address = pending->startAddress + i;
+        if (registerScript_isCacheable(address)) {
+            registerShadow_set(shadow, address, pending->values[i]);
+        }
+    }
+    return ERROR_NONE;
+}
+
+private void registerScript_delay(const RegisterScriptWriter *writer, const uint32_t millis,
+                                  RegisterScriptStats *stats) {
+    if (millis == 0) return;
+    if (writer->delay) writer->delay(writer->context, millis);
+    stats->delayMillis += millis;
+}
+
+public bool registerScript_isEnd(const OV5642RegisterEntry *entry) {
+    return entry->address == OV5642_REGISTER_ADDRESS_END && entry->value == OV5642_REGISTER_VALUE_END;
+}
+
+public size_t registerScript_length(const OV5642RegisterEntry *entries) {
+    size_t length = 0;
+    while (!registerScript_isEnd(&entries[length])) length++;
+    return length;
+}
+
+public uint32_t registerScript_delayAfterWrite(const uint16_t address, const uint8_t value) {
+    if (address == OV5642_REGISTER_SYSTEM_CONTROL && (value & OV5642_SYSTEM_CONTROL_SOFTWARE_RESET)) {
+        return REGISTER_SCRIPT_RESET_DELAY_MILLIS;
+    }
+    return 0;
+}
+
+public bool registerScript_isCacheable(const uint16_t address) {
+    return address != OV5642_REGISTER_SYSTEM_CONTROL && address != OV5642_REGISTER_GROUP_ACCESS;
+}
+
+public Error registerScript_run(const RegisterScriptWriter *writer, RegisterShadow *shadow,
+                                const OV5642RegisterEntry *entries, RegisterScriptStats *statsIn) {
+    if (!writer || !writer->write || !entries) return ERROR_NULL_ARGUMENT;
+    RegisterScriptStats stats = {};
+    PendingWrite pending = {.length = 0};
+    Error err = ERROR_NONE;
+    for (const OV5642RegisterEntry *entry = entries; !registerScript_isEnd(entry); entry++) {
+        if (entry->address == OV5642_REGISTER_ADDRESS_DELAY) {
+            if ((err = registerScript_flush(writer, shadow, &pending, &stats))) break;
+            registerScript_delay(writer, entry->value, &stats);
+            continue;
+        }
+        stats.entryCount++;
+        if (registerScript_isCacheable(entry->address) &&
+            registerShadow_isUnchanged(shadow, entry->address, entry->value)) {
+            stats.skippedCount++;
+            continue;
+        }
+        const bool isConsecutive = pending.length > 0 &&
+                                   entry->address == pending.startAddress + pending.length &&
+                                   pending.length < REGISTER_SCRIPT_MAX_WRITE_LENGTH;
+        if (!isConsecutive) {
+            if ((err = registerScript_flush(writer, shadow, &pending, &stats))) break;
+            pending.startAddress = entry->address;
+        }
+        pending.values[pending.length++] = entry->value;
+        const uint32_t waitMillis = registerScript_delayAfterWrite(entry->address, entry->value);
+        if (waitMillis > 0) { // the write must land before waiting
+            if ((err = registerScript_flush(writer, shadow, &pending, &stats))) break;
+            registerShadow_clear(shadow); // the sensor has reset every register to its default
+            registerScript_delay(writer, waitMillis, &stats);
+        }
+    }
+    if (err == ERROR_NONE) {
+        err = registerScript_flush(writer, shadow, &pending, &stats);
+    }
+    if (statsIn) *statsIn = stats;
+    return err;
+}
+
+/** Finds the value of the last write to address in entries, false if entries never writes address */
+private bool registerScript_finalValue(const OV5642RegisterEntry *entries, const size_t length,
+                                       const uint16_t address, uint8_t *value) {
+    for (size_t i = length; i > 0; i--) {
+        if (entries[i - 1].address == address) {
+            *value = entries[i - 1].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** true if entries writes address more than once with different values, such as a block reset pulse */
+private bool registerScript_isSequenced(const OV5642RegisterEntry *entries, const size_t length,
+                                        const uint16_t address) {
+    bool isFound = false;
+    uint8_t firstValue = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (entries[i].address != address) continue;
+        if (!isFound) {
+            isFound = true;
+            firstValue = entries[i].value;
+        } else if (entries[i].value != firstValue) {
+            return true;
+        }
+    }
+    return false;
+}
+
+public Error registerScript_createDelta(const OV5642RegisterEntry *from, const OV5642RegisterEntry *to,
+                                        OV5642RegisterEntry **delta) {
+    if (!from || !to || !delta) return ERROR_NULL_ARGUMENT;
+    const size_t fromLength = registerScript_length(from);
+    const size_t toLength = registerScript_length(to);
+    OV5642RegisterEntry *result = alloc((toLength + 1) * sizeof(OV5642RegisterEntry));
+    if (!result) return ERROR_LIBRARY_FAILURE;
+
+    bool isReset = false;
+    for (size_t i = 0; i < toLength; i++) {
+        if (registerScript_delayAfterWrite(to[i].address, to[i].value) > 0) isReset = true;
+    }
+    size_t length = 0;
+    for (size_t i = 0; i < toLength; i++) {
+        const OV5642RegisterEntry *entry = &to[i];
+        bool isNeeded = isReset || entry->address == OV5642_REGISTER_ADDRESS_DELAY ||
+                        !registerScript_isCacheable(entry->address) ||
+                        registerScript_isSequenced(to, toLength, entry->address);
+        if (!isNeeded) {
+            // not sequenced so every write of this register has the same value, only keep the last one
+            // and only if the from table left the register holding something else
+            uint8_t value;
+            const bool isLastWrite = !registerScript_finalValue(to + i + 1, toLength - i - 1, entry->address, &value);
+            isNeeded = isLastWrite && (!registerScript_finalValue(from, fromLength, entry->address, &value) ||
+                                       value != entry->value);
+        }
+        if (isNeeded) result[length++] = *entry;
+    }
+    result[length] = (OV5642RegisterEntry) {.address = OV5642_REGISTER_ADDRESS_END, .value = OV5642_REGISTER_VALUE_END};
+    *delta = result;
+    return ERROR_NONE;
+}
+
+public Error registerScript_concat(const OV5642RegisterEntry *first, const OV5642RegisterEntry *second,
+                                   OV5642RegisterEntry **script) {
+    if (!first || !second || !script) return ERROR_NULL_ARGUMENT;
+    const size_t firstLength = registerScript_length(first);
+    const size_t secondLength = registerScript_length(second);
+    OV5642RegisterEntry *result = alloc((firstLength + secondLength + 1) * sizeof(OV5642RegisterEntry));
+    if (!result) return ERROR_LIBRARY_FAILURE;
+    memcpy(result, first, firstLength * sizeof(OV5642RegisterEntry));
+    memcpy(result + firstLength, second, (secondLength + 1) * sizeof(OV5642RegisterEntry)); // and its end entry
+    *script = result;
+    return ERROR_NONE;
+}
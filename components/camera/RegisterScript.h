@@ -0,0 +1,74 @@
+#ifndef ESP32_REMOTECAMERA_REGISTERSCRIPT_H
+#define ESP32_REMOTECAMERA_REGISTERSCRIPT_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "OV5642.h"
+#include "RegisterShadow.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Writes a table of OV5642RegisterEntry to the sensor with as few bus transactions as possible,
+ * entries with consecutive addresses are merged into a single auto-increment (sequential) write
+ * and the only delays are the ones the sensor actually needs, such as after a software reset.
+ * When given a RegisterShadow, entries whose register already holds the value are skipped
+ * and the shadow is updated after every successful write
+ */
+
+/** Max register values sent in a single sequential write, keeps the I2C command link small */
+#define REGISTER_SCRIPT_MAX_WRITE_LENGTH 32
+/** OV5642 needs about 1ms after a software reset before it will accept writes, give it some headroom */
+#define REGISTER_SCRIPT_RESET_DELAY_MILLIS 5
+
+typedef struct RegisterScriptWriter {
+    /** Passed as the first argument to every writer function */
+    void *context;
+    /** Write length values to consecutive registers starting at address in one bus transaction */
+    Error (*write)(void *context, const uint16_t address, const uint8_t *values, const size_t length);
+    /** Block for at least millis milliseconds */
+    void (*delay)(void *context, const uint32_t millis);
+} RegisterScriptWriter;
+
+typedef struct RegisterScriptStats {
+    /** Register entries in the script, excluding delay entries and the end entry */
+    uint32_t entryCount;
+    /** Bus transactions actually performed */
+    uint32_t writeCount;
+    /** Entries not written because the shadow showed the register already held the value */
+    uint32_t skippedCount;
+    /** Total time spent in delays */
+    uint32_t delayMillis;
+} RegisterScriptStats;
+
+/** true if entry is the terminating entry of a table */
+extern bool registerScript_isEnd(const OV5642RegisterEntry *entry);
+
+/** Number of entries before the end entry, including delay entries */
+extern size_t registerScript_length(const OV5642RegisterEntry *entries);
+
+/** The delay in milliseconds the sensor needs after writing value to address, 0 if none */
+extern uint32_t registerScript_delayAfterWrite(const uint16_t address, const uint8_t value);
+
+/** false for registers that act on every write (reset, group hold) and so must never be skipped */
+extern bool registerScript_isCacheable(const uint16_t address);
+
+/** Write all entries up until the end entry, shadow and stats can be NULL,
+ * stops at and returns the first writer error */
+extern Error registerScript_run(const RegisterScriptWriter *writer, RegisterShadow *shadow,
+                                const OV5642RegisterEntry *entries, RegisterScriptStats *stats);
+
+/** Create the script that takes a sensor last configured by the from table to the same state as writing the whole
+ * to table, keeping only entries of to that change a register's final value, plus entries whose order matters
+ * (delays, uncacheable registers and registers to writes more than once with different values).
+ * If to resets the sensor the delta is a copy of to. *delta is allocated and must be freed by the caller */
+extern Error registerScript_createDelta(const OV5642RegisterEntry *from, const OV5642RegisterEntry *to,
+                                        OV5642RegisterEntry **delta);
+
+/** Create the script that writes all of first then all of second, *script is allocated and must be freed by the
+ * caller */
+extern Error registerScript_concat(const OV5642RegisterEntry *first, const OV5642RegisterEntry *second,
+                                   OV5642RegisterEntry **script);
+
+#endif //ESP32_REMOTECAMERA_REGISTERSCRIPT_H
@@ -0,0 +1,102 @@
+#include "RegisterShadow.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct RegisterShadowData {
+    capacity_t capacity;
+    capacity_t size;
+    /** Sorted by address */
+    OV5642RegisterEntry *entries;
+} RegisterShadowData;
+
+/** Index of address if found, otherwise the index it should be inserted at */
+private index_t registerShadow_search(const RegisterShadowData *this, const uint16_t address, bool *isFound) {
+    index_t low = 0;
+    index_t high = this->size;
+    while (low < high) {
+        const index_t middle = low + (high - low) / 2;
+        const uint16_t middleAddress = this->entries[middle].address;
+        if (middleAddress == address) {
+            *isFound = true;
+            return middle;
+        } else if (middleAddress < address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *isFound = false;
+    return low;
+}
+
+public RegisterShadow *registerShadow_create(const capacity_t capacity) {
+    if (capacity == 0) return NULL;
+    RegisterShadowData *this = new(RegisterShadowData);
+    this->capacity = capacity;
+    this->size = 0;
+    this->entries = alloc(capacity * sizeof(OV5642RegisterEntry));
+    if (!this->entries) {
+        delete(this);
+        return NULL;
+    }
+    return this;
+}
+
+public void registerShadow_destroy(RegisterShadow *registerShadow) {
+    if (!registerShadow) return;
+    RegisterShadowData *this = (RegisterShadowData *) registerShadow;
+    delete(this->entries);
+    delete(this);
+}
+
+public bool registerShadow_get(const RegisterShadow *registerShadow, const uint16_t address, uint8_t *value) {
+    if (!registerShadow) return false;
+    const RegisterShadowData *this = (const RegisterShadowData *) registerShadow;
+    bool isFound;
+    const index_t index = registerShadow_search(this, address, &isFound);
+    if (isFound && value) *value = this->entries[index].value;
+    return isFound;
+}
+
+public Error registerShadow_set(RegisterShadow *registerShadow, const uint16_t address, const uint8_t value) {
+    if (!registerShadow) return ERROR_NULL_ARGUMENT;
+    RegisterShadowData *this = (RegisterShadowData *) registerShadow;
+    bool isFound;
+    const index_t index = registerShadow_search(this, address, &isFound);
+    if (isFound) {
+        this->entries[index].value = value;
+        return ERROR_NONE;
+    }
+    if (this->size == this->capacity) return ERROR_OUT_OF_BOUNDS;
+    memmove(&this->entries[index + 1], &this->entries[index], (this->size - index) * sizeof(OV5642RegisterEntry));
+    this->entries[index] = (OV5642RegisterEntry) {.address = address, .value = value};
+    this->size++;
+    return ERROR_NONE;
+}
+
+public bool registerShadow_isUnchanged(const RegisterShadow *registerShadow,
+                                       const uint16_t address, const uint8_t value) {
+    uint8_t knownValue;
+    return registerShadow_get(registerShadow, address, &knownValue) && knownValue == value;
+}
+
+public void registerShadow_clear(RegisterShadow *registerShadow) {
+    if (!registerShadow) return;
+    RegisterShadowData *this = (RegisterShadowData *) registerShadow;
+    this->size = 0;
+}
+
+public capacity_t registerShadow_getSize(const RegisterShadow *registerShadow) {
+    if (!registerShadow) return LIST_INVALID_INDEX_CAPACITY;
+    const RegisterShadowData *this = (const RegisterShadowData *) registerShadow;
+    return this->size;
+}
+
+public void registerShadow_forEach(const RegisterShadow *registerShadow,
+                                   RegisterShadowVisitor visitor, void *userArg) {
+    if (!registerShadow || !visitor) return;
+    const RegisterShadowData *this = (const RegisterShadowData *) registerShadow;
+    for (index_t i = 0; i < this->size; i++) {
+        visitor(this->entries[i].address, this->entries[i].value, userArg);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef ESP32_REMOTECAMERA_REGISTERSHADOW_H
+#define ESP32_REMOTECAMERA_REGISTERSHADOW_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "List.h"
+#include "OV5642.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * In-RAM copy of the sensor registers we have written to, kept sorted by address,
+ * used to skip writes of a value a register already holds.
+ * Only registers that have been written since the last clear are known, anything else is treated as unknown
+ * and will always be written
+ */
+typedef void RegisterShadow;
+
+/** Big enough for every distinct register written by the tables in OV5642.c */
+#define REGISTER_SHADOW_DEFAULT_CAPACITY 1024
+
+typedef void (*RegisterShadowVisitor)(const uint16_t address, const uint8_t value, void *userArg);
+
+extern RegisterShadow *registerShadow_create(const capacity_t capacity);
+
+extern void registerShadow_destroy(RegisterShadow *registerShadow);
+
+/** true and writes value if address is known, false otherwise */
+extern bool registerShadow_get(const RegisterShadow *registerShadow, const uint16_t address, uint8_t *value);
+
+/** Record that value was written to address,
+ * returns ERROR_OUT_OF_BOUNDS if the shadow is full in which case address stays unknown */
+extern Error registerShadow_set(RegisterShadow *registerShadow, const uint16_t address, const uint8_t value);
+
+/** true if address is known to already hold value so writing it again would change nothing */
+extern bool registerShadow_isUnchanged(const RegisterShadow *registerShadow,
+                                       const uint16_t address, const uint8_t value);
+
+/** Forget every register, such as after a sensor reset */
+extern void registerShadow_clear(RegisterShadow *registerShadow);
+
+extern capacity_t registerShadow_getSize(const RegisterShadow *registerShadow);
+
+/** Call visitor for every known register in ascending address order */
+extern void registerShadow_forEach(const RegisterShadow *registerShadow,
+                                   RegisterShadowVisitor visitor, void *userArg);
+
+#endif //ESP32_REMOTECAMERA_REGISTERSHADOW_H
@@ -0,0 +1,31 @@
+#include "SPIClock.h"
+
+#define SPI_CLOCK_CHECKSUM_PRIME 0x01000193U
+
+public uint32_t spiClock_checksum(const uint32_t checksum, const uint8_t *bytes, const size_t length) {
+    uint32_t hash = checksum;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * SPI_CLOCK_CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+public bool spiClock_isStepOk(const CameraSPIClockStep *step) {
+    return step && step->isRegisterOk && step->isFrameOk;
+}
+
+public Error spiClock_choose(const CameraSPIClockStep *steps, const uint stepCount, const uint32_t marginPercent,
+                             uint32_t *fastestReliableHz, uint32_t *clockHz) {
+    if (!steps || !fastestReliableHz || !clockHz) return ERROR_NULL_ARGUMENT;
+    if (marginPercent >= 100) return ERROR_ILLEGAL_ARGUMENT;
+    uint reliableCount = 0;
+    while (reliableCount < stepCount && spiClock_isStepOk(&steps[reliableCount])) reliableCount++;
+    if (reliableCount == 0) return ERROR_NOT_FOUND;
+    *fastestReliableHz = steps[reliableCount - 1].clockHz;
+    const uint64_t maxHz = ((uint64_t) *fastestReliableHz * (100 - marginPercent)) / 100;
+    *clockHz = steps[0].clockHz; // the slowest is kept when nothing is far enough below the fastest
+    for (uint i = 1; i < reliableCount; i++) {
+        if (steps[i].clockHz <= maxHz) *clockHz = steps[i].clockHz;
+    }
+    return ERROR_NONE;
+}
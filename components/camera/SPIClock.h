@@ -0,0 +1,30 @@
+#ifndef ESP32_REMOTECAMERA_SPICLOCK_H
+#define ESP32_REMOTECAMERA_SPICLOCK_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Decides which SPI clock to keep from the steps of a calibration, a clock is only trusted when every slower clock
+ * passed too, and the clock kept is the fastest trusted one at least marginPercent slower than the fastest trusted,
+ * so a clock on the edge of failing (such as when the board warms up) is never kept
+ */
+
+/** Starting value for spiClock_checksum() */
+#define SPI_CLOCK_CHECKSUM_SEED 0x811C9DC5U
+
+/** Continue an FNV-1a checksum over length bytes, chain calls to checksum a frame read in several chunks */
+extern uint32_t spiClock_checksum(const uint32_t checksum, const uint8_t *bytes, const size_t length);
+
+/** Whether the step passed both its register and its frame checks */
+extern bool spiClock_isStepOk(const CameraSPIClockStep *step);
+
+/** Choose from stepCount steps in order of rising clock, returns ERROR_NOT_FOUND if even the slowest step failed */
+extern Error spiClock_choose(const CameraSPIClockStep *steps, const uint stepCount, const uint32_t marginPercent,
+                             uint32_t *fastestReliableHz, uint32_t *clockHz);
+
+#endif //ESP32_REMOTECAMERA_SPICLOCK_H
@@ -0,0 +1,129 @@
+#include "SensorWindow.h"
+
+/** Where the image size tables start the window, the array's first active pixel with mirror on */
+#define SENSOR_WINDOW_ARRAY_X_START 0x1B0
+#define SENSOR_WINDOW_ARRAY_Y_START 0x00A
+
+#define OV5642_REGISTER_ARRAY_WINDOW 0x3800
+#define OV5642_REGISTER_ISP_WINDOW 0x5680
+
+private const struct {
+    uint32_t width;
+    uint32_t height;
+} SENSOR_WINDOW_OUTPUT_SIZES[] = {
+        [CAMERA_IMAGE_SIZE_320x240] = {320, 240},
+        [CAMERA_IMAGE_SIZE_640x480] = {640, 480},
+        [CAMERA_IMAGE_SIZE_1024x768] = {1024, 768},
+        [CAMERA_IMAGE_SIZE_1280x960] = {1280, 960},
+        [CAMERA_IMAGE_SIZE_1600x1200] = {1600, 1200},
+        [CAMERA_IMAGE_SIZE_2048x1536] = {2048, 1536},
+        [CAMERA_IMAGE_SIZE_2592x1944] = {2592, 1944},
+};
+
+private uint32_t roundUpEven(const uint32_t value) {
+    return (value + 1) & ~1U;
+}
+
+/** start such that a length long span centred on centre lies inside 0 to limit, rounded down to even */
+private uint32_t centredStart(const uint32_t centre, const uint32_t length, const uint32_t limit) {
+    const uint32_t halfLength = length / 2;
+    uint32_t start = centre > halfLength ? centre - halfLength : 0;
+    if (start + length > limit) start = limit - length;
+    return start & ~1U;
+}
+
+private void putUInt16(OV5642RegisterEntry *entries, const uint16_t address, const uint16_t value) {
+    entries[0] = (OV5642RegisterEntry) {.address = address, .value = value >> 8};
+    entries[1] = (OV5642RegisterEntry) {.address = address + 1, .value = value & 0xFF};
+}
+
+public Error sensorWindow_outputSize(const CameraImageSize imageSize, uint32_t *width, uint32_t *height) {
+    if (!width || !height) return ERROR_NULL_ARGUMENT;
+    if (imageSize < 0 || imageSize >= CAMERA_IMAGE_SIZE_COUNT) return ERROR_OUT_OF_BOUNDS;
+    *width = SENSOR_WINDOW_OUTPUT_SIZES[imageSize].width;
+    *height = SENSOR_WINDOW_OUTPUT_SIZES[imageSize].height;
+    return ERROR_NONE;
+}
+
+public bool sensorWindow_isValidRegion(const CameraRegion *region) {
+    return region != NULL && region->width > 0 && region->height > 0 &&
+           region->width <= CAMERA_SENSOR_WIDTH && region->height <= CAMERA_SENSOR_HEIGHT &&
+           region->x <= CAMERA_SENSOR_WIDTH - region->width && region->y <= CAMERA_SENSOR_HEIGHT - region->height;
+}
+
+public Error sensorWindow_fromZoom(const float centreX, const float centreY, const float zoom, CameraRegion *region) {
+    if (!region) return ERROR_NULL_ARGUMENT;
+    if (!(centreX >= 0.0F && centreX <= 1.0F) || !(centreY >= 0.0F && centreY <= 1.0F) ||
+        !(zoom >= 1.0F && zoom <= SENSOR_WINDOW_MAX_ZOOM)) {
+        return ERROR_OUT_OF_BOUNDS;
+    }
+    const uint32_t width = roundUpEven((uint32_t) ((float) CAMERA_SENSOR_WIDTH / zoom));
+    const uint32_t height = roundUpEven((uint32_t) ((float) CAMERA_SENSOR_HEIGHT / zoom));
+    *region = (CameraRegion) {
+            .x = centredStart((uint32_t) (centreX * CAMERA_SENSOR_WIDTH), width, CAMERA_SENSOR_WIDTH),
+            .y = centredStart((uint32_t) (centreY * CAMERA_SENSOR_HEIGHT), height, CAMERA_SENSOR_HEIGHT),
+            .width = width,
+            .height = height,
+    };
+    return ERROR_NONE;
+}
+
+public Error sensorWindow_fit(const CameraRegion *region, const CameraImageSize imageSize, CameraRegion *window) {
+    if (!region || !window) return ERROR_NULL_ARGUMENT;
+    if (!sensorWindow_isValidRegion(region)) return ERROR_OUT_OF_BOUNDS;
+    uint32_t outputWidth;
+    uint32_t outputHeight;
+    const Error err = sensorWindow_outputSize(imageSize, &outputWidth, &outputHeight);
+    if (err != ERROR_NONE) return err;
+
+    // grow the short side to the output's aspect ratio so the ISP scales both axes by the same amount
+    uint32_t width = region->width;
+    uint32_t height = region->height;
+    if ((uint64_t) width * outputHeight < (uint64_t) height * outputWidth) {
+        width = (((uint64_t) height * outputWidth) + outputHeight - 1) / outputHeight;
+    } else {
+        height = (((uint64_t) width * outputHeight) + outputWidth - 1) / outputWidth;
+    }
+    if (width < outputWidth) {
+        width = outputWidth;
+        height = outputHeight;
+    }
+    if (width > CAMERA_SENSOR_WIDTH) {
+        width = CAMERA_SENSOR_WIDTH;
+        height = ((uint64_t) CAMERA_SENSOR_WIDTH * outputHeight) / outputWidth;
+    }
+    if (height > CAMERA_SENSOR_HEIGHT) {
+        height = CAMERA_SENSOR_HEIGHT;
+        width = ((uint64_t) CAMERA_SENSOR_HEIGHT * outputWidth) / outputHeight;
+    }
+    width = roundUpEven(width); // the array's sides are even so this never takes the window past them
+    height = roundUpEven(height);
+    *window = (CameraRegion) {
+            .x = centredStart(region->x + (region->width / 2), width, CAMERA_SENSOR_WIDTH),
+            .y = centredStart(region->y + (region->height / 2), height, CAMERA_SENSOR_HEIGHT),
+            .width = width,
+            .height = height,
+    };
+    return ERROR_NONE;
+}
+
+public Error sensorWindow_compile(const CameraRegion *window, const bool isMirrored, const bool isFlipped,
+                                  OV5642RegisterEntry *entries) {
+    if (!window || !entries) return ERROR_NULL_ARGUMENT;
+    if (!sensorWindow_isValidRegion(window)) return ERROR_OUT_OF_BOUNDS;
+    // a mirrored readout puts the image's left edge at the array's right edge, the same goes for flip and the top
+    const uint32_t arrayX = isMirrored ? CAMERA_SENSOR_WIDTH - window->x - window->width : window->x;
+    const uint32_t arrayY = isFlipped ? CAMERA_SENSOR_HEIGHT - window->y - window->height : window->y;
+    putUInt16(entries + 0, OV5642_REGISTER_ARRAY_WINDOW + 0, SENSOR_WINDOW_ARRAY_X_START + arrayX);
+    putUInt16(entries + 2, OV5642_REGISTER_ARRAY_WINDOW + 2, SENSOR_WINDOW_ARRAY_Y_START + arrayY);
+    putUInt16(entries + 4, OV5642_REGISTER_ARRAY_WINDOW + 4, window->width);
+    putUInt16(entries + 6, OV5642_REGISTER_ARRAY_WINDOW + 6, window->height);
+    // the ISP takes the whole array window, it is only offset for a window inside the array window
+    putUInt16(entries + 8, OV5642_REGISTER_ISP_WINDOW + 0, 0);
+    putUInt16(entries + 10, OV5642_REGISTER_ISP_WINDOW + 2, window->width);
+    putUInt16(entries + 12, OV5642_REGISTER_ISP_WINDOW + 4, 0);
+    putUInt16(entries + 14, OV5642_REGISTER_ISP_WINDOW + 6, window->height);
+    entries[SENSOR_WINDOW_REGISTER_COUNT] = (OV5642RegisterEntry) {OV5642_REGISTER_ADDRESS_END,
+                                                                   OV5642_REGISTER_VALUE_END};
+    return ERROR_NONE;
+}
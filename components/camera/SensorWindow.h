@@ -0,0 +1,45 @@
+#ifndef ESP32_REMOTECAMERA_SENSORWINDOW_H
+#define ESP32_REMOTECAMERA_SENSORWINDOW_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Camera.h"
+#include "OV5642.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Compiles a region of interest into the OV5642's array window (0x3800-0x3807) and ISP input window (0x5680-0x5687)
+ * registers, the ISP scales the window down to the image size's output so a smaller window is a digital zoom with
+ * no change to the output size, timing (HTS/VTS) or JPEG settings
+ */
+
+/** Registers in the array window then the ISP input window, written in ascending address order */
+#define SENSOR_WINDOW_REGISTER_COUNT 16
+/** Size of the entries array to compile into, includes the end entry */
+#define SENSOR_WINDOW_MAX_ENTRIES (SENSOR_WINDOW_REGISTER_COUNT + 1)
+/** The ISP only scales down so the window can't be smaller than the smallest output, 320x240 */
+#define SENSOR_WINDOW_MAX_ZOOM ((float) CAMERA_SENSOR_WIDTH / 320.0F)
+
+/** Width and height of the JPEG the sensor outputs at imageSize */
+extern Error sensorWindow_outputSize(const CameraImageSize imageSize, uint32_t *width, uint32_t *height);
+
+/** Whether region is non-empty and inside the sensor's array */
+extern bool sensorWindow_isValidRegion(const CameraRegion *region);
+
+/** The region zoom times smaller than the whole array centred on (centreX, centreY), given as fractions (0 to 1) of
+ * the image's width and height, the region is moved inside the array if the centre is too close to an edge,
+ * returns ERROR_OUT_OF_BOUNDS for a centre outside the image or a zoom outside 1 to SENSOR_WINDOW_MAX_ZOOM */
+extern Error sensorWindow_fromZoom(const float centreX, const float centreY, const float zoom, CameraRegion *region);
+
+/** The window the sensor can actually read for region at imageSize, region is grown around its centre to the output's
+ * aspect ratio and to at least the output's size (the ISP can't scale up), aligned to even pixels and moved inside
+ * the array, returns ERROR_OUT_OF_BOUNDS for an invalid region */
+extern Error sensorWindow_fit(const CameraRegion *region, const CameraImageSize imageSize, CameraRegion *window);
+
+/** Write the register script for a fitted window into entries (at least SENSOR_WINDOW_MAX_ENTRIES long), the window
+ * is in image coordinates and is mirrored and flipped into array coordinates to match the sensor's readout */
+extern Error sensorWindow_compile(const CameraRegion *window, const bool isMirrored, const bool isFlipped,
+                                  OV5642RegisterEntry *entries);
+
+#endif //ESP32_REMOTECAMERA_SENSORWINDOW_H
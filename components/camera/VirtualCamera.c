@@ -0,0 +1,430 @@
+#include "VirtualCamera.h"
+#include "OV5642.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <strings.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define VIRTUAL_CAMERA_SPI_REGISTER_COUNT 0x80
+#define VIRTUAL_CAMERA_SENSOR_REGISTER_COUNT 0x10000
+/** The sensor registers are kept in pages allocated on first write, the Arducam tables only touch about 25 of them */
+#define VIRTUAL_CAMERA_SENSOR_PAGE_SIZE 0x100
+#define VIRTUAL_CAMERA_SENSOR_PAGE_COUNT (VIRTUAL_CAMERA_SENSOR_REGISTER_COUNT / VIRTUAL_CAMERA_SENSOR_PAGE_SIZE)
+/** The frame count register is 3 bits of frames after the first */
+#define VIRTUAL_CAMERA_MAX_FRAMES_PER_CAPTURE 8
+#define OV5642_REGISTER_SYSTEM_CONTROL 0x3008
+#define OV5642_SYSTEM_CONTROL_SOFTWARE_RESET 0x80
+
+typedef struct VirtualCameraFrame {
+    /** The frame's bytes when it was added from memory, NULL for a recording, which is read from path as needed */
+    uint8_t *data;
+    char *path;
+    size_t length;
+} VirtualCameraFrame;
+
+typedef struct VirtualCameraData {
+    VirtualCameraOptions options;
+    VirtualCameraStats stats;
+    uint8_t spiRegisters[VIRTUAL_CAMERA_SPI_REGISTER_COUNT];
+    /** The 16 bit sensor register space, a page that was never written is NULL and reads as 0x00 */
+    uint8_t *sensorPages[VIRTUAL_CAMERA_SENSOR_PAGE_COUNT];
+    struct {
+        VirtualCameraFrame *list;
+        size_t count;
+        size_t capacity;
+        /** Frame the next capture starts from */
+        size_t next;
+    } frames;
+    struct {
+        /** The frames the last completed capture wrote in FIFO order, each followed by framePaddingBytes */
+        size_t frames[VIRTUAL_CAMERA_MAX_FRAMES_PER_CAPTURE];
+        uint frameCount;
+        /** Bytes written by the last completed capture, what the FIFO size registers report */
+        size_t length;
+        size_t readPosition;
+        bool isCapturing;
+        bool isDone;
+        uint64_t doneMicros;
+    } fifo;
+    /** The recording last read from, kept open while the FIFO is read through it */
+    struct {
+        FILE *file;
+        size_t frame;
+        long position;
+    } recording;
+} VirtualCameraData;
+
+private uint64_t virtualCamera_systemClock(void *context) {
+    (void) context;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000) + ((uint64_t) now.tv_nsec / 1000);
+}
+
+/** Move the first length bytes to a new allocation of newLength bytes, pointer is left untouched if that fails */
+private void *virtualCamera_resize(void *pointer, const size_t length, const size_t newLength) {
+    uint8_t *resized = alloc(newLength);
+    if (!resized) return NULL;
+    if (pointer) memcpy(resized, pointer, length < newLength ? length : newLength);
+    delete(pointer);
+    return resized;
+}
+
+private void virtualCamera_resetSensor(VirtualCameraData *this) {
+    for (size_t i = 0; i < VIRTUAL_CAMERA_SENSOR_PAGE_COUNT; i++) {
+        delete(this->sensorPages[i]);
+        this->sensorPages[i] = NULL;
+    }
+}
+
+private uint8_t virtualCamera_getRegister(const VirtualCameraData *this, const uint16_t address) {
+    if (address == OV5642_I2C_REGISTER_CHIP_ID_HIGH) return OV5642_I2C_CHIP_ID_HIGH;
+    if (address == OV5642_I2C_REGISTER_CHIP_ID_LOW) return OV5642_I2C_CHIP_ID_LOW;
+    const uint8_t *page = this->sensorPages[address / VIRTUAL_CAMERA_SENSOR_PAGE_SIZE];
+    return page ? page[address % VIRTUAL_CAMERA_SENSOR_PAGE_SIZE] : 0x00;
+}
+
+private Error virtualCamera_setRegister(VirtualCameraData *this, const uint16_t address, const uint8_t value) {
+    uint8_t **page = &this->sensorPages[address / VIRTUAL_CAMERA_SENSOR_PAGE_SIZE];
+    if (!*page && !(*page = alloc(VIRTUAL_CAMERA_SENSOR_PAGE_SIZE))) return ERROR_LIBRARY_FAILURE;
+    (*page)[address % VIRTUAL_CAMERA_SENSOR_PAGE_SIZE] = value;
+    return ERROR_NONE;
+}
+
+private void virtualCamera_closeRecording(VirtualCameraData *this) {
+    if (this->recording.file) fclose(this->recording.file);
+    this->recording.file = NULL;
+}
+
+public VirtualCamera *virtualCamera_create(const VirtualCameraOptions *options) {
+    VirtualCameraData *this = new(VirtualCameraData);
+    if (!this) return NULL;
+    if (options) this->options = *options;
+    if (!this->options.clock) this->options.clock = virtualCamera_systemClock;
+    this->spiRegisters[VIRTUAL_CAMERA_SPI_REGISTER_FRAME_COUNT] = VIRTUAL_CAMERA_DEFAULT_FRAME_COUNT - 1;
+    return this;
+}
+
+public void virtualCamera_destroy(VirtualCamera *virtualCamera) {
+    if (!virtualCamera) return;
+    VirtualCameraData *this = (VirtualCameraData *) virtualCamera;
+    virtualCamera_closeRecording(this);
+    for (size_t i = 0; i < this->frames.count; i++) {
+        delete(this->frames.list[i].data);
+        delete(this->frames.list[i].path);
+    }
+    delete(this->frames.list);
+    virtualCamera_resetSensor(this);
+    delete(this);
+}
+
+/** Make room for one more frame at the end of the frames list */
+private Error virtualCamera_growFrames(VirtualCameraData *this) {
+    if (this->frames.count < this->frames.capacity) return ERROR_NONE;
+    const size_t capacity = this->frames.capacity > 0 ? this->frames.capacity * 2 : 8;
+    const size_t frameBytes = sizeof(VirtualCameraFrame);
+    VirtualCameraFrame *list = virtualCamera_resize(this->frames.list, this->frames.count * frameBytes,
+                                                    capacity * frameBytes);
+    if (!list) return ERROR_LIBRARY_FAILURE;
+    this->frames.list = list;
+    this->frames.capacity = capacity;
+    return ERROR_NONE;
+}
+
+public Error virtualCamera_addFrame(VirtualCamera *virtualCamera, const uint8_t *data, const size_t length) {
+    if (!virtualCamera || !data) return ERROR_NULL_ARGUMENT;
+    if (length == 0 || length > VIRTUAL_CAMERA_FIFO_MAX_BYTES) return ERROR_ILLEGAL_ARGUMENT;
+    VirtualCameraData *this = (VirtualCameraData *) virtualCamera;
+    if (virtualCamera_growFrames(this) != ERROR_NONE) return ERROR_LIBRARY_FAILURE;
+    uint8_t *copy = alloc(length);
+    if (!copy) return ERROR_LIBRARY_FAILURE;
+    memcpy(copy, data, length);
+    this->frames.list[this->frames.count++] = (VirtualCameraFrame) {.data = copy, .length = length};
+    return ERROR_NONE;
+}
+
+private bool virtualCamera_isJPEGFileName(const char *name) {
+    const char *extension = strrchr(name, '.');
+    return extension && (strcasecmp(extension, ".jpg") == 0 || strcasecmp(extension, ".jpeg") == 0);
+}
+
+private int virtualCamera_compareNames(const void *a, const void *b) {
+    return strcmp(*(const char *const *) a, *(const char *const *) b);
+}
+
+/** Add the recording at path, which it takes ownership of, only its length is read now */
+private Error virtualCamera_addRecording(VirtualCameraData *this, char *path) {
+    struct stat fileStat;
+    if (stat(path, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        delete(path);
+        return ERROR_NOT_FOUND;
+    }
+    if (fileStat.st_size <= 0 || fileStat.st_size > VIRTUAL_CAMERA_FIFO_MAX_BYTES) {
+        delete(path);
+        return ERROR_ILLEGAL_ARGUMENT;
+    }
+    if (virtualCamera_growFrames(this) != ERROR_NONE) {
+        delete(path);
+        return ERROR_LIBRARY_FAILURE;
+    }
+    this->frames.list[this->frames.count++] = (VirtualCameraFrame) {.path = path, .length = fileStat.st_size};
+    return ERROR_NONE;
+}
+
+public Error virtualCamera_loadFrames(VirtualCamera *virtualCamera, const char *directoryPath) {
+    if (!virtualCamera || !directoryPath) return ERROR_NULL_ARGUMENT;
+    DIR *directory = opendir(directoryPath);
+    if (!directory) return ERROR_NOT_FOUND;
+    char **names = NULL;
+    size_t nameCount = 0;
+    size_t nameCapacity = 0;
+    Error err = ERROR_NONE;
+    struct dirent *entry;
+    while (err == ERROR_NONE && (entry = readdir(directory)) != NULL) {
+        if (!virtualCamera_isJPEGFileName(entry->d_name)) continue;
+        if (nameCount == nameCapacity) {
+            const size_t capacity = nameCapacity > 0 ? nameCapacity * 2 : 16;
+            char **grown = virtualCamera_resize(names, nameCount * sizeof(char *), capacity * sizeof(char *));
+            if (!grown) {
+                err = ERROR_LIBRARY_FAILURE;
+                break;
+            }
+            names = grown;
+            nameCapacity = capacity;
+        }
+        const size_t pathLength = strlen(directoryPath) + 1 + strlen(entry->d_name);
+        names[nameCount] = stralloc(pathLength);
+        if (!names[nameCount]) {
+            err = ERROR_LIBRARY_FAILURE;
+            break;
+        }
+        snprintf(names[nameCount], pathLength + 1, "%s/%s", directoryPath, entry->d_name);
+        nameCount++;
+    }
+    closedir(directory);
+    // readdir order is up to the filesystem, recordings are named so that name order is capture order
+    if (nameCount > 0) qsort(names, nameCount, sizeof(char *), virtualCamera_compareNames);
+    for (size_t i = 0; i < nameCount; i++) {
+        if (err == ERROR_NONE) {
+            err = virtualCamera_addRecording((VirtualCameraData *) virtualCamera, names[i]);
+        } else {
+            delete(names[i]);
+        }
+    }
+    delete(names);
+    if (err == ERROR_NONE && nameCount == 0) err = ERROR_NOT_FOUND;
+    return err;
+}
+
+public size_t virtualCamera_getFrameCount(const VirtualCamera *virtualCamera) {
+    if (!virtualCamera) return 0;
+    return ((const VirtualCameraData *) virtualCamera)->frames.count;
+}
+
+/** Fill the FIFO with the next frames of the capture that just finished, frames that don't fit are lost as on the
+ * real FIFO, which stops writing when it is full. Only which frames were written is kept, their bytes are read from
+ * the frame as the FIFO is read */
+private void virtualCamera_writeFIFO(VirtualCameraData *this) {
+    const uint frameCount = this->spiRegisters[VIRTUAL_CAMERA_SPI_REGISTER_FRAME_COUNT] + 1;
+    this->fifo.length = 0;
+    this->fifo.frameCount = 0;
+    for (uint i = 0; i < frameCount && this->frames.count > 0; i++) {
+        const VirtualCameraFrame *frame = &this->frames.list[this->frames.next];
+        const size_t frameLength = frame->length + this->options.framePaddingBytes;
+        if (this->fifo.length + frameLength > VIRTUAL_CAMERA_FIFO_MAX_BYTES) break;
+        this->fifo.frames[this->fifo.frameCount++] = this->frames.next;
+        this->fifo.length += frameLength;
+        this->frames.next = (this->frames.next + 1) % this->frames.count;
+        this->stats.framesCaptured++;
+    }
+}
+
+/** Finish the capture in progress if its latency has passed, done lazily whenever the driver looks at the FIFO */
+private void virtualCamera_updateCapture(VirtualCameraData *this) {
+    if (!this->fifo.isCapturing) return;
+    if (this->options.clock(this->options.clockContext) < this->fifo.doneMicros) return;
+    virtualCamera_writeFIFO(this);
+    this->fifo.isCapturing = false;
+    this->fifo.isDone = true;
+}
+
+private void virtualCamera_fifoControl(VirtualCameraData *this, const uint8_t value) {
+    if (value & VIRTUAL_CAMERA_FIFO_CLEAR_DONE_FLAG) {
+        this->fifo.isDone = false;
+    }
+    if (value & VIRTUAL_CAMERA_FIFO_RESET_WRITE) {
+        this->fifo.isCapturing = false;
+        this->fifo.length = 0;
+        this->fifo.frameCount = 0;
+    }
+    if (value & VIRTUAL_CAMERA_FIFO_RESET_READ) {
+        this->fifo.readPosition = 0;
+    }
+    if (value & VIRTUAL_CAMERA_FIFO_START_CAPTURE) {
+        // the recordings can be on a card mounted after the model was created, so look for them until some are found
+        if (this->frames.count == 0 && this->options.framesPath) {
+            virtualCamera_loadFrames(this, this->options.framesPath);
+        }
+        const uint frameCount = this->spiRegisters[VIRTUAL_CAMERA_SPI_REGISTER_FRAME_COUNT] + 1;
+        this->fifo.isCapturing = true;
+        this->fifo.isDone = false;
+        this->fifo.readPosition = 0;
+        this->fifo.doneMicros = this->options.clock(this->options.clockContext) +
+                                ((uint64_t) this->options.captureMicros * frameCount);
+        this->stats.capturesStarted++;
+    }
+}
+
+/** Read length bytes of a frame starting at offset, a recording that can't be read reads as 0x00 like a garbled
+ * FIFO would */
+private void virtualCamera_readFrame(VirtualCameraData *this, const size_t frameIndex, const size_t offset,
+                                     uint8_t *buffer, const size_t length) {
+    const VirtualCameraFrame *frame = &this->frames.list[frameIndex];
+    if (frame->data) {
+        memcpy(buffer, frame->data + offset, length);
+        return;
+    }
+    if (!this->recording.file || this->recording.frame != frameIndex) {
+        virtualCamera_closeRecording(this);
+        this->recording.file = fopen(frame->path, "rb");
+        this->recording.frame = frameIndex;
+        this->recording.position = 0;
+    }
+    size_t bytesRead = 0;
+    if (this->recording.file) {
+        if (this->recording.position == (long) offset || fseek(this->recording.file, (long) offset, SEEK_SET) == 0) {
+            bytesRead = fread(buffer, 1, length, this->recording.file);
+        }
+        this->recording.position = (long) (offset + bytesRead);
+        if (bytesRead < length) virtualCamera_closeRecording(this); // reopened and sought on the next read
+    }
+    memset(buffer + bytesRead, 0x00, length - bytesRead);
+}
+
+private void virtualCamera_readFIFO(VirtualCameraData *this, uint8_t *receiveData, const size_t length) {
+    size_t bytesDone = 0;
+    size_t frameStart = 0;
+    for (uint i = 0; i < this->fifo.frameCount && bytesDone < length; i++) {
+        const size_t frameIndex = this->fifo.frames[i];
+        const size_t frameLength = this->frames.list[frameIndex].length;
+        const size_t frameEnd = frameStart + frameLength + this->options.framePaddingBytes;
+        const size_t position = this->fifo.readPosition + bytesDone;
+        if (position < frameEnd) {
+            const size_t offset = position - frameStart;
+            const size_t bytesWanted = length - bytesDone;
+            if (offset < frameLength) {
+                const size_t bytes = bytesWanted < frameLength - offset ? bytesWanted : frameLength - offset;
+                virtualCamera_readFrame(this, frameIndex, offset, receiveData + bytesDone, bytes);
+                bytesDone += bytes;
+            }
+            const size_t paddingLeft = frameEnd - (this->fifo.readPosition + bytesDone);
+            const size_t padding = length - bytesDone < paddingLeft ? length - bytesDone : paddingLeft;
+            memset(receiveData + bytesDone, 0x00, padding);
+            bytesDone += padding;
+        }
+        frameStart = frameEnd;
+    }
+    memset(receiveData + bytesDone, 0x00, length - bytesDone);
+    this->fifo.readPosition += length;
+    this->stats.fifoBytesRead += length;
+}
+
+/** The value of a single byte register read */
+private uint8_t virtualCamera_readRegister(VirtualCameraData *this, const uint8_t address) {
+    switch (address) {
+        case VIRTUAL_CAMERA_SPI_REGISTER_VERSION:
+            return VIRTUAL_CAMERA_ARDUCHIP_VERSION;
+        case VIRTUAL_CAMERA_SPI_REGISTER_STATUS:
+            virtualCamera_updateCapture(this);
+            return this->fifo.isDone ? VIRTUAL_CAMERA_STATUS_DONE : 0x00;
+        case VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_LOW:
+            virtualCamera_updateCapture(this);
+            return (uint8_t) (this->fifo.length & 0xFF);
+        case VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_MIDDLE:
+            virtualCamera_updateCapture(this);
+            return (uint8_t) ((this->fifo.length >> 8) & 0xFF);
+        case VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_HIGH:
+            virtualCamera_updateCapture(this);
+            return (uint8_t) ((this->fifo.length >> 16) & 0x7F);
+        default:
+            return this->spiRegisters[address];
+    }
+}
+
+public Error virtualCamera_spiTransfer(VirtualCamera *virtualCamera, const uint8_t command,
+                                       const uint8_t *sendData, const size_t sendDataLength,
+                                       uint8_t *receiveData, const size_t receiveDataLength) {
+    if (!virtualCamera) return ERROR_NULL_ARGUMENT;
+    if ((sendDataLength > 0 && !sendData) || (receiveDataLength > 0 && !receiveData)) return ERROR_NULL_ARGUMENT;
+    VirtualCameraData *this = (VirtualCameraData *) virtualCamera;
+    const uint8_t address = command & ~VIRTUAL_CAMERA_SPI_WRITE;
+    this->stats.spiTransfers++;
+    if (command & VIRTUAL_CAMERA_SPI_WRITE) {
+        if (sendDataLength == 0) return ERROR_ILLEGAL_ARGUMENT;
+        const uint8_t value = sendData[0];
+        if (address == VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL) {
+            virtualCamera_fifoControl(this, value);
+        } else if (address == VIRTUAL_CAMERA_SPI_REGISTER_FRAME_COUNT) {
+            this->spiRegisters[address] = value & 0x07;
+        } else if (address != VIRTUAL_CAMERA_SPI_REGISTER_VERSION && address != VIRTUAL_CAMERA_SPI_REGISTER_STATUS) {
+            this->spiRegisters[address] = value;
+        }
+        return ERROR_NONE;
+    }
+    if (address == VIRTUAL_CAMERA_SPI_REGISTER_BURST_READ || address == VIRTUAL_CAMERA_SPI_REGISTER_SINGLE_READ) {
+        // single read returns 1 byte however long the transaction, burst read streams for as long as it lasts
+        const size_t length = address == VIRTUAL_CAMERA_SPI_REGISTER_SINGLE_READ && receiveDataLength > 1 ?
+                              1 : receiveDataLength;
+        virtualCamera_readFIFO(this, receiveData, length);
+        if (length < receiveDataLength) memset(receiveData + length, 0x00, receiveDataLength - length);
+        return ERROR_NONE;
+    }
+    // registers other than the FIFO only drive the first byte, the rest of a longer read is the same byte repeated
+    if (receiveDataLength > 0) memset(receiveData, virtualCamera_readRegister(this, address), receiveDataLength);
+    return ERROR_NONE;
+}
+
+public Error virtualCamera_i2cWrite(VirtualCamera *virtualCamera, const uint16_t address,
+                                    const uint8_t *values, const size_t length) {
+    if (!virtualCamera) return ERROR_NULL_ARGUMENT;
+    if (length > 0 && !values) return ERROR_NULL_ARGUMENT;
+    if ((size_t) address + length > VIRTUAL_CAMERA_SENSOR_REGISTER_COUNT) return ERROR_OUT_OF_BOUNDS;
+    VirtualCameraData *this = (VirtualCameraData *) virtualCamera;
+    this->stats.i2cWrites++;
+    for (size_t i = 0; i < length; i++) {
+        const uint16_t registerAddress = address + i;
+        if (registerAddress == OV5642_REGISTER_SYSTEM_CONTROL && (values[i] & OV5642_SYSTEM_CONTROL_SOFTWARE_RESET)) {
+            virtualCamera_resetSensor(this);
+        } else if (virtualCamera_setRegister(this, registerAddress, values[i]) != ERROR_NONE) {
+            return ERROR_LIBRARY_FAILURE;
+        }
+        this->stats.i2cRegistersWritten++;
+    }
+    return ERROR_NONE;
+}
+
+public Error virtualCamera_i2cRead(VirtualCamera *virtualCamera, const uint16_t address,
+                                   uint8_t *values, const size_t length) {
+    if (!virtualCamera) return ERROR_NULL_ARGUMENT;
+    if (length > 0 && !values) return ERROR_NULL_ARGUMENT;
+    if ((size_t) address + length > VIRTUAL_CAMERA_SENSOR_REGISTER_COUNT) return ERROR_OUT_OF_BOUNDS;
+    VirtualCameraData *this = (VirtualCameraData *) virtualCamera;
+    this->stats.i2cReads++;
+    for (size_t i = 0; i < length; i++) {
+        values[i] = virtualCamera_getRegister(this, address + i);
+    }
+    return ERROR_NONE;
+}
+
+public uint8_t virtualCamera_getSensorRegister(const VirtualCamera *virtualCamera, const uint16_t address) {
+    if (!virtualCamera) return 0;
+    return virtualCamera_getRegister((const VirtualCameraData *) virtualCamera, address);
+}
+
+public void virtualCamera_getStats(const VirtualCamera *virtualCamera, VirtualCameraStats *stats) {
+    if (!virtualCamera || !stats) return;
+    *stats = ((const VirtualCameraData *) virtualCamera)->stats;
+}
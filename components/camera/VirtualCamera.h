@@ -0,0 +1,103 @@
+#ifndef ESP32_REMOTECAMERA_VIRTUALCAMERA_H
+#define ESP32_REMOTECAMERA_VIRTUALCAMERA_H
+
+#include "Error.h"
+#include "Utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Model of the Arducam, the ArduChip SPI registers and FIFO and the OV5642's I2C registers, that serves recorded
+ * JPEG frames instead of real ones. Camera.c talks to it in place of the SPI and I2C drivers when
+ * CONFIG_CAMERA_VIRTUAL_DEVICE is set so the real capture code can be run and benchmarked on a board with no camera.
+ * Recorded frames are read from their files as the FIFO is read rather than held in memory, and only the sensor
+ * register pages that were written are allocated, so the model fits on a board with no PSRAM
+ */
+typedef void VirtualCamera;
+
+#define VIRTUAL_CAMERA_SPI_WRITE 0x80
+#define VIRTUAL_CAMERA_SPI_REGISTER_TEST 0x00
+#define VIRTUAL_CAMERA_SPI_REGISTER_FRAME_COUNT 0x01
+#define VIRTUAL_CAMERA_SPI_REGISTER_TIMING 0x03
+#define VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL 0x04
+#define VIRTUAL_CAMERA_SPI_REGISTER_BURST_READ 0x3C
+#define VIRTUAL_CAMERA_SPI_REGISTER_SINGLE_READ 0x3D
+#define VIRTUAL_CAMERA_SPI_REGISTER_VERSION 0x40
+#define VIRTUAL_CAMERA_SPI_REGISTER_STATUS 0x41
+#define VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_LOW 0x42
+#define VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_MIDDLE 0x43
+#define VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_HIGH 0x44
+
+#define VIRTUAL_CAMERA_FIFO_CLEAR_DONE_FLAG 0x01
+#define VIRTUAL_CAMERA_FIFO_START_CAPTURE 0x02
+#define VIRTUAL_CAMERA_FIFO_RESET_WRITE 0x10
+#define VIRTUAL_CAMERA_FIFO_RESET_READ 0x20
+#define VIRTUAL_CAMERA_STATUS_DONE 0x08
+
+/** ArduChip version the Arducam 5MP Plus reports, 7.3 */
+#define VIRTUAL_CAMERA_ARDUCHIP_VERSION 0x73
+/** The FIFO size is a 23 bit number, the 5MP Plus has 8MB of FIFO */
+#define VIRTUAL_CAMERA_FIFO_MAX_BYTES 0x7FFFFF
+/** Frames captured per start when the frame count register was never written */
+#define VIRTUAL_CAMERA_DEFAULT_FRAME_COUNT 1
+
+typedef struct VirtualCameraOptions {
+    /** Time from a capture starting until a frame is in the FIFO, each frame of a multi-frame capture takes as long */
+    uint32_t captureMicros;
+    /** 0x00 bytes written to the FIFO after every frame, the real FIFO always holds a little more than the JPEG */
+    uint32_t framePaddingBytes;
+    /** Monotonic time in microseconds, NULL for the system's monotonic clock, tests pass their own to step time */
+    uint64_t (*clock)(void *context);
+    /** Passed to clock */
+    void *clockContext;
+    /** Directory of recorded frames loaded by the first capture that starts with no frames, so the card they are on
+     * can be mounted after the model is created, NULL to only serve frames added or loaded explicitly */
+    const char *framesPath;
+} VirtualCameraOptions;
+
+typedef struct VirtualCameraStats {
+    uint32_t spiTransfers;
+    uint32_t capturesStarted;
+    /** Frames written to the FIFO by completed captures */
+    uint32_t framesCaptured;
+    /** Bytes read out of the FIFO by burst and single reads, including reads past its end */
+    uint32_t fifoBytesRead;
+    /** I2C write transactions and the registers they wrote, a sequential write counts once but writes many registers */
+    uint32_t i2cWrites;
+    uint32_t i2cRegistersWritten;
+    uint32_t i2cReads;
+} VirtualCameraStats;
+
+extern VirtualCamera *virtualCamera_create(const VirtualCameraOptions *options);
+
+extern void virtualCamera_destroy(VirtualCamera *virtualCamera);
+
+/** Copy a frame to the end of the frames served, frames are served in the order added and loop around */
+extern Error virtualCamera_addFrame(VirtualCamera *virtualCamera, const uint8_t *data, const size_t length);
+
+/** Add every .jpg and .jpeg file in directoryPath in name order, ERROR_NOT_FOUND if there were none. Only the names
+ * and lengths are read here, a frame's bytes are read from its file each time it is read out of the FIFO */
+extern Error virtualCamera_loadFrames(VirtualCamera *virtualCamera, const char *directoryPath);
+
+extern size_t virtualCamera_getFrameCount(const VirtualCamera *virtualCamera);
+
+/** One half duplex SPI transaction, the 8 bit command is the register address with VIRTUAL_CAMERA_SPI_WRITE set
+ * for a write, writes use sendData and reads fill receiveData, burst reads run on past the end of the FIFO as 0x00 */
+extern Error virtualCamera_spiTransfer(VirtualCamera *virtualCamera, const uint8_t command,
+                                       const uint8_t *sendData, const size_t sendDataLength,
+                                       uint8_t *receiveData, const size_t receiveDataLength);
+
+/** Write length values to consecutive sensor registers starting at address, as the sensor's auto-increment does */
+extern Error virtualCamera_i2cWrite(VirtualCamera *virtualCamera, const uint16_t address,
+                                    const uint8_t *values, const size_t length);
+
+extern Error virtualCamera_i2cRead(VirtualCamera *virtualCamera, const uint16_t address,
+                                   uint8_t *values, const size_t length);
+
+/** A sensor register's value without counting as an I2C read, for tests to check what the driver wrote */
+extern uint8_t virtualCamera_getSensorRegister(const VirtualCamera *virtualCamera, const uint16_t address);
+
+extern void virtualCamera_getStats(const VirtualCamera *virtualCamera, VirtualCameraStats *stats);
+
+#endif //ESP32_REMOTECAMERA_VIRTUALCAMERA_H
@@ -3,6 +3,8 @@
 
 #include "Error.h"
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 
 typedef enum CameraImageSize {
     CAMERA_IMAGE_SIZE_320x240 = 0,
@@ -15,28 +17,544 @@ typedef enum CameraImageSize {
     CAMERA_IMAGE_SIZE_DEFAULT = CAMERA_IMAGE_SIZE_1280x960
 } CameraImageSize;
 
+#define CAMERA_IMAGE_SIZE_COUNT (CAMERA_IMAGE_SIZE_2592x1944 + 1)
+
+/** Size of the sensor's pixel array, every image size is scaled down from a window of it */
+#define CAMERA_SENSOR_WIDTH 2592
+#define CAMERA_SENSOR_HEIGHT 1944
+
 typedef enum CameraImageQuality {
     CAMERA_IMAGE_QUALITY_LOW = 0,
     CAMERA_IMAGE_QUALITY_NORMAL = 1,
     CAMERA_IMAGE_QUALITY_HIGH = 2,
 } CameraImageQuality;
 
+typedef enum CameraLiveCaptureMode {
+    /** Trigger, wait for FIFO done, read the whole frame, repeat, capture and read times add up */
+    CAMERA_LIVE_CAPTURE_MODE_SERIAL = 0,
+    /** Trigger multiple frames at once and read each frame out of the FIFO while the next is being captured */
+    CAMERA_LIVE_CAPTURE_MODE_PIPELINED = 1,
+    /** The sensor free-runs on a video profile and the FIFO is only re-armed once every
+     * CAMERA_BURST_MAX_FRAMES_PER_TRIGGER frames, every video profile captures this way so it can't be set */
+    CAMERA_LIVE_CAPTURE_MODE_VIDEO = 2,
+} CameraLiveCaptureMode;
+
+typedef enum CameraVideoProfile {
+    /** Live frames are stills from the JPEG capture tables at the settings' image size */
+    CAMERA_VIDEO_PROFILE_NONE = 0,
+    /** 1280x720 from the sensor's 720p video timing */
+    CAMERA_VIDEO_PROFILE_720P = 1,
+    /** 1920x1080 from the sensor's 1080p video timing */
+    CAMERA_VIDEO_PROFILE_1080P = 2,
+} CameraVideoProfile;
+
+#define CAMERA_VIDEO_PROFILE_COUNT (CAMERA_VIDEO_PROFILE_1080P + 1)
+
+typedef enum CameraSensorProfile {
+    /** The Arducam JPEG capture timing, the whole array is read out and scaled down to the image size */
+    CAMERA_SENSOR_PROFILE_STILL = 0,
+    /** The fastest timing for the image size, a faster PLL clock with 2x2 binning up to 1280x960 and the whole array
+     * with the least blanking above, a region can't be set with it */
+    CAMERA_SENSOR_PROFILE_STREAMING = 1,
+} CameraSensorProfile;
+
+#define CAMERA_SENSOR_PROFILE_COUNT (CAMERA_SENSOR_PROFILE_STREAMING + 1)
+
+typedef enum CameraSettingsField {
+    CAMERA_SETTINGS_FIELD_IMAGE_SIZE = 1 << 0,
+    CAMERA_SETTINGS_FIELD_SATURATION = 1 << 1,
+    CAMERA_SETTINGS_FIELD_BRIGHTNESS = 1 << 2,
+    CAMERA_SETTINGS_FIELD_CONTRAST = 1 << 3,
+    CAMERA_SETTINGS_FIELD_HUE = 1 << 4,
+    CAMERA_SETTINGS_FIELD_EXPOSURE = 1 << 5,
+    CAMERA_SETTINGS_FIELD_SHARPNESS = 1 << 6,
+    CAMERA_SETTINGS_FIELD_IMAGE_QUALITY = 1 << 7,
+    CAMERA_SETTINGS_FIELD_REGION = 1 << 8,
+    CAMERA_SETTINGS_FIELD_SENSOR_PROFILE = 1 << 9,
+} CameraSettingsField;
+
+/** A rectangle of the sensor's pixel array in image coordinates, (0, 0) is the image's top left */
+typedef struct CameraRegion {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} CameraRegion;
+
+typedef struct CameraSettings {
+    /** Bitwise OR of CameraSettingsField, only these fields are applied, or known when reading settings back */
+    uint32_t fields;
+    CameraImageSize imageSize;
+    int saturation;
+    int brightness;
+    int contrast;
+    int hue;
+    int exposure;
+    int sharpness;
+    CameraImageQuality imageQuality;
+    /** The region of interest the image is cropped to, the whole array (0, 0, CAMERA_SENSOR_WIDTH,
+     * CAMERA_SENSOR_HEIGHT) is no zoom, the sensor reads a window grown to the image size's aspect ratio and to at
+     * least the image size since it can only scale down */
+    CameraRegion region;
+    /** Sensor timing the image size is captured with, changing it writes the image size's table again */
+    CameraSensorProfile sensorProfile;
+} CameraSettings;
+
+typedef struct CameraCaptureBenchmark {
+    CameraLiveCaptureMode mode;
+    uint32_t frameCount;
+    uint32_t bytesRead;
+    uint32_t elapsedMillis;
+    float fps;
+    /** SPI transfers other than FIFO reads (triggers, FIFO resets, done flag and size polls), the per frame control
+     * overhead is controlTransfers / frameCount */
+    uint32_t controlTransfers;
+} CameraCaptureBenchmark;
+
+typedef struct CameraVideoBenchmark {
+    CameraVideoProfile profile;
+    /** The still image size nearest to the profile, the still-per-frame loop is run at it */
+    CameraImageSize stillImageSize;
+    /** The frames were given to the record callback instead of to live capture's consumers */
+    bool isRecording;
+    /** One trigger, FIFO done wait and readout per frame, as live capture is without a video profile */
+    CameraCaptureBenchmark still;
+    CameraCaptureBenchmark video;
+} CameraVideoBenchmark;
+
+/** Most frames camera_benchmarkVideo() captures per run, it holds the camera the whole time */
+#define CAMERA_VIDEO_BENCHMARK_MAX_FRAMES 64
+
+/** Most clocks camera_calibrateSPIClock() steps through */
+#define CAMERA_SPI_CLOCK_MAX_STEPS 8
+
+typedef struct CameraSPIClockStep {
+    uint32_t clockHz;
+    /** Every test register pattern read back as it was written */
+    bool isRegisterOk;
+    /** Every test bar frame was read from its SOI to its EOI and, when the test bar is stable, matched the one read
+     * at the slowest clock */
+    bool isFrameOk;
+    uint32_t frameBytes;
+    /** FIFO readout of the test bar frames, over SPI and through the JPEG scanner */
+    float readoutMBps;
+} CameraSPIClockStep;
+
+typedef struct CameraSPIClockCalibration {
+    /** In order of rising clock, stepping stops at the first clock that fails */
+    CameraSPIClockStep steps[CAMERA_SPI_CLOCK_MAX_STEPS];
+    uint32_t stepCount;
+    /** The test bar frames at the slowest clock were identical, so faster clocks had to match them byte for byte */
+    bool isTestBarStable;
+    /** Fastest clock that passed along with every slower one */
+    uint32_t fastestReliableHz;
+    /** The clock kept, a safety margin below fastestReliableHz */
+    uint32_t clockHz;
+} CameraSPIClockCalibration;
+
+typedef struct CameraImageSizeSwitchBenchmark {
+    CameraImageSize from;
+    CameraImageSize to;
+    /** Writing the whole size table, as every switch used to */
+    uint32_t fullRegisterCount;
+    uint32_t fullMicros;
+    /** Writing only the registers that differ between the 2 tables */
+    uint32_t deltaRegisterCount;
+    uint32_t deltaMicros;
+} CameraImageSizeSwitchBenchmark;
+
+typedef struct CameraSensorProfileBenchmark {
+    CameraSensorProfile profile;
+    CameraImageSize imageSize;
+    uint32_t frameCount;
+    /** Trigger to FIFO done, the time the sensor took to expose and compress a frame, averaged over the frames */
+    float captureMillis;
+    /** FIFO length of a frame, padding included, averaged over the frames */
+    uint32_t fifoBytes;
+    /** Frames per second counting both capture and readout, as the serial live capture loop would run */
+    float fps;
+} CameraSensorProfileBenchmark;
+
+/** Most frames camera_benchmarkSensorProfiles() captures per profile and image size, it holds the camera the whole
+ * time */
+#define CAMERA_SENSOR_PROFILE_BENCHMARK_MAX_FRAMES 16
+
+typedef struct CameraFrameStats {
+    /** JPEG frames read out of the FIFO with both their SOI and EOI */
+    uint32_t framesCompleted;
+    /** Malformed frames (missing SOI or EOI) that were not passed on */
+    uint32_t framesDropped;
+    /** Size of the last completed frame from SOI to EOI, the FIFO length includes padding so is larger */
+    uint32_t lastFrameBytes;
+    uint32_t largestFrameBytes;
+    /** FIFO padding read over SPI (before the first read ends at EOI) and not passed on */
+    uint32_t fifoBytesSkipped;
+    /** FIFO padding after an EOI that was never read over SPI */
+    uint32_t fifoBytesNotRead;
+} CameraFrameStats;
+
+/** A whole JPEG frame from SOI to EOI, shared read-only between every reader holding a reference */
+typedef struct CameraFrame {
+    const uint8_t *data;
+    size_t length;
+    /** Increases by 1 for every frame captured */
+    uint32_t sequence;
+    uint32_t timestampMillis;
+} CameraFrame;
+
+/** How far camera_readFrame() has read a frame out of the FIFO, only the camera writes to it */
+typedef struct CameraFrameCursor {
+    /** Bytes the FIFO held when the frame was opened, the JPEG and the ArduChip's padding around it */
+    uint32_t fifoBytes;
+    /** FIFO bytes not read over SPI yet, an upper bound on the JPEG bytes still to come, the padding after the EOI
+     * is never read so this need not reach 0 */
+    uint32_t bytesRemaining;
+    /** JPEG bytes given to the caller so far, the JPEG's exact length once isComplete */
+    uint32_t bytesRead;
+    /** Every byte up to and including the EOI has been given to the caller */
+    bool isComplete;
+    /** The FIFO held no JPEG or ran out before its EOI, what was read should be discarded */
+    bool isFailed;
+} CameraFrameCursor;
+
+typedef struct CameraFramePoolStats {
+    uint32_t frameCount;
+    /** Capacity of every frame, sized from the image size and quality */
+    uint32_t frameBytes;
+    uint32_t framesInUse;
+    uint32_t framesInUseHighWater;
+    uint32_t acquireCount;
+    /** Frames that could not be captured because every frame was still held by a reader */
+    uint32_t acquireFailures;
+    /** Frames larger than the pool's frames that were not pooled, the pool is resized to fit them */
+    uint32_t framesTooLarge;
+} CameraFramePoolStats;
+
+typedef struct CameraFrameConsumerStats {
+    /** Frames the camera has handed to every consumer, the capture rate */
+    uint32_t framesPublished;
+    /** Frames this consumer has taken, the consumer's send rate */
+    uint32_t framesTaken;
+    /** Frames this consumer fell too far behind to take, they were overwritten by newer frames */
+    uint32_t framesDropped;
+    /** Frames waiting to be taken */
+    uint32_t framesPending;
+} CameraFrameConsumerStats;
+
+typedef enum CameraQualityTargetMode {
+    /** Image size and quality are only changed by hand */
+    CAMERA_QUALITY_TARGET_MODE_NONE = 0,
+    /** Hold the frame rate at value frames per second */
+    CAMERA_QUALITY_TARGET_MODE_FPS = 1,
+    /** Hold the JPEG bandwidth at value kbit/s */
+    CAMERA_QUALITY_TARGET_MODE_KBPS = 2,
+} CameraQualityTargetMode;
+
+typedef struct CameraQualityTarget {
+    CameraQualityTargetMode mode;
+    float value;
+    /** How far from value (in percent) a measurement must be before image size or quality is stepped */
+    uint32_t hysteresisPercent;
+    /** The image size is never stepped outside of these */
+    CameraImageSize minImageSize;
+    CameraImageSize maxImageSize;
+} CameraQualityTarget;
+
+typedef enum CameraQualityAction {
+    CAMERA_QUALITY_ACTION_HOLD = 0,
+    /** One step down the ladder of image size and quality, quality goes down first then image size */
+    CAMERA_QUALITY_ACTION_STEP_DOWN = 1,
+    CAMERA_QUALITY_ACTION_STEP_UP = 2,
+} CameraQualityAction;
+
+typedef enum CameraQualityReason {
+    CAMERA_QUALITY_REASON_DISABLED = 0,
+    /** Not enough frames measured since the last decision */
+    CAMERA_QUALITY_REASON_MEASURING,
+    /** Frames measured right after a step are discarded while the sensor switches */
+    CAMERA_QUALITY_REASON_SETTLING,
+    CAMERA_QUALITY_REASON_TARGET_MET,
+    CAMERA_QUALITY_REASON_FPS_BELOW_TARGET,
+    CAMERA_QUALITY_REASON_FPS_ABOVE_TARGET,
+    CAMERA_QUALITY_REASON_KBPS_ABOVE_TARGET,
+    CAMERA_QUALITY_REASON_KBPS_BELOW_TARGET,
+    /** Frame consumers (websocket sends) are dropping frames, they cannot keep up */
+    CAMERA_QUALITY_REASON_SEND_BACKLOG,
+} CameraQualityReason;
+
+typedef struct CameraQualityDecision {
+    CameraQualityAction action;
+    CameraQualityReason reason;
+    /** A step was wanted but the image size and quality are already at the target's limit */
+    bool isAtLimit;
+    /** Image size and quality after the decision */
+    CameraImageSize imageSize;
+    CameraImageQuality imageQuality;
+    /** Measured over the last window of frames */
+    float measuredFps;
+    float measuredKbps;
+    uint32_t measuredFrameBytes;
+    uint32_t framesDropped;
+    uint32_t stepCount;
+} CameraQualityDecision;
+
+/** Distribution of one capture pipeline measurement, percentiles are accurate to within 25% */
+typedef struct CameraStatsSummary {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+} CameraStatsSummary;
+
+typedef struct CameraCaptureStats {
+    /** Capture trigger until the FIFO write done flag */
+    CameraStatsSummary captureMicros;
+    /** Reading a frame out of the FIFO over SPI */
+    CameraStatsSummary readoutMicros;
+    /** Scanning one chunk of the FIFO and passing its frame bytes on */
+    CameraStatsSummary chunkMicros;
+    /** Trigger until the frame has been passed on, for pipelined captures a trigger's time is shared by its frames */
+    CameraStatsSummary frameMicros;
+    CameraStatsSummary frameBytes;
+    uint32_t framesCompleted;
+    /** Malformed frames (missing SOI or EOI) that were not passed on */
+    uint32_t framesDropped;
+    /** How long these stats have been collected for */
+    uint32_t elapsedMillis;
+} CameraCaptureStats;
+
+typedef struct CameraStartStats {
+    /** Whether the last camera_start() wrote the stored register image instead of replaying every table */
+    bool isWarm;
+    /** Sensor registers written by the last camera_start() */
+    uint32_t registersWritten;
+    /** From camera_start() being called until the sensor was configured */
+    uint32_t configureMillis;
+    /** From camera_start() being called until the first live frame was complete, 0 until then */
+    uint32_t firstFrameMillis;
+} CameraStartStats;
+
+/** What a request for the camera will use it for, which decides how soon it is granted the camera */
+typedef enum CameraRequestClass {
+    /** A single frame for a caller waiting on it, such as a snapshot */
+    CAMERA_REQUEST_CLASS_STILL = 0,
+    /** One live capture by the camera task, there is always another one coming */
+    CAMERA_REQUEST_CLASS_LIVE = 1,
+    /** Settings, standby and video profile changes, short and wanted by the captures after them */
+    CAMERA_REQUEST_CLASS_SETTINGS = 2,
+    /** Bursts and benchmarks, which hold the camera for many frames */
+    CAMERA_REQUEST_CLASS_BURST = 3,
+} CameraRequestClass;
+
+#define CAMERA_REQUEST_CLASS_COUNT (CAMERA_REQUEST_CLASS_BURST + 1)
+
+typedef struct CameraRequestClassStats {
+    uint32_t requests;
+    /** Still requests served by reading out a frame captured for another request, with no capture of their own */
+    uint32_t coalesced;
+    /** Requests granted the camera after their deadline */
+    uint32_t deadlinesMissed;
+    /** Requests waiting for the camera right now */
+    uint32_t waiting;
+    /** From a request being queued until it was granted the camera */
+    CameraStatsSummary queueMicros;
+} CameraRequestClassStats;
+
+typedef struct CameraSchedulerStats {
+    /** Indexed by CameraRequestClass */
+    CameraRequestClassStats classes[CAMERA_REQUEST_CLASS_COUNT];
+    /** Requests refused because too many were already waiting */
+    uint32_t requestsRefused;
+} CameraSchedulerStats;
+
+typedef struct CameraLiveDemandStats {
+    /** Consumers subscribed to live capture right now */
+    uint32_t subscribers;
+    /** Live capture is running, for subscribers or for the linger after the last one left */
+    bool isRunning;
+    /** Times live capture started from idle */
+    uint32_t starts;
+    uint32_t runningMillis;
+    uint32_t idleMillis;
+    /** Share of the time live capture ran */
+    float dutyCyclePercent;
+    /** From the last start to the first frame it completed */
+    uint32_t lastWarmUpMillis;
+    /** How long live capture keeps running after the last subscriber leaves */
+    uint32_t lingerMillis;
+} CameraLiveDemandStats;
+
+/** Most frames one camera_captureBurst() can capture */
+#define CAMERA_BURST_MAX_FRAMES 32
+/** Most frames the ArduChip captures back to back into its FIFO from a single trigger */
+#define CAMERA_BURST_MAX_FRAMES_PER_TRIGGER 7
+
+typedef struct CameraBurstFrame {
+    /** Position of the frame in the burst, a dropped frame's index is reused by the next frame */
+    uint32_t index;
+    /** JPEG bytes of the frame so far, SOI to EOI once the frame is complete */
+    uint32_t bytes;
+    /** When the frame's EOI was read out of the FIFO, since the burst started, 0 until the frame is complete,
+     * the readout chases the FIFO write pointer so this is close to when the sensor finished the frame */
+    uint32_t timestampMicros;
+    bool isComplete;
+    /** The frame ended without an EOI, its bytes already passed on should be thrown away */
+    bool isDropped;
+} CameraBurstFrame;
+
+typedef struct CameraBurst {
+    uint32_t frameCount;
+    uint32_t framesDropped;
+    /** How many times capture was triggered, frames of one trigger are captured back to back */
+    uint32_t triggerCount;
+    /** From the first trigger until the last frame was complete */
+    uint32_t elapsedMillis;
+    float fps;
+    /** The first frameCount are the completed frames */
+    CameraBurstFrame frames[CAMERA_BURST_MAX_FRAMES];
+} CameraBurst;
+
+/** Most zones one motion detector watches */
+#define CAMERA_MOTION_MAX_ZONES 4
+
+/** Part of the image, in percent (0 to 100) of the image's width and height, (0, 0) is the image's top left */
+typedef struct CameraMotionZone {
+    uint8_t left;
+    uint8_t top;
+    uint8_t width;
+    uint8_t height;
+} CameraMotionZone;
+
+/** Fields left 0 take their defaults */
+typedef struct CameraMotionOptions {
+    bool isEnabled;
+    /** How far (1 to 255) an 8x8 block's mean luma must be from the background for the block to have changed,
+     * lower is more sensitive */
+    uint8_t threshold;
+    /** Percent of a zone's blocks that must change for motion in the zone */
+    uint8_t triggerPercent;
+    /** The background moves 1 / 2^backgroundShift of the way to every frame, higher is slower to take in changes
+     * such as lighting but also slower to forget an object that stopped moving */
+    uint8_t backgroundShift;
+    /** Frames with no zone at triggerPercent before motion ends */
+    uint8_t quietFrames;
+    /** 0 to watch the whole image as one zone */
+    uint32_t zoneCount;
+    CameraMotionZone zones[CAMERA_MOTION_MAX_ZONES];
+} CameraMotionOptions;
+
+typedef struct CameraMotionEvent {
+    /** Motion started, false when it ended */
+    bool isMotion;
+    /** Live frame the event was detected in, counted from when motion detection was enabled */
+    uint32_t frameSequence;
+    uint32_t timestampMillis;
+    /** Highest percent of changed blocks of any zone */
+    uint8_t score;
+    /** Bit n is set if zone n was at triggerPercent */
+    uint32_t zoneMask;
+} CameraMotionEvent;
+
+typedef struct CameraMotionStats {
+    bool isEnabled;
+    bool isMotion;
+    uint32_t framesAnalysed;
+    /** Frames whose DC coefficients could not be decoded, such as progressive or corrupt frames */
+    uint32_t framesFailed;
+    /** Motion started, events for motion ending are not counted */
+    uint32_t motionEvents;
+    /** Of the latest frame analysed */
+    uint8_t score;
+    uint8_t zoneScores[CAMERA_MOTION_MAX_ZONES];
+    /** Size of the luma map the background is kept at, 1/8 of the image or smaller for large image sizes */
+    uint32_t mapWidth;
+    uint32_t mapHeight;
+    /** Decoding a frame's DC coefficients and comparing them to the background, every chunk of the frame added up */
+    CameraStatsSummary frameMicros;
+} CameraMotionStats;
+
+/** Called with a sensor register address and the value it is known to hold */
+typedef void CameraRegisterCallback(const uint16_t address, const uint8_t value, void *userArg);
+
 typedef void CameraReadCallback(char *buffer, int bufferSize, void *userArgs);
 
+/** Called with every whole frame captured into the frame pool, retain the frame to keep it past the call */
+typedef void CameraLiveFrameCallback(CameraFrame *frame);
+
+/** Called with every piece of a burst frame's JPEG in order, frame->isComplete on the frame's last piece and
+ * frame->isDropped (with no segment) if the frame was abandoned */
+typedef void CameraBurstCallback(const CameraBurstFrame *frame, const uint8_t *segment, const size_t segmentLength,
+                                 void *userArg);
+
+/** Called on the camera task when motion starts or ends, live capture waits for it to return, it must not add or
+ * remove motion callbacks */
+typedef void CameraMotionCallback(const CameraMotionEvent *event);
+
 typedef void CameraLiveCaptureCallback(uint8_t *buffer, size_t bufferLength,
                                        size_t bytesRead, size_t bytesRemaining);
 
 extern Error camera_init();
 
-/** Initializes the camera to its default values ready to use, can be called multiple times to restart camera */
+/** Initializes the camera ready to use, can be called multiple times to restart camera.
+ * When settings hold a register image from a previous start the sensor is reset and given the image in one batch
+ * (a warm start), else the tables are replayed and default settings applied (a cold start) */
 extern Error camera_start();
 
 extern Error camera_pauseLiveCapture(bool pause);
 
+extern bool camera_isLiveCapturePaused();
+
+/** Puts the sensor into software standby or wakes it, in standby the sensor draws a fraction of its active current
+ * and keeps its registers but outputs no frames, live capture is skipped and captures return ERROR_ILLEGAL_STATE,
+ * the first frames after waking are exposed with the gains from before standby */
+extern Error camera_setStandby(const bool standby);
+
+/** Only standby set by camera_setStandby(), not the standby the sensor waits in while live capture is idle */
+extern bool camera_isStandby();
+
 extern Error camera_destroy();
 
 extern Error camera_captureImage(uint32_t *imageSize);
 
+/** Captures a still and reads it out to readCallback buffered through buffer, like camera_captureImage() and
+ * camera_readImageBufferedWithCallback() but as one request for the camera, which the scheduler grants ahead of live
+ * capture and should grant within deadlineMillis (0 for the default), still requests waiting at the same time on
+ * other tasks, such as a timelapse shot and a snapshot, are served by one capture that each of them reads out of the
+ * FIFO. Requests on one task never wait together, the server handles one request at a time */
+extern Error camera_captureStill(const uint32_t deadlineMillis, char *buffer, const int bufferLength,
+                                 CameraReadCallback readCallback, void *userArg);
+
+/** Captures a still (or shares one, like camera_captureStill()) and opens it for camera_readFrame(), the camera is
+ * held for the caller until camera_closeFrame(), which must be called even after a failed read */
+extern Error camera_openFrame(const uint32_t deadlineMillis, CameraFrameCursor *cursor);
+
+/** Reads the open frame's next JPEG bytes, up to length of them, straight out of the FIFO into buffer (no copy is
+ * made beyond trimming the padding before the SOI), any length works and bytesRead is only short of length at the
+ * EOI or the end of the FIFO, 0 once the cursor isComplete, returns ERROR_NOT_FOUND when the cursor isFailed */
+extern Error camera_readFrame(CameraFrameCursor *cursor, uint8_t *buffer, const size_t length, size_t *bytesRead);
+
+/** Done with the open frame, whether or not it was read to its EOI, the camera goes to the next request */
+extern Error camera_closeFrame(CameraFrameCursor *cursor);
+
+/** Applies all fields of settings in a single register batch between 2 live frames, every field is validated first
+ * so an invalid value means nothing is written, effectiveSettings (can be NULL) receives the settings the camera
+ * has after the call, the settings are kept in the register image for the next camera_start() */
+extern Error camera_applySettings(const CameraSettings *settings, CameraSettings *effectiveSettings);
+
+/** camera_applySettings() without keeping the settings in the register image, for settings that change often or only
+ * for a while, such as a zoom from the live player, every kept change is a flash write. The next
+ * camera_applySettings() writes the values from before back before it keeps anything, except fields it sets itself */
+extern Error camera_applyTransientSettings(const CameraSettings *settings, CameraSettings *effectiveSettings);
+
+/** Write back the values from before every camera_applyTransientSettings() since the last camera_applySettings() */
+extern Error camera_restoreTransientSettings();
+
+/** The settings last applied, fields not applied since camera_start() are not set in settings->fields */
+extern Error camera_getSettings(CameraSettings *settings);
+
 extern Error camera_setImageSize(const CameraImageSize imageSize);
 
 extern Error camera_setSaturation(const int saturationLevel);
@@ -53,8 +571,153 @@ extern Error camera_setSharpness(const int sharpnessLevel);
 
 extern Error camera_setImageQuality(const CameraImageQuality imageQuality);
 
+extern Error camera_setRegion(const CameraRegion *region);
+
+extern Error camera_setSensorProfile(const CameraSensorProfile sensorProfile);
+
+/** The region zoom times smaller than the whole array centred on (centreX, centreY), fractions (0 to 1) of the
+ * image's width and height, a zoom of 1 is the whole array, returns ERROR_OUT_OF_BOUNDS for a zoom the sensor
+ * can't do */
+extern Error camera_zoomRegion(const float centreX, const float centreY, const float zoom, CameraRegion *region);
+
+/** camera_setRegion() with camera_zoomRegion() */
+extern Error camera_setZoom(const float centreX, const float centreY, const float zoom);
+
+/** The window the sensor is reading for the current region and image size, the whole array when no region is set */
+extern Error camera_getSensorWindow(CameraRegion *window);
+
+extern Error camera_setLiveCaptureMode(const CameraLiveCaptureMode liveCaptureMode);
+
+/** Reprograms the sensor with a video profile's table (a sensor reset) with JPEG output and leaves it free-running,
+ * live capture then reads frames continuously with CAMERA_LIVE_CAPTURE_MODE_VIDEO, the image size and region can't
+ * be set in a video profile and other settings are applied but not kept for the next camera_start(),
+ * CAMERA_VIDEO_PROFILE_NONE restarts the camera to go back to stills */
+extern Error camera_setVideoProfile(const CameraVideoProfile profile);
+
+extern CameraVideoProfile camera_getVideoProfile();
+
+/** Captures frameCount frames in each live capture mode (serially on the calling task, live capture is paused
+ * meanwhile but the live callback still receives the frames) and writes the results to serial and pipelined */
+extern Error camera_benchmarkLiveCapture(const uint32_t frameCount,
+                                         CameraCaptureBenchmark *serial, CameraCaptureBenchmark *pipelined);
+
+/** Steps the ArduChip's SPI clock up from the stock 8 MHz, at each clock the test register is written and read back
+ * with several patterns and the OV5642's test bar is captured and read out of the FIFO, stepping stops at the first
+ * clock that fails. The fastest clock that passed, less a safety margin, is kept and stored in settings for every
+ * camera_init() after, the stock clock is kept if even it fails. Live capture is paused meanwhile */
+extern Error camera_calibrateSPIClock(CameraSPIClockCalibration *calibration);
+
+/** The clock the ArduChip's SPI bus runs at */
+extern uint32_t camera_getSPIClock();
+
+/** Captures frameCount frames with the still-per-frame loop at the nearest still image size, then with the video
+ * profile (live capture is paused meanwhile), the video profile in use before is restored after. With no
+ * recordCallback the frames stream to live capture's consumers, else they are only given to recordCallback, such as
+ * to save them. frameCount can be at most CAMERA_VIDEO_BENCHMARK_MAX_FRAMES, or CAMERA_BURST_MAX_FRAMES / 2 when
+ * recording as both runs' frames are indexed as one burst */
+extern Error camera_benchmarkVideo(const CameraVideoProfile profile, const uint32_t frameCount,
+                                   CameraBurstCallback recordCallback, void *userArg, CameraVideoBenchmark *benchmark);
+
+/** Captures frameCount frames into the ArduChip's FIFO and reads each one out while the next is captured, live
+ * capture is paused meanwhile, with an intervalMillis of 0 up to CAMERA_BURST_MAX_FRAMES_PER_TRIGGER frames are
+ * captured back to back per trigger at the sensor's frame rate, else one frame is triggered every intervalMillis,
+ * burstCallback (can be NULL) receives the frames' bytes and burst the timing of every frame */
+extern Error camera_captureBurst(const uint32_t frameCount, const uint32_t intervalMillis,
+                                 CameraBurstCallback burstCallback, void *userArg, CameraBurst *burst);
+
+/** Switches between every pair of image sizes (live capture is paused meanwhile) timing the whole size table against
+ * the delta script, results must hold CAMERA_IMAGE_SIZE_COUNT * CAMERA_IMAGE_SIZE_COUNT entries, indexed
+ * [(from * CAMERA_IMAGE_SIZE_COUNT) + to], the original settings are restored after */
+extern Error camera_benchmarkImageSizeSwitch(CameraImageSizeSwitchBenchmark *results);
+
+/** Captures and reads out frameCount frames at every sensor profile and image size (live capture is paused
+ * meanwhile), results must hold CAMERA_SENSOR_PROFILE_COUNT * CAMERA_IMAGE_SIZE_COUNT entries, indexed
+ * [(profile * CAMERA_IMAGE_SIZE_COUNT) + imageSize], the original settings are restored after, frameCount can be at
+ * most CAMERA_SENSOR_PROFILE_BENCHMARK_MAX_FRAMES */
+extern Error camera_benchmarkSensorProfiles(const uint32_t frameCount, CameraSensorProfileBenchmark *results);
+
+extern Error camera_getFrameStats(CameraFrameStats *frameStats);
+
+/** Live capture pipeline latency and size distributions since camera_init() or the last reset */
+extern Error camera_getCaptureStats(CameraCaptureStats *captureStats);
+
+/** Resets the capture, the scheduler and the live demand stats */
+extern Error camera_resetCaptureStats();
+
+/** How many requests of each class were made for the camera and how long they waited for it, since camera_init() or
+ * the last camera_resetCaptureStats() */
+extern Error camera_getSchedulerStats(CameraSchedulerStats *schedulerStats);
+
+/** How long the last camera_start() took to configure the sensor and to deliver its first frame */
+extern Error camera_getStartStats(CameraStartStats *startStats);
+
+/** Calls registerCallback for every sensor register written since the last reset, in address order,
+ * these are served from an in-RAM shadow so this does no I2C traffic, useful for diagnostics */
+extern Error camera_forEachKnownRegister(CameraRegisterCallback registerCallback, void *userArg);
+
+/** Live capture only runs while a consumer is subscribed to it (and for a linger after the last one leaves),
+ * meanwhile the sensor waits in software standby, the first subscriber wakes the camera task straight away */
+extern Error camera_subscribeLiveCapture();
+
+/** Every camera_subscribeLiveCapture() must be matched by one of these, ERROR_ILLEGAL_STATE when none is subscribed */
+extern Error camera_unsubscribeLiveCapture();
+
+/** How long live capture ran and sat idle since camera_init() or the last camera_resetCaptureStats() */
+extern Error camera_getLiveDemandStats(CameraLiveDemandStats *liveDemandStats);
+
 extern Error camera_setCameraLiveCaptureCallback(CameraLiveCaptureCallback cameraLiveCaptureCallback);
 
+/** Live frames are captured whole into a pool of frame buffers (when the image size is small enough for the pool)
+ * and passed to liveFrameCallback instead of being streamed in chunks to the live capture callback */
+extern Error camera_setLiveFrameCallback(CameraLiveFrameCallback liveFrameCallback);
+
+/** The latest live frame if it is at most maxAgeMillis old, otherwise a newly captured frame, with a reference
+ * held for the caller who must camera_releaseFrame() it, returns ERROR_ILLEGAL_STATE if the frame pool cannot
+ * hold frames at the current image size */
+extern Error camera_acquireFrame(const uint32_t maxAgeMillis, CameraFrame **frame);
+
+extern CameraFrame *camera_retainFrame(CameraFrame *frame);
+
+extern Error camera_releaseFrame(CameraFrame *frame);
+
+/** Returns ERROR_ILLEGAL_STATE if there is no frame pool at the current image size */
+extern Error camera_getFramePoolStats(CameraFramePoolStats *framePoolStats);
+
+/** Add a consumer of pooled frames, the camera task never waits for a consumer, a consumer that falls behind has
+ * its oldest frames dropped, returns ERROR_OUT_OF_BOUNDS when there are no more consumers available */
+extern Error camera_addFrameConsumer(uint32_t *consumer);
+
+/** Wait up to timeoutMillis for consumer's next frame, the caller must camera_releaseFrame() it,
+ * returns ERROR_NOT_FOUND if no frame was published in time */
+extern Error camera_takeFrame(const uint32_t consumer, const uint32_t timeoutMillis, CameraFrame **frame);
+
+extern Error camera_getFrameConsumerStats(const uint32_t consumer, CameraFrameConsumerStats *consumerStats);
+
+/** Have the live capture step image size and quality up and down to hold target, settings applied by hand
+ * are where the controller continues stepping from */
+extern Error camera_setQualityTarget(const CameraQualityTarget *target);
+
+extern Error camera_getQualityTarget(CameraQualityTarget *target);
+
+/** The quality controller's latest decision and the measurements it was made from */
+extern Error camera_getQualityDecision(CameraQualityDecision *decision);
+
+/** Compare every live frame to a running background, from the DC coefficient (mean) of every 8x8 luma block decoded
+ * as the frame is read out of the FIFO with no full JPEG decode, enabling it starts live capture even with no other
+ * consumer of live frames, changing it forgets the background */
+extern Error camera_setMotionDetection(const CameraMotionOptions *options);
+
+/** The options in use, with defaults filled in */
+extern Error camera_getMotionDetection(CameraMotionOptions *options);
+
+extern Error camera_getMotionStats(CameraMotionStats *motionStats);
+
+extern void camera_addMotionCallback(CameraMotionCallback motionCallback);
+
+extern void camera_removeMotionCallback(CameraMotionCallback motionCallback);
+
+/** Reads the image captured by camera_captureImage() calling readCallback with the JPEG's bytes (FIFO padding is
+ * trimmed) buffered through buffer, returns ERROR_NOT_FOUND if no complete JPEG was in the FIFO */
 extern Error camera_readImageBufferedWithCallback(char *buffer, const int bufferLength,
                                                   const uint32_t imageSize,
                                                   CameraReadCallback readCallback, void *userArg);
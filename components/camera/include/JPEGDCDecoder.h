@@ -0,0 +1,87 @@
+#ifndef ESP32_REMOTECAMERA_JPEGDCDECODER_H
+#define ESP32_REMOTECAMERA_JPEGDCDECODER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Streaming baseline JPEG entropy decoder that recovers only the lowest frequency coefficients of every 8x8 block.
+ * The DC coefficient is 8 times the block's mean so DC alone is a 1/8 scale image with no IDCT. Every coefficient
+ * is still Huffman decoded to find where the next block starts, but only the first coefficientCount (in zigzag
+ * order) are dequantized and passed on. Bytes can be given in pieces of any size, such as FIFO chunks as they are
+ * read, the decoder keeps its place between them
+ */
+typedef void JPEGDCDecoder;
+
+#define JPEG_DC_DECODER_MAX_COMPONENTS 3
+/** DC and the 5 lowest AC terms, enough for a 2x2 reconstruction of each block */
+#define JPEG_DC_DECODER_MAX_COEFFICIENTS 6
+/** Bit of componentMask for the luma component (Y), always the first component of a YCbCr JPEG */
+#define JPEG_DC_DECODER_COMPONENT_LUMA 0x01
+#define JPEG_DC_DECODER_COMPONENT_ALL 0x07
+
+typedef struct JPEGDCDecoderComponent {
+    uint8_t id;
+    uint8_t horizontalSampling;
+    uint8_t verticalSampling;
+    /** Blocks across and down the component, blocks that only pad an MCU past the image's edge are not counted */
+    uint32_t blocksWide;
+    uint32_t blocksHigh;
+} JPEGDCDecoderComponent;
+
+typedef struct JPEGDCDecoderInfo {
+    uint32_t width;
+    uint32_t height;
+    uint32_t componentCount;
+    JPEGDCDecoderComponent components[JPEG_DC_DECODER_MAX_COMPONENTS];
+    /** MCUs between restart markers, 0 when there are none */
+    uint32_t restartInterval;
+} JPEGDCDecoderInfo;
+
+typedef struct JPEGDCDecoderBlock {
+    const JPEGDCDecoderInfo *info;
+    /** Index into info->components */
+    uint32_t component;
+    /** Position in blocks within the component */
+    uint32_t x;
+    uint32_t y;
+    /** Dequantized, in zigzag order, coefficients[0] / 8 + 128 is the block's mean sample */
+    int32_t coefficients[JPEG_DC_DECODER_MAX_COEFFICIENTS];
+} JPEGDCDecoderBlock;
+
+/** Called for every block decoded in the components asked for, in the order the blocks are in the scan */
+typedef void JPEGDCDecoderCallback(const JPEGDCDecoderBlock *block, void *userArg);
+
+typedef struct JPEGDCDecoderStats {
+    /** Frames decoded up to their EOI */
+    uint32_t framesDecoded;
+    /** Malformed or unsupported frames (progressive, arithmetic coded or 12 bit) */
+    uint32_t framesFailed;
+    uint32_t blocksDecoded;
+} JPEGDCDecoderStats;
+
+extern JPEGDCDecoder *jpegDCDecoder_create();
+
+extern void jpegDCDecoder_destroy(JPEGDCDecoder *jpegDCDecoder);
+
+/** Start a new frame, its first bytes must be the SOI, blocks of the components with their bit (1 << component
+ * index) set in componentMask are passed to callback with coefficientCount coefficients (1 for DC only) */
+extern Error jpegDCDecoder_begin(JPEGDCDecoder *jpegDCDecoder, const uint32_t componentMask,
+                                 const uint32_t coefficientCount, JPEGDCDecoderCallback callback, void *userArg);
+
+/** Decode the frame's next bytes, returns ERROR_ILLEGAL_ARGUMENT for a malformed or unsupported frame after which
+ * the rest of the frame is ignored, bytes after the EOI are ignored */
+extern Error jpegDCDecoder_decode(JPEGDCDecoder *jpegDCDecoder, const uint8_t *bytes, const size_t length);
+
+/** Whether the frame has been decoded up to its EOI */
+extern bool jpegDCDecoder_isDone(const JPEGDCDecoder *jpegDCDecoder);
+
+/** The frame's size and components, ERROR_NOT_FOUND until its SOF has been decoded */
+extern Error jpegDCDecoder_getInfo(const JPEGDCDecoder *jpegDCDecoder, JPEGDCDecoderInfo *info);
+
+extern Error jpegDCDecoder_getStats(const JPEGDCDecoder *jpegDCDecoder, JPEGDCDecoderStats *stats);
+
+#endif //ESP32_REMOTECAMERA_JPEGDCDECODER_H
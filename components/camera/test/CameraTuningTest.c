@@ -0,0 +1,103 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "CameraTuning.h"
+
+#define TEST_TAG "[CameraTuning]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+private uint countEntries(const OV5642RegisterEntry *entries) {
+    uint count = 0;
+    while (entries[count].address != OV5642_REGISTER_ADDRESS_END) count++;
+    return count;
+}
+
+TEST("CameraTuning compile saturation") {
+    OV5642RegisterEntry entries[CAMERA_TUNING_MAX_ENTRIES];
+    ASSERT_INT_EQUAL(ERROR_NONE, cameraTuning_compile(CAMERA_TUNING_SATURATION, 4, entries), "compile should succeed");
+    ASSERT_UINT_EQUAL(4, countEntries(entries), "entry count was incorrect");
+    ASSERT_UINT_EQUAL(0x5583, entries[2].address, "address was incorrect");
+    ASSERT_UINT_EQUAL(0x80, entries[2].value, "value was incorrect");
+    ASSERT_UINT_EQUAL(0x5584, entries[3].address, "address was incorrect");
+    ASSERT_UINT_EQUAL(0x80, entries[3].value, "value was incorrect");
+}
+
+TEST("CameraTuning compile hue steps") {
+    OV5642RegisterEntry entries[CAMERA_TUNING_MAX_ENTRIES];
+    ASSERT_INT_EQUAL(ERROR_NONE, cameraTuning_compile(CAMERA_TUNING_HUE, -90, entries), "compile should succeed");
+    ASSERT_UINT_EQUAL(0x5581, entries[2].address, "address was incorrect");
+    ASSERT_UINT_EQUAL(0x00, entries[2].value, "value was incorrect");
+    ASSERT_UINT_EQUAL(0x80, entries[3].value, "value was incorrect");
+    ASSERT_UINT_EQUAL(0x02, entries[4].value, "value was incorrect");
+
+    ASSERT(cameraTuning_isValidLevel(CAMERA_TUNING_HUE, 180), "180 should be valid");
+    ASSERT_FALSE(cameraTuning_isValidLevel(CAMERA_TUNING_HUE, 45), "45 is not a 30 degree step");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, cameraTuning_compile(CAMERA_TUNING_HUE, 45, entries),
+                     "compile should fail");
+}
+
+TEST("CameraTuning out of range levels") {
+    OV5642RegisterEntry entries[CAMERA_TUNING_MAX_ENTRIES];
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, cameraTuning_compile(CAMERA_TUNING_BRIGHTNESS, 5, entries),
+                     "compile should fail");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, cameraTuning_compile(CAMERA_TUNING_EXPOSURE, -6, entries),
+                     "compile should fail");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, cameraTuning_compile(CAMERA_TUNING_IMAGE_QUALITY, 3, entries),
+                     "compile should fail");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, cameraTuning_compile(CAMERA_TUNING_SETTING_COUNT, 0, entries),
+                     "compile should fail");
+    ASSERT_INT_EQUAL(ERROR_NULL_ARGUMENT, cameraTuning_compile(CAMERA_TUNING_CONTRAST, 0, NULL),
+                     "compile should fail");
+}
+
+TEST("CameraTuning every level is sorted and terminated") {
+    OV5642RegisterEntry entries[CAMERA_TUNING_MAX_ENTRIES];
+    for (CameraTuningSetting setting = 0; setting < CAMERA_TUNING_SETTING_COUNT; setting++) {
+        for (int level = -180; level <= 180; level++) {
+            if (!cameraTuning_isValidLevel(setting, level)) continue;
+            ASSERT_INT_EQUAL(ERROR_NONE, cameraTuning_compile(setting, level, entries), "compile should succeed");
+            const uint count = countEntries(entries);
+            ASSERT(count <= CAMERA_TUNING_MAX_REGISTERS, "too many entries");
+            for (uint i = 1; i < count; i++) {
+                ASSERT(entries[i - 1].address < entries[i].address, "entries should be in ascending address order");
+            }
+        }
+    }
+}
+
+TEST("CameraTuning compile batch merges shared registers") {
+    OV5642RegisterEntry entries[CAMERA_TUNING_MAX_BATCH_ENTRIES];
+    const CameraTuningLevel levels[] = {
+            {CAMERA_TUNING_SATURATION, 2},
+            {CAMERA_TUNING_BRIGHTNESS, -1},
+            {CAMERA_TUNING_EXPOSURE, 0},
+    };
+    ASSERT_INT_EQUAL(ERROR_NONE, cameraTuning_compileBatch(levels, 3, entries), "compile should succeed");
+    // saturation 4 + brightness 4 + exposure 6, less 0x5001 and 0x5580 which both saturation and brightness write
+    ASSERT_UINT_EQUAL(12, countEntries(entries), "entry count was incorrect");
+    for (uint i = 1; i < countEntries(entries); i++) {
+        ASSERT(entries[i - 1].address < entries[i].address, "entries should be in ascending address order");
+    }
+    bool found5580 = false;
+    for (uint i = 0; i < countEntries(entries); i++) {
+        if (entries[i].address == 0x5580) {
+            found5580 = true;
+            ASSERT_UINT_EQUAL(0x04, entries[i].value, "the last setting should win");
+        }
+    }
+    ASSERT(found5580, "0x5580 should be in the batch");
+}
+
+TEST("CameraTuning compile batch is all or nothing") {
+    OV5642RegisterEntry entries[CAMERA_TUNING_MAX_BATCH_ENTRIES];
+    entries[0] = (OV5642RegisterEntry) {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END};
+    const CameraTuningLevel levels[] = {
+            {CAMERA_TUNING_SATURATION, 2},
+            {CAMERA_TUNING_CONTRAST, 9},
+    };
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, cameraTuning_compileBatch(levels, 2, entries), "compile should fail");
+    ASSERT_UINT_EQUAL(0, countEntries(entries), "nothing should be compiled");
+
+    ASSERT_INT_EQUAL(ERROR_NONE, cameraTuning_compileBatch(NULL, 0, entries), "empty batch should succeed");
+    ASSERT_UINT_EQUAL(0, countEntries(entries), "empty batch should have no entries");
+}
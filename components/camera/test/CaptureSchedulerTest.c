@@ -0,0 +1,136 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "CaptureScheduler.h"
+
+#define TEST_TAG "[CaptureScheduler]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_DEADLINE_MILLIS 100
+
+/** Grant the camera to the next request at nowMicros and release it straight away, returns its ticket */
+private uint grantAndRelease(CaptureScheduler *captureScheduler, const int64_t nowMicros) {
+    uint ticket = CAPTURE_SCHEDULER_MAX_REQUESTS;
+    ASSERT(captureScheduler_grantNext(captureScheduler, nowMicros, &ticket), "a request should be granted");
+    captureScheduler_release(captureScheduler, ticket, false);
+    return ticket;
+}
+
+TEST("CaptureScheduler grants one request at a time") {
+    CaptureScheduler *captureScheduler = captureScheduler_create();
+    ASSERT_NOT_NULL(captureScheduler, "CaptureScheduler should not be NULL");
+    uint ticket;
+    ASSERT_FALSE(captureScheduler_grantNext(captureScheduler, 0, &ticket), "nothing should be granted when empty");
+    uint first, second;
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_LIVE, 0, 0, &first);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_LIVE, 0, 10, &second);
+    ASSERT(captureScheduler_grantNext(captureScheduler, 20, &ticket), "the first request should be granted");
+    ASSERT_UINT_EQUAL(first, ticket, "requests of a class should be granted in the order they were queued");
+    ASSERT_FALSE(captureScheduler_grantNext(captureScheduler, 20, &ticket), "nothing else while one is granted");
+    captureScheduler_release(captureScheduler, first, false);
+    ASSERT(captureScheduler_grantNext(captureScheduler, 30, &ticket), "the second request should be granted");
+    ASSERT_UINT_EQUAL(second, ticket, "ticket was incorrect");
+    captureScheduler_destroy(captureScheduler);
+}
+
+TEST("CaptureScheduler refuses requests when full") {
+    CaptureScheduler *captureScheduler = captureScheduler_create();
+    uint ticket;
+    for (uint i = 0; i < CAPTURE_SCHEDULER_MAX_REQUESTS; i++) {
+        ASSERT_INT_EQUAL(ERROR_NONE, captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, i,
+                                                              &ticket), "enqueue %u should succeed", i);
+    }
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0,
+                                                                   0, &ticket), "enqueue should fail when full");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_COUNT, 0,
+                                                                      0, &ticket), "unknown class should fail");
+    CameraSchedulerStats stats;
+    captureScheduler_getStats(captureScheduler, &stats);
+    ASSERT_UINT_EQUAL(1, stats.requestsRefused, "requests refused was incorrect");
+    ASSERT_UINT_EQUAL(CAPTURE_SCHEDULER_MAX_REQUESTS, stats.classes[CAMERA_REQUEST_CLASS_STILL].waiting,
+                      "waiting was incorrect");
+    captureScheduler_destroy(captureScheduler);
+}
+
+TEST("CaptureScheduler grants by class priority") {
+    CaptureScheduler *captureScheduler = captureScheduler_create();
+    uint live, burst, still, settings;
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_LIVE, 0, 0, &live);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_BURST, 0, 1, &burst);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, 2, &still);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_SETTINGS, 0, 3, &settings);
+    ASSERT_UINT_EQUAL(settings, grantAndRelease(captureScheduler, 10), "settings should go first");
+    ASSERT_UINT_EQUAL(still, grantAndRelease(captureScheduler, 20), "a still should go before a burst");
+    ASSERT_UINT_EQUAL(burst, grantAndRelease(captureScheduler, 30), "a burst should go before live capture");
+    ASSERT_UINT_EQUAL(live, grantAndRelease(captureScheduler, 40), "live capture should go last");
+    captureScheduler_destroy(captureScheduler);
+}
+
+TEST("CaptureScheduler grants overdue requests first") {
+    CaptureScheduler *captureScheduler = captureScheduler_create();
+    uint live, still, ticket;
+    const int64_t deadlineMicros = TEST_DEADLINE_MILLIS * 1000;
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_LIVE, TEST_DEADLINE_MILLIS, 0, &live);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, 10, &still);
+    ASSERT(captureScheduler_grantNext(captureScheduler, deadlineMicros + 1, &ticket), "a request should be granted");
+    ASSERT_UINT_EQUAL(live, ticket, "live capture past its deadline should go before a still");
+    captureScheduler_release(captureScheduler, ticket, false);
+    ASSERT_UINT_EQUAL(still, grantAndRelease(captureScheduler, deadlineMicros + 2), "the still should go next");
+
+    CameraSchedulerStats stats;
+    captureScheduler_getStats(captureScheduler, &stats);
+    ASSERT_UINT_EQUAL(1, stats.classes[CAMERA_REQUEST_CLASS_LIVE].deadlinesMissed, "live deadlines missed");
+    ASSERT_UINT_EQUAL(0, stats.classes[CAMERA_REQUEST_CLASS_STILL].deadlinesMissed, "still deadlines missed");
+    ASSERT_UINT_EQUAL(1, stats.classes[CAMERA_REQUEST_CLASS_LIVE].queueMicros.count, "queue delay count");
+    ASSERT(stats.classes[CAMERA_REQUEST_CLASS_LIVE].queueMicros.max >= deadlineMicros, "queue delay was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.classes[CAMERA_REQUEST_CLASS_LIVE].waiting, "nothing should be waiting");
+    captureScheduler_destroy(captureScheduler);
+}
+
+TEST("CaptureScheduler shares a still with the stills queued before it") {
+    CaptureScheduler *captureScheduler = captureScheduler_create();
+    uint first, second, late, ticket;
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, 0, &first);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, 10, &second);
+    captureScheduler_grantNext(captureScheduler, 20, &ticket);
+    ASSERT_FALSE(captureScheduler_canShareCapture(captureScheduler, first), "nothing has been captured yet");
+    captureScheduler_shareCapture(captureScheduler, 100);
+    captureScheduler_release(captureScheduler, first, false);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, 200, &late);
+
+    captureScheduler_grantNext(captureScheduler, 210, &ticket);
+    ASSERT_UINT_EQUAL(second, ticket, "ticket was incorrect");
+    ASSERT(captureScheduler_canShareCapture(captureScheduler, second), "a still queued before should be shared");
+    captureScheduler_release(captureScheduler, second, true);
+    captureScheduler_grantNext(captureScheduler, 220, &ticket);
+    ASSERT_FALSE(captureScheduler_canShareCapture(captureScheduler, late), "a still queued after is too old");
+    captureScheduler_release(captureScheduler, late, false);
+
+    CameraSchedulerStats stats;
+    captureScheduler_getStats(captureScheduler, &stats);
+    ASSERT_UINT_EQUAL(3, stats.classes[CAMERA_REQUEST_CLASS_STILL].requests, "requests was incorrect");
+    ASSERT_UINT_EQUAL(1, stats.classes[CAMERA_REQUEST_CLASS_STILL].coalesced, "coalesced was incorrect");
+    captureScheduler_resetStats(captureScheduler);
+    captureScheduler_getStats(captureScheduler, &stats);
+    ASSERT_UINT_EQUAL(0, stats.classes[CAMERA_REQUEST_CLASS_STILL].requests, "reset should clear requests");
+    captureScheduler_destroy(captureScheduler);
+}
+
+TEST("CaptureScheduler forgets a shared still when another class uses the camera") {
+    CaptureScheduler *captureScheduler = captureScheduler_create();
+    uint first, settings, second, ticket;
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, 0, &first);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_STILL, 0, 10, &second);
+    captureScheduler_grantNext(captureScheduler, 20, &ticket);
+    captureScheduler_shareCapture(captureScheduler, 100);
+    captureScheduler_enqueue(captureScheduler, CAMERA_REQUEST_CLASS_SETTINGS, 0, 110, &settings);
+    captureScheduler_release(captureScheduler, first, false);
+    ASSERT_UINT_EQUAL(settings, grantAndRelease(captureScheduler, 120), "settings should go before the still");
+    captureScheduler_grantNext(captureScheduler, 130, &ticket);
+    ASSERT_UINT_EQUAL(second, ticket, "ticket was incorrect");
+    ASSERT_FALSE(captureScheduler_canShareCapture(captureScheduler, second), "a still from before settings is stale");
+    captureScheduler_shareCapture(captureScheduler, 200);
+    captureScheduler_forgetCapture(captureScheduler);
+    ASSERT_FALSE(captureScheduler_canShareCapture(captureScheduler, second), "a forgotten still is not shared");
+    captureScheduler_destroy(captureScheduler);
+}
@@ -0,0 +1,161 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "FIFOReader.h"
+
+#define TEST_TAG "[FIFOReader]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_BUFFER_LENGTH 16
+#define TEST_FIFO_LENGTH 100
+
+/** Fake transport, the "FIFO" is a counting byte pattern and queued reads complete in order when awaited */
+typedef struct {
+    size_t fifoPosition;
+    uint8_t *queuedBuffers[FIFO_READER_BUFFER_COUNT];
+    size_t queuedLengths[FIFO_READER_BUFFER_COUNT];
+    uint queueHead;
+    uint queueSize;
+    uint maxQueueSize;
+    uint queueCount;
+    bool failQueue;
+} FakeTransport;
+
+typedef struct {
+    size_t bytesSeen;
+    uint callbackCount;
+    /** Stop the read after this many callbacks, 0 to read everything */
+    uint stopAfter;
+    bool isInOrder;
+    bool isRemainingCorrect;
+    uint8_t *previousBuffer;
+    bool buffersAlternate;
+} CallbackResult;
+
+private Error fakeQueueRead(void *context, uint8_t *buffer, const size_t length) {
+    FakeTransport *fake = context;
+    if (fake->failQueue && fake->queueCount > 0) return ERROR_LIBRARY_FAILURE;
+    if (fake->queueSize >= FIFO_READER_BUFFER_COUNT) return ERROR_ILLEGAL_STATE;
+    const uint tail = (fake->queueHead + fake->queueSize) % FIFO_READER_BUFFER_COUNT;
+    fake->queuedBuffers[tail] = buffer;
+    fake->queuedLengths[tail] = length;
+    fake->queueSize++;
+    fake->queueCount++;
+    if (fake->queueSize > fake->maxQueueSize) fake->maxQueueSize = fake->queueSize;
+    return ERROR_NONE;
+}
+
+private Error fakeAwaitRead(void *context, uint8_t **buffer, size_t *length) {
+    FakeTransport *fake = context;
+    if (fake->queueSize == 0) return ERROR_ILLEGAL_STATE;
+    *buffer = fake->queuedBuffers[fake->queueHead];
+    *length = fake->queuedLengths[fake->queueHead];
+    for (size_t i = 0; i < *length; i++) {
+        (*buffer)[i] = (uint8_t) (fake->fifoPosition++);
+    }
+    fake->queueHead = (fake->queueHead + 1) % FIFO_READER_BUFFER_COUNT;
+    fake->queueSize--;
+    return ERROR_NONE;
+}
+
+private bool testCallback(uint8_t *buffer, const size_t bufferLength,
+                          const size_t bytesRead, const size_t bytesRemaining, void *userArg) {
+    CallbackResult *result = userArg;
+    for (size_t i = 0; i < bufferLength; i++) {
+        if (buffer[i] != (uint8_t) (result->bytesSeen + i)) result->isInOrder = false;
+    }
+    result->bytesSeen += bufferLength;
+    if (bytesRead != result->bytesSeen || bytesRemaining != TEST_FIFO_LENGTH - result->bytesSeen) {
+        result->isRemainingCorrect = false;
+    }
+    if (result->previousBuffer == buffer) result->buffersAlternate = false;
+    result->previousBuffer = buffer;
+    result->callbackCount++;
+    return result->stopAfter == 0 || result->callbackCount < result->stopAfter;
+}
+
+private uint8_t bufferA[TEST_BUFFER_LENGTH];
+private uint8_t bufferB[TEST_BUFFER_LENGTH];
+
+private FIFOReader *createTestReader(FakeTransport *fake) {
+    FIFOReaderTransport transport = {.context = fake, .queueRead = fakeQueueRead, .awaitRead = fakeAwaitRead};
+    uint8_t *const buffers[FIFO_READER_BUFFER_COUNT] = {bufferA, bufferB};
+    return fifoReader_create(&transport, buffers, TEST_BUFFER_LENGTH);
+}
+
+TEST("FIFOReader create") {
+    FakeTransport fake = {};
+    FIFOReader *fifoReader = createTestReader(&fake);
+    ASSERT_NOT_NULL(fifoReader, "FIFOReader should not be NULL");
+    fifoReader_destroy(fifoReader);
+
+    FIFOReaderTransport transport = {.context = &fake, .queueRead = fakeQueueRead, .awaitRead = NULL};
+    uint8_t *const buffers[FIFO_READER_BUFFER_COUNT] = {bufferA, bufferB};
+    ASSERT_NULL(fifoReader_create(&transport, buffers, TEST_BUFFER_LENGTH), "Transport without await should fail");
+}
+
+TEST("FIFOReader read delivers every byte in order") {
+    FakeTransport fake = {};
+    FIFOReader *fifoReader = createTestReader(&fake);
+    CallbackResult result = {.isInOrder = true, .isRemainingCorrect = true, .buffersAlternate = true};
+
+    Error err = fifoReader_read(fifoReader, TEST_FIFO_LENGTH, testCallback, &result);
+    ASSERT_INT_EQUAL(ERROR_NONE, err, "read should succeed");
+    ASSERT_UINT_EQUAL(TEST_FIFO_LENGTH, result.bytesSeen, "all bytes should be delivered");
+    ASSERT_UINT_EQUAL((TEST_FIFO_LENGTH + TEST_BUFFER_LENGTH - 1) / TEST_BUFFER_LENGTH, result.callbackCount,
+                      "callback count was incorrect");
+    ASSERT(result.isInOrder, "bytes were delivered out of order");
+    ASSERT(result.isRemainingCorrect, "bytesRead or bytesRemaining were incorrect");
+    ASSERT(result.buffersAlternate, "buffers should alternate between chunks");
+    ASSERT_UINT_EQUAL(FIFO_READER_BUFFER_COUNT, fake.maxQueueSize, "both buffers should be in flight at once");
+    ASSERT_UINT_EQUAL(0, fake.queueSize, "nothing should be left queued");
+    fifoReader_destroy(fifoReader);
+}
+
+TEST("FIFOReader read smaller than a buffer") {
+    FakeTransport fake = {};
+    FIFOReader *fifoReader = createTestReader(&fake);
+    CallbackResult result = {.isInOrder = true, .isRemainingCorrect = true, .buffersAlternate = true};
+
+    ASSERT_INT_EQUAL(ERROR_NONE, fifoReader_read(fifoReader, 5, testCallback, &result), "read should succeed");
+    ASSERT_UINT_EQUAL(5, result.bytesSeen, "all bytes should be delivered");
+    ASSERT_UINT_EQUAL(1, result.callbackCount, "callback count was incorrect");
+    ASSERT_UINT_EQUAL(1, fake.maxQueueSize, "only one read should be queued");
+    fifoReader_destroy(fifoReader);
+}
+
+TEST("FIFOReader read nothing") {
+    FakeTransport fake = {};
+    FIFOReader *fifoReader = createTestReader(&fake);
+    CallbackResult result = {.isInOrder = true, .isRemainingCorrect = true, .buffersAlternate = true};
+
+    ASSERT_INT_EQUAL(ERROR_NONE, fifoReader_read(fifoReader, 0, testCallback, &result), "read should succeed");
+    ASSERT_UINT_EQUAL(0, result.callbackCount, "callback should not be called");
+    ASSERT_UINT_EQUAL(0, fake.queueCount, "nothing should be queued");
+    fifoReader_destroy(fifoReader);
+}
+
+TEST("FIFOReader read transport error drains queue") {
+    FakeTransport fake = {.failQueue = true};
+    FIFOReader *fifoReader = createTestReader(&fake);
+    CallbackResult result = {.isInOrder = true, .isRemainingCorrect = true, .buffersAlternate = true};
+
+    Error err = fifoReader_read(fifoReader, TEST_FIFO_LENGTH, testCallback, &result);
+    ASSERT_INT_EQUAL(ERROR_LIBRARY_FAILURE, err, "transport error should be returned");
+    ASSERT_UINT_EQUAL(0, fake.queueSize, "nothing should be left queued");
+    fifoReader_destroy(fifoReader);
+}
+
+TEST("FIFOReader read stops when the callback asks") {
+    FakeTransport fake = {};
+    FIFOReader *fifoReader = createTestReader(&fake);
+    CallbackResult result = {.isInOrder = true, .isRemainingCorrect = true, .buffersAlternate = true, .stopAfter = 2};
+
+    ASSERT_INT_EQUAL(ERROR_NONE, fifoReader_read(fifoReader, TEST_FIFO_LENGTH, testCallback, &result),
+                     "read should succeed");
+    ASSERT_UINT_EQUAL(2, result.callbackCount, "callback should not be called after it stops the read");
+    ASSERT_UINT_EQUAL(2 * TEST_BUFFER_LENGTH, result.bytesSeen, "bytes seen was incorrect");
+    ASSERT_UINT_EQUAL(3, fake.queueCount, "only the read already in flight should follow the stop");
+    ASSERT_UINT_EQUAL(0, fake.queueSize, "nothing should be left queued");
+    fifoReader_destroy(fifoReader);
+}
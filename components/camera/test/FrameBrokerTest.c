@@ -0,0 +1,134 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "FrameBroker.h"
+
+#define TEST_TAG "[FrameBroker]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_CAPACITY 2
+#define TEST_FRAME_COUNT 8
+#define TEST_FRAME_BYTES 16
+
+/** Acquires a frame like the camera does, publishes it, then drops the camera's own reference */
+private CameraFrame *publishFrame(FrameBroker *frameBroker, FramePool *framePool, const uint32_t sequence) {
+    CameraFrame *frame = framePool_acquire(framePool);
+    frame->sequence = sequence;
+    frameBroker_publish(frameBroker, frame);
+    framePool_release(frame);
+    return frame;
+}
+
+private uint32_t framesInUse(FramePool *framePool) {
+    CameraFramePoolStats stats;
+    framePool_getStats(framePool, &stats);
+    return stats.framesInUse;
+}
+
+TEST("FrameBroker create") {
+    FrameBroker *frameBroker = frameBroker_create(TEST_CAPACITY);
+    ASSERT_NOT_NULL(frameBroker, "FrameBroker should not be NULL");
+    ASSERT_INT_EQUAL(ERROR_NONE, frameBroker_destroy(frameBroker), "destroy should succeed");
+
+    ASSERT_NULL(frameBroker_create(0), "FrameBroker with 0 capacity should be NULL");
+    ASSERT_NULL(frameBroker_create(3), "FrameBroker with a capacity that is not a power of 2 should be NULL");
+}
+
+TEST("FrameBroker consumers") {
+    FrameBroker *frameBroker = frameBroker_create(TEST_CAPACITY);
+    uint consumer = 0;
+    for (uint i = 0; i < FRAME_BROKER_MAX_CONSUMERS; i++) {
+        ASSERT_INT_EQUAL(ERROR_NONE, frameBroker_addConsumer(frameBroker, &consumer), "add %u should succeed", i);
+        ASSERT_UINT_EQUAL(i, consumer, "consumer was incorrect");
+    }
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, frameBroker_addConsumer(frameBroker, &consumer), "add should fail when full");
+    CameraFrame *frame = NULL;
+    ASSERT_FALSE(frameBroker_take(frameBroker, FRAME_BROKER_MAX_CONSUMERS, &frame), "unknown consumer cannot take");
+    frameBroker_destroy(frameBroker);
+}
+
+TEST("FrameBroker every consumer takes every frame") {
+    FramePool *framePool = framePool_create(TEST_FRAME_COUNT, TEST_FRAME_BYTES);
+    FrameBroker *frameBroker = frameBroker_create(TEST_CAPACITY);
+    uint first, second;
+    frameBroker_addConsumer(frameBroker, &first);
+    frameBroker_addConsumer(frameBroker, &second);
+    CameraFrame *frame = NULL;
+    ASSERT_FALSE(frameBroker_take(frameBroker, first, &frame), "nothing should be taken from an empty broker");
+
+    publishFrame(frameBroker, framePool, 1);
+    publishFrame(frameBroker, framePool, 2);
+    ASSERT_UINT_EQUAL(2, framesInUse(framePool), "the broker should hold the published frames");
+    for (uint32_t sequence = 1; sequence <= 2; sequence++) {
+        ASSERT(frameBroker_take(frameBroker, first, &frame), "first should take frame %u", sequence);
+        ASSERT_UINT_EQUAL(sequence, frame->sequence, "first took frames out of order");
+        framePool_release(frame);
+    }
+    ASSERT_FALSE(frameBroker_take(frameBroker, first, &frame), "first should have taken everything");
+    ASSERT_UINT_EQUAL(2, framesInUse(framePool), "frames should stay in use until every consumer takes them");
+
+    for (uint32_t sequence = 1; sequence <= 2; sequence++) {
+        ASSERT(frameBroker_take(frameBroker, second, &frame), "second should take frame %u", sequence);
+        ASSERT_UINT_EQUAL(sequence, frame->sequence, "second took frames out of order");
+        framePool_release(frame);
+    }
+    ASSERT_UINT_EQUAL(0, framesInUse(framePool), "frames should return once every consumer released them");
+
+    CameraFrameConsumerStats stats;
+    ASSERT_INT_EQUAL(ERROR_NONE, frameBroker_getStats(frameBroker, second, &stats), "getStats should succeed");
+    ASSERT_UINT_EQUAL(2, stats.framesPublished, "frames published was incorrect");
+    ASSERT_UINT_EQUAL(2, stats.framesTaken, "frames taken was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.framesDropped, "no frames should be dropped");
+    ASSERT_UINT_EQUAL(0, stats.framesPending, "no frames should be pending");
+    frameBroker_destroy(frameBroker);
+    framePool_destroy(framePool);
+}
+
+TEST("FrameBroker overruns a slow consumer") {
+    FramePool *framePool = framePool_create(TEST_FRAME_COUNT, TEST_FRAME_BYTES);
+    FrameBroker *frameBroker = frameBroker_create(TEST_CAPACITY);
+    uint fast, slow;
+    frameBroker_addConsumer(frameBroker, &fast);
+    frameBroker_addConsumer(frameBroker, &slow);
+    CameraFrame *frame = NULL;
+    for (uint32_t sequence = 1; sequence <= 5; sequence++) {
+        publishFrame(frameBroker, framePool, sequence);
+        ASSERT(frameBroker_take(frameBroker, fast, &frame), "fast should take frame %u", sequence);
+        framePool_release(frame);
+    }
+    ASSERT_UINT_EQUAL(TEST_CAPACITY, framesInUse(framePool), "only a ring of frames should be held for slow");
+
+    CameraFrameConsumerStats stats;
+    frameBroker_getStats(frameBroker, slow, &stats);
+    ASSERT_UINT_EQUAL(3, stats.framesDropped, "slow should have its oldest frames dropped");
+    ASSERT_UINT_EQUAL(TEST_CAPACITY, stats.framesPending, "slow should have a ring of frames pending");
+    frameBroker_getStats(frameBroker, fast, &stats);
+    ASSERT_UINT_EQUAL(0, stats.framesDropped, "fast should not drop frames");
+
+    ASSERT(frameBroker_take(frameBroker, slow, &frame), "slow should take a frame");
+    ASSERT_UINT_EQUAL(4, frame->sequence, "slow should continue from the oldest frame still in the ring");
+    framePool_release(frame);
+    frameBroker_destroy(frameBroker);
+    ASSERT_UINT_EQUAL(0, framesInUse(framePool), "destroy should release frames nobody took");
+    framePool_destroy(framePool);
+}
+
+TEST("FrameBroker dropAll") {
+    FramePool *framePool = framePool_create(TEST_FRAME_COUNT, TEST_FRAME_BYTES);
+    FrameBroker *frameBroker = frameBroker_create(TEST_CAPACITY);
+    uint consumer;
+    frameBroker_addConsumer(frameBroker, &consumer);
+    publishFrame(frameBroker, framePool, 1);
+    publishFrame(frameBroker, framePool, 2);
+    frameBroker_dropAll(frameBroker);
+    ASSERT_UINT_EQUAL(0, framesInUse(framePool), "dropAll should release every frame");
+    CameraFrame *frame = NULL;
+    ASSERT_FALSE(frameBroker_take(frameBroker, consumer, &frame), "nothing should be left to take");
+
+    publishFrame(frameBroker, framePool, 3);
+    ASSERT(frameBroker_take(frameBroker, consumer, &frame), "frames published after dropAll should be taken");
+    ASSERT_UINT_EQUAL(3, frame->sequence, "sequence was incorrect");
+    framePool_release(frame);
+    frameBroker_destroy(frameBroker);
+    framePool_destroy(framePool);
+}
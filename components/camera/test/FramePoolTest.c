@@ -0,0 +1,84 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "FramePool.h"
+
+#define TEST_TAG "[FramePool]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_FRAME_COUNT 3
+#define TEST_FRAME_BYTES 64
+
+TEST("FramePool create") {
+    FramePool *framePool = framePool_create(TEST_FRAME_COUNT, TEST_FRAME_BYTES);
+    ASSERT_NOT_NULL(framePool, "FramePool should not be NULL");
+    CameraFramePoolStats stats;
+    ASSERT_INT_EQUAL(ERROR_NONE, framePool_getStats(framePool, &stats), "getStats should succeed");
+    ASSERT_UINT_EQUAL(TEST_FRAME_COUNT, stats.frameCount, "frame count was incorrect");
+    ASSERT_UINT_EQUAL(TEST_FRAME_BYTES, stats.frameBytes, "frame bytes was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.framesInUse, "no frames should be in use");
+    ASSERT_INT_EQUAL(ERROR_NONE, framePool_destroy(framePool), "destroy should succeed");
+
+    ASSERT_NULL(framePool_create(0, TEST_FRAME_BYTES), "FramePool with 0 frames should be NULL");
+    ASSERT_NULL(framePool_create(TEST_FRAME_COUNT, 0), "FramePool with 0 byte frames should be NULL");
+}
+
+TEST("FramePool acquire until full") {
+    FramePool *framePool = framePool_create(TEST_FRAME_COUNT, TEST_FRAME_BYTES);
+    CameraFrame *frames[TEST_FRAME_COUNT];
+    for (int i = 0; i < TEST_FRAME_COUNT; i++) {
+        ASSERT_FALSE(framePool_isFull(framePool), "pool should not be full after %i acquires", i);
+        frames[i] = framePool_acquire(framePool);
+        ASSERT_NOT_NULL(frames[i], "acquire %i should succeed", i);
+        ASSERT_UINT_EQUAL(0, frames[i]->length, "acquired frame should be empty");
+    }
+    ASSERT(framePool_isFull(framePool), "pool should be full");
+    ASSERT_NULL(framePool_acquire(framePool), "acquire should fail when full");
+
+    CameraFramePoolStats stats;
+    framePool_getStats(framePool, &stats);
+    ASSERT_UINT_EQUAL(TEST_FRAME_COUNT + 1, stats.acquireCount, "acquire count was incorrect");
+    ASSERT_UINT_EQUAL(1, stats.acquireFailures, "acquire failures was incorrect");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_STATE, framePool_destroy(framePool), "destroy should fail with frames in use");
+
+    for (int i = 0; i < TEST_FRAME_COUNT; i++) framePool_release(frames[i]);
+    ASSERT_INT_EQUAL(ERROR_NONE, framePool_destroy(framePool), "destroy should succeed");
+}
+
+TEST("FramePool frame returns on last release") {
+    FramePool *framePool = framePool_create(1, TEST_FRAME_BYTES);
+    CameraFrame *frame = framePool_acquire(framePool);
+    size_t capacity = 0;
+    uint8_t *buffer = framePool_getBuffer(frame, &capacity);
+    ASSERT_NOT_NULL(buffer, "buffer should not be NULL");
+    ASSERT_UINT_EQUAL(TEST_FRAME_BYTES, capacity, "capacity was incorrect");
+    ASSERT(frame->data == buffer, "frame data should be the buffer");
+
+    ASSERT(framePool_retain(frame) == frame, "retain should return the frame");
+    framePool_retain(frame);
+    framePool_release(frame);
+    framePool_release(frame);
+    ASSERT(framePool_isFull(framePool), "frame should stay in use while a reference is held");
+    ASSERT_NULL(framePool_acquire(framePool), "acquire should fail while a reference is held");
+
+    framePool_release(frame);
+    ASSERT_FALSE(framePool_isFull(framePool), "frame should return after the last release");
+    ASSERT(framePool_acquire(framePool) == frame, "the released frame should be acquired again");
+    framePool_release(frame);
+    framePool_destroy(framePool);
+}
+
+TEST("FramePool high water") {
+    FramePool *framePool = framePool_create(TEST_FRAME_COUNT, TEST_FRAME_BYTES);
+    CameraFrame *first = framePool_acquire(framePool);
+    CameraFrame *second = framePool_acquire(framePool);
+    framePool_release(first);
+    framePool_release(second);
+    framePool_release(framePool_acquire(framePool));
+
+    CameraFramePoolStats stats;
+    framePool_getStats(framePool, &stats);
+    ASSERT_UINT_EQUAL(0, stats.framesInUse, "no frames should be in use");
+    ASSERT_UINT_EQUAL(2, stats.framesInUseHighWater, "high water was incorrect");
+    framePool_destroy(framePool);
+}
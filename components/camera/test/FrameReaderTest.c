@@ -0,0 +1,128 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "FrameReader.h"
+
+#define TEST_TAG "[FrameReader]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define MAX_FRAME_BYTES 64
+
+/** Stands in for the FIFO, reads come out of data in order */
+typedef struct {
+    const uint8_t *data;
+    size_t position;
+    uint reads;
+    bool isFailing;
+} FakeFIFO;
+
+private Error fakeFIFORead(void *context, uint8_t *buffer, const size_t length) {
+    FakeFIFO *fifo = context;
+    if (fifo->isFailing) return ERROR_LIBRARY_FAILURE;
+    memcpy(buffer, fifo->data + fifo->position, length);
+    fifo->position += length;
+    fifo->reads++;
+    return ERROR_NONE;
+}
+
+private const uint8_t PADDED_FRAME[] = {
+        0x00, 0x12, 0xFF, // leading garbage, including a lone 0xFF
+        0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x11, 0x22, 0xFF, 0x00, 0x33, 0x44, 0x55, 0x66, 0xFF, 0xD9,
+        0x00, 0x00, 0x00, 0x00, 0xAB, 0xCD, 0xEF, 0x01 // trailing FIFO padding
+};
+#define PADDED_FRAME_START 3
+#define PADDED_FRAME_LENGTH 16
+
+/** Reads the whole frame in reads of readLength into frame, returns the bytes read */
+private size_t readInReads(FrameReader *frameReader, CameraFrameCursor *cursor, const size_t readLength,
+                           uint8_t *frame) {
+    size_t frameLength = 0;
+    while (!cursor->isComplete && !cursor->isFailed) {
+        uint8_t buffer[MAX_FRAME_BYTES];
+        size_t bytesRead = 0;
+        if (frameReader_read(frameReader, cursor, buffer, readLength, &bytesRead) != ERROR_NONE) break;
+        if (bytesRead < readLength && !cursor->isComplete) return 0; // only the end of the frame may be short
+        memcpy(frame + frameLength, buffer, bytesRead);
+        frameLength += bytesRead;
+    }
+    return frameLength;
+}
+
+TEST("FrameReader reads exactly the frame in reads of any length") {
+    JPEGScanner *scanner = jpegScanner_create();
+    for (size_t readLength = 1; readLength <= sizeof(PADDED_FRAME) + 1; readLength++) {
+        FakeFIFO fifo = {.data = PADDED_FRAME};
+        FrameReader *frameReader = frameReader_create(scanner, fakeFIFORead, &fifo);
+        ASSERT_NOT_NULL(frameReader, "FrameReader should not be NULL");
+        CameraFrameCursor cursor;
+        frameReader_open(frameReader, sizeof(PADDED_FRAME), &cursor);
+        uint8_t frame[MAX_FRAME_BYTES];
+        const size_t frameLength = readInReads(frameReader, &cursor, readLength, frame);
+        ASSERT(cursor.isComplete, "the frame should be complete reading %u at a time", readLength);
+        ASSERT_UINT_EQUAL(PADDED_FRAME_LENGTH, frameLength, "frame length was incorrect reading %u", readLength);
+        ASSERT_UINT_EQUAL(PADDED_FRAME_LENGTH, cursor.bytesRead, "bytes read was incorrect reading %u", readLength);
+        ASSERT(memcmp(PADDED_FRAME + PADDED_FRAME_START, frame, PADDED_FRAME_LENGTH) == 0,
+               "frame bytes were incorrect reading %u at a time", readLength);
+        ASSERT_UINT_EQUAL(sizeof(PADDED_FRAME) - fifo.position, cursor.bytesRemaining,
+                          "bytes remaining should be the FIFO bytes not read, reading %u", readLength);
+        size_t bytesRead = 1;
+        ASSERT_INT_EQUAL(ERROR_NONE, frameReader_read(frameReader, &cursor, frame, readLength, &bytesRead),
+                         "reading a complete frame should succeed");
+        ASSERT_UINT_EQUAL(0, bytesRead, "nothing should be read after the EOI");
+        ASSERT_UINT_EQUAL(cursor.bytesRemaining, frameReader_close(frameReader, &cursor), "bytes not read");
+        frameReader_destroy(frameReader);
+    }
+    jpegScanner_destroy(scanner);
+}
+
+TEST("FrameReader can be closed part way through a frame") {
+    JPEGScanner *scanner = jpegScanner_create();
+    FakeFIFO fifo = {.data = PADDED_FRAME};
+    FrameReader *frameReader = frameReader_create(scanner, fakeFIFORead, &fifo);
+    CameraFrameCursor cursor;
+    frameReader_open(frameReader, sizeof(PADDED_FRAME), &cursor);
+    uint8_t buffer[4];
+    size_t bytesRead = 0;
+    ASSERT_INT_EQUAL(ERROR_NONE, frameReader_read(frameReader, &cursor, buffer, sizeof(buffer), &bytesRead),
+                     "read should succeed");
+    ASSERT_UINT_EQUAL(sizeof(buffer), bytesRead, "a read in the middle of the frame should fill the buffer");
+    ASSERT_FALSE(cursor.isComplete, "the frame should not be complete");
+    ASSERT_UINT_EQUAL(sizeof(PADDED_FRAME) - fifo.position, frameReader_close(frameReader, &cursor),
+                      "every FIFO byte not read should be returned");
+
+    // the next frame starts clean
+    fifo = (FakeFIFO) {.data = PADDED_FRAME};
+    uint8_t frame[MAX_FRAME_BYTES];
+    frameReader_open(frameReader, sizeof(PADDED_FRAME), &cursor);
+    ASSERT_UINT_EQUAL(PADDED_FRAME_LENGTH, readInReads(frameReader, &cursor, 5, frame), "frame length");
+    frameReader_close(frameReader, &cursor);
+    frameReader_destroy(frameReader);
+    jpegScanner_destroy(scanner);
+}
+
+TEST("FrameReader fails a frame with no EOI") {
+    JPEGScanner *scanner = jpegScanner_create();
+    const size_t fifoBytes = PADDED_FRAME_START + PADDED_FRAME_LENGTH - 2; // ends before the EOI
+    FakeFIFO fifo = {.data = PADDED_FRAME};
+    FrameReader *frameReader = frameReader_create(scanner, fakeFIFORead, &fifo);
+    CameraFrameCursor cursor;
+    frameReader_open(frameReader, fifoBytes, &cursor);
+    uint8_t buffer[MAX_FRAME_BYTES];
+    size_t bytesRead = 0;
+    ASSERT_INT_EQUAL(ERROR_NOT_FOUND, frameReader_read(frameReader, &cursor, buffer, sizeof(buffer), &bytesRead),
+                     "a frame with no EOI should not be found");
+    ASSERT(cursor.isFailed, "the cursor should be failed");
+    ASSERT_FALSE(cursor.isComplete, "the cursor should not be complete");
+    ASSERT_UINT_EQUAL(0, cursor.bytesRemaining, "the whole FIFO should have been read");
+    ASSERT_UINT_EQUAL(fifoBytes, fifo.position, "nothing past the FIFO should be read");
+    frameReader_close(frameReader, &cursor);
+
+    fifo = (FakeFIFO) {.data = PADDED_FRAME, .isFailing = true};
+    frameReader_open(frameReader, sizeof(PADDED_FRAME), &cursor);
+    ASSERT_INT_EQUAL(ERROR_LIBRARY_FAILURE, frameReader_read(frameReader, &cursor, buffer, sizeof(buffer),
+                                                             &bytesRead), "the FIFO's error should be returned");
+    ASSERT(cursor.isFailed, "the cursor should be failed");
+    frameReader_close(frameReader, &cursor);
+    frameReader_destroy(frameReader);
+    jpegScanner_destroy(scanner);
+}
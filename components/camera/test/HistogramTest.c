@@ -0,0 +1,68 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "Histogram.h"
+
+#define TEST_TAG "[Histogram]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+TEST("Histogram empty") {
+    Histogram *histogram = histogram_create();
+    ASSERT_NOT_NULL(histogram, "Histogram should not be NULL");
+    CameraStatsSummary summary;
+    histogram_getSummary(histogram, &summary);
+    ASSERT_UINT_EQUAL(0, summary.count, "count was incorrect");
+    ASSERT_UINT_EQUAL(0, summary.min, "min of nothing should be 0");
+    ASSERT_UINT_EQUAL(0, summary.p99, "p99 of nothing should be 0");
+    histogram_destroy(histogram);
+}
+
+TEST("Histogram small values are exact") {
+    Histogram *histogram = histogram_create();
+    for (uint32_t value = 0; value < HISTOGRAM_SUB_BUCKETS; value++) {
+        histogram_record(histogram, value);
+    }
+    ASSERT_UINT_EQUAL(0, histogram_getPercentile(histogram, 0), "p0 was incorrect");
+    ASSERT_UINT_EQUAL(1, histogram_getPercentile(histogram, 50), "p50 was incorrect");
+    ASSERT_UINT_EQUAL(HISTOGRAM_SUB_BUCKETS - 1, histogram_getPercentile(histogram, 100), "p100 was incorrect");
+    histogram_destroy(histogram);
+}
+
+TEST("Histogram percentiles") {
+    Histogram *histogram = histogram_create();
+    for (uint32_t value = 1; value <= 1000; value++) {
+        histogram_record(histogram, value);
+    }
+    CameraStatsSummary summary;
+    histogram_getSummary(histogram, &summary);
+    ASSERT_UINT_EQUAL(1000, summary.count, "count was incorrect");
+    ASSERT_UINT_EQUAL(1, summary.min, "min was incorrect");
+    ASSERT_UINT_EQUAL(1000, summary.max, "max was incorrect");
+    ASSERT_UINT_EQUAL(500, summary.mean, "mean was incorrect");
+    const uint32_t percentiles[] = {50, 95, 99};
+    const uint32_t actuals[] = {summary.p50, summary.p95, summary.p99};
+    for (int i = 0; i < 3; i++) {
+        const uint32_t expected = percentiles[i] * 10;
+        ASSERT(actuals[i] >= expected, "p%u %u should not be below %u", percentiles[i], actuals[i], expected);
+        ASSERT(actuals[i] <= expected + (expected / 4), "p%u %u should be within 25%% of %u",
+               percentiles[i], actuals[i], expected);
+    }
+    ASSERT(summary.p99 <= summary.max, "p99 should never be above max");
+    histogram_destroy(histogram);
+}
+
+TEST("Histogram extremes and reset") {
+    Histogram *histogram = histogram_create();
+    histogram_record(histogram, UINT32_MAX);
+    histogram_record(histogram, 1u << 31);
+    ASSERT_UINT_EQUAL(UINT32_MAX, histogram_getPercentile(histogram, 100), "max value should be in the last bucket");
+    const uint32_t p0 = histogram_getPercentile(histogram, 0);
+    ASSERT(p0 >= (1u << 31) && p0 <= (1u << 31) + (1u << 29), "p0 %u should be in the min's bucket", p0);
+
+    histogram_reset(histogram);
+    CameraStatsSummary summary;
+    histogram_getSummary(histogram, &summary);
+    ASSERT_UINT_EQUAL(0, summary.count, "count should be 0 after reset");
+    ASSERT_UINT_EQUAL(0, summary.max, "max should be 0 after reset");
+    histogram_destroy(histogram);
+}
@@ -0,0 +1,254 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "JPEGDCDecoder.h"
+#include "VirtualCamera.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_TAG "[JPEGDCDecoder]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_BLOCKS_WIDE 4
+#define TEST_BLOCKS_HIGH 2
+/** Read like the camera reads the FIFO */
+#define TEST_CHUNK_BYTES 4096
+
+/** 32x16 4:2:2 baseline JPEG at quality 100 (every quantizer 1) with a restart marker after every MCU, each 8x8
+ * block is one flat grey, TEST_GREYS */
+private const uint8_t TEST_JPEG[] = {
+        0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+        0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xC0,
+        0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x20, 0x03, 0x01, 0x21, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+        0x01, 0xFF, 0xC4, 0x00, 0x1F, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+        0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+        0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7D, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+        0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23,
+        0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17,
+        0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A,
+        0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A,
+        0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A,
+        0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+        0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7,
+        0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5,
+        0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1,
+        0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFF, 0xC4, 0x00, 0x1F, 0x01, 0x00, 0x03,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x11, 0x00,
+        0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00,
+        0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13,
+        0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15,
+        0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26, 0x27,
+        0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+        0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6,
+        0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4,
+        0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE2,
+        0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9,
+        0xFA, 0xFF, 0xDD, 0x00, 0x04, 0x00, 0x01, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11,
+        0x03, 0x11, 0x00, 0x3F, 0x00, 0xFE, 0x1F, 0xEB, 0xF6, 0x02, 0x80, 0x3F, 0xFF, 0xD0, 0x2B, 0xFA,
+        0x00, 0xA0, 0x0F, 0xFF, 0xD1, 0xFE, 0xFE, 0x2B, 0xF9, 0x07, 0xA0, 0x0F, 0xFF, 0xD2, 0xFC, 0xFF,
+        0x00, 0xAF, 0xE7, 0xFE, 0x80, 0x3F, 0xFF, 0xD9,
+};
+
+private const uint8_t TEST_GREYS[TEST_BLOCKS_HIGH][TEST_BLOCKS_WIDE] = {
+        {16, 64, 128, 192},
+        {255, 160, 96, 32},
+};
+
+typedef struct TestBlocks {
+    uint32_t count;
+    /** Luma DC of each block, as blocks are in the test image */
+    int32_t dc[TEST_BLOCKS_HIGH][TEST_BLOCKS_WIDE];
+    uint32_t chromaCount;
+    int32_t coefficientSum;
+} TestBlocks;
+
+private void testBlockCallback(const JPEGDCDecoderBlock *block, void *userArg) {
+    TestBlocks *blocks = (TestBlocks *) userArg;
+    blocks->count++;
+    if (block->component != 0) {
+        blocks->chromaCount++;
+        return;
+    }
+    if (block->x < TEST_BLOCKS_WIDE && block->y < TEST_BLOCKS_HIGH) {
+        blocks->dc[block->y][block->x] = block->coefficients[0];
+    }
+    for (uint32_t i = 1; i < JPEG_DC_DECODER_MAX_COEFFICIENTS; i++) {
+        blocks->coefficientSum += abs(block->coefficients[i]);
+    }
+}
+
+private void decodeInPieces(JPEGDCDecoder *decoder, const uint8_t *bytes, const size_t length, const size_t pieceLength,
+                            TestBlocks *blocks) {
+    memset(blocks, 0, sizeof(TestBlocks));
+    jpegDCDecoder_begin(decoder, JPEG_DC_DECODER_COMPONENT_ALL, JPEG_DC_DECODER_MAX_COEFFICIENTS, testBlockCallback,
+                        blocks);
+    for (size_t i = 0; i < length; i += pieceLength) {
+        const size_t count = length - i < pieceLength ? length - i : pieceLength;
+        ASSERT_INT_EQUAL(ERROR_NONE, jpegDCDecoder_decode(decoder, bytes + i, count), "decode failed at byte %u", i);
+    }
+}
+
+TEST("JPEGDCDecoder DC is the mean of every block") {
+    JPEGDCDecoder *decoder = jpegDCDecoder_create();
+    ASSERT_NOT_NULL(decoder, "decoder should not be NULL");
+    ASSERT_INT_EQUAL(ERROR_NOT_FOUND, jpegDCDecoder_getInfo(decoder, &(JPEGDCDecoderInfo) {}),
+                     "there should be no info before a frame");
+    TestBlocks blocks;
+    decodeInPieces(decoder, TEST_JPEG, sizeof(TEST_JPEG), sizeof(TEST_JPEG), &blocks);
+    ASSERT(jpegDCDecoder_isDone(decoder), "frame should be decoded to its EOI");
+    JPEGDCDecoderInfo info;
+    ASSERT_INT_EQUAL(ERROR_NONE, jpegDCDecoder_getInfo(decoder, &info), "info should be found");
+    ASSERT_UINT_EQUAL(32, info.width, "width was incorrect");
+    ASSERT_UINT_EQUAL(16, info.height, "height was incorrect");
+    ASSERT_UINT_EQUAL(3, info.componentCount, "component count was incorrect");
+    ASSERT_UINT_EQUAL(1, info.restartInterval, "restart interval was incorrect");
+    ASSERT_UINT_EQUAL(TEST_BLOCKS_WIDE, info.components[0].blocksWide, "luma blocks wide was incorrect");
+    ASSERT_UINT_EQUAL(2, info.components[1].blocksWide, "4:2:2 chroma should be half as wide");
+    ASSERT_UINT_EQUAL(TEST_BLOCKS_HIGH, info.components[1].blocksHigh, "4:2:2 chroma should be as high as luma");
+    // 8 luma blocks and 4 blocks of each chroma component
+    ASSERT_UINT_EQUAL(16, blocks.count, "block count was incorrect");
+    ASSERT_UINT_EQUAL(8, blocks.chromaCount, "chroma block count was incorrect");
+    for (uint32_t y = 0; y < TEST_BLOCKS_HIGH; y++) {
+        for (uint32_t x = 0; x < TEST_BLOCKS_WIDE; x++) {
+            ASSERT_INT_EQUAL((TEST_GREYS[y][x] - 128) * 8, blocks.dc[y][x], "DC of block (%u, %u) was incorrect", x, y);
+        }
+    }
+    ASSERT_INT_EQUAL(0, blocks.coefficientSum, "flat blocks should have no AC coefficients");
+    jpegDCDecoder_destroy(decoder);
+}
+
+TEST("JPEGDCDecoder decodes the same in pieces of any size") {
+    JPEGDCDecoder *decoder = jpegDCDecoder_create();
+    TestBlocks whole;
+    TestBlocks pieces;
+    decodeInPieces(decoder, TEST_JPEG, sizeof(TEST_JPEG), sizeof(TEST_JPEG), &whole);
+    const size_t pieceLengths[] = {1, 2, 3, 7, 64, 100};
+    for (uint32_t i = 0; i < sizeof(pieceLengths) / sizeof(pieceLengths[0]); i++) {
+        decodeInPieces(decoder, TEST_JPEG, sizeof(TEST_JPEG), pieceLengths[i], &pieces);
+        ASSERT(jpegDCDecoder_isDone(decoder), "frame should be decoded in pieces of %u", pieceLengths[i]);
+        ASSERT(memcmp(&whole, &pieces, sizeof(TestBlocks)) == 0, "pieces of %u decoded differently", pieceLengths[i]);
+    }
+    JPEGDCDecoderStats stats;
+    jpegDCDecoder_getStats(decoder, &stats);
+    ASSERT_UINT_EQUAL(7, stats.framesDecoded, "frames decoded was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.framesFailed, "no frame should fail");
+    jpegDCDecoder_destroy(decoder);
+}
+
+TEST("JPEGDCDecoder rejects unsupported and truncated frames") {
+    JPEGDCDecoder *decoder = jpegDCDecoder_create();
+    TestBlocks blocks = {0};
+    uint8_t frame[sizeof(TEST_JPEG)];
+    memcpy(frame, TEST_JPEG, sizeof(TEST_JPEG));
+    for (size_t i = 0; i + 1 < sizeof(frame); i++) {
+        if (frame[i] == 0xFF && frame[i + 1] == 0xC0) frame[i + 1] = 0xC2; // progressive
+    }
+    jpegDCDecoder_begin(decoder, JPEG_DC_DECODER_COMPONENT_LUMA, 1, testBlockCallback, &blocks);
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, jpegDCDecoder_decode(decoder, frame, sizeof(frame)),
+                     "a progressive frame should be rejected");
+    ASSERT_FALSE(jpegDCDecoder_isDone(decoder), "a rejected frame should not be done");
+
+    jpegDCDecoder_begin(decoder, JPEG_DC_DECODER_COMPONENT_LUMA, 1, testBlockCallback, &blocks);
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, jpegDCDecoder_decode(decoder, TEST_JPEG + 2, sizeof(TEST_JPEG) - 2),
+                     "a frame without its SOI should be rejected");
+
+    // the scan ends at the EOI with 2 of the 4 MCUs left
+    memcpy(frame, TEST_JPEG, sizeof(TEST_JPEG));
+    size_t restartCount = 0;
+    size_t eoi = 0;
+    for (size_t i = 0; i + 1 < sizeof(frame) && eoi == 0; i++) {
+        if (frame[i] == 0xFF && frame[i + 1] >= 0xD0 && frame[i + 1] <= 0xD7 && ++restartCount == 2) eoi = i;
+    }
+    frame[eoi + 1] = 0xD9;
+    jpegDCDecoder_begin(decoder, JPEG_DC_DECODER_COMPONENT_LUMA, 1, testBlockCallback, &blocks);
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, jpegDCDecoder_decode(decoder, frame, eoi + 2),
+                     "a frame missing MCUs should be rejected");
+    JPEGDCDecoderStats stats;
+    jpegDCDecoder_getStats(decoder, &stats);
+    ASSERT_UINT_EQUAL(3, stats.framesFailed, "frames failed was incorrect");
+
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, jpegDCDecoder_begin(decoder, JPEG_DC_DECODER_COMPONENT_LUMA,
+                                                              JPEG_DC_DECODER_MAX_COEFFICIENTS + 1, NULL, NULL),
+                     "too many coefficients should be rejected");
+    jpegDCDecoder_destroy(decoder);
+}
+
+private void countBlockCallback(const JPEGDCDecoderBlock *block, void *userArg) {
+    (*(uint32_t *) userArg)++;
+}
+
+private uint64_t nowMicros() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000) + ((uint64_t) now.tv_nsec / 1000);
+}
+
+/** Decodes the recorded frames the virtual camera plays, as they come out of its FIFO, skipped with no recording */
+TEST("JPEGDCDecoder benchmark over recorded frames") {
+    VirtualCamera *virtualCamera = virtualCamera_create(NULL);
+    if (virtualCamera_loadFrames(virtualCamera, CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH) != ERROR_NONE) {
+        printf("No recorded frames in %s, skipping benchmark\n", CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH);
+        virtualCamera_destroy(virtualCamera);
+        return;
+    }
+    const uint32_t frameCount = virtualCamera_getFrameCount(virtualCamera);
+    JPEGDCDecoder *decoder = jpegDCDecoder_create();
+    uint8_t *chunk = alloc(TEST_CHUNK_BYTES);
+    ASSERT_NOT_NULL(chunk, "chunk should not be NULL");
+    uint64_t decodeMicros = 0;
+    uint64_t frameBytes = 0;
+    uint32_t blockCount = 0;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        const uint8_t start = VIRTUAL_CAMERA_FIFO_START_CAPTURE;
+        virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL | VIRTUAL_CAMERA_SPI_WRITE,
+                                  &start, 1, NULL, 0);
+        uint8_t status = 0;
+        while (!(status & VIRTUAL_CAMERA_STATUS_DONE)) {
+            virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_STATUS, NULL, 0, &status, 1);
+        }
+        uint8_t size[3];
+        for (uint32_t j = 0; j < 3; j++) {
+            virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_LOW + j, NULL, 0,
+                                      &size[j], 1);
+        }
+        size_t bytesLeft = size[0] | (size[1] << 8) | ((size[2] & 0x7F) << 16);
+        frameBytes += bytesLeft;
+        jpegDCDecoder_begin(decoder, JPEG_DC_DECODER_COMPONENT_LUMA, 1, countBlockCallback, &blockCount);
+        while (bytesLeft > 0) {
+            const size_t chunkLength = bytesLeft < TEST_CHUNK_BYTES ? bytesLeft : TEST_CHUNK_BYTES;
+            virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_BURST_READ, NULL, 0,
+                                      chunk, chunkLength);
+            const uint64_t startMicros = nowMicros();
+            jpegDCDecoder_decode(decoder, chunk, chunkLength);
+            decodeMicros += nowMicros() - startMicros;
+            bytesLeft -= chunkLength;
+        }
+        const uint8_t clear = VIRTUAL_CAMERA_FIFO_CLEAR_DONE_FLAG;
+        virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL | VIRTUAL_CAMERA_SPI_WRITE,
+                                  &clear, 1, NULL, 0);
+    }
+    JPEGDCDecoderStats stats;
+    jpegDCDecoder_getStats(decoder, &stats);
+    const float millisPerFrame = (float) decodeMicros / 1000.0F / (float) frameCount;
+    printf("Decoded %u of %u frames (%u KB each, %u luma blocks each) in %.2f ms per frame, %.1f fps\n",
+           stats.framesDecoded, frameCount, (uint32_t) (frameBytes / frameCount / 1024), blockCount / frameCount,
+           millisPerFrame, millisPerFrame > 0.0F ? 1000.0F / millisPerFrame : 0.0F);
+    ASSERT_UINT_EQUAL(frameCount, stats.framesDecoded + stats.framesFailed, "every frame should be decoded or fail");
+    free(chunk);
+    jpegDCDecoder_destroy(decoder);
+    virtualCamera_destroy(virtualCamera);
+}
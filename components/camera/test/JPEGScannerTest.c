@@ -0,0 +1,160 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "JPEGScanner.h"
+
+#define TEST_TAG "[JPEGScanner]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define MAX_FRAME_BYTES 256
+
+/** Reassembles the frames the scanner passes on */
+typedef struct {
+    uint8_t frame[MAX_FRAME_BYTES];
+    size_t frameLength;
+    uint framesEnded;
+    uint framesDropped;
+    bool isRunningTotalCorrect;
+} ScanResult;
+
+private void testCallback(const uint8_t *segment, const size_t segmentLength, const size_t frameBytesRead,
+                          const JPEGScannerSegmentType segmentType, void *userArg) {
+    ScanResult *result = userArg;
+    if (segmentType == JPEG_SCANNER_SEGMENT_DROPPED) {
+        result->framesDropped++;
+        result->frameLength = 0;
+        return;
+    }
+    memcpy(result->frame + result->frameLength, segment, segmentLength);
+    result->frameLength += segmentLength;
+    if (result->frameLength != frameBytesRead) result->isRunningTotalCorrect = false;
+    if (segmentType == JPEG_SCANNER_SEGMENT_END) result->framesEnded++;
+}
+
+/** Scans data in chunks of chunkLength */
+private uint32_t scanInChunks(JPEGScanner *scanner, const uint8_t *data, const size_t length,
+                              const size_t chunkLength, ScanResult *result) {
+    uint32_t framesCompleted = 0;
+    for (size_t i = 0; i < length; i += chunkLength) {
+        const size_t remaining = length - i;
+        framesCompleted += jpegScanner_scan(scanner, data + i, remaining < chunkLength ? remaining : chunkLength,
+                                            testCallback, result);
+    }
+    return framesCompleted;
+}
+
+private const uint8_t PADDED_FRAME[] = {
+        0x00, 0x12, 0xFF, // leading garbage, including a lone 0xFF
+        0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x11, 0x22, 0xFF, 0x00, 0x33, 0x44, 0x55, 0x66, 0xFF, 0xD9,
+        0x00, 0x00, 0x00, 0x00, 0xAB, 0xCD, 0xEF, 0x01 // trailing FIFO padding
+};
+#define PADDED_FRAME_START 3
+#define PADDED_FRAME_LENGTH 16
+
+TEST("JPEGScanner trims padding around a frame") {
+    JPEGScanner *scanner = jpegScanner_create();
+    ScanResult result = {.isRunningTotalCorrect = true};
+    ASSERT_UINT_EQUAL(1, jpegScanner_scan(scanner, PADDED_FRAME, sizeof(PADDED_FRAME), testCallback, &result),
+                      "one frame should be completed");
+    jpegScanner_finish(scanner, testCallback, &result);
+    ASSERT_UINT_EQUAL(PADDED_FRAME_LENGTH, result.frameLength, "frame length was incorrect");
+    ASSERT(memcmp(PADDED_FRAME + PADDED_FRAME_START, result.frame, PADDED_FRAME_LENGTH) == 0, "frame was incorrect");
+
+    JPEGScannerStats stats;
+    ASSERT_INT_EQUAL(ERROR_NONE, jpegScanner_getStats(scanner, &stats), "get stats should succeed");
+    ASSERT_UINT_EQUAL(1, stats.framesCompleted, "frames completed was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.framesDropped, "frames dropped was incorrect");
+    ASSERT_UINT_EQUAL(PADDED_FRAME_LENGTH, stats.lastFrameBytes, "last frame bytes was incorrect");
+    ASSERT_UINT_EQUAL(sizeof(PADDED_FRAME) - PADDED_FRAME_LENGTH, stats.bytesSkipped, "bytes skipped was incorrect");
+    jpegScanner_destroy(scanner);
+}
+
+TEST("JPEGScanner finds markers across every chunk boundary") {
+    for (size_t chunkLength = 1; chunkLength <= sizeof(PADDED_FRAME); chunkLength++) {
+        JPEGScanner *scanner = jpegScanner_create();
+        ScanResult result = {.isRunningTotalCorrect = true};
+        ASSERT_UINT_EQUAL(1, scanInChunks(scanner, PADDED_FRAME, sizeof(PADDED_FRAME), chunkLength, &result),
+                          "one frame should be completed");
+        ASSERT_UINT_EQUAL(1, result.framesEnded, "frame should be ended once");
+        ASSERT_UINT_EQUAL(PADDED_FRAME_LENGTH, result.frameLength, "frame length was incorrect");
+        ASSERT(memcmp(PADDED_FRAME + PADDED_FRAME_START, result.frame, PADDED_FRAME_LENGTH) == 0,
+               "frame was incorrect");
+        ASSERT(result.isRunningTotalCorrect, "frame bytes read should be a running total");
+        JPEGScannerStats stats;
+        jpegScanner_getStats(scanner, &stats);
+        ASSERT_UINT_EQUAL(sizeof(PADDED_FRAME) - PADDED_FRAME_LENGTH, stats.bytesSkipped,
+                          "bytes skipped was incorrect");
+        jpegScanner_destroy(scanner);
+    }
+}
+
+TEST("JPEGScanner drops a frame without EOI") {
+    const uint8_t truncated[] = {0xFF, 0xD8, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    JPEGScanner *scanner = jpegScanner_create();
+    ScanResult result = {.isRunningTotalCorrect = true};
+    ASSERT_UINT_EQUAL(0, jpegScanner_scan(scanner, truncated, sizeof(truncated), testCallback, &result),
+                      "no frame should be completed");
+    ASSERT(jpegScanner_isInFrame(scanner), "scanner should be in a frame");
+    jpegScanner_finish(scanner, testCallback, &result);
+    ASSERT_FALSE(jpegScanner_isInFrame(scanner), "finish should end the frame");
+    ASSERT_UINT_EQUAL(1, result.framesDropped, "frame should be dropped");
+
+    JPEGScannerStats stats;
+    jpegScanner_getStats(scanner, &stats);
+    ASSERT_UINT_EQUAL(0, stats.framesCompleted, "frames completed was incorrect");
+    ASSERT_UINT_EQUAL(1, stats.framesDropped, "frames dropped was incorrect");
+    jpegScanner_destroy(scanner);
+}
+
+TEST("JPEGScanner drops a frame interrupted by another SOI") {
+    const uint8_t data[] = {
+            0xFF, 0xD8, 0x01, 0x02, 0x03, // first frame never ends
+            0xFF, 0xD8, 0x04, 0x05, 0xFF, 0xD9
+    };
+    JPEGScanner *scanner = jpegScanner_create();
+    ScanResult result = {.isRunningTotalCorrect = true};
+    ASSERT_UINT_EQUAL(1, jpegScanner_scan(scanner, data, sizeof(data), testCallback, &result),
+                      "second frame should be completed");
+    ASSERT_UINT_EQUAL(1, result.framesDropped, "first frame should be dropped");
+    ASSERT_UINT_EQUAL(6, result.frameLength, "second frame length was incorrect");
+    ASSERT(memcmp(data + 5, result.frame, 6) == 0, "second frame was incorrect");
+    jpegScanner_destroy(scanner);
+}
+
+TEST("JPEGScanner counts a readout with no frame as dropped") {
+    uint8_t garbage[64];
+    memset(garbage, 0x5A, sizeof(garbage));
+    garbage[10] = 0xFF;
+    garbage[11] = 0xD9; // EOI outside a frame means nothing
+    JPEGScanner *scanner = jpegScanner_create();
+    ScanResult result = {.isRunningTotalCorrect = true};
+    ASSERT_UINT_EQUAL(0, jpegScanner_scan(scanner, garbage, sizeof(garbage), testCallback, &result),
+                      "no frame should be completed");
+    jpegScanner_finish(scanner, testCallback, &result);
+    ASSERT_UINT_EQUAL(0, result.frameLength, "nothing should be passed on");
+
+    JPEGScannerStats stats;
+    jpegScanner_getStats(scanner, &stats);
+    ASSERT_UINT_EQUAL(1, stats.framesDropped, "frames dropped was incorrect");
+    ASSERT_UINT_EQUAL(sizeof(garbage), stats.bytesSkipped, "bytes skipped was incorrect");
+    jpegScanner_destroy(scanner);
+}
+
+TEST("JPEGScanner multiple frames in one readout") {
+    uint8_t data[3 * PADDED_FRAME_LENGTH];
+    for (int i = 0; i < 3; i++) {
+        memcpy(data + (i * PADDED_FRAME_LENGTH), PADDED_FRAME + PADDED_FRAME_START, PADDED_FRAME_LENGTH);
+    }
+    JPEGScanner *scanner = jpegScanner_create();
+    ScanResult result = {.isRunningTotalCorrect = true};
+    ASSERT_UINT_EQUAL(3, scanInChunks(scanner, data, sizeof(data), 7, &result), "3 frames should be completed");
+    jpegScanner_finish(scanner, testCallback, &result);
+    ASSERT_UINT_EQUAL(3, result.framesEnded, "3 frames should be ended");
+
+    JPEGScannerStats stats;
+    jpegScanner_getStats(scanner, &stats);
+    ASSERT_UINT_EQUAL(3, stats.framesCompleted, "frames completed was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.framesDropped, "frames dropped was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.bytesSkipped, "bytes skipped was incorrect");
+    jpegScanner_destroy(scanner);
+}
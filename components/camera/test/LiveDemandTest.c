@@ -0,0 +1,69 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "LiveDemand.h"
+
+#define TEST_TAG "[LiveDemand]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_LINGER_MILLIS 100
+
+TEST("LiveDemand starts idle and runs from the first subscriber") {
+    LiveDemand *liveDemand = liveDemand_create(TEST_LINGER_MILLIS, 0);
+    ASSERT_NOT_NULL(liveDemand, "LiveDemand should not be NULL");
+    ASSERT_FALSE(liveDemand_isRunning(liveDemand, 10), "nothing is subscribed so it should be idle");
+    ASSERT(liveDemand_subscribe(liveDemand, 20), "the first subscriber should start it");
+    ASSERT_FALSE(liveDemand_subscribe(liveDemand, 30), "a second subscriber should not start it again");
+    ASSERT(liveDemand_isRunning(liveDemand, 40), "it should run while subscribed");
+    liveDemand_destroy(liveDemand);
+}
+
+TEST("LiveDemand lingers after the last subscriber leaves") {
+    LiveDemand *liveDemand = liveDemand_create(TEST_LINGER_MILLIS, 0);
+    liveDemand_subscribe(liveDemand, 0);
+    liveDemand_subscribe(liveDemand, 0);
+    ASSERT_INT_EQUAL(ERROR_NONE, liveDemand_unsubscribe(liveDemand, 100), "unsubscribe should succeed");
+    ASSERT(liveDemand_isRunning(liveDemand, 100 + (2 * TEST_LINGER_MILLIS)), "one is still subscribed");
+    ASSERT_INT_EQUAL(ERROR_NONE, liveDemand_unsubscribe(liveDemand, 1000), "unsubscribe should succeed");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_STATE, liveDemand_unsubscribe(liveDemand, 1000), "none are left to unsubscribe");
+    ASSERT(liveDemand_isRunning(liveDemand, 1000 + TEST_LINGER_MILLIS - 1), "it should linger");
+    ASSERT_FALSE(liveDemand_isRunning(liveDemand, 1000 + TEST_LINGER_MILLIS), "it should be idle after the linger");
+    liveDemand_destroy(liveDemand);
+}
+
+TEST("LiveDemand keeps running for a subscriber that comes back within the linger") {
+    LiveDemand *liveDemand = liveDemand_create(TEST_LINGER_MILLIS, 0);
+    liveDemand_subscribe(liveDemand, 0);
+    liveDemand_unsubscribe(liveDemand, 100);
+    ASSERT_FALSE(liveDemand_subscribe(liveDemand, 150), "it was still lingering so it should not start again");
+    liveDemand_unsubscribe(liveDemand, 200);
+    ASSERT(liveDemand_subscribe(liveDemand, 200 + TEST_LINGER_MILLIS + 1), "it was idle so it should start");
+    CameraLiveDemandStats stats;
+    liveDemand_getStats(liveDemand, 400, &stats);
+    ASSERT_UINT_EQUAL(2, stats.starts, "starts was incorrect");
+    ASSERT_UINT_EQUAL(1, stats.subscribers, "subscribers was incorrect");
+    liveDemand_destroy(liveDemand);
+}
+
+TEST("LiveDemand counts running and idle time for the duty cycle") {
+    LiveDemand *liveDemand = liveDemand_create(TEST_LINGER_MILLIS, 0);
+    liveDemand_subscribe(liveDemand, 100);
+    liveDemand_recordFrame(liveDemand, 130);
+    liveDemand_recordFrame(liveDemand, 160);
+    liveDemand_unsubscribe(liveDemand, 200);
+    CameraLiveDemandStats stats;
+    liveDemand_getStats(liveDemand, 1000, &stats);
+    ASSERT_FALSE(stats.isRunning, "it should be idle");
+    ASSERT_UINT_EQUAL(100 + TEST_LINGER_MILLIS, stats.runningMillis, "the linger should count as running");
+    ASSERT_UINT_EQUAL(1000 - 100 - TEST_LINGER_MILLIS, stats.idleMillis, "idle millis was incorrect");
+    ASSERT(stats.dutyCyclePercent > 19.9f && stats.dutyCyclePercent < 20.1f, "duty cycle was incorrect");
+    ASSERT_UINT_EQUAL(30, stats.lastWarmUpMillis, "warm up should be to the first frame after the start");
+    ASSERT_UINT_EQUAL(TEST_LINGER_MILLIS, stats.lingerMillis, "linger was incorrect");
+
+    liveDemand_resetStats(liveDemand, 1000);
+    liveDemand_getStats(liveDemand, 1500, &stats);
+    ASSERT_UINT_EQUAL(0, stats.starts, "reset should clear starts");
+    ASSERT_UINT_EQUAL(0, stats.runningMillis, "reset should clear running millis");
+    ASSERT_UINT_EQUAL(500, stats.idleMillis, "idle should be counted from the reset");
+    liveDemand_destroy(liveDemand);
+}
@@ -0,0 +1,127 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "MotionDetector.h"
+
+#define TEST_TAG "[MotionDetector]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+/** 640x480 in 8x8 blocks */
+#define TEST_BLOCKS_WIDE 80
+#define TEST_BLOCKS_HIGH 60
+#define TEST_GREY 100
+
+/** A grey frame with a square of side blocks at (left, top) in luma */
+private void addFrame(MotionDetector *motionDetector, const uint32_t blocksWide, const uint32_t blocksHigh,
+                      const uint32_t left, const uint32_t top, const uint32_t side, const uint8_t luma,
+                      MotionDetectorResult *result) {
+    motionDetector_beginFrame(motionDetector, blocksWide, blocksHigh);
+    for (uint32_t y = 0; y < blocksHigh; y++) {
+        for (uint32_t x = 0; x < blocksWide; x++) {
+            const bool isInSquare = x >= left && x < left + side && y >= top && y < top + side;
+            motionDetector_addBlock(motionDetector, x, y, isInSquare ? luma : TEST_GREY);
+        }
+    }
+    motionDetector_endFrame(motionDetector, result);
+}
+
+TEST("MotionDetector motion starts with a change and ends after quiet frames") {
+    MotionDetector *motionDetector = motionDetector_create();
+    ASSERT_NOT_NULL(motionDetector, "motion detector should not be NULL");
+    const CameraMotionOptions options = {.isEnabled = true, .threshold = 20, .triggerPercent = 5, .quietFrames = 3};
+    ASSERT_INT_EQUAL(ERROR_NONE, motionDetector_setOptions(motionDetector, &options), "options should be valid");
+    MotionDetectorResult result;
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, 0, 0, &result);
+    ASSERT(result.isLearning, "the first frame should become the background");
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, 0, 0, &result);
+    ASSERT_FALSE(result.isMotion, "an unchanged frame has no motion");
+    ASSERT_UINT_EQUAL(0, result.score, "an unchanged frame should score 0");
+
+    // 20x20 of 80x60 blocks is 8%
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 10, 10, 20, TEST_GREY + 50, &result);
+    ASSERT(result.isMotion && result.isChanged, "motion should start");
+    ASSERT_UINT_EQUAL(8, result.score, "score was incorrect");
+    ASSERT_UINT_EQUAL(0x01, result.zoneMask, "the whole image zone should be triggered");
+    for (uint32_t i = 0; i < options.quietFrames - 1; i++) {
+        addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, 0, 0, &result);
+        ASSERT(result.isMotion && !result.isChanged, "motion should continue through quiet frame %u", i);
+    }
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, 0, 0, &result);
+    ASSERT(!result.isMotion && result.isChanged, "motion should end after the quiet frames");
+
+    // a change under the threshold is noise
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 10, 10, 20, TEST_GREY + 19, &result);
+    ASSERT_UINT_EQUAL(0, result.score, "a change under the threshold should not count");
+    motionDetector_destroy(motionDetector);
+}
+
+TEST("MotionDetector zones only see motion inside them") {
+    MotionDetector *motionDetector = motionDetector_create();
+    const CameraMotionOptions options = {
+            .isEnabled = true,
+            .triggerPercent = 50,
+            .zoneCount = 2,
+            .zones = {{.left = 0, .top = 0, .width = 50, .height = 50},
+                      {.left = 50, .top = 50, .width = 50, .height = 50}},
+    };
+    ASSERT_INT_EQUAL(ERROR_NONE, motionDetector_setOptions(motionDetector, &options), "options should be valid");
+    MotionDetectorResult result;
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, 0, 0, &result);
+    // fills the bottom right zone, 40x30 blocks, and none of the top left
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 40, 30, 40, 0, &result);
+    ASSERT(result.isMotion, "motion should be found");
+    ASSERT_UINT_EQUAL(0x02, result.zoneMask, "only the bottom right zone should be triggered");
+    ASSERT_UINT_EQUAL(0, result.zoneScores[0], "top left zone score was incorrect");
+    ASSERT_UINT_EQUAL(100, result.zoneScores[1], "bottom right zone score was incorrect");
+
+    CameraMotionOptions invalid = options;
+    invalid.zones[1].left = 60;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, motionDetector_setOptions(motionDetector, &invalid),
+                     "a zone past the image's edge should be rejected");
+    invalid = options;
+    invalid.zones[0].width = 0;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, motionDetector_setOptions(motionDetector, &invalid),
+                     "a zone with no area should be rejected");
+    motionDetector_destroy(motionDetector);
+}
+
+TEST("MotionDetector averages large frames down and relearns on a new size") {
+    MotionDetector *motionDetector = motionDetector_create();
+    motionDetector_setOptions(motionDetector, &(CameraMotionOptions) {.isEnabled = true});
+    MotionDetectorResult result;
+    // 2592x1944 is 324x243 blocks, averaged 8x8 blocks to a cell
+    addFrame(motionDetector, 324, 243, 0, 0, 0, 0, &result);
+    uint32_t width = 0;
+    uint32_t height = 0;
+    motionDetector_getMapSize(motionDetector, &width, &height);
+    ASSERT_UINT_EQUAL(41, width, "map width was incorrect");
+    ASSERT_UINT_EQUAL(31, height, "map height was incorrect");
+    addFrame(motionDetector, 324, 243, 0, 0, 0, 0, &result);
+    ASSERT_FALSE(result.isLearning, "the same size should be compared");
+    ASSERT_UINT_EQUAL(0, result.score, "the edge cells are only partly covered but should still score 0");
+
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, 0, 0, &result);
+    ASSERT(result.isLearning, "a new size should become the background");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, motionDetector_beginFrame(motionDetector, 1000, 1000),
+                     "a frame too large to average down should be rejected");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_STATE, motionDetector_endFrame(motionDetector, &result),
+                     "there should be no frame to end");
+    motionDetector_destroy(motionDetector);
+}
+
+TEST("MotionDetector background takes in a lasting change") {
+    MotionDetector *motionDetector = motionDetector_create();
+    motionDetector_setOptions(motionDetector, &(CameraMotionOptions) {.isEnabled = true, .backgroundShift = 2});
+    MotionDetectorResult result;
+    addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, 0, 0, &result);
+    // the lights come on, every frame is brighter from now on
+    uint32_t framesWithMotion = 0;
+    for (uint32_t i = 0; i < 40; i++) {
+        addFrame(motionDetector, TEST_BLOCKS_WIDE, TEST_BLOCKS_HIGH, 0, 0, TEST_BLOCKS_WIDE, TEST_GREY + 100, &result);
+        if (result.score > 0) framesWithMotion++;
+    }
+    ASSERT(framesWithMotion > 0, "the change should be seen at first");
+    ASSERT_UINT_EQUAL(0, result.score, "the background should have caught up");
+    ASSERT_FALSE(result.isMotion, "motion should have ended");
+    motionDetector_destroy(motionDetector);
+}
@@ -0,0 +1,172 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "QualityController.h"
+
+#define TEST_TAG "[QualityController]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+private const CameraQualityTarget TEST_FPS_TARGET = {
+        .mode = CAMERA_QUALITY_TARGET_MODE_FPS,
+        .value = 10.0F,
+        .hysteresisPercent = 20,
+        .minImageSize = CAMERA_IMAGE_SIZE_320x240,
+        .maxImageSize = CAMERA_IMAGE_SIZE_1024x768
+};
+
+/** Add a whole window of frames at fps, each frameBytes long */
+private void addWindow(QualityController *qualityController, const float fps, const uint32_t frameBytes,
+                       const uint32_t framesDropped) {
+    const uint32_t frameCount = QUALITY_CONTROLLER_WINDOW_FRAMES;
+    qualityController_addFrames(qualityController, frameCount, (uint32_t) ((1000.0F * frameCount) / fps),
+                                frameBytes * frameCount, framesDropped);
+}
+
+TEST("QualityController disabled") {
+    QualityController *qualityController = qualityController_create();
+    ASSERT_NOT_NULL(qualityController, "QualityController should not be NULL");
+    addWindow(qualityController, 1.0F, 1000, 0);
+    CameraQualityDecision decision;
+    ASSERT_FALSE(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_HIGH,
+                                          &decision), "a disabled controller should never change anything");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_DISABLED, decision.reason, "reason was incorrect");
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController rejects invalid targets") {
+    QualityController *qualityController = qualityController_create();
+    CameraQualityTarget target = TEST_FPS_TARGET;
+    target.value = 0.0F;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, qualityController_setTarget(qualityController, &target),
+                     "a target of 0 should be rejected");
+    target = TEST_FPS_TARGET;
+    target.minImageSize = CAMERA_IMAGE_SIZE_1280x960;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, qualityController_setTarget(qualityController, &target),
+                     "min image size above max image size should be rejected");
+    target = TEST_FPS_TARGET;
+    target.hysteresisPercent = 100;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, qualityController_setTarget(qualityController, &target),
+                     "hysteresis of 100%% should be rejected");
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController waits for a whole window") {
+    QualityController *qualityController = qualityController_create();
+    qualityController_setTarget(qualityController, &TEST_FPS_TARGET);
+    qualityController_addFrames(qualityController, QUALITY_CONTROLLER_WINDOW_FRAMES - 1, 10000, 1000, 0);
+    CameraQualityDecision decision;
+    ASSERT_FALSE(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_LOW,
+                                          &decision), "nothing should change before a whole window");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_MEASURING, decision.reason, "reason was incorrect");
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController steps down quality then image size") {
+    QualityController *qualityController = qualityController_create();
+    qualityController_setTarget(qualityController, &TEST_FPS_TARGET);
+    CameraQualityDecision decision;
+    addWindow(qualityController, 5.0F, 20000, 0);
+    ASSERT(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_NORMAL,
+                                    &decision), "5 fps for a 10 fps target should step down");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_ACTION_STEP_DOWN, decision.action, "action was incorrect");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_FPS_BELOW_TARGET, decision.reason, "reason was incorrect");
+    ASSERT_INT_EQUAL(CAMERA_IMAGE_SIZE_640x480, decision.imageSize, "image size should stay");
+    ASSERT_INT_EQUAL(CAMERA_IMAGE_QUALITY_LOW, decision.imageQuality, "quality should go down first");
+    ASSERT_UINT_EQUAL(5, (uint32_t) decision.measuredFps, "measured fps was incorrect");
+    ASSERT_UINT_EQUAL(20000, decision.measuredFrameBytes, "measured frame bytes was incorrect");
+
+    addWindow(qualityController, 5.0F, 20000, 0);
+    ASSERT_FALSE(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_LOW,
+                                          &decision), "the window after a step should be discarded");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_SETTLING, decision.reason, "reason was incorrect");
+
+    addWindow(qualityController, 5.0F, 20000, 0);
+    ASSERT(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_LOW,
+                                    &decision), "still too slow should step down again");
+    ASSERT_INT_EQUAL(CAMERA_IMAGE_SIZE_320x240, decision.imageSize, "image size should go down");
+    ASSERT_INT_EQUAL(CAMERA_IMAGE_QUALITY_HIGH, decision.imageQuality, "quality should go to the top of the size");
+    ASSERT_UINT_EQUAL(2, decision.stepCount, "step count was incorrect");
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController holds inside the hysteresis band") {
+    QualityController *qualityController = qualityController_create();
+    qualityController_setTarget(qualityController, &TEST_FPS_TARGET);
+    CameraQualityDecision decision;
+    const float fpsInBand[] = {8.5F, 10.0F, 11.5F};
+    for (int i = 0; i < 3; i++) {
+        addWindow(qualityController, fpsInBand[i], 20000, 0);
+        ASSERT_FALSE(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480,
+                                              CAMERA_IMAGE_QUALITY_NORMAL, &decision),
+                     "%.1f fps should be inside the band", fpsInBand[i]);
+        ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_TARGET_MET, decision.reason, "reason was incorrect");
+    }
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController stops at the target's limits") {
+    QualityController *qualityController = qualityController_create();
+    qualityController_setTarget(qualityController, &TEST_FPS_TARGET);
+    CameraQualityDecision decision;
+    addWindow(qualityController, 30.0F, 20000, 0);
+    ASSERT_FALSE(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_1024x768, CAMERA_IMAGE_QUALITY_HIGH,
+                                          &decision), "nothing is above the max image size at high quality");
+    ASSERT(decision.isAtLimit, "should be at the limit");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_ACTION_HOLD, decision.action, "action was incorrect");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_FPS_ABOVE_TARGET, decision.reason, "reason was incorrect");
+
+    addWindow(qualityController, 10.0F, 20000, 0);
+    ASSERT(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_2592x1944, CAMERA_IMAGE_QUALITY_LOW,
+                                    &decision), "an image size above the max should be brought back");
+    ASSERT_INT_EQUAL(CAMERA_IMAGE_SIZE_1024x768, decision.imageSize, "image size was incorrect");
+    ASSERT_INT_EQUAL(CAMERA_IMAGE_QUALITY_HIGH, decision.imageQuality, "quality was incorrect");
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController steps down for a send backlog") {
+    QualityController *qualityController = qualityController_create();
+    qualityController_setTarget(qualityController, &TEST_FPS_TARGET);
+    CameraQualityDecision decision;
+    addWindow(qualityController, 10.0F, 20000, QUALITY_CONTROLLER_WINDOW_FRAMES / 2);
+    ASSERT(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_NORMAL,
+                                    &decision), "dropping half the frames should step down");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_SEND_BACKLOG, decision.reason, "reason was incorrect");
+    ASSERT_UINT_EQUAL(QUALITY_CONTROLLER_WINDOW_FRAMES / 2, decision.framesDropped, "frames dropped was incorrect");
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController bandwidth target") {
+    QualityController *qualityController = qualityController_create();
+    CameraQualityTarget target = TEST_FPS_TARGET;
+    target.mode = CAMERA_QUALITY_TARGET_MODE_KBPS;
+    target.value = 800.0F;
+    qualityController_setTarget(qualityController, &target);
+    CameraQualityDecision decision;
+    addWindow(qualityController, 10.0F, 20000, 0); // 20000 bytes at 10 fps is 1600 kbit/s
+    ASSERT(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_NORMAL,
+                                    &decision), "double the bandwidth target should step down");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_KBPS_ABOVE_TARGET, decision.reason, "reason was incorrect");
+    ASSERT_UINT_EQUAL(1600, (uint32_t) decision.measuredKbps, "measured kbps was incorrect");
+    qualityController_destroy(qualityController);
+}
+
+TEST("QualityController backs off a step up that did not hold") {
+    QualityController *qualityController = qualityController_create();
+    qualityController_setTarget(qualityController, &TEST_FPS_TARGET);
+    CameraQualityDecision decision;
+    addWindow(qualityController, 20.0F, 20000, 0);
+    ASSERT(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_LOW,
+                                    &decision), "too fast should step up");
+    addWindow(qualityController, 20.0F, 20000, 0);
+    qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_NORMAL, &decision);
+    addWindow(qualityController, 5.0F, 20000, 0);
+    ASSERT(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_NORMAL,
+                                    &decision), "too slow after the step up should step back down");
+    addWindow(qualityController, 20.0F, 20000, 0);
+    qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_LOW, &decision);
+    addWindow(qualityController, 20.0F, 20000, 0);
+    ASSERT_FALSE(qualityController_decide(qualityController, CAMERA_IMAGE_SIZE_640x480, CAMERA_IMAGE_QUALITY_LOW,
+                                          &decision), "stepping straight back up should be held off");
+    ASSERT_INT_EQUAL(CAMERA_QUALITY_REASON_FPS_ABOVE_TARGET, decision.reason, "reason was incorrect");
+    qualityController_destroy(qualityController);
+}
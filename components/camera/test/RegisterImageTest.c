@@ -0,0 +1,168 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "RegisterImage.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_TAG "[RegisterImage]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_SCRIPTS_CHECKSUM 0x12345678
+
+/** Fake sensor, a register file that counts the bus transactions it sees */
+typedef struct {
+    uint8_t registers[0x10000];
+    uint writeCount;
+    uint readCount;
+} FakeSensor;
+
+private Error fakeWrite(void *context, const uint16_t address, const uint8_t *values, const size_t length) {
+    FakeSensor *fake = context;
+    memcpy(fake->registers + address, values, length);
+    fake->writeCount++;
+    return ERROR_NONE;
+}
+
+private Error fakeRead(void *context, const uint16_t address, uint8_t *values, const size_t length) {
+    FakeSensor *fake = context;
+    memcpy(values, fake->registers + address, length);
+    fake->readCount++;
+    return ERROR_NONE;
+}
+
+private const OV5642RegisterEntry TEST_ENTRIES[] = {
+        {0x3818, 0xa8},
+        {0x3500, 0x01}, // auto exposure, not verifiable
+        {0x5180, 0x01}, {0x5181, 0x02}, {0x5182, 0x03},
+        {0x5190, 0x42},
+        {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+};
+
+private RegisterShadow *createTestShadow() {
+    RegisterShadow *shadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    for (const OV5642RegisterEntry *entry = TEST_ENTRIES; !registerScript_isEnd(entry); entry++) {
+        registerShadow_set(shadow, entry->address, entry->value);
+    }
+    registerShadow_set(shadow, 0x3818, 0xa9); // written twice, only the final value is in the image
+    return shadow;
+}
+
+TEST("RegisterImage create and info") {
+    RegisterShadow *shadow = createTestShadow();
+    const uint32_t userData = 0xCAFEF00D;
+    uint8_t *image = NULL;
+    size_t imageLength = 0;
+    ASSERT_INT_EQUAL(ERROR_NONE, registerImage_create(shadow, TEST_SCRIPTS_CHECKSUM, &userData, sizeof(userData),
+                                                      &image, &imageLength), "create should succeed");
+    ASSERT_NOT_NULL(image, "image should not be NULL");
+    RegisterImageInfo info;
+    ASSERT_INT_EQUAL(ERROR_NONE, registerImage_getInfo(image, imageLength, &info), "image should be valid");
+    ASSERT_UINT_EQUAL(6, info.entryCount, "entry count was incorrect");
+    ASSERT_UINT_EQUAL(4, info.runCount, "consecutive registers should share a run");
+    ASSERT_UINT_EQUAL(TEST_SCRIPTS_CHECKSUM, info.scriptsChecksum, "scripts checksum was incorrect");
+    ASSERT_UINT_EQUAL(sizeof(userData), info.userDataLength, "user data length was incorrect");
+    ASSERT(memcmp(info.userData, &userData, sizeof(userData)) == 0, "user data was incorrect");
+    free(image);
+    registerShadow_destroy(shadow);
+}
+
+TEST("RegisterImage rejects corrupt images") {
+    RegisterShadow *shadow = createTestShadow();
+    uint8_t *image = NULL;
+    size_t imageLength = 0;
+    registerImage_create(shadow, TEST_SCRIPTS_CHECKSUM, NULL, 0, &image, &imageLength);
+    RegisterImageInfo info;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, registerImage_getInfo(image, imageLength - 1, &info),
+                     "a truncated image should be rejected");
+    image[imageLength - 1] ^= 0x01;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, registerImage_getInfo(image, imageLength, &info),
+                     "a corrupt image should be rejected");
+    FakeSensor *fake = new(FakeSensor);
+    const RegisterScriptWriter writer = {.context = fake, .write = fakeWrite};
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, registerImage_apply(image, imageLength, &writer, NULL, NULL),
+                     "a corrupt image should not be applied");
+    ASSERT_UINT_EQUAL(0, fake->writeCount, "nothing should be written from a corrupt image");
+    delete(fake);
+    free(image);
+    registerShadow_destroy(shadow);
+}
+
+TEST("RegisterImage apply and verify") {
+    RegisterShadow *shadow = createTestShadow();
+    uint8_t *image = NULL;
+    size_t imageLength = 0;
+    registerImage_create(shadow, TEST_SCRIPTS_CHECKSUM, NULL, 0, &image, &imageLength);
+    FakeSensor *fake = new(FakeSensor);
+    const RegisterScriptWriter writer = {.context = fake, .write = fakeWrite};
+    RegisterShadow *appliedShadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    RegisterScriptStats stats;
+    ASSERT_INT_EQUAL(ERROR_NONE, registerImage_apply(image, imageLength, &writer, appliedShadow, &stats),
+                     "apply should succeed");
+    ASSERT_UINT_EQUAL(4, fake->writeCount, "every run should be one write");
+    ASSERT_UINT_EQUAL(6, stats.entryCount, "entry count was incorrect");
+    ASSERT_UINT_EQUAL(0xa9, fake->registers[0x3818], "the final value should be written");
+    ASSERT_UINT_EQUAL(0x03, fake->registers[0x5182], "run values were incorrect");
+    ASSERT_UINT_EQUAL(6, registerShadow_getSize(appliedShadow), "applying should fill the shadow");
+
+    const RegisterImageReader reader = {.context = fake, .read = fakeRead};
+    ASSERT_INT_EQUAL(ERROR_NONE, registerImage_verify(image, imageLength, &reader), "verify should succeed");
+    ASSERT_UINT_EQUAL(4, fake->readCount, "every run should be one read");
+
+    fake->registers[0x3500] = 0x7F; // auto exposure moved on
+    ASSERT_INT_EQUAL(ERROR_NONE, registerImage_verify(image, imageLength, &reader),
+                     "registers the sensor changes itself should not fail verify");
+    fake->registers[0x5181] = 0x00;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_STATE, registerImage_verify(image, imageLength, &reader),
+                     "a register that did not take the image should fail verify");
+    registerShadow_destroy(appliedShadow);
+    delete(fake);
+    free(image);
+    registerShadow_destroy(shadow);
+}
+
+/** Reads like the I2C master does, the sensor stops driving the bus after the first byte the master NACKs and the
+ * rest of the read is the idle bus, 0xFF. Only the last byte is NACKed unless nackEveryByte is set */
+typedef struct {
+    FakeSensor *sensor;
+    bool nackEveryByte;
+} FakeI2CBus;
+
+private Error fakeI2CRead(void *context, const uint16_t address, uint8_t *values, const size_t length) {
+    FakeI2CBus *bus = context;
+    const size_t bytesDriven = bus->nackEveryByte ? 1 : length;
+    memcpy(values, bus->sensor->registers + address, bytesDriven);
+    memset(values + bytesDriven, 0xFF, length - bytesDriven);
+    bus->sensor->readCount++;
+    return ERROR_NONE;
+}
+
+TEST("RegisterImage verify reads a run in one multi-byte read") {
+    RegisterShadow *shadow = createTestShadow();
+    uint8_t *image = NULL;
+    size_t imageLength = 0;
+    registerImage_create(shadow, TEST_SCRIPTS_CHECKSUM, NULL, 0, &image, &imageLength);
+    FakeSensor *fake = new(FakeSensor);
+    const RegisterScriptWriter writer = {.context = fake, .write = fakeWrite};
+    registerImage_apply(image, imageLength, &writer, NULL, NULL);
+
+    FakeI2CBus bus = {.sensor = fake, .nackEveryByte = false};
+    const RegisterImageReader reader = {.context = &bus, .read = fakeI2CRead};
+    ASSERT_INT_EQUAL(ERROR_NONE, registerImage_verify(image, imageLength, &reader),
+                     "verify should succeed when only the last byte is NACKed");
+    ASSERT_UINT_EQUAL(4, fake->readCount, "the 3 register run should be one read");
+    bus.nackEveryByte = true;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_STATE, registerImage_verify(image, imageLength, &reader),
+                     "NACKing every byte should lose the rest of the run");
+    delete(fake);
+    free(image);
+    registerShadow_destroy(shadow);
+}
+
+TEST("RegisterImage script checksum") {
+    const uint32_t checksum = registerImage_checksumScript(REGISTER_IMAGE_CHECKSUM_SEED, TEST_ENTRIES);
+    ASSERT(checksum != REGISTER_IMAGE_CHECKSUM_SEED, "checksum should change");
+    ASSERT_UINT_EQUAL(checksum, registerImage_checksumScript(REGISTER_IMAGE_CHECKSUM_SEED, TEST_ENTRIES),
+                      "checksum should be the same every time");
+    ASSERT(registerImage_checksumScript(checksum, TEST_ENTRIES) != checksum, "chained checksum should change");
+}
@@ -0,0 +1,231 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "RegisterScript.h"
+#include <stdlib.h>
+
+#define TEST_TAG "[RegisterScript]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define MAX_RECORDED_WRITES 64
+
+/** Fake writer that records every transaction and every delay */
+typedef struct {
+    uint16_t addresses[MAX_RECORDED_WRITES];
+    size_t lengths[MAX_RECORDED_WRITES];
+    uint8_t values[MAX_RECORDED_WRITES][REGISTER_SCRIPT_MAX_WRITE_LENGTH];
+    uint writeCount;
+    uint32_t delays[MAX_RECORDED_WRITES];
+    uint delayCount;
+    uint writesBeforeFirstDelay;
+    int failAtWrite;
+} FakeWriter;
+
+private Error fakeWrite(void *context, const uint16_t address, const uint8_t *values, const size_t length) {
+    FakeWriter *fake = context;
+    if (fake->failAtWrite > 0 && fake->writeCount + 1 == fake->failAtWrite) return ERROR_LIBRARY_FAILURE;
+    fake->addresses[fake->writeCount] = address;
+    fake->lengths[fake->writeCount] = length;
+    memcpy(fake->values[fake->writeCount], values, length);
+    fake->writeCount++;
+    return ERROR_NONE;
+}
+
+private void fakeDelay(void *context, const uint32_t millis) {
+    FakeWriter *fake = context;
+    if (fake->delayCount == 0) fake->writesBeforeFirstDelay = fake->writeCount;
+    fake->delays[fake->delayCount++] = millis;
+}
+
+#define createFakeWriter(fake) {.context = (fake), .write = fakeWrite, .delay = fakeDelay}
+
+TEST("RegisterScript merges consecutive addresses") {
+    const OV5642RegisterEntry entries[] = {
+            {0x5180, 0x01}, {0x5181, 0x02}, {0x5182, 0x03},
+            {0x5190, 0x04},
+            {0x5191, 0xFF}, // an entry with value 0xFF is not the end of the table
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    FakeWriter fake = {};
+    const RegisterScriptWriter writer = createFakeWriter(&fake);
+    RegisterScriptStats stats;
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, NULL, entries, &stats), "run should succeed");
+    ASSERT_UINT_EQUAL(2, fake.writeCount, "consecutive entries should be merged");
+    ASSERT_UINT_EQUAL(0x5180, fake.addresses[0], "first write address was incorrect");
+    ASSERT_UINT_EQUAL(3, fake.lengths[0], "first write length was incorrect");
+    ASSERT_UINT_EQUAL(0x03, fake.values[0][2], "first write values were incorrect");
+    ASSERT_UINT_EQUAL(0x5190, fake.addresses[1], "second write address was incorrect");
+    ASSERT_UINT_EQUAL(2, fake.lengths[1], "second write length was incorrect");
+    ASSERT_UINT_EQUAL(0xFF, fake.values[1][1], "second write values were incorrect");
+    ASSERT_UINT_EQUAL(5, stats.entryCount, "entry count was incorrect");
+    ASSERT_UINT_EQUAL(5, registerScript_length(entries), "length was incorrect");
+    ASSERT_UINT_EQUAL(2, stats.writeCount, "write count was incorrect");
+    ASSERT_UINT_EQUAL(0, fake.delayCount, "there should be no delays");
+}
+
+TEST("RegisterScript delays only after software reset") {
+    const OV5642RegisterEntry entries[] = {
+            {0x3103, 0x93},
+            {0x3008, 0x82},
+            {0x3009, 0x00},
+            {0x3008, 0x02}, // not a reset
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    FakeWriter fake = {};
+    const RegisterScriptWriter writer = createFakeWriter(&fake);
+    RegisterScriptStats stats;
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, NULL, entries, &stats), "run should succeed");
+    ASSERT_UINT_EQUAL(1, fake.delayCount, "only the reset should delay");
+    ASSERT_UINT_EQUAL(REGISTER_SCRIPT_RESET_DELAY_MILLIS, fake.delays[0], "reset delay was incorrect");
+    ASSERT_UINT_EQUAL(2, fake.writesBeforeFirstDelay, "reset must be written before the delay");
+    ASSERT_UINT_EQUAL(0x3008, fake.addresses[1], "reset should be written on its own");
+    ASSERT_UINT_EQUAL(1, fake.lengths[1], "reset should be written on its own");
+    ASSERT_UINT_EQUAL(REGISTER_SCRIPT_RESET_DELAY_MILLIS, stats.delayMillis, "delay stats were incorrect");
+}
+
+TEST("RegisterScript explicit delay entries") {
+    const OV5642RegisterEntry entries[] = {
+            {0x3000, 0x01},
+            {OV5642_REGISTER_ADDRESS_DELAY, 20},
+            {0x3001, 0x02},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    FakeWriter fake = {};
+    const RegisterScriptWriter writer = createFakeWriter(&fake);
+    RegisterScriptStats stats;
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, NULL, entries, &stats), "run should succeed");
+    ASSERT_UINT_EQUAL(2, fake.writeCount, "a delay should split consecutive writes");
+    ASSERT_UINT_EQUAL(1, fake.delayCount, "delay count was incorrect");
+    ASSERT_UINT_EQUAL(20, fake.delays[0], "delay was incorrect");
+    ASSERT_UINT_EQUAL(1, fake.writesBeforeFirstDelay, "delay happened at the wrong time");
+    ASSERT_UINT_EQUAL(2, stats.entryCount, "delay entries should not be counted");
+}
+
+TEST("RegisterScript splits long runs") {
+    OV5642RegisterEntry entries[REGISTER_SCRIPT_MAX_WRITE_LENGTH + 2];
+    for (int i = 0; i < REGISTER_SCRIPT_MAX_WRITE_LENGTH + 1; i++) {
+        entries[i] = (OV5642RegisterEntry) {.address = 0x4000 + i, .value = (uint8_t) i};
+    }
+    entries[REGISTER_SCRIPT_MAX_WRITE_LENGTH + 1] =
+            (OV5642RegisterEntry) {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END};
+    FakeWriter fake = {};
+    const RegisterScriptWriter writer = createFakeWriter(&fake);
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, NULL, entries, NULL), "run should succeed");
+    ASSERT_UINT_EQUAL(2, fake.writeCount, "run should be split at the max write length");
+    ASSERT_UINT_EQUAL(REGISTER_SCRIPT_MAX_WRITE_LENGTH, fake.lengths[0], "first write length was incorrect");
+    ASSERT_UINT_EQUAL(0x4000 + REGISTER_SCRIPT_MAX_WRITE_LENGTH, fake.addresses[1], "second address was incorrect");
+}
+
+TEST("RegisterScript stops at writer error") {
+    const OV5642RegisterEntry entries[] = {
+            {0x3000, 0x01},
+            {0x4000, 0x02},
+            {0x5000, 0x03},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    FakeWriter fake = {.failAtWrite = 2};
+    const RegisterScriptWriter writer = createFakeWriter(&fake);
+
+    ASSERT_INT_EQUAL(ERROR_LIBRARY_FAILURE, registerScript_run(&writer, NULL, entries, NULL), "error should be returned");
+    ASSERT_UINT_EQUAL(1, fake.writeCount, "no writes should happen after the error");
+}
+
+TEST("RegisterScript skips registers the shadow already holds") {
+    const OV5642RegisterEntry entries[] = {
+            {0x5001, 0xff},
+            {0x5580, 0x02},
+            {0x5583, 0x40},
+            {0x5584, 0x40},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    RegisterShadow *shadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    FakeWriter fake = {};
+    const RegisterScriptWriter writer = createFakeWriter(&fake);
+    RegisterScriptStats stats;
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, shadow, entries, &stats), "run should succeed");
+    ASSERT_UINT_EQUAL(3, stats.writeCount, "first run should write everything");
+    ASSERT_UINT_EQUAL(4, registerShadow_getSize(shadow), "shadow should hold every written register");
+
+    fake.writeCount = 0;
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, shadow, entries, &stats), "run should succeed");
+    ASSERT_UINT_EQUAL(0, fake.writeCount, "second run should write nothing");
+    ASSERT_UINT_EQUAL(4, stats.skippedCount, "every entry should be skipped");
+
+    const OV5642RegisterEntry reset[] = {
+            {0x3008, 0x80},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, shadow, reset, NULL), "reset should succeed");
+    ASSERT_UINT_EQUAL(0, registerShadow_getSize(shadow), "reset should clear the shadow");
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_run(&writer, shadow, reset, NULL), "reset should succeed");
+    ASSERT_UINT_EQUAL(2, fake.writeCount, "reset should never be skipped");
+    registerShadow_destroy(shadow);
+}
+
+TEST("RegisterScript delta keeps only changed registers") {
+    const OV5642RegisterEntry from[] = {
+            {0x3800, 0x01}, {0x3801, 0xa8}, {0x3808, 0x01}, {0x3809, 0x40},
+            {0x3801, 0xb0},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    const OV5642RegisterEntry to[] = {
+            {0x3800, 0x01}, {0x3801, 0xb0}, {0x3808, 0x02}, {0x3809, 0x40}, {0x380a, 0x01},
+            {0x3002, 0x0c}, {0x3002, 0x00}, // block reset pulse, must always be replayed
+            {0x5001, 0x7f}, {0x5001, 0x7f},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    OV5642RegisterEntry *delta = NULL;
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_createDelta(from, to, &delta), "delta should succeed");
+    ASSERT_UINT_EQUAL(5, registerScript_length(delta), "delta length was incorrect");
+    ASSERT_UINT_EQUAL(0x3808, delta[0].address, "changed register should be kept");
+    ASSERT_UINT_EQUAL(0x380a, delta[1].address, "register missing from the from table should be kept");
+    ASSERT_UINT_EQUAL(0x3002, delta[2].address, "sequenced register should be kept");
+    ASSERT_UINT_EQUAL(0x0c, delta[2].value, "sequenced register order was incorrect");
+    ASSERT_UINT_EQUAL(0x00, delta[3].value, "sequenced register order was incorrect");
+    ASSERT_UINT_EQUAL(0x5001, delta[4].address, "only the last repeated write should be kept");
+    free(delta);
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_createDelta(to, to, &delta), "delta should succeed");
+    ASSERT_UINT_EQUAL(2, registerScript_length(delta), "only the sequenced register should remain");
+    free(delta);
+}
+
+TEST("RegisterScript delta of a resetting table is the whole table") {
+    const OV5642RegisterEntry from[] = {
+            {0x3800, 0x01},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    const OV5642RegisterEntry to[] = {
+            {0x3008, 0x80}, {0x3800, 0x01},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    OV5642RegisterEntry *delta = NULL;
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_createDelta(from, to, &delta), "delta should succeed");
+    ASSERT_UINT_EQUAL(2, registerScript_length(delta), "delta should be the whole table");
+    free(delta);
+    ASSERT_INT_EQUAL(ERROR_NULL_ARGUMENT, registerScript_createDelta(from, NULL, &delta), "NULL should fail");
+}
+
+TEST("RegisterScript concat writes both tables in order") {
+    const OV5642RegisterEntry first[] = {
+            {0x3800, 0x01}, {0x3801, 0xb0},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    const OV5642RegisterEntry second[] = {
+            {0x3801, 0x50},
+            {OV5642_REGISTER_ADDRESS_END, OV5642_REGISTER_VALUE_END}
+    };
+    OV5642RegisterEntry *script = NULL;
+    ASSERT_INT_EQUAL(ERROR_NONE, registerScript_concat(first, second, &script), "concat should succeed");
+    ASSERT_UINT_EQUAL(3, registerScript_length(script), "script length was incorrect");
+    ASSERT_UINT_EQUAL(0x3800, script[0].address, "first table should come first");
+    ASSERT_UINT_EQUAL(0x50, script[2].value, "second table should come last");
+    ASSERT(registerScript_isEnd(&script[3]), "script should end with the end entry");
+    free(script);
+    ASSERT_INT_EQUAL(ERROR_NULL_ARGUMENT, registerScript_concat(first, NULL, &script), "NULL should fail");
+}
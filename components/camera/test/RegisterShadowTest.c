@@ -0,0 +1,82 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "RegisterShadow.h"
+
+#define TEST_TAG "[RegisterShadow]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+typedef struct {
+    uint16_t previousAddress;
+    uint count;
+    bool isSorted;
+} VisitResult;
+
+private void testVisitor(const uint16_t address, const uint8_t value, void *userArg) {
+    VisitResult *result = userArg;
+    if (result->count > 0 && address <= result->previousAddress) result->isSorted = false;
+    result->previousAddress = address;
+    result->count++;
+}
+
+TEST("RegisterShadow create") {
+    RegisterShadow *registerShadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    ASSERT_NOT_NULL(registerShadow, "RegisterShadow should not be NULL");
+    ASSERT_UINT_EQUAL(0, registerShadow_getSize(registerShadow), "size was incorrect");
+    registerShadow_destroy(registerShadow);
+
+    ASSERT_NULL(registerShadow_create(0), "RegisterShadow with 0 capacity should be NULL");
+}
+
+TEST("RegisterShadow set and get") {
+    RegisterShadow *registerShadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    uint8_t value = 0;
+    ASSERT_FALSE(registerShadow_get(registerShadow, 0x5001, &value), "unknown register should not be found");
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerShadow_set(registerShadow, 0x5001, 0x7f), "set should succeed");
+    ASSERT(registerShadow_get(registerShadow, 0x5001, &value), "register should be found");
+    ASSERT_UINT_EQUAL(0x7f, value, "value was incorrect");
+
+    ASSERT_INT_EQUAL(ERROR_NONE, registerShadow_set(registerShadow, 0x5001, 0xff), "set should succeed");
+    ASSERT(registerShadow_get(registerShadow, 0x5001, &value), "register should be found");
+    ASSERT_UINT_EQUAL(0xff, value, "value should be updated");
+    ASSERT_UINT_EQUAL(1, registerShadow_getSize(registerShadow), "updating should not grow the shadow");
+    registerShadow_destroy(registerShadow);
+}
+
+TEST("RegisterShadow isUnchanged") {
+    RegisterShadow *registerShadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    ASSERT_FALSE(registerShadow_isUnchanged(registerShadow, 0x5580, 0x02), "unknown register is never unchanged");
+    registerShadow_set(registerShadow, 0x5580, 0x02);
+    ASSERT(registerShadow_isUnchanged(registerShadow, 0x5580, 0x02), "same value should be unchanged");
+    ASSERT_FALSE(registerShadow_isUnchanged(registerShadow, 0x5580, 0x04), "different value should be changed");
+    ASSERT_FALSE(registerShadow_isUnchanged(NULL, 0x5580, 0x02), "NULL shadow is never unchanged");
+    registerShadow_destroy(registerShadow);
+}
+
+TEST("RegisterShadow full") {
+    RegisterShadow *registerShadow = registerShadow_create(2);
+    ASSERT_INT_EQUAL(ERROR_NONE, registerShadow_set(registerShadow, 0x3000, 1), "set should succeed");
+    ASSERT_INT_EQUAL(ERROR_NONE, registerShadow_set(registerShadow, 0x3001, 2), "set should succeed");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, registerShadow_set(registerShadow, 0x3002, 3), "set should fail when full");
+    ASSERT_FALSE(registerShadow_get(registerShadow, 0x3002, NULL), "register should stay unknown");
+    ASSERT_INT_EQUAL(ERROR_NONE, registerShadow_set(registerShadow, 0x3001, 4), "updating should succeed when full");
+    registerShadow_destroy(registerShadow);
+}
+
+TEST("RegisterShadow clear and forEach") {
+    RegisterShadow *registerShadow = registerShadow_create(REGISTER_SHADOW_DEFAULT_CAPACITY);
+    const uint16_t addresses[] = {0x5588, 0x3008, 0x4407, 0x3000, 0x5001};
+    for (int i = 0; i < 5; i++) {
+        registerShadow_set(registerShadow, addresses[i], (uint8_t) i);
+    }
+    VisitResult result = {.isSorted = true};
+    registerShadow_forEach(registerShadow, testVisitor, &result);
+    ASSERT_UINT_EQUAL(5, result.count, "every register should be visited");
+    ASSERT(result.isSorted, "registers should be visited in address order");
+
+    registerShadow_clear(registerShadow);
+    ASSERT_UINT_EQUAL(0, registerShadow_getSize(registerShadow), "size should be 0 after clear");
+    ASSERT_FALSE(registerShadow_get(registerShadow, 0x4407, NULL), "register should be unknown after clear");
+    registerShadow_destroy(registerShadow);
+}
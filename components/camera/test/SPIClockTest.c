@@ -0,0 +1,69 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "SPIClock.h"
+
+#define TEST_TAG "[SPIClock]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_MARGIN_PERCENT 20
+
+private const uint32_t TEST_CLOCKS_HZ[] = {8000000, 10000000, 13333333, 16000000, 20000000, 26666666, 40000000};
+#define TEST_CLOCK_COUNT (sizeof(TEST_CLOCKS_HZ) / sizeof(TEST_CLOCKS_HZ[0]))
+
+/** Steps at every test clock, the first passedCount of them passed */
+private void createSteps(CameraSPIClockStep *steps, const uint passedCount) {
+    for (uint i = 0; i < TEST_CLOCK_COUNT; i++) {
+        steps[i] = (CameraSPIClockStep) {
+                .clockHz = TEST_CLOCKS_HZ[i],
+                .isRegisterOk = i < passedCount,
+                .isFrameOk = i < passedCount
+        };
+    }
+}
+
+TEST("SPIClock keeps a clock a margin below the fastest reliable one") {
+    CameraSPIClockStep steps[TEST_CLOCK_COUNT];
+    uint32_t fastestHz = 0, clockHz = 0;
+    createSteps(steps, 6);
+    ASSERT_INT_EQUAL(ERROR_NONE, spiClock_choose(steps, TEST_CLOCK_COUNT, TEST_MARGIN_PERCENT, &fastestHz, &clockHz),
+                     "choose should succeed");
+    ASSERT_UINT_EQUAL(26666666, fastestHz, "the fastest reliable clock was incorrect");
+    ASSERT_UINT_EQUAL(20000000, clockHz, "the clock kept should be below the fastest by the margin");
+
+    createSteps(steps, TEST_CLOCK_COUNT);
+    spiClock_choose(steps, TEST_CLOCK_COUNT, TEST_MARGIN_PERCENT, &fastestHz, &clockHz);
+    ASSERT_UINT_EQUAL(26666666, clockHz, "40 MHz passing should keep the next clock down");
+}
+
+TEST("SPIClock only trusts a clock when every slower clock passed") {
+    CameraSPIClockStep steps[TEST_CLOCK_COUNT];
+    uint32_t fastestHz = 0, clockHz = 0;
+    createSteps(steps, TEST_CLOCK_COUNT);
+    steps[2].isFrameOk = false;
+    spiClock_choose(steps, TEST_CLOCK_COUNT, TEST_MARGIN_PERCENT, &fastestHz, &clockHz);
+    ASSERT_UINT_EQUAL(10000000, fastestHz, "a failure should cap the fastest reliable clock");
+    ASSERT_UINT_EQUAL(8000000, clockHz, "the clock kept was incorrect");
+
+    createSteps(steps, 1);
+    spiClock_choose(steps, TEST_CLOCK_COUNT, TEST_MARGIN_PERCENT, &fastestHz, &clockHz);
+    ASSERT_UINT_EQUAL(8000000, clockHz, "only the slowest passing should keep the slowest");
+
+    createSteps(steps, 0);
+    ASSERT_INT_EQUAL(ERROR_NOT_FOUND, spiClock_choose(steps, TEST_CLOCK_COUNT, TEST_MARGIN_PERCENT, &fastestHz,
+                                                      &clockHz), "nothing passing should choose nothing");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, spiClock_choose(steps, TEST_CLOCK_COUNT, 100, &fastestHz, &clockHz),
+                     "a margin of 100%% should fail");
+}
+
+TEST("SPIClock checksums a frame the same in any chunks") {
+    const uint8_t frame[] = {0xFF, 0xD8, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xFF, 0xD9};
+    const uint32_t whole = spiClock_checksum(SPI_CLOCK_CHECKSUM_SEED, frame, sizeof(frame));
+    uint32_t chunked = spiClock_checksum(SPI_CLOCK_CHECKSUM_SEED, frame, 4);
+    chunked = spiClock_checksum(chunked, frame + 4, sizeof(frame) - 4);
+    ASSERT_UINT_EQUAL(whole, chunked, "chunked checksum should match the whole");
+    uint8_t corrupt[sizeof(frame)];
+    memcpy(corrupt, frame, sizeof(frame));
+    corrupt[4] ^= 0x01;
+    ASSERT(whole != spiClock_checksum(SPI_CLOCK_CHECKSUM_SEED, corrupt, sizeof(corrupt)), "a flipped bit should show");
+}
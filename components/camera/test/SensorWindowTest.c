@@ -0,0 +1,100 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "SensorWindow.h"
+#include "RegisterScript.h"
+
+#define TEST_TAG "[SensorWindow]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+private const CameraRegion WHOLE_ARRAY = {.x = 0, .y = 0, .width = CAMERA_SENSOR_WIDTH, .height = CAMERA_SENSOR_HEIGHT};
+
+private uint16_t registerValue(const OV5642RegisterEntry *entries, const uint16_t address) {
+    for (const OV5642RegisterEntry *entry = entries; !registerScript_isEnd(entry); entry++) {
+        if (entry->address == address) return (entry[0].value << 8) | entry[1].value;
+    }
+    return 0xFFFF;
+}
+
+TEST("SensorWindow whole array matches the image size tables") {
+    OV5642RegisterEntry entries[SENSOR_WINDOW_MAX_ENTRIES];
+    CameraRegion window;
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_fit(&WHOLE_ARRAY, CAMERA_IMAGE_SIZE_1280x960, &window),
+                     "fit should succeed");
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_compile(&window, true, true, entries), "compile should succeed");
+    ASSERT_UINT_EQUAL(SENSOR_WINDOW_REGISTER_COUNT, registerScript_length(entries), "entry count was incorrect");
+    ASSERT_UINT_EQUAL(0x1B0, registerValue(entries, 0x3800), "horizontal start was incorrect");
+    ASSERT_UINT_EQUAL(0x00A, registerValue(entries, 0x3802), "vertical start was incorrect");
+    ASSERT_UINT_EQUAL(CAMERA_SENSOR_WIDTH, registerValue(entries, 0x3804), "width was incorrect");
+    ASSERT_UINT_EQUAL(CAMERA_SENSOR_HEIGHT, registerValue(entries, 0x3806), "height was incorrect");
+    ASSERT_UINT_EQUAL(CAMERA_SENSOR_WIDTH, registerValue(entries, 0x5682), "ISP width was incorrect");
+    ASSERT_UINT_EQUAL(CAMERA_SENSOR_HEIGHT, registerValue(entries, 0x5686), "ISP height was incorrect");
+    for (int i = 1; i < SENSOR_WINDOW_REGISTER_COUNT; i++) {
+        ASSERT(entries[i].address > entries[i - 1].address, "entries should be in ascending address order");
+    }
+}
+
+TEST("SensorWindow fit keeps the aspect ratio and output size") {
+    CameraRegion window;
+    const CameraRegion wide = {.x = 1000, .y = 900, .width = 800, .height = 100};
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_fit(&wide, CAMERA_IMAGE_SIZE_320x240, &window), "fit should succeed");
+    ASSERT_UINT_EQUAL(800, window.width, "width was incorrect");
+    ASSERT_UINT_EQUAL(600, window.height, "a wide region should grow taller");
+    ASSERT_UINT_EQUAL(1000, window.x, "window should stay centred");
+    ASSERT_UINT_EQUAL(650, window.y, "window should grow around the centre");
+
+    const CameraRegion small = {.x = 100, .y = 100, .width = 64, .height = 48};
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_fit(&small, CAMERA_IMAGE_SIZE_640x480, &window), "fit should succeed");
+    ASSERT_UINT_EQUAL(640, window.width, "window should not be smaller than the output");
+    ASSERT_UINT_EQUAL(480, window.height, "window should not be smaller than the output");
+    ASSERT_UINT_EQUAL(0, window.x, "window should be moved inside the array");
+    ASSERT_UINT_EQUAL(0, window.y, "window should be moved inside the array");
+
+    const CameraRegion corner = {.x = 2500, .y = 1900, .width = 92, .height = 44};
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_fit(&corner, CAMERA_IMAGE_SIZE_320x240, &window), "fit should succeed");
+    ASSERT_UINT_EQUAL(CAMERA_SENSOR_WIDTH, window.x + window.width, "window should end at the array's edge");
+    ASSERT_UINT_EQUAL(CAMERA_SENSOR_HEIGHT, window.y + window.height, "window should end at the array's edge");
+    ASSERT(window.x % 2 == 0 && window.y % 2 == 0, "window should be even aligned");
+
+    const CameraRegion outside = {.x = 2000, .y = 0, .width = 800, .height = 600};
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, sensorWindow_fit(&outside, CAMERA_IMAGE_SIZE_320x240, &window),
+                     "a region outside the array should be rejected");
+    const CameraRegion empty = {.x = 0, .y = 0, .width = 0, .height = 0};
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, sensorWindow_fit(&empty, CAMERA_IMAGE_SIZE_320x240, &window),
+                     "an empty region should be rejected");
+}
+
+TEST("SensorWindow compile mirrors and flips into array coordinates") {
+    OV5642RegisterEntry entries[SENSOR_WINDOW_MAX_ENTRIES];
+    const CameraRegion window = {.x = 100, .y = 200, .width = 640, .height = 480};
+    sensorWindow_compile(&window, false, false, entries);
+    ASSERT_UINT_EQUAL(0x1B0 + 100, registerValue(entries, 0x3800), "unmirrored start was incorrect");
+    ASSERT_UINT_EQUAL(0x00A + 200, registerValue(entries, 0x3802), "unflipped start was incorrect");
+    sensorWindow_compile(&window, true, true, entries);
+    ASSERT_UINT_EQUAL(0x1B0 + CAMERA_SENSOR_WIDTH - 740, registerValue(entries, 0x3800),
+                      "mirrored start was incorrect");
+    ASSERT_UINT_EQUAL(0x00A + CAMERA_SENSOR_HEIGHT - 680, registerValue(entries, 0x3802),
+                      "flipped start was incorrect");
+}
+
+TEST("SensorWindow zoom") {
+    CameraRegion region;
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_fromZoom(0.5F, 0.5F, 1.0F, &region), "zoom should succeed");
+    ASSERT(region.x == 0 && region.y == 0 && region.width == CAMERA_SENSOR_WIDTH &&
+           region.height == CAMERA_SENSOR_HEIGHT, "a zoom of 1 should be the whole array");
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_fromZoom(0.5F, 0.5F, 2.0F, &region), "zoom should succeed");
+    ASSERT_UINT_EQUAL(1296, region.width, "width was incorrect");
+    ASSERT_UINT_EQUAL(972, region.height, "height was incorrect");
+    ASSERT_UINT_EQUAL(648, region.x, "x was incorrect");
+    ASSERT_UINT_EQUAL(486, region.y, "y was incorrect");
+    ASSERT_INT_EQUAL(ERROR_NONE, sensorWindow_fromZoom(0.0F, 1.0F, 4.0F, &region), "zoom should succeed");
+    ASSERT_UINT_EQUAL(0, region.x, "a centre at the edge should move the region inside the array");
+    ASSERT_UINT_EQUAL(CAMERA_SENSOR_HEIGHT, region.y + region.height, "a centre at the edge should move the region");
+    ASSERT(sensorWindow_isValidRegion(&region), "zoomed region should be valid");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, sensorWindow_fromZoom(0.5F, 0.5F, 0.5F, &region),
+                     "a zoom below 1 should be rejected");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, sensorWindow_fromZoom(0.5F, 0.5F, SENSOR_WINDOW_MAX_ZOOM + 1.0F, &region),
+                     "a zoom past the smallest output should be rejected");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, sensorWindow_fromZoom(1.5F, 0.5F, 2.0F, &region),
+                     "a centre outside the image should be rejected");
+}
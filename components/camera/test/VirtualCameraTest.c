@@ -0,0 +1,239 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "VirtualCamera.h"
+#include "OV5642.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_TAG "[VirtualCamera]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+#define TEST_CAPTURE_MICROS 1000
+/** Where the recordings test writes its frames, the test is skipped where it can't be created */
+#define TEST_RECORDINGS_PATH P_tmpdir "/VirtualCameraTest"
+
+private const uint8_t TEST_FRAME_1[] = {0xFF, 0xD8, 0x01, 0x02, 0x03, 0xFF, 0xD9};
+private const uint8_t TEST_FRAME_2[] = {0xFF, 0xD8, 0x04, 0x05, 0xFF, 0xD9};
+
+/** Time only moves when a test moves it */
+private uint64_t testClock(void *context) {
+    return *(uint64_t *) context;
+}
+
+private VirtualCamera *createTestCamera(uint64_t *now, const uint32_t framePaddingBytes) {
+    const VirtualCameraOptions options = {
+            .captureMicros = TEST_CAPTURE_MICROS,
+            .framePaddingBytes = framePaddingBytes,
+            .clock = testClock,
+            .clockContext = now,
+    };
+    VirtualCamera *virtualCamera = virtualCamera_create(&options);
+    virtualCamera_addFrame(virtualCamera, TEST_FRAME_1, sizeof(TEST_FRAME_1));
+    virtualCamera_addFrame(virtualCamera, TEST_FRAME_2, sizeof(TEST_FRAME_2));
+    return virtualCamera;
+}
+
+private uint8_t readRegister(VirtualCamera *virtualCamera, const uint8_t address) {
+    uint8_t value = 0;
+    virtualCamera_spiTransfer(virtualCamera, address, NULL, 0, &value, sizeof(value));
+    return value;
+}
+
+private void writeRegister(VirtualCamera *virtualCamera, const uint8_t address, const uint8_t value) {
+    virtualCamera_spiTransfer(virtualCamera, address | VIRTUAL_CAMERA_SPI_WRITE, &value, sizeof(value), NULL, 0);
+}
+
+private uint32_t readFIFOSize(VirtualCamera *virtualCamera) {
+    return readRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_LOW) |
+           (readRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_MIDDLE) << 8) |
+           ((readRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_SIZE_HIGH) & 0x7F) << 16);
+}
+
+private bool isDone(VirtualCamera *virtualCamera) {
+    return readRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_STATUS) & VIRTUAL_CAMERA_STATUS_DONE;
+}
+
+private void startCapture(VirtualCamera *virtualCamera) {
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL, VIRTUAL_CAMERA_FIFO_CLEAR_DONE_FLAG);
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL, VIRTUAL_CAMERA_FIFO_START_CAPTURE);
+}
+
+TEST("VirtualCamera test and version registers") {
+    uint64_t now = 0;
+    VirtualCamera *virtualCamera = createTestCamera(&now, 0);
+    ASSERT_NOT_NULL(virtualCamera, "VirtualCamera should not be NULL");
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_TEST, 0x69);
+    ASSERT_UINT_EQUAL(0x69, readRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_TEST), "test register was incorrect");
+    ASSERT_UINT_EQUAL(VIRTUAL_CAMERA_ARDUCHIP_VERSION, readRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_VERSION),
+                      "version was incorrect");
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_VERSION, 0x00);
+    ASSERT_UINT_EQUAL(VIRTUAL_CAMERA_ARDUCHIP_VERSION, readRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_VERSION),
+                      "version should be read only");
+    virtualCamera_destroy(virtualCamera);
+}
+
+TEST("VirtualCamera sensor chip ID and software reset") {
+    uint64_t now = 0;
+    VirtualCamera *virtualCamera = createTestCamera(&now, 0);
+    uint8_t chipId[2] = {0};
+    ASSERT_INT_EQUAL(ERROR_NONE, virtualCamera_i2cRead(virtualCamera, OV5642_I2C_REGISTER_CHIP_ID_HIGH, chipId, 2),
+                     "chip ID read failed");
+    ASSERT_UINT_EQUAL(OV5642_I2C_CHIP_ID_HIGH, chipId[0], "chip ID high was incorrect");
+    ASSERT_UINT_EQUAL(OV5642_I2C_CHIP_ID_LOW, chipId[1], "chip ID low was incorrect");
+
+    const uint8_t values[] = {0x11, 0x22, 0x33};
+    virtualCamera_i2cWrite(virtualCamera, 0x5000, values, sizeof(values));
+    ASSERT_UINT_EQUAL(0x33, virtualCamera_getSensorRegister(virtualCamera, 0x5002), "writes should auto-increment");
+    VirtualCameraStats stats;
+    virtualCamera_getStats(virtualCamera, &stats);
+    ASSERT_UINT_EQUAL(1, stats.i2cWrites, "i2c writes was incorrect");
+    ASSERT_UINT_EQUAL(3, stats.i2cRegistersWritten, "i2c registers written was incorrect");
+
+    const uint8_t reset = 0x80;
+    virtualCamera_i2cWrite(virtualCamera, 0x3008, &reset, sizeof(reset));
+    ASSERT_UINT_EQUAL(0x00, virtualCamera_getSensorRegister(virtualCamera, 0x5002), "reset should clear registers");
+    ASSERT_UINT_EQUAL(OV5642_I2C_CHIP_ID_HIGH, virtualCamera_getSensorRegister(virtualCamera,
+                                                                              OV5642_I2C_REGISTER_CHIP_ID_HIGH),
+                      "reset should keep the chip ID");
+    ASSERT_INT_EQUAL(ERROR_OUT_OF_BOUNDS, virtualCamera_i2cWrite(virtualCamera, 0xFFFF, values, sizeof(values)),
+                     "writing past the last register should fail");
+    virtualCamera_destroy(virtualCamera);
+}
+
+TEST("VirtualCamera capture waits for the capture latency") {
+    uint64_t now = 0;
+    VirtualCamera *virtualCamera = createTestCamera(&now, 0);
+    startCapture(virtualCamera);
+    now = TEST_CAPTURE_MICROS - 1;
+    ASSERT_FALSE(isDone(virtualCamera), "capture should not be done before the latency");
+    ASSERT_UINT_EQUAL(0, readFIFOSize(virtualCamera), "FIFO should be empty before the capture is done");
+    now = TEST_CAPTURE_MICROS;
+    ASSERT(isDone(virtualCamera), "capture should be done after the latency");
+    ASSERT_UINT_EQUAL(sizeof(TEST_FRAME_1), readFIFOSize(virtualCamera), "FIFO size was incorrect");
+
+    uint8_t buffer[sizeof(TEST_FRAME_1) + 2];
+    memset(buffer, 0xAA, sizeof(buffer));
+    virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_BURST_READ, NULL, 0, buffer, sizeof(buffer));
+    ASSERT(memcmp(buffer, TEST_FRAME_1, sizeof(TEST_FRAME_1)) == 0, "burst read should return the frame");
+    ASSERT_UINT_EQUAL(0x00, buffer[sizeof(TEST_FRAME_1)], "reading past the end should return 0x00");
+
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL, VIRTUAL_CAMERA_FIFO_CLEAR_DONE_FLAG);
+    ASSERT_FALSE(isDone(virtualCamera), "done flag should be cleared");
+    virtualCamera_destroy(virtualCamera);
+}
+
+TEST("VirtualCamera frames loop in order") {
+    uint64_t now = 0;
+    VirtualCamera *virtualCamera = createTestCamera(&now, 0);
+    const size_t expectedSizes[] = {sizeof(TEST_FRAME_1), sizeof(TEST_FRAME_2), sizeof(TEST_FRAME_1)};
+    for (int i = 0; i < 3; i++) {
+        startCapture(virtualCamera);
+        now += TEST_CAPTURE_MICROS;
+        ASSERT(isDone(virtualCamera), "capture %i should be done", i);
+        ASSERT_UINT_EQUAL(expectedSizes[i], readFIFOSize(virtualCamera), "FIFO size of capture %i was incorrect", i);
+    }
+    VirtualCameraStats stats;
+    virtualCamera_getStats(virtualCamera, &stats);
+    ASSERT_UINT_EQUAL(3, stats.capturesStarted, "captures started was incorrect");
+    ASSERT_UINT_EQUAL(3, stats.framesCaptured, "frames captured was incorrect");
+    virtualCamera_destroy(virtualCamera);
+}
+
+TEST("VirtualCamera multi-frame capture with padding") {
+    uint64_t now = 0;
+    VirtualCamera *virtualCamera = createTestCamera(&now, 4);
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FRAME_COUNT, 1); // 2 frames
+    startCapture(virtualCamera);
+    now = TEST_CAPTURE_MICROS;
+    ASSERT_FALSE(isDone(virtualCamera), "2 frames should take twice the latency");
+    now = 2 * TEST_CAPTURE_MICROS;
+    ASSERT(isDone(virtualCamera), "2 frames should be done");
+    const uint32_t expectedSize = sizeof(TEST_FRAME_1) + sizeof(TEST_FRAME_2) + 8;
+    ASSERT_UINT_EQUAL(expectedSize, readFIFOSize(virtualCamera), "FIFO size was incorrect");
+
+    uint8_t buffer[sizeof(TEST_FRAME_1) + sizeof(TEST_FRAME_2) + 8];
+    uint8_t byte = 0;
+    virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_SINGLE_READ, NULL, 0, &byte, 1);
+    ASSERT_UINT_EQUAL(0xFF, byte, "single read was incorrect");
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FIFO_CONTROL, VIRTUAL_CAMERA_FIFO_RESET_READ);
+    virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_BURST_READ, NULL, 0, buffer, sizeof(buffer));
+    const uint8_t *second = buffer + sizeof(TEST_FRAME_1) + 4;
+    ASSERT_UINT_EQUAL(0x00, buffer[sizeof(TEST_FRAME_1)], "padding should follow the first frame");
+    ASSERT(memcmp(second, TEST_FRAME_2, sizeof(TEST_FRAME_2)) == 0, "second frame should follow the padding");
+    virtualCamera_destroy(virtualCamera);
+}
+
+TEST("VirtualCamera loading frames from a missing directory") {
+    uint64_t now = 0;
+    VirtualCamera *virtualCamera = createTestCamera(&now, 0);
+    ASSERT_INT_EQUAL(ERROR_NOT_FOUND, virtualCamera_loadFrames(virtualCamera, "/does/not/exist"),
+                     "a missing directory should not be found");
+    ASSERT_UINT_EQUAL(2, virtualCamera_getFrameCount(virtualCamera), "frame count should be unchanged");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, virtualCamera_addFrame(virtualCamera, TEST_FRAME_1, 0),
+                     "an empty frame should be rejected");
+    virtualCamera_destroy(virtualCamera);
+}
+
+private bool writeRecording(const char *name, const uint8_t *data, const size_t length) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", TEST_RECORDINGS_PATH, name);
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    const bool isWritten = fwrite(data, 1, length, file) == length;
+    fclose(file);
+    return isWritten;
+}
+
+private void removeRecording(const char *name) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", TEST_RECORDINGS_PATH, name);
+    remove(path);
+}
+
+TEST("VirtualCamera streams recordings loaded by the first capture") {
+    mkdir(TEST_RECORDINGS_PATH, 0755);
+    if (!writeRecording("2.jpg", TEST_FRAME_2, sizeof(TEST_FRAME_2)) ||
+        !writeRecording("1.jpg", TEST_FRAME_1, sizeof(TEST_FRAME_1))) {
+        printf("Could not write recordings to %s, skipping test\n", TEST_RECORDINGS_PATH);
+        return;
+    }
+    uint64_t now = 0;
+    const VirtualCameraOptions options = {
+            .captureMicros = TEST_CAPTURE_MICROS,
+            .framePaddingBytes = 2,
+            .clock = testClock,
+            .clockContext = &now,
+            .framesPath = TEST_RECORDINGS_PATH,
+    };
+    VirtualCamera *virtualCamera = virtualCamera_create(&options);
+    ASSERT_UINT_EQUAL(0, virtualCamera_getFrameCount(virtualCamera), "frames should wait for the first capture");
+    writeRegister(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_FRAME_COUNT, 2); // 3 frames, the first again last
+    startCapture(virtualCamera);
+    ASSERT_UINT_EQUAL(2, virtualCamera_getFrameCount(virtualCamera), "the capture should load the recordings");
+    now = 3 * TEST_CAPTURE_MICROS;
+    const size_t expectedSize = 2 * sizeof(TEST_FRAME_1) + sizeof(TEST_FRAME_2) + 3 * 2;
+    ASSERT_UINT_EQUAL(expectedSize, readFIFOSize(virtualCamera), "FIFO size was incorrect");
+
+    // read in chunks that straddle the frames and their padding, as the DMA reader does
+    uint8_t buffer[2 * sizeof(TEST_FRAME_1) + sizeof(TEST_FRAME_2) + 3 * 2 + 3];
+    memset(buffer, 0xAA, sizeof(buffer));
+    for (size_t offset = 0; offset < sizeof(buffer); offset += 5) {
+        const size_t length = sizeof(buffer) - offset < 5 ? sizeof(buffer) - offset : 5;
+        virtualCamera_spiTransfer(virtualCamera, VIRTUAL_CAMERA_SPI_REGISTER_BURST_READ, NULL, 0,
+                                  buffer + offset, length);
+    }
+    const uint8_t *second = buffer + sizeof(TEST_FRAME_1) + 2;
+    const uint8_t *third = second + sizeof(TEST_FRAME_2) + 2;
+    ASSERT(memcmp(buffer, TEST_FRAME_1, sizeof(TEST_FRAME_1)) == 0, "frames should be in name order");
+    ASSERT_UINT_EQUAL(0x00, buffer[sizeof(TEST_FRAME_1) + 1], "padding should follow the first frame");
+    ASSERT(memcmp(second, TEST_FRAME_2, sizeof(TEST_FRAME_2)) == 0, "second frame should follow the padding");
+    ASSERT(memcmp(third, TEST_FRAME_1, sizeof(TEST_FRAME_1)) == 0, "frames should loop around");
+    ASSERT_UINT_EQUAL(0x00, buffer[sizeof(buffer) - 1], "reading past the end should return 0x00");
+    virtualCamera_destroy(virtualCamera);
+    removeRecording("1.jpg");
+    removeRecording("2.jpg");
+    rmdir(TEST_RECORDINGS_PATH);
+}
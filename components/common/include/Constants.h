@@ -16,4 +16,18 @@
 //  a way to reduce overall binary size when disabled if needed at the cost of less clear error messages
 #define CONFIG_USE_ERROR_TO_STRING 1
 
+// 1 to run the camera against VirtualCamera instead of the Arducam on the SPI and I2C buses, frames are the
+//  recorded JPEGs in CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH, each taking CONFIG_CAMERA_VIRTUAL_DEVICE_CAPTURE_MICROS
+//  to capture, for running and benchmarking the capture code on a board with no camera attached
+#define CONFIG_CAMERA_VIRTUAL_DEVICE 0
+#ifndef CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH // the host tests point it at their own recordings
+#define CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH "/sd/frames"
+#endif
+#define CONFIG_CAMERA_VIRTUAL_DEVICE_CAPTURE_MICROS 66000
+
+// Current the board draws with the camera capturing and with the sensor in standby and the CPU idle, in milliamps,
+//  there is no current sensor so each timelapse shot's charge is estimated from how long it spent in each
+#define CONFIG_TIMELAPSE_ACTIVE_MILLIAMPS 240
+#define CONFIG_TIMELAPSE_STANDBY_MILLIAMPS 45
+
 #endif //ESP32_REMOTECAMERA_CONSTANTS_H
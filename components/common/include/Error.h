@@ -7,7 +7,7 @@ typedef enum {
     /* General/Common Errors =================================================================== */
     ERROR_NONE = 0,
     ERROR_UNKNOWN = -1,
-    ERROR_ILLEGAL_ARGUMENT,
+    ERROR_ILLEGAL_ARGUMENT = 1,
     ERROR_ILLEGAL_STATE,
     ERROR_NULL_ARGUMENT,
     ERROR_NOT_FOUND,
@@ -63,8 +63,10 @@ __FILENAME__, "%s:%d "message, __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__
 #endif
 
 #define throw(error, message, ...) \
-ERROR(message, ##__VA_ARGS__);   \
-return error
+do{                                \
+ERROR(message, ##__VA_ARGS__);     \
+return error;                      \
+}while(0)
 
 #define throwIfError(func, message, ...) \
 do{                                      \
@@ -184,6 +184,51 @@ public SettingsError settings_getUInt32(const SettingsKey *key,
     return SETTINGS_ERROR_NONE;
 }
 
+public SettingsError settings_putBlob(const SettingsKey *key, const void *value, const size_t length) {
+    requireNotNull(key, SETTINGS_ERROR_INVALID_PARAMETER, "key cannot be a NULL pointer");
+    requireNotNull(value, SETTINGS_ERROR_INVALID_PARAMETER, "value cannot be a NULL pointer");
+    esp_err_t err = nvs_set_blob(nvsDefaultHandle, key, value, length);
+    if (err == ESP_ERR_NVS_INVALID_HANDLE) {
+        throw(SETTINGS_ERROR_NVS_CLOSED, "NVS handled is closed");
+    } else if (err == ESP_ERR_NVS_INVALID_NAME) {
+        throw(SETTINGS_ERROR_INVALID_KEY,
+              "Key: %s doesn't satisfy key name constraints, should be %i chars long (including terminator)",
+              key, NVS_KEY_NAME_MAX_SIZE);
+    } else if (err == ESP_ERR_NVS_NOT_ENOUGH_SPACE) {
+        throw(SETTINGS_ERROR_NOT_ENOUGH_SPACE, "Not enough space in NVS to save key: %s, length: %u",
+              key, length);
+    } else if (err == ESP_ERR_NVS_VALUE_TOO_LONG) {
+        throw(SETTINGS_ERROR_INVALID_VALUE, "Value too long, length: %u", length);
+    } else if (err != ESP_OK) {
+        throw(SETTINGS_ERROR_GENERIC_FAILURE, "nvs_set_blob() returned %s", esp_err_to_name(err));
+    }
+    err = nvs_commit(nvsDefaultHandle);
+    if (err != ESP_OK) {
+        throw(SETTINGS_ERROR_GENERIC_FAILURE, "nvs_commit() returned %s", esp_err_to_name(err));
+    }
+    return SETTINGS_ERROR_NONE;
+}
+
+public SettingsError settings_getBlob(const SettingsKey *key, void *value, size_t *length) {
+    requireNotNull(key, SETTINGS_ERROR_INVALID_PARAMETER, "key cannot be a NULL pointer");
+    requireNotNull(length, SETTINGS_ERROR_INVALID_PARAMETER, "length cannot be a NULL pointer");
+    esp_err_t err = nvs_get_blob(nvsDefaultHandle, key, value, length);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        throw(SETTINGS_ERROR_KEY_NOT_FOUND, "Key %s does not exist", key);
+    } else if (err == ESP_ERR_NVS_INVALID_HANDLE) {
+        throw(SETTINGS_ERROR_NVS_CLOSED, "NVS handle is closed");
+    } else if (err == ESP_ERR_NVS_INVALID_NAME) {
+        throw(SETTINGS_ERROR_INVALID_KEY,
+              "Key: %s doesn't satisfy key name constraints, should be %i chars long (including terminator)",
+              key, NVS_KEY_NAME_MAX_SIZE);
+    } else if (err == ESP_ERR_NVS_INVALID_LENGTH) {
+        throw(SETTINGS_ERROR_INVALID_LENGTH, "Blob at key %s is longer than the given length: %u", key, *length);
+    } else if (err != ESP_OK) {
+        throw(SETTINGS_ERROR_GENERIC_FAILURE, "nvs_get_blob() returned %s", esp_err_to_name(err));
+    }
+    return SETTINGS_ERROR_NONE;
+}
+
 public SettingsError settings_deleteKey(const SettingsKey *key) {
     requireNotNull(key, SETTINGS_ERROR_INVALID_PARAMETER, "key cannot be a NULL pointer");
     esp_err_t err = nvs_erase_key(nvsDefaultHandle, key);
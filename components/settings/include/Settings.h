@@ -8,6 +8,10 @@
 #define SETTINGS_KEY_WIFI_SSID "wifissid"
 #define SETTINGS_KEY_WIFI_PASSWORD "wifipassword"
 #define SETTINGS_KEY_WIFI_IP_ADDRESS "wifiipaddress"
+#define SETTINGS_KEY_CAMERA_REGISTER_IMAGE "camregimage"
+#define SETTINGS_KEY_CAMERA_SPI_CLOCK "camspiclock"
+#define SETTINGS_KEY_TIMELAPSE_SCHEDULE "tlschedule"
+#define SETTINGS_KEY_TIMELAPSE_SEQUENCE "tlsequence"
 
 typedef char SettingsKey;
 
@@ -42,6 +46,13 @@ extern SettingsError settings_putUInt32(const SettingsKey *key, const uint32_t v
 
 extern SettingsError settings_getUInt32(const SettingsKey *key, uint32_t *value);
 
+/** Puts length bytes of value at key, updating it if it exists and creating it if it doesn't */
+extern SettingsError settings_putBlob(const SettingsKey *key, const void *value, const size_t length);
+
+/** Reads the blob at key into value which must hold *length bytes, *length receives the blob's length,
+ * pass a NULL value to only get the length */
+extern SettingsError settings_getBlob(const SettingsKey *key, void *value, size_t *length);
+
 extern SettingsError settings_deleteKey(const SettingsKey *key);
 
 extern SettingsError settings_hasKey(const SettingsKey *key, bool *hasKey);
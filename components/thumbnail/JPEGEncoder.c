@@ -0,0 +1,379 @@
+#include "JPEGEncoder.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JPEG_MARKER_PREFIX 0xFF
+#define JPEG_MARKER_SOF0 0xC0
+#define JPEG_MARKER_DHT 0xC4
+#define JPEG_MARKER_SOI 0xD8
+#define JPEG_MARKER_EOI 0xD9
+#define JPEG_MARKER_SOS 0xDA
+#define JPEG_MARKER_DQT 0xDB
+#define JPEG_MARKER_APP0 0xE0
+#define JPEG_STUFFED_ZERO 0x00
+
+#define JPEG_BLOCK_SIZE 8
+#define JPEG_BLOCK_COEFFICIENTS 64
+#define JPEG_MAX_CODE_LENGTH 16
+/** 16x16 luma samples, 4 luma blocks then one of each chroma */
+#define JPEG_MCU_SIZE 16
+#define JPEG_SYMBOL_ZRL 0xF0
+#define JPEG_SYMBOL_EOB 0x00
+#define JPEG_ENCODER_BUFFER_SIZE 512
+
+/** The standard tables of Annex K, quantization tables in zigzag order */
+private const uint8_t LUMA_QUANT_TABLE[JPEG_BLOCK_COEFFICIENTS] = {
+         16,  11,  12,  14,  12,  10,  16,  14,  13,  14,  18,  17,  16,  19,  24,  40,
+         26,  24,  22,  22,  24,  49,  35,  37,  29,  40,  58,  51,  61,  60,  57,  51,
+         56,  55,  64,  72,  92,  78,  64,  68,  87,  69,  55,  56,  80, 109,  81,  87,
+         95,  98, 103, 104, 103,  62,  77, 113, 121, 112, 100, 120,  92, 101, 103,  99,
+};
+
+private const uint8_t CHROMA_QUANT_TABLE[JPEG_BLOCK_COEFFICIENTS] = {
+        17, 18, 18, 24, 21, 24, 47, 26, 26, 47, 99, 66, 56, 66, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+private const uint8_t LUMA_DC_BITS[JPEG_MAX_CODE_LENGTH] = {
+        0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+};
+
+private const uint8_t LUMA_DC_VALUES[] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+};
+
+private const uint8_t LUMA_AC_BITS[JPEG_MAX_CODE_LENGTH] = {
+        0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 125,
+};
+
+private const uint8_t LUMA_AC_VALUES[] = {
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+        0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08,
+        0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72,
+        0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45,
+        0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+        0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75,
+        0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+        0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3,
+        0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6,
+        0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9,
+        0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+        0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4,
+        0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA,
+};
+
+private const uint8_t CHROMA_DC_BITS[JPEG_MAX_CODE_LENGTH] = {
+        0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+};
+
+private const uint8_t CHROMA_DC_VALUES[] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+};
+
+private const uint8_t CHROMA_AC_BITS[JPEG_MAX_CODE_LENGTH] = {
+        0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 119,
+};
+
+private const uint8_t CHROMA_AC_VALUES[] = {
+        0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+        0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+        0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15, 0x62, 0x72, 0xD1,
+        0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+        0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44,
+        0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+        0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74,
+        0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+        0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A,
+        0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4,
+        0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+        0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+        0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4,
+        0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA,
+};
+
+private const uint8_t ZIGZAG_TO_NATURAL[JPEG_BLOCK_COEFFICIENTS] = {
+         0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+typedef enum JPEGEncoderTable {
+    JPEG_ENCODER_TABLE_LUMA = 0,
+    JPEG_ENCODER_TABLE_CHROMA = 1,
+    JPEG_ENCODER_TABLE_COUNT = 2,
+} JPEGEncoderTable;
+
+/** The code and its length in bits for every symbol of a Huffman table, length 0 for symbols not in the table */
+typedef struct HuffmanCodes {
+    uint16_t codes[256];
+    uint8_t lengths[256];
+} HuffmanCodes;
+
+typedef struct JPEGEncoderData {
+    /** cosines[u][x] is C(u) / 2 * cos((2x + 1) * u * pi / 16), one pass of the separable 8x8 FDCT */
+    float cosines[JPEG_BLOCK_SIZE][JPEG_BLOCK_SIZE];
+    /** Zigzag order, as in DQT */
+    uint8_t quantTables[JPEG_ENCODER_TABLE_COUNT][JPEG_BLOCK_COEFFICIENTS];
+    /** 1 / quantTables so quantizing is a multiply */
+    float reciprocals[JPEG_ENCODER_TABLE_COUNT][JPEG_BLOCK_COEFFICIENTS];
+    HuffmanCodes dcCodes[JPEG_ENCODER_TABLE_COUNT];
+    HuffmanCodes acCodes[JPEG_ENCODER_TABLE_COUNT];
+    uint32_t bits;
+    uint32_t bitCount;
+    uint8_t buffer[JPEG_ENCODER_BUFFER_SIZE];
+    size_t bufferLength;
+    JPEGEncoderWriteCallback *callback;
+    void *userArg;
+    /** The first error from callback, nothing more is written after it */
+    Error error;
+} JPEGEncoderData;
+
+private void jpegEncoder_flush(JPEGEncoderData *this) {
+    if (this->bufferLength > 0 && this->error == ERROR_NONE) {
+        this->error = this->callback(this->buffer, this->bufferLength, this->userArg);
+    }
+    this->bufferLength = 0;
+}
+
+private void jpegEncoder_putByte(JPEGEncoderData *this, const uint8_t byte) {
+    this->buffer[this->bufferLength++] = byte;
+    if (this->bufferLength == JPEG_ENCODER_BUFFER_SIZE) jpegEncoder_flush(this);
+}
+
+private void jpegEncoder_putWord(JPEGEncoderData *this, const uint16_t word) {
+    jpegEncoder_putByte(this, word >> 8);
+    jpegEncoder_putByte(this, word & 0xFF);
+}
+
+private void jpegEncoder_putMarker(JPEGEncoderData *this, const uint8_t marker) {
+    jpegEncoder_putByte(this, JPEG_MARKER_PREFIX);
+    jpegEncoder_putByte(this, marker);
+}
+
+/** Add the low length bits of value to the entropy coded data, a 0xFF byte is followed by a stuffed 0 */
+private void jpegEncoder_putBits(JPEGEncoderData *this, const uint32_t value, const uint32_t length) {
+    this->bits = (this->bits << length) | (value & ((1U << length) - 1));
+    this->bitCount += length;
+    while (this->bitCount >= 8) {
+        this->bitCount -= 8;
+        const uint8_t byte = (this->bits >> this->bitCount) & 0xFF;
+        jpegEncoder_putByte(this, byte);
+        if (byte == JPEG_MARKER_PREFIX) jpegEncoder_putByte(this, JPEG_STUFFED_ZERO);
+    }
+    this->bits &= (1U << this->bitCount) - 1;
+}
+
+/** Generate the codes of a table given as DHT gives it, the count of codes of each length then the symbols */
+private void jpegEncoder_buildCodes(HuffmanCodes *huffmanCodes, const uint8_t *bits, const uint8_t *values) {
+    uint32_t code = 0;
+    uint32_t index = 0;
+    for (uint32_t length = 1; length <= JPEG_MAX_CODE_LENGTH; length++) {
+        for (uint32_t i = 0; i < bits[length - 1]; i++) {
+            huffmanCodes->codes[values[index]] = code++;
+            huffmanCodes->lengths[values[index]] = length;
+            index++;
+        }
+        code <<= 1;
+    }
+}
+
+/** Scale the standard table like libjpeg does, quality 50 is the table as it is */
+private void jpegEncoder_buildQuantTable(JPEGEncoderData *this, const JPEGEncoderTable table, const uint8_t *base,
+                                         const uint8_t quality) {
+    const uint32_t scale = quality < 50 ? 5000 / quality : 200 - (quality * 2);
+    for (uint32_t i = 0; i < JPEG_BLOCK_COEFFICIENTS; i++) {
+        uint32_t value = ((base[i] * scale) + 50) / 100;
+        if (value < 1) value = 1;
+        if (value > 255) value = 255;
+        this->quantTables[table][i] = value;
+        this->reciprocals[table][i] = 1.0F / (float) value;
+    }
+}
+
+private void jpegEncoder_putHuffmanTable(JPEGEncoderData *this, const uint8_t tableClass, const uint8_t id,
+                                         const uint8_t *bits, const uint8_t *values, const uint32_t valueCount) {
+    jpegEncoder_putByte(this, (tableClass << 4) | id);
+    for (uint32_t i = 0; i < JPEG_MAX_CODE_LENGTH; i++) jpegEncoder_putByte(this, bits[i]);
+    for (uint32_t i = 0; i < valueCount; i++) jpegEncoder_putByte(this, values[i]);
+}
+
+private void jpegEncoder_putHeaders(JPEGEncoderData *this, const JPEGEncoderImage *image) {
+    jpegEncoder_putMarker(this, JPEG_MARKER_SOI);
+    // JFIF so viewers take the components as YCbCr, 1:1 pixels and no thumbnail of its own
+    const uint8_t jfif[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    jpegEncoder_putMarker(this, JPEG_MARKER_APP0);
+    jpegEncoder_putWord(this, 2 + sizeof(jfif));
+    for (uint32_t i = 0; i < sizeof(jfif); i++) jpegEncoder_putByte(this, jfif[i]);
+
+    jpegEncoder_putMarker(this, JPEG_MARKER_DQT);
+    jpegEncoder_putWord(this, 2 + (JPEG_ENCODER_TABLE_COUNT * (1 + JPEG_BLOCK_COEFFICIENTS)));
+    for (uint32_t table = 0; table < JPEG_ENCODER_TABLE_COUNT; table++) {
+        jpegEncoder_putByte(this, table);
+        for (uint32_t i = 0; i < JPEG_BLOCK_COEFFICIENTS; i++) jpegEncoder_putByte(this, this->quantTables[table][i]);
+    }
+
+    // luma is sampled 2x2 and both chroma 1x1, 4:2:0
+    jpegEncoder_putMarker(this, JPEG_MARKER_SOF0);
+    jpegEncoder_putWord(this, 17);
+    jpegEncoder_putByte(this, 8);
+    jpegEncoder_putWord(this, image->height);
+    jpegEncoder_putWord(this, image->width);
+    jpegEncoder_putByte(this, 3);
+    const uint8_t components[3][3] = {{1, 0x22, JPEG_ENCODER_TABLE_LUMA},
+                                      {2, 0x11, JPEG_ENCODER_TABLE_CHROMA},
+                                      {3, 0x11, JPEG_ENCODER_TABLE_CHROMA}};
+    for (uint32_t i = 0; i < 3; i++) {
+        for (uint32_t j = 0; j < 3; j++) jpegEncoder_putByte(this, components[i][j]);
+    }
+
+    jpegEncoder_putMarker(this, JPEG_MARKER_DHT);
+    jpegEncoder_putWord(this, 2 + (4 * (1 + JPEG_MAX_CODE_LENGTH)) + sizeof(LUMA_DC_VALUES) +
+                              sizeof(LUMA_AC_VALUES) + sizeof(CHROMA_DC_VALUES) + sizeof(CHROMA_AC_VALUES));
+    jpegEncoder_putHuffmanTable(this, 0, JPEG_ENCODER_TABLE_LUMA, LUMA_DC_BITS, LUMA_DC_VALUES,
+                                sizeof(LUMA_DC_VALUES));
+    jpegEncoder_putHuffmanTable(this, 1, JPEG_ENCODER_TABLE_LUMA, LUMA_AC_BITS, LUMA_AC_VALUES,
+                                sizeof(LUMA_AC_VALUES));
+    jpegEncoder_putHuffmanTable(this, 0, JPEG_ENCODER_TABLE_CHROMA, CHROMA_DC_BITS, CHROMA_DC_VALUES,
+                                sizeof(CHROMA_DC_VALUES));
+    jpegEncoder_putHuffmanTable(this, 1, JPEG_ENCODER_TABLE_CHROMA, CHROMA_AC_BITS, CHROMA_AC_VALUES,
+                                sizeof(CHROMA_AC_VALUES));
+
+    jpegEncoder_putMarker(this, JPEG_MARKER_SOS);
+    jpegEncoder_putWord(this, 12);
+    jpegEncoder_putByte(this, 3);
+    for (uint32_t i = 0; i < 3; i++) {
+        jpegEncoder_putByte(this, components[i][0]);
+        jpegEncoder_putByte(this, (components[i][2] << 4) | components[i][2]);
+    }
+    jpegEncoder_putByte(this, 0); // spectral selection and successive approximation are fixed for baseline
+    jpegEncoder_putByte(this, JPEG_BLOCK_COEFFICIENTS - 1);
+    jpegEncoder_putByte(this, 0);
+}
+
+/** The 8x8 block at (left, top) of plane, less 128, samples past the plane's edges repeat the last row or column */
+private void jpegEncoder_getBlock(const uint8_t *plane, const uint32_t width, const uint32_t height,
+                                  const uint32_t left, const uint32_t top, float *block) {
+    for (uint32_t y = 0; y < JPEG_BLOCK_SIZE; y++) {
+        const uint32_t row = top + y < height ? top + y : height - 1;
+        for (uint32_t x = 0; x < JPEG_BLOCK_SIZE; x++) {
+            const uint32_t column = left + x < width ? left + x : width - 1;
+            block[(y * JPEG_BLOCK_SIZE) + x] = (float) plane[(row * width) + column] - 128.0F;
+        }
+    }
+}
+
+/** Forward DCT of block then quantize into coefficients in zigzag order */
+private void jpegEncoder_transformBlock(const JPEGEncoderData *this, const JPEGEncoderTable table,
+                                        const float *block, int32_t *coefficients) {
+    float rows[JPEG_BLOCK_COEFFICIENTS];
+    for (uint32_t y = 0; y < JPEG_BLOCK_SIZE; y++) {
+        for (uint32_t u = 0; u < JPEG_BLOCK_SIZE; u++) {
+            float sum = 0;
+            for (uint32_t x = 0; x < JPEG_BLOCK_SIZE; x++) {
+                sum += this->cosines[u][x] * block[(y * JPEG_BLOCK_SIZE) + x];
+            }
+            rows[(y * JPEG_BLOCK_SIZE) + u] = sum;
+        }
+    }
+    float transformed[JPEG_BLOCK_COEFFICIENTS];
+    for (uint32_t u = 0; u < JPEG_BLOCK_SIZE; u++) {
+        for (uint32_t v = 0; v < JPEG_BLOCK_SIZE; v++) {
+            float sum = 0;
+            for (uint32_t y = 0; y < JPEG_BLOCK_SIZE; y++) {
+                sum += this->cosines[v][y] * rows[(y * JPEG_BLOCK_SIZE) + u];
+            }
+            transformed[(v * JPEG_BLOCK_SIZE) + u] = sum;
+        }
+    }
+    for (uint32_t i = 0; i < JPEG_BLOCK_COEFFICIENTS; i++) {
+        coefficients[i] = (int32_t) lroundf(transformed[ZIGZAG_TO_NATURAL[i]] * this->reciprocals[table][i]);
+    }
+}
+
+/** A symbol's code followed by the value's magnitude bits, negative values are written as value - 1 */
+private void jpegEncoder_putValue(JPEGEncoderData *this, const HuffmanCodes *huffmanCodes, const uint32_t run,
+                                  const int32_t value) {
+    const uint32_t magnitude = value < 0 ? -value : value;
+    const uint32_t size = magnitude == 0 ? 0 : 32 - __builtin_clz(magnitude);
+    const uint32_t symbol = (run << 4) | size;
+    jpegEncoder_putBits(this, huffmanCodes->codes[symbol], huffmanCodes->lengths[symbol]);
+    if (size > 0) jpegEncoder_putBits(this, value < 0 ? value - 1 : value, size);
+}
+
+private void jpegEncoder_encodeBlock(JPEGEncoderData *this, const JPEGEncoderTable table, const float *block,
+                                     int32_t *dcPredictor) {
+    int32_t coefficients[JPEG_BLOCK_COEFFICIENTS];
+    jpegEncoder_transformBlock(this, table, block, coefficients);
+    jpegEncoder_putValue(this, &this->dcCodes[table], 0, coefficients[0] - *dcPredictor);
+    *dcPredictor = coefficients[0];
+    const HuffmanCodes *acCodes = &this->acCodes[table];
+    uint32_t run = 0;
+    for (uint32_t i = 1; i < JPEG_BLOCK_COEFFICIENTS; i++) {
+        if (coefficients[i] == 0) {
+            run++;
+            continue;
+        }
+        for (; run > 15; run -= 16) {
+            jpegEncoder_putBits(this, acCodes->codes[JPEG_SYMBOL_ZRL], acCodes->lengths[JPEG_SYMBOL_ZRL]);
+        }
+        jpegEncoder_putValue(this, acCodes, run, coefficients[i]);
+        run = 0;
+    }
+    if (run > 0) jpegEncoder_putBits(this, acCodes->codes[JPEG_SYMBOL_EOB], acCodes->lengths[JPEG_SYMBOL_EOB]);
+}
+
+public Error jpegEncoder_encode(const JPEGEncoderImage *image, const uint8_t quality,
+                                JPEGEncoderWriteCallback callback, void *userArg) {
+    if (!image || !image->luma || !image->blueChroma || !image->redChroma || !callback) return ERROR_NULL_ARGUMENT;
+    if (image->width == 0 || image->height == 0 || image->width > JPEG_ENCODER_MAX_SIZE ||
+        image->height > JPEG_ENCODER_MAX_SIZE || quality == 0 || quality > 100) {
+        return ERROR_ILLEGAL_ARGUMENT;
+    }
+    JPEGEncoderData *this = new(JPEGEncoderData);
+    if (!this) return ERROR_LIBRARY_FAILURE;
+    this->callback = callback;
+    this->userArg = userArg;
+    for (uint32_t u = 0; u < JPEG_BLOCK_SIZE; u++) {
+        const float scale = u == 0 ? (float) M_SQRT1_2 / 2.0F : 0.5F;
+        for (uint32_t x = 0; x < JPEG_BLOCK_SIZE; x++) {
+            this->cosines[u][x] = scale * cosf((float) (((2 * x) + 1) * u) * (float) M_PI / 16.0F);
+        }
+    }
+    jpegEncoder_buildQuantTable(this, JPEG_ENCODER_TABLE_LUMA, LUMA_QUANT_TABLE, quality);
+    jpegEncoder_buildQuantTable(this, JPEG_ENCODER_TABLE_CHROMA, CHROMA_QUANT_TABLE, quality);
+    jpegEncoder_buildCodes(&this->dcCodes[JPEG_ENCODER_TABLE_LUMA], LUMA_DC_BITS, LUMA_DC_VALUES);
+    jpegEncoder_buildCodes(&this->acCodes[JPEG_ENCODER_TABLE_LUMA], LUMA_AC_BITS, LUMA_AC_VALUES);
+    jpegEncoder_buildCodes(&this->dcCodes[JPEG_ENCODER_TABLE_CHROMA], CHROMA_DC_BITS, CHROMA_DC_VALUES);
+    jpegEncoder_buildCodes(&this->acCodes[JPEG_ENCODER_TABLE_CHROMA], CHROMA_AC_BITS, CHROMA_AC_VALUES);
+    jpegEncoder_putHeaders(this, image);
+
+    const uint32_t chromaWidth = (image->width + 1) / 2;
+    const uint32_t chromaHeight = (image->height + 1) / 2;
+    int32_t dcPredictors[3] = {0};
+    float block[JPEG_BLOCK_COEFFICIENTS];
+    for (uint32_t top = 0; top < image->height && this->error == ERROR_NONE; top += JPEG_MCU_SIZE) {
+        for (uint32_t left = 0; left < image->width; left += JPEG_MCU_SIZE) {
+            for (uint32_t i = 0; i < 4; i++) {
+                jpegEncoder_getBlock(image->luma, image->width, image->height,
+                                     left + ((i % 2) * JPEG_BLOCK_SIZE), top + ((i / 2) * JPEG_BLOCK_SIZE), block);
+                jpegEncoder_encodeBlock(this, JPEG_ENCODER_TABLE_LUMA, block, &dcPredictors[0]);
+            }
+            jpegEncoder_getBlock(image->blueChroma, chromaWidth, chromaHeight, left / 2, top / 2, block);
+            jpegEncoder_encodeBlock(this, JPEG_ENCODER_TABLE_CHROMA, block, &dcPredictors[1]);
+            jpegEncoder_getBlock(image->redChroma, chromaWidth, chromaHeight, left / 2, top / 2, block);
+            jpegEncoder_encodeBlock(this, JPEG_ENCODER_TABLE_CHROMA, block, &dcPredictors[2]);
+        }
+    }
+    // the last byte is padded with 1 bits
+    if (this->bitCount > 0) jpegEncoder_putBits(this, 0xFF, 8 - this->bitCount);
+    jpegEncoder_putMarker(this, JPEG_MARKER_EOI);
+    jpegEncoder_flush(this);
+    const Error err = this->error;
+    delete(this);
+    return err;
+}
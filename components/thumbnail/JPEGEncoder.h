@@ -0,0 +1,37 @@
+#ifndef ESP32_REMOTECAMERA_JPEGENCODER_H
+#define ESP32_REMOTECAMERA_JPEGENCODER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Baseline JPEG encoder for small images, such as thumbnails, made to be opened by any browser. Encodes YCbCr
+ * 4:2:0 with the standard (Annex K) quantization tables scaled by quality, like libjpeg, and the standard Huffman
+ * tables so there is no second pass to optimize them. The JPEG is written in pieces to a callback as it is encoded
+ * so it needs no output buffer the size of the image
+ */
+
+#define JPEG_ENCODER_MAX_SIZE 65535
+#define JPEG_ENCODER_DEFAULT_QUALITY 80
+
+typedef struct JPEGEncoderImage {
+    uint32_t width;
+    uint32_t height;
+    /** width by height samples, row after row */
+    const uint8_t *luma;
+    /** (width + 1) / 2 by (height + 1) / 2 samples each */
+    const uint8_t *blueChroma;
+    const uint8_t *redChroma;
+} JPEGEncoderImage;
+
+/** Called with the JPEG's next bytes, an error stops the encoder and is returned from jpegEncoder_encode() */
+typedef Error JPEGEncoderWriteCallback(const uint8_t *bytes, const size_t length, void *userArg);
+
+/** Encode image at quality (1 to 100) and write it to callback, returns ERROR_ILLEGAL_ARGUMENT for an image with
+ * no samples or larger than JPEG_ENCODER_MAX_SIZE on a side */
+extern Error jpegEncoder_encode(const JPEGEncoderImage *image, const uint8_t quality,
+                                JPEGEncoderWriteCallback callback, void *userArg);
+
+#endif //ESP32_REMOTECAMERA_JPEGENCODER_H
@@ -0,0 +1,227 @@
+#include "Thumbnail.h"
+#include "Thumbnailer.h"
+#include "JPEGEncoder.h"
+#include "Utils.h"
+#include "Logger.h"
+#include "ExternalStorage.h"
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define THUMBNAIL_READ_BUFFER_SIZE 4096
+#define THUMBNAIL_QUALITY JPEG_ENCODER_DEFAULT_QUALITY
+
+private struct {
+    bool isInitialized;
+    /** Guards stats and the totals, thumbnails are made on the webserver's and the timelapse's tasks */
+    SemaphoreHandle_t mutex;
+    ThumbnailStats stats;
+    uint64_t readMicros;
+    uint64_t decodeMicros;
+    uint64_t encodeMicros;
+} this;
+
+#define obtainMutex() xSemaphoreTake(this.mutex, portMAX_DELAY)
+#define releaseMutex() xSemaphoreGive(this.mutex)
+
+typedef struct ThumbnailGeneratorData {
+    ThumbnailScale scale;
+    Thumbnailer *thumbnailer;
+    bool isBegun;
+    /** The first error of the JPEG, from reading or decoding it */
+    Error error;
+    uint32_t sourceBytes;
+    uint32_t readMicros;
+    uint32_t decodeMicros;
+} ThumbnailGeneratorData;
+
+typedef struct ThumbnailFileContext {
+    FILE *file;
+    size_t position;
+} ThumbnailFileContext;
+
+private uint32_t thumbnail_microsSince(const int64_t startMicros) {
+    return (uint32_t) (esp_timer_get_time() - startMicros);
+}
+
+private Error thumbnail_fileCallback(const uint8_t *bytes, const size_t length, void *userArg) {
+    ThumbnailFileContext *context = (ThumbnailFileContext *) userArg;
+    uint bytesWritten = 0;
+    const Error err = externalStorage_writeFile(context->file, context->position, bytes, length, &bytesWritten);
+    if (err != ERROR_NONE) return err;
+    if (bytesWritten != length) return ERROR_LIBRARY_FAILURE;
+    context->position += bytesWritten;
+    return ERROR_NONE;
+}
+
+/** Encode the thumbnail into the file at path, a thumbnail that could not be written whole is deleted */
+private Error thumbnail_writeFile(const char *path, const JPEGEncoderImage *thumbnail, ThumbnailImageStats *stats) {
+    const int64_t startMicros = esp_timer_get_time();
+    ThumbnailFileContext context = {.file = NULL};
+    Error err = externalStorage_openFile(path, &context.file, FILE_MODE_WRITE);
+    if (err == ERROR_NONE) {
+        err = jpegEncoder_encode(thumbnail, THUMBNAIL_QUALITY, thumbnail_fileCallback, &context);
+        externalStorage_closeFile(context.file);
+        if (err != ERROR_NONE) externalStorage_deleteFile(path);
+    }
+    stats->width = thumbnail->width;
+    stats->height = thumbnail->height;
+    stats->bytes = context.position;
+    stats->encodeMicros = thumbnail_microsSince(startMicros);
+    return err;
+}
+
+private void thumbnail_recordThumbnail(const char *imagePath, const ThumbnailImageStats *stats, const Error err) {
+    if (err != ERROR_NONE) {
+        WARN("Could not make a thumbnail of %s: %i", imagePath, err);
+    } else {
+        VERBOSE("Thumbnail of %s, %ux%u, %u bytes from %u, read: %u us, decode: %u us, encode: %u us", imagePath,
+                stats->width, stats->height, stats->bytes, stats->sourceBytes, stats->readMicros,
+                stats->decodeMicros, stats->encodeMicros);
+    }
+    if (!this.isInitialized) return;
+    obtainMutex();
+    if (err != ERROR_NONE) {
+        this.stats.thumbnailsFailed++;
+    } else {
+        this.stats.thumbnailsSaved++;
+        this.stats.sourceBytes += stats->sourceBytes;
+        this.readMicros += stats->readMicros;
+        this.decodeMicros += stats->decodeMicros;
+        this.encodeMicros += stats->encodeMicros;
+        this.stats.lastThumbnail = *stats;
+    }
+    releaseMutex();
+}
+
+public Error thumbnail_init() {
+    if (this.isInitialized) {
+        WARN("Thumbnail has already been initialized");
+        return ERROR_NONE;
+    }
+    this.mutex = xSemaphoreCreateMutex();
+    requireNotNull(this.mutex, ERROR_LIBRARY_FAILURE, "Could not create thumbnail mutex");
+    this.isInitialized = true;
+    return ERROR_NONE;
+}
+
+public Error thumbnail_getPath(const char *imagePath, const ThumbnailScale scale, char *path, const size_t pathLength) {
+    requireArgNotNull(imagePath);
+    requireArgNotNull(path);
+    if (scale != THUMBNAIL_SCALE_EIGHTH && scale != THUMBNAIL_SCALE_QUARTER) return ERROR_ILLEGAL_ARGUMENT;
+    // the extension is replaced, a dot in a directory's name is not an extension
+    const char *slash = strrchr(imagePath, '/');
+    const char *dot = strrchr(imagePath, '.');
+    const size_t nameLength = (dot != NULL && (slash == NULL || dot > slash)) ? dot - imagePath : strlen(imagePath);
+    const int length = snprintf(path, pathLength, "%.*s.thumb%u.jpg", (int) nameLength, imagePath, scale);
+    if (length < 0 || (size_t) length >= pathLength) return ERROR_OUT_OF_BOUNDS;
+    return ERROR_NONE;
+}
+
+public Error thumbnail_generate(const char *imagePath, const ThumbnailScale scale, ThumbnailImageStats *stats) {
+    requireArgNotNull(imagePath);
+    ThumbnailGeneratorData *generator = (ThumbnailGeneratorData *) thumbnail_createGenerator(scale);
+    requireNotNull(generator, ERROR_LIBRARY_FAILURE, "Could not create thumbnail generator");
+    uint8_t *buffer = alloc(THUMBNAIL_READ_BUFFER_SIZE);
+    FILE *file = NULL;
+    Error err = buffer ? externalStorage_openFile(imagePath, &file, FILE_MODE_READ) : ERROR_LIBRARY_FAILURE;
+    size_t position = 0;
+    while (err == ERROR_NONE && !thumbnailer_isDone(generator->thumbnailer)) {
+        const int64_t startMicros = esp_timer_get_time();
+        uint bytesRead = 0;
+        err = externalStorage_readFile(file, position, buffer, THUMBNAIL_READ_BUFFER_SIZE, &bytesRead);
+        generator->readMicros += thumbnail_microsSince(startMicros);
+        if (err != ERROR_NONE || bytesRead == 0) break; // a JPEG cut short is found by thumbnail_save()
+        position += bytesRead;
+        err = thumbnail_addBytes(generator, buffer, bytesRead);
+    }
+    if (file) externalStorage_closeFile(file);
+    delete(buffer);
+    // an error reading the JPEG is reported and counted like one decoding it
+    if (err != ERROR_NONE && generator->error == ERROR_NONE) generator->error = err;
+    generator->isBegun = true;
+    err = thumbnail_save(generator, imagePath, stats);
+    thumbnail_destroyGenerator(generator);
+    return err;
+}
+
+public ThumbnailGenerator *thumbnail_createGenerator(const ThumbnailScale scale) {
+    if (scale != THUMBNAIL_SCALE_EIGHTH && scale != THUMBNAIL_SCALE_QUARTER) return NULL;
+    ThumbnailGeneratorData *generator = new(ThumbnailGeneratorData);
+    if (!generator) return NULL;
+    generator->scale = scale;
+    generator->thumbnailer = thumbnailer_create();
+    if (!generator->thumbnailer) {
+        delete(generator);
+        return NULL;
+    }
+    return generator;
+}
+
+public void thumbnail_destroyGenerator(ThumbnailGenerator *generator) {
+    if (!generator) return;
+    thumbnailer_destroy(((ThumbnailGeneratorData *) generator)->thumbnailer);
+    delete(generator);
+}
+
+public Error thumbnail_addBytes(ThumbnailGenerator *thumbnailGenerator, const void *bytes, const size_t length) {
+    requireArgNotNull(thumbnailGenerator);
+    requireArgNotNull(bytes);
+    ThumbnailGeneratorData *generator = (ThumbnailGeneratorData *) thumbnailGenerator;
+    if (!generator->isBegun) {
+        generator->isBegun = true;
+        generator->sourceBytes = 0;
+        generator->decodeMicros = 0;
+        generator->error = thumbnailer_begin(generator->thumbnailer, generator->scale);
+    }
+    if (generator->error != ERROR_NONE) return generator->error;
+    const int64_t startMicros = esp_timer_get_time();
+    generator->error = thumbnailer_decode(generator->thumbnailer, bytes, length);
+    generator->decodeMicros += thumbnail_microsSince(startMicros);
+    generator->sourceBytes += length;
+    return generator->error;
+}
+
+public Error thumbnail_save(ThumbnailGenerator *thumbnailGenerator, const char *imagePath,
+                            ThumbnailImageStats *stats) {
+    requireArgNotNull(thumbnailGenerator);
+    requireArgNotNull(imagePath);
+    ThumbnailGeneratorData *generator = (ThumbnailGeneratorData *) thumbnailGenerator;
+    ThumbnailImageStats imageStats = {
+            .sourceBytes = generator->sourceBytes,
+            .readMicros = generator->readMicros,
+            .decodeMicros = generator->decodeMicros,
+    };
+    Error err = generator->isBegun ? generator->error : ERROR_ILLEGAL_STATE;
+    JPEGEncoderImage thumbnail;
+    if (err == ERROR_NONE) err = thumbnailer_getImage(generator->thumbnailer, &thumbnail);
+    char path[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+    if (err == ERROR_NONE) err = thumbnail_getPath(imagePath, generator->scale, path, sizeof(path));
+    if (err == ERROR_NONE) err = thumbnail_writeFile(path, &thumbnail, &imageStats);
+    thumbnail_discard(generator);
+    thumbnail_recordThumbnail(imagePath, &imageStats, err);
+    if (stats) *stats = imageStats;
+    return err;
+}
+
+public void thumbnail_discard(ThumbnailGenerator *thumbnailGenerator) {
+    if (!thumbnailGenerator) return;
+    ThumbnailGeneratorData *generator = (ThumbnailGeneratorData *) thumbnailGenerator;
+    generator->isBegun = false;
+    generator->error = ERROR_NONE;
+    generator->readMicros = 0;
+}
+
+public Error thumbnail_getStats(ThumbnailStats *stats) {
+    requireArgNotNull(stats);
+    require(this.isInitialized, ERROR_NOT_INITIALIZED, "Thumbnail has not been initialized");
+    obtainMutex();
+    *stats = this.stats;
+    stats->readMillis = (uint32_t) (this.readMicros / 1000);
+    stats->decodeMillis = (uint32_t) (this.decodeMicros / 1000);
+    stats->encodeMillis = (uint32_t) (this.encodeMicros / 1000);
+    releaseMutex();
+    return ERROR_NONE;
+}
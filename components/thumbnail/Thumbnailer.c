@@ -0,0 +1,241 @@
+#include "Thumbnailer.h"
+#include "JPEGDCDecoder.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** DC, the first horizontal and vertical AC terms then, 5th in zigzag order, the first diagonal term */
+#define THUMBNAILER_QUARTER_COEFFICIENTS 5
+#define THUMBNAILER_ZIGZAG_HORIZONTAL 1
+#define THUMBNAILER_ZIGZAG_VERTICAL 2
+#define THUMBNAILER_ZIGZAG_DIAGONAL 4
+/** The IDCT's cosines summed over a quarter of a block, in 1/1024ths, a quarter's mean is DC / 8 +- 0.1133 of the
+ * horizontal and vertical terms +- 0.1026 of the diagonal term, the sign is + on the left and top */
+#define THUMBNAILER_WEIGHT_BITS 10
+#define THUMBNAILER_FIRST_WEIGHT 116
+#define THUMBNAILER_DIAGONAL_WEIGHT 105
+#define THUMBNAILER_LEVEL_SHIFT 128
+
+typedef struct ThumbnailerData {
+    JPEGDCDecoder *decoder;
+    ThumbnailScale scale;
+    /** The first error of the JPEG, from its blocks or the decoder */
+    Error error;
+    bool isPrepared;
+    bool isAveraged;
+    bool hasChroma;
+    /** The JPEG scaled by 1 / scale, in samples, before they are averaged into the thumbnail */
+    uint32_t gridWidth;
+    uint32_t gridHeight;
+    /** Samples averaged into one are 2^shift across and down, 2^(shift + 1) for chroma */
+    uint32_t shift;
+    uint32_t width;
+    uint32_t height;
+    uint32_t chromaWidth;
+    uint32_t chromaHeight;
+    /** Luma samples of the grid each sample of a chroma component covers, across and down */
+    uint32_t chromaSpanX[JPEG_DC_DECODER_MAX_COMPONENTS];
+    uint32_t chromaSpanY[JPEG_DC_DECODER_MAX_COMPONENTS];
+    /** Luma then both chroma planes added up per thumbnail sample, 2^(2 * (MAX_SHIFT + 1)) * 255 fits, they are
+     * averaged in place into the thumbnail's samples */
+    uint16_t *sums;
+    size_t sumsCapacity;
+} ThumbnailerData;
+
+private uint8_t thumbnailer_clamp(const int32_t value) {
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+/** Grid samples in thumbnail sample number index along a side of count samples */
+private uint32_t thumbnailer_span(const uint32_t index, const uint32_t count, const uint32_t shift) {
+    const uint32_t first = index << shift;
+    const uint32_t end = (index + 1) << shift;
+    return (end < count ? end : count) - first;
+}
+
+/** Size the thumbnail once the JPEG's SOF is known, which is by its first block */
+private Error thumbnailer_prepare(ThumbnailerData *this, const JPEGDCDecoderInfo *info) {
+    if (info->componentCount != 1 && info->componentCount != 3) return ERROR_ILLEGAL_ARGUMENT;
+    const JPEGDCDecoderComponent *luma = &info->components[0];
+    for (uint32_t i = 1; i < info->componentCount; i++) {
+        const JPEGDCDecoderComponent *chroma = &info->components[i];
+        if (luma->horizontalSampling % chroma->horizontalSampling != 0 ||
+            luma->verticalSampling % chroma->verticalSampling != 0) {
+            return ERROR_ILLEGAL_ARGUMENT;
+        }
+        this->chromaSpanX[i] = luma->horizontalSampling / chroma->horizontalSampling;
+        this->chromaSpanY[i] = luma->verticalSampling / chroma->verticalSampling;
+    }
+    this->gridWidth = (info->width + this->scale - 1) / this->scale;
+    this->gridHeight = (info->height + this->scale - 1) / this->scale;
+    uint32_t shift = 0;
+    while (((this->gridWidth - 1) >> shift) >= THUMBNAIL_MAX_WIDTH ||
+           ((this->gridHeight - 1) >> shift) >= THUMBNAIL_MAX_HEIGHT) {
+        if (++shift > THUMBNAILER_MAX_SHIFT) return ERROR_OUT_OF_BOUNDS;
+    }
+    this->shift = shift;
+    this->width = ((this->gridWidth - 1) >> shift) + 1;
+    this->height = ((this->gridHeight - 1) >> shift) + 1;
+    this->chromaWidth = ((this->gridWidth - 1) >> (shift + 1)) + 1;
+    this->chromaHeight = ((this->gridHeight - 1) >> (shift + 1)) + 1;
+    this->hasChroma = info->componentCount == 3;
+
+    const size_t sumCount = (this->width * this->height) + (2 * this->chromaWidth * this->chromaHeight);
+    if (sumCount > this->sumsCapacity) {
+        delete(this->sums);
+        this->sums = alloc(sumCount * sizeof(uint16_t));
+        this->sumsCapacity = this->sums ? sumCount : 0;
+        if (!this->sums) return ERROR_LIBRARY_FAILURE;
+    }
+    memset(this->sums, 0, sumCount * sizeof(uint16_t));
+    this->isPrepared = true;
+    return ERROR_NONE;
+}
+
+/** The block's mean at 1/8 or the means of its 4 quarters at 1/4, row after row */
+private uint32_t thumbnailer_getSamples(const ThumbnailerData *this, const int32_t *coefficients,
+                                        uint8_t samples[2][2]) {
+    if (this->scale == THUMBNAIL_SCALE_EIGHTH) {
+        samples[0][0] = thumbnailer_clamp(((coefficients[0] + 4) >> 3) + THUMBNAILER_LEVEL_SHIFT);
+        return 1;
+    }
+    const int32_t mean = coefficients[0] * (1 << (THUMBNAILER_WEIGHT_BITS - 3));
+    const int32_t horizontal = THUMBNAILER_FIRST_WEIGHT * coefficients[THUMBNAILER_ZIGZAG_HORIZONTAL];
+    const int32_t vertical = THUMBNAILER_FIRST_WEIGHT * coefficients[THUMBNAILER_ZIGZAG_VERTICAL];
+    const int32_t diagonal = THUMBNAILER_DIAGONAL_WEIGHT * coefficients[THUMBNAILER_ZIGZAG_DIAGONAL];
+    for (uint32_t y = 0; y < 2; y++) {
+        for (uint32_t x = 0; x < 2; x++) {
+            const int32_t sum = mean + (x == 0 ? horizontal : -horizontal) + (y == 0 ? vertical : -vertical) +
+                                (x == y ? diagonal : -diagonal);
+            samples[y][x] = thumbnailer_clamp(((sum + (1 << (THUMBNAILER_WEIGHT_BITS - 1))) >>
+                                               THUMBNAILER_WEIGHT_BITS) + THUMBNAILER_LEVEL_SHIFT);
+        }
+    }
+    return 2;
+}
+
+private void thumbnailer_blockCallback(const JPEGDCDecoderBlock *block, void *userArg) {
+    ThumbnailerData *this = (ThumbnailerData *) userArg;
+    if (this->error != ERROR_NONE) return;
+    if (!this->isPrepared) {
+        this->error = thumbnailer_prepare(this, block->info);
+        if (this->error != ERROR_NONE) return;
+    }
+    uint8_t samples[2][2];
+    const uint32_t size = thumbnailer_getSamples(this, block->coefficients, samples);
+    const uint32_t left = block->x * size;
+    const uint32_t top = block->y * size;
+    if (block->component == 0) {
+        for (uint32_t y = 0; y < size; y++) {
+            const uint32_t gridY = top + y;
+            if (gridY >= this->gridHeight) break;
+            uint16_t *row = &this->sums[(gridY >> this->shift) * this->width];
+            for (uint32_t x = 0; x < size && left + x < this->gridWidth; x++) {
+                row[(left + x) >> this->shift] += samples[y][x];
+            }
+        }
+        return;
+    }
+    // a chroma sample is added once for every luma sample of the grid it covers, so averaging weighs it right
+    const uint32_t spanX = this->chromaSpanX[block->component];
+    const uint32_t spanY = this->chromaSpanY[block->component];
+    const uint32_t shift = this->shift + 1;
+    uint16_t *plane = &this->sums[(this->width * this->height) +
+                                  ((block->component - 1) * this->chromaWidth * this->chromaHeight)];
+    for (uint32_t y = 0; y < size * spanY; y++) {
+        const uint32_t gridY = (top * spanY) + y;
+        if (gridY >= this->gridHeight) break;
+        uint16_t *row = &plane[(gridY >> shift) * this->chromaWidth];
+        for (uint32_t x = 0; x < size * spanX; x++) {
+            const uint32_t gridX = (left * spanX) + x;
+            if (gridX >= this->gridWidth) break;
+            row[gridX >> shift] += samples[y / spanY][x / spanX];
+        }
+    }
+}
+
+/** Divide a plane's sums by how many grid samples went into each, writing the samples over the sums from the
+ * start, sample i is written to byte i which is before every sum still to be read */
+private void thumbnailer_averagePlane(const ThumbnailerData *this, const size_t offset, const uint32_t width,
+                                      const uint32_t height, const uint32_t shift, const bool isGrey) {
+    uint8_t *samples = (uint8_t *) this->sums;
+    for (uint32_t y = 0; y < height; y++) {
+        const uint32_t rows = thumbnailer_span(y, this->gridHeight, shift);
+        for (uint32_t x = 0; x < width; x++) {
+            const size_t i = offset + (y * width) + x;
+            const uint32_t count = rows * thumbnailer_span(x, this->gridWidth, shift);
+            samples[i] = isGrey ? THUMBNAILER_LEVEL_SHIFT : (this->sums[i] + (count / 2)) / count;
+        }
+    }
+}
+
+public Thumbnailer *thumbnailer_create() {
+    ThumbnailerData *this = new(ThumbnailerData);
+    if (!this) return NULL;
+    this->decoder = jpegDCDecoder_create();
+    if (!this->decoder) {
+        delete(this);
+        return NULL;
+    }
+    return this;
+}
+
+public void thumbnailer_destroy(Thumbnailer *thumbnailer) {
+    if (!thumbnailer) return;
+    ThumbnailerData *this = (ThumbnailerData *) thumbnailer;
+    jpegDCDecoder_destroy(this->decoder);
+    delete(this->sums);
+    delete(this);
+}
+
+public Error thumbnailer_begin(Thumbnailer *thumbnailer, const ThumbnailScale scale) {
+    if (!thumbnailer) return ERROR_NULL_ARGUMENT;
+    if (scale != THUMBNAIL_SCALE_EIGHTH && scale != THUMBNAIL_SCALE_QUARTER) return ERROR_ILLEGAL_ARGUMENT;
+    ThumbnailerData *this = (ThumbnailerData *) thumbnailer;
+    this->scale = scale;
+    this->error = ERROR_NONE;
+    this->isPrepared = false;
+    this->isAveraged = false;
+    return jpegDCDecoder_begin(this->decoder, JPEG_DC_DECODER_COMPONENT_ALL,
+                               scale == THUMBNAIL_SCALE_EIGHTH ? 1 : THUMBNAILER_QUARTER_COEFFICIENTS,
+                               thumbnailer_blockCallback, this);
+}
+
+public Error thumbnailer_decode(Thumbnailer *thumbnailer, const uint8_t *bytes, const size_t length) {
+    if (!thumbnailer || !bytes) return ERROR_NULL_ARGUMENT;
+    ThumbnailerData *this = (ThumbnailerData *) thumbnailer;
+    if (this->error != ERROR_NONE) return this->error;
+    const Error err = jpegDCDecoder_decode(this->decoder, bytes, length);
+    if (this->error == ERROR_NONE) this->error = err;
+    return this->error;
+}
+
+public bool thumbnailer_isDone(const Thumbnailer *thumbnailer) {
+    if (!thumbnailer) return false;
+    const ThumbnailerData *this = (const ThumbnailerData *) thumbnailer;
+    return this->error == ERROR_NONE && jpegDCDecoder_isDone(this->decoder);
+}
+
+public Error thumbnailer_getImage(Thumbnailer *thumbnailer, JPEGEncoderImage *image) {
+    if (!thumbnailer || !image) return ERROR_NULL_ARGUMENT;
+    ThumbnailerData *this = (ThumbnailerData *) thumbnailer;
+    if (!thumbnailer_isDone(this) || !this->isPrepared) return ERROR_ILLEGAL_STATE;
+    const size_t lumaCount = this->width * this->height;
+    const size_t chromaCount = this->chromaWidth * this->chromaHeight;
+    if (!this->isAveraged) {
+        thumbnailer_averagePlane(this, 0, this->width, this->height, this->shift, false);
+        thumbnailer_averagePlane(this, lumaCount, this->chromaWidth, this->chromaHeight, this->shift + 1,
+                                 !this->hasChroma);
+        thumbnailer_averagePlane(this, lumaCount + chromaCount, this->chromaWidth, this->chromaHeight,
+                                 this->shift + 1, !this->hasChroma);
+        this->isAveraged = true;
+    }
+    const uint8_t *samples = (const uint8_t *) this->sums;
+    *image = (JPEGEncoderImage) {
+            .width = this->width,
+            .height = this->height,
+            .luma = samples,
+            .blueChroma = &samples[lumaCount],
+            .redChroma = &samples[lumaCount + chromaCount],
+    };
+    return ERROR_NONE;
+}
@@ -0,0 +1,43 @@
+#ifndef ESP32_REMOTECAMERA_THUMBNAILER_H
+#define ESP32_REMOTECAMERA_THUMBNAILER_H
+
+#include "Error.h"
+#include "Utils.h"
+#include "Thumbnail.h"
+#include "JPEGEncoder.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Scales a JPEG down to 1/8 or 1/4 as its bytes are given, without an IDCT. At 1/8 every 8x8 block becomes one
+ * sample, its mean from the DC coefficient. At 1/4 it becomes 2x2 samples, the means of its quarters, from DC and
+ * the first horizontal, vertical and diagonal AC coefficients, higher terms add little. Chroma is brought to 4:2:0
+ * at the thumbnail's size whatever the JPEG's sampling. When the scaled JPEG is still larger than
+ * THUMBNAIL_MAX_WIDTH by THUMBNAIL_MAX_HEIGHT, 2x2, 4x4 or 8x8 samples are averaged into one
+ */
+typedef void Thumbnailer;
+
+/** Most samples averaged into one are 2^MAX_SHIFT across and down, enough for 1/4 of 2592x1944 */
+#define THUMBNAILER_MAX_SHIFT 3
+
+extern Thumbnailer *thumbnailer_create();
+
+extern void thumbnailer_destroy(Thumbnailer *thumbnailer);
+
+/** Start a new JPEG, its first bytes must be the SOI */
+extern Error thumbnailer_begin(Thumbnailer *thumbnailer, const ThumbnailScale scale);
+
+/** Decode the JPEG's next bytes, returns ERROR_ILLEGAL_ARGUMENT for a malformed or unsupported JPEG,
+ * ERROR_OUT_OF_BOUNDS for one too large to average down to a thumbnail and ERROR_LIBRARY_FAILURE when the
+ * thumbnail could not be allocated, after an error the rest of the JPEG is ignored */
+extern Error thumbnailer_decode(Thumbnailer *thumbnailer, const uint8_t *bytes, const size_t length);
+
+/** Whether the JPEG has been decoded up to its EOI */
+extern bool thumbnailer_isDone(const Thumbnailer *thumbnailer);
+
+/** The thumbnail, ready for jpegEncoder_encode() and valid until the next thumbnailer_begin(), ERROR_ILLEGAL_STATE
+ * until the JPEG has been decoded up to its EOI */
+extern Error thumbnailer_getImage(Thumbnailer *thumbnailer, JPEGEncoderImage *image);
+
+#endif //ESP32_REMOTECAMERA_THUMBNAILER_H
@@ -0,0 +1,80 @@
+#ifndef ESP32_REMOTECAMERA_THUMBNAIL_H
+#define ESP32_REMOTECAMERA_THUMBNAIL_H
+
+#include "Error.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Thumbnails of the JPEGs on the SD card, saved next to them as <name>.thumb8.jpg or <name>.thumb4.jpg. They are
+ * made without decoding the JPEG, from the lowest frequency coefficients of its 8x8 blocks, so they are cheap
+ * enough to make on the device right after a capture. Thumbnails larger than THUMBNAIL_MAX_WIDTH by
+ * THUMBNAIL_MAX_HEIGHT, the size of an EXIF thumbnail, are averaged down to fit
+ */
+
+#define THUMBNAIL_MAX_WIDTH 160
+#define THUMBNAIL_MAX_HEIGHT 120
+
+typedef enum ThumbnailScale {
+    /** One sample per 8x8 block, its DC coefficient */
+    THUMBNAIL_SCALE_EIGHTH = 8,
+    /** 2x2 samples per 8x8 block from its DC and first AC coefficients, sharper but more averaging for large
+     * images */
+    THUMBNAIL_SCALE_QUARTER = 4,
+} ThumbnailScale;
+
+typedef struct ThumbnailImageStats {
+    uint32_t width;
+    uint32_t height;
+    uint32_t sourceBytes;
+    uint32_t bytes;
+    /** Reading the JPEG from the SD card, 0 when it was given as it was captured */
+    uint32_t readMicros;
+    /** Entropy decoding the JPEG's blocks into the thumbnail */
+    uint32_t decodeMicros;
+    /** Encoding the thumbnail and writing it to the SD card */
+    uint32_t encodeMicros;
+} ThumbnailImageStats;
+
+typedef struct ThumbnailStats {
+    uint32_t thumbnailsSaved;
+    uint32_t thumbnailsFailed;
+    /** Totals over the thumbnails saved, sourceBytes / decodeMillis is the decoder's throughput */
+    uint32_t sourceBytes;
+    uint32_t readMillis;
+    uint32_t decodeMillis;
+    uint32_t encodeMillis;
+    /** All 0 until the first thumbnail */
+    ThumbnailImageStats lastThumbnail;
+} ThumbnailStats;
+
+/** Makes the thumbnail of one JPEG from its bytes as they are captured or read, can be used again for the next */
+typedef void ThumbnailGenerator;
+
+extern Error thumbnail_init();
+
+/** The path of the thumbnail of the image at imagePath, ERROR_OUT_OF_BOUNDS when it does not fit in pathLength */
+extern Error thumbnail_getPath(const char *imagePath, const ThumbnailScale scale, char *path, const size_t pathLength);
+
+/** Read the JPEG at imagePath on the SD card and save its thumbnail next to it, stats can be NULL */
+extern Error thumbnail_generate(const char *imagePath, const ThumbnailScale scale, ThumbnailImageStats *stats);
+
+extern ThumbnailGenerator *thumbnail_createGenerator(const ThumbnailScale scale);
+
+extern void thumbnail_destroyGenerator(ThumbnailGenerator *generator);
+
+/** Give the generator the next bytes of a JPEG, such as from camera_readImageBufferedWithCallback() while it is
+ * saved, so its thumbnail is made without reading it back, after an error the rest of the JPEG is ignored */
+extern Error thumbnail_addBytes(ThumbnailGenerator *generator, const void *bytes, const size_t length);
+
+/** Save the thumbnail of the JPEG given to thumbnail_addBytes() next to imagePath and get the generator ready for
+ * the next JPEG, ERROR_ILLEGAL_STATE when the JPEG was not given up to its end, stats can be NULL */
+extern Error thumbnail_save(ThumbnailGenerator *generator, const char *imagePath, ThumbnailImageStats *stats);
+
+/** Forget the JPEG given to thumbnail_addBytes() so far, for a JPEG that was not saved */
+extern void thumbnail_discard(ThumbnailGenerator *generator);
+
+extern Error thumbnail_getStats(ThumbnailStats *stats);
+
+#endif //ESP32_REMOTECAMERA_THUMBNAIL_H
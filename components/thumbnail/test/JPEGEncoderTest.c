@@ -0,0 +1,136 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "JPEGEncoder.h"
+#include "JPEGDCDecoder.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_TAG "[JPEGEncoder]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+/** Not a multiple of the 16x16 MCU so the last MCUs are padded */
+#define TEST_WIDTH 40
+#define TEST_HEIGHT 24
+#define TEST_BLOCKS_WIDE 5
+#define TEST_BLOCKS_HIGH 3
+#define TEST_CHROMA_WIDTH ((TEST_WIDTH + 1) / 2)
+#define TEST_CHROMA_HEIGHT ((TEST_HEIGHT + 1) / 2)
+#define TEST_QUALITY 90
+#define TEST_MAX_JPEG_BYTES 8192
+
+typedef struct TestOutput {
+    uint8_t bytes[TEST_MAX_JPEG_BYTES];
+    size_t length;
+    uint32_t writes;
+    Error err;
+} TestOutput;
+
+typedef struct TestMeans {
+    int32_t luma[TEST_BLOCKS_HIGH][TEST_BLOCKS_WIDE];
+    uint32_t blocks;
+} TestMeans;
+
+private Error testWriteCallback(const uint8_t *bytes, const size_t length, void *userArg) {
+    TestOutput *output = (TestOutput *) userArg;
+    output->writes++;
+    if (output->err != ERROR_NONE) return output->err;
+    if (output->length + length > TEST_MAX_JPEG_BYTES) return ERROR_OUT_OF_BOUNDS;
+    memcpy(&output->bytes[output->length], bytes, length);
+    output->length += length;
+    return ERROR_NONE;
+}
+
+private void testBlockCallback(const JPEGDCDecoderBlock *block, void *userArg) {
+    TestMeans *means = (TestMeans *) userArg;
+    if (block->x < TEST_BLOCKS_WIDE && block->y < TEST_BLOCKS_HIGH) {
+        means->luma[block->y][block->x] = (block->coefficients[0] / 8) + 128;
+        means->blocks++;
+    }
+}
+
+/** Every 8x8 luma block one flat grey, blocks get lighter to the right and down, chroma is a flat color */
+private void testFillImage(uint8_t *luma, uint8_t *blueChroma, uint8_t *redChroma) {
+    for (uint32_t y = 0; y < TEST_HEIGHT; y++) {
+        for (uint32_t x = 0; x < TEST_WIDTH; x++) {
+            luma[(y * TEST_WIDTH) + x] = 20 + ((x / 8) * 30) + ((y / 8) * 40);
+        }
+    }
+    memset(blueChroma, 100, TEST_CHROMA_WIDTH * TEST_CHROMA_HEIGHT);
+    memset(redChroma, 180, TEST_CHROMA_WIDTH * TEST_CHROMA_HEIGHT);
+}
+
+TEST("JPEGEncoder encodes a baseline JPEG with the image's block means") {
+    uint8_t *luma = malloc(TEST_WIDTH * TEST_HEIGHT);
+    uint8_t *blueChroma = malloc(TEST_CHROMA_WIDTH * TEST_CHROMA_HEIGHT);
+    uint8_t *redChroma = malloc(TEST_CHROMA_WIDTH * TEST_CHROMA_HEIGHT);
+    testFillImage(luma, blueChroma, redChroma);
+    const JPEGEncoderImage image = {.width = TEST_WIDTH, .height = TEST_HEIGHT, .luma = luma,
+            .blueChroma = blueChroma, .redChroma = redChroma};
+    TestOutput *output = calloc(1, sizeof(TestOutput));
+    ASSERT_INT_EQUAL(ERROR_NONE, jpegEncoder_encode(&image, TEST_QUALITY, testWriteCallback, output),
+                     "encode should succeed");
+    ASSERT(output->length > 4, "a JPEG should be written");
+    ASSERT(output->bytes[0] == 0xFF && output->bytes[1] == 0xD8, "the JPEG should start with SOI");
+    ASSERT(output->bytes[output->length - 2] == 0xFF && output->bytes[output->length - 1] == 0xD9,
+           "the JPEG should end with EOI");
+
+    JPEGDCDecoder *decoder = jpegDCDecoder_create();
+    TestMeans means = {0};
+    jpegDCDecoder_begin(decoder, JPEG_DC_DECODER_COMPONENT_LUMA, 1, testBlockCallback, &means);
+    ASSERT_INT_EQUAL(ERROR_NONE, jpegDCDecoder_decode(decoder, output->bytes, output->length),
+                     "the JPEG should decode");
+    ASSERT(jpegDCDecoder_isDone(decoder), "the JPEG should decode up to its EOI");
+    JPEGDCDecoderInfo info;
+    jpegDCDecoder_getInfo(decoder, &info);
+    ASSERT_UINT_EQUAL(TEST_WIDTH, info.width, "width was incorrect");
+    ASSERT_UINT_EQUAL(TEST_HEIGHT, info.height, "height was incorrect");
+    ASSERT_UINT_EQUAL(3, info.componentCount, "the JPEG should be YCbCr");
+    ASSERT_UINT_EQUAL(2, info.components[0].horizontalSampling, "luma should be sampled 2x across");
+    ASSERT_UINT_EQUAL(2, info.components[0].verticalSampling, "luma should be sampled 2x down");
+    ASSERT_UINT_EQUAL(1, info.components[1].horizontalSampling, "chroma should be sampled 1x");
+    ASSERT_UINT_EQUAL(TEST_BLOCKS_WIDE * TEST_BLOCKS_HIGH, means.blocks, "every block inside should be decoded");
+    for (uint32_t y = 0; y < TEST_BLOCKS_HIGH; y++) {
+        for (uint32_t x = 0; x < TEST_BLOCKS_WIDE; x++) {
+            const int32_t expected = 20 + (x * 30) + (y * 40);
+            ASSERT(abs(means.luma[y][x] - expected) <= 2, "block mean was incorrect");
+        }
+    }
+    jpegDCDecoder_destroy(decoder);
+    free(output);
+    free(luma);
+    free(blueChroma);
+    free(redChroma);
+}
+
+TEST("JPEGEncoder rejects bad images and stops on a write error") {
+    uint8_t *luma = malloc(TEST_WIDTH * TEST_HEIGHT);
+    uint8_t *blueChroma = malloc(TEST_CHROMA_WIDTH * TEST_CHROMA_HEIGHT);
+    uint8_t *redChroma = malloc(TEST_CHROMA_WIDTH * TEST_CHROMA_HEIGHT);
+    testFillImage(luma, blueChroma, redChroma);
+    JPEGEncoderImage image = {.width = TEST_WIDTH, .height = TEST_HEIGHT, .luma = luma,
+            .blueChroma = blueChroma, .redChroma = redChroma};
+    TestOutput *output = calloc(1, sizeof(TestOutput));
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, jpegEncoder_encode(&image, 0, testWriteCallback, output),
+                     "quality 0 should be rejected");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, jpegEncoder_encode(&image, 101, testWriteCallback, output),
+                     "quality over 100 should be rejected");
+    image.width = 0;
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, jpegEncoder_encode(&image, TEST_QUALITY, testWriteCallback, output),
+                     "an image with no samples should be rejected");
+    image.width = TEST_WIDTH;
+    image.luma = NULL;
+    ASSERT_INT_EQUAL(ERROR_NULL_ARGUMENT, jpegEncoder_encode(&image, TEST_QUALITY, testWriteCallback, output),
+                     "an image with no luma should be rejected");
+    image.luma = luma;
+    ASSERT_UINT_EQUAL(0, output->writes, "nothing should be written for a rejected image");
+
+    output->err = ERROR_LIBRARY_FAILURE;
+    ASSERT_INT_EQUAL(ERROR_LIBRARY_FAILURE, jpegEncoder_encode(&image, TEST_QUALITY, testWriteCallback, output),
+                     "the write error should be returned");
+    ASSERT_UINT_EQUAL(1, output->writes, "nothing more should be written after the error");
+    free(output);
+    free(luma);
+    free(blueChroma);
+    free(redChroma);
+}
@@ -0,0 +1,271 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "Thumbnailer.h"
+#include "JPEGEncoder.h"
+#include "Constants.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_TAG "[Thumbnailer]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+/** Read like the camera reads the FIFO and the SD card is read */
+#define TEST_CHUNK_BYTES 4096
+#define TEST_MAX_JPEG_BYTES 16384
+/** 1/4 of this is just wider than THUMBNAIL_MAX_WIDTH so it is averaged down 2x2 */
+#define TEST_WIDE_WIDTH 656
+#define TEST_WIDE_HEIGHT 16
+
+/** 32x16 4:2:0 baseline JPEG at quality 100. The left MCU is grey, its top left block is in quarters of 40, 80,
+ * 120 and 160, the others are flat 80, 120 and 160, so that block's mean is 100. The right MCU is flat red,
+ * YCbCr 87, 101, 208 */
+private const uint8_t TEST_JPEG[] = {
+        0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+        0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xC0,
+        0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x20, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+        0x01, 0xFF, 0xC4, 0x00, 0x1F, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+        0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+        0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7D, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+        0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23,
+        0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17,
+        0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A,
+        0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A,
+        0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A,
+        0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+        0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7,
+        0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5,
+        0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1,
+        0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFF, 0xC4, 0x00, 0x1F, 0x01, 0x00, 0x03,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x11, 0x00,
+        0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00,
+        0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13,
+        0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15,
+        0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26, 0x27,
+        0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+        0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6,
+        0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4,
+        0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE2,
+        0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9,
+        0xFA, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00, 0xF8,
+        0x7F, 0xF6, 0x6E, 0xFF, 0x00, 0x82, 0x6E, 0xFF, 0x00, 0xC8, 0xE7, 0xFF, 0x00, 0x17, 0x9B, 0xFE,
+        0x85, 0xDF, 0xF9, 0xA7, 0x7F, 0xF6, 0x1D, 0xFF, 0x00, 0xA9, 0xEA, 0xBE, 0x5F, 0xAF, 0xD4, 0x0A,
+        0xFD, 0x40, 0xA0, 0x0F, 0xE6, 0xFE, 0x8A, 0x28, 0xAF, 0xE2, 0x73, 0xFE, 0xA0, 0x0F, 0xFF, 0xD9,};
+
+typedef struct TestOutput {
+    uint8_t *bytes;
+    size_t length;
+} TestOutput;
+
+private Error testWriteCallback(const uint8_t *bytes, const size_t length, void *userArg) {
+    TestOutput *output = (TestOutput *) userArg;
+    if (output->bytes) {
+        if (output->length + length > TEST_MAX_JPEG_BYTES) return ERROR_OUT_OF_BOUNDS;
+        memcpy(&output->bytes[output->length], bytes, length);
+    }
+    output->length += length;
+    return ERROR_NONE;
+}
+
+private void assertNear(const int32_t expected, const int32_t actual, const int32_t tolerance, const char *message) {
+    if (abs(expected - actual) > tolerance) printf("Expected %i but was %i\n", expected, actual);
+    ASSERT(abs(expected - actual) <= tolerance, message);
+}
+
+TEST("Thumbnailer at 1/8 is the mean of every block") {
+    Thumbnailer *thumbnailer = thumbnailer_create();
+    ASSERT_NOT_NULL(thumbnailer, "thumbnailer should not be NULL");
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_begin(thumbnailer, THUMBNAIL_SCALE_EIGHTH), "begin should succeed");
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_decode(thumbnailer, TEST_JPEG, sizeof(TEST_JPEG)),
+                     "decode should succeed");
+    ASSERT(thumbnailer_isDone(thumbnailer), "the JPEG should be decoded up to its EOI");
+    JPEGEncoderImage image;
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_getImage(thumbnailer, &image), "getImage should succeed");
+    ASSERT_UINT_EQUAL(4, image.width, "width was incorrect");
+    ASSERT_UINT_EQUAL(2, image.height, "height was incorrect");
+    const int32_t lumas[2][4] = {{100, 80, 87, 87}, {120, 160, 87, 87}};
+    for (uint32_t y = 0; y < 2; y++) {
+        for (uint32_t x = 0; x < 4; x++) {
+            assertNear(lumas[y][x], image.luma[(y * 4) + x], 1, "luma was incorrect");
+        }
+    }
+    assertNear(128, image.blueChroma[0], 1, "grey should have no chroma");
+    assertNear(128, image.redChroma[0], 1, "grey should have no chroma");
+    assertNear(101, image.blueChroma[1], 1, "blue chroma was incorrect");
+    assertNear(208, image.redChroma[1], 1, "red chroma was incorrect");
+    thumbnailer_destroy(thumbnailer);
+}
+
+TEST("Thumbnailer at 1/4 tells the quarters of a block apart") {
+    Thumbnailer *thumbnailer = thumbnailer_create();
+    thumbnailer_begin(thumbnailer, THUMBNAIL_SCALE_QUARTER);
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_decode(thumbnailer, TEST_JPEG, sizeof(TEST_JPEG)),
+                     "decode should succeed");
+    JPEGEncoderImage image;
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_getImage(thumbnailer, &image), "getImage should succeed");
+    ASSERT_UINT_EQUAL(8, image.width, "width was incorrect");
+    ASSERT_UINT_EQUAL(4, image.height, "height was incorrect");
+    // a sharp edge also has higher terms, left out, so the quarters come out a little closer together
+    assertNear(40, image.luma[0], 12, "top left quarter was incorrect");
+    assertNear(80, image.luma[1], 12, "top right quarter was incorrect");
+    assertNear(120, image.luma[8], 12, "bottom left quarter was incorrect");
+    assertNear(160, image.luma[9], 12, "bottom right quarter was incorrect");
+    assertNear(80, image.luma[2], 1, "a flat block's quarters should be its mean");
+    assertNear(160, image.luma[19], 1, "a flat block's quarters should be its mean");
+    assertNear(87, image.luma[7], 1, "a flat block's quarters should be its mean");
+    assertNear(208, image.redChroma[3], 1, "red chroma was incorrect");
+    thumbnailer_destroy(thumbnailer);
+}
+
+TEST("Thumbnailer decodes in pieces and rejects bad JPEGs") {
+    Thumbnailer *thumbnailer = thumbnailer_create();
+    thumbnailer_begin(thumbnailer, THUMBNAIL_SCALE_EIGHTH);
+    for (size_t i = 0; i < sizeof(TEST_JPEG); i++) {
+        ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_decode(thumbnailer, &TEST_JPEG[i], 1), "decode should succeed");
+    }
+    JPEGEncoderImage image;
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_getImage(thumbnailer, &image), "getImage should succeed");
+    assertNear(100, image.luma[0], 1, "luma was incorrect");
+    assertNear(208, image.redChroma[1], 1, "red chroma was incorrect");
+
+    thumbnailer_begin(thumbnailer, THUMBNAIL_SCALE_EIGHTH);
+    thumbnailer_decode(thumbnailer, TEST_JPEG, sizeof(TEST_JPEG) - 2);
+    ASSERT_FALSE(thumbnailer_isDone(thumbnailer), "a JPEG with no EOI should not be done");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_STATE, thumbnailer_getImage(thumbnailer, &image),
+                     "a JPEG cut short should have no thumbnail");
+
+    const uint8_t notJPEG[] = {0x89, 'P', 'N', 'G'};
+    thumbnailer_begin(thumbnailer, THUMBNAIL_SCALE_EIGHTH);
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, thumbnailer_decode(thumbnailer, notJPEG, sizeof(notJPEG)),
+                     "bytes that are not a JPEG should be rejected");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, thumbnailer_decode(thumbnailer, TEST_JPEG, sizeof(TEST_JPEG)),
+                     "the rest of a rejected JPEG should be ignored");
+    ASSERT_INT_EQUAL(ERROR_ILLEGAL_ARGUMENT, thumbnailer_begin(thumbnailer, 2), "only 1/8 and 1/4 are supported");
+    thumbnailer_destroy(thumbnailer);
+}
+
+TEST("Thumbnailer averages large JPEGs down to fit") {
+    uint8_t *luma = malloc(TEST_WIDE_WIDTH * TEST_WIDE_HEIGHT);
+    const size_t chromaLength = ((TEST_WIDE_WIDTH + 1) / 2) * ((TEST_WIDE_HEIGHT + 1) / 2);
+    uint8_t *chroma = malloc(chromaLength);
+    ASSERT(luma != NULL && chroma != NULL, "image should be allocated");
+    for (uint32_t y = 0; y < TEST_WIDE_HEIGHT; y++) {
+        for (uint32_t x = 0; x < TEST_WIDE_WIDTH; x++) {
+            luma[(y * TEST_WIDE_WIDTH) + x] = x < TEST_WIDE_WIDTH / 2 ? 50 : 200;
+        }
+    }
+    memset(chroma, 128, chromaLength);
+    const JPEGEncoderImage source = {.width = TEST_WIDE_WIDTH, .height = TEST_WIDE_HEIGHT, .luma = luma,
+            .blueChroma = chroma, .redChroma = chroma};
+    TestOutput output = {.bytes = malloc(TEST_MAX_JPEG_BYTES)};
+    ASSERT_INT_EQUAL(ERROR_NONE, jpegEncoder_encode(&source, JPEG_ENCODER_DEFAULT_QUALITY, testWriteCallback,
+                                                    &output), "encode should succeed");
+    free(luma);
+    free(chroma);
+
+    Thumbnailer *thumbnailer = thumbnailer_create();
+    thumbnailer_begin(thumbnailer, THUMBNAIL_SCALE_QUARTER);
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_decode(thumbnailer, output.bytes, output.length),
+                     "decode should succeed");
+    JPEGEncoderImage image;
+    ASSERT_INT_EQUAL(ERROR_NONE, thumbnailer_getImage(thumbnailer, &image), "getImage should succeed");
+    ASSERT_UINT_EQUAL(TEST_WIDE_WIDTH / 8, image.width, "1/4 should be averaged down 2x2 to fit");
+    ASSERT_UINT_EQUAL(TEST_WIDE_HEIGHT / 8, image.height, "1/4 should be averaged down 2x2 to fit");
+    ASSERT(image.width <= THUMBNAIL_MAX_WIDTH, "the thumbnail should fit");
+    assertNear(50, image.luma[0], 2, "left half was incorrect");
+    assertNear(200, image.luma[image.width - 1], 2, "right half was incorrect");
+    assertNear(128, image.blueChroma[0], 1, "grey should have no chroma");
+    thumbnailer_destroy(thumbnailer);
+    free(output.bytes);
+}
+
+private uint64_t nowMicros() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000) + ((uint64_t) now.tv_nsec / 1000);
+}
+
+/** Thumbnails the recorded frames the virtual camera plays at both scales, skipped with no recording */
+TEST("Thumbnailer benchmark over recorded frames") {
+    DIR *directory = opendir(CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH);
+    if (!directory) {
+        printf("No recorded frames in %s, skipping benchmark\n", CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH);
+        return;
+    }
+    Thumbnailer *thumbnailer = thumbnailer_create();
+    uint8_t *chunk = malloc(TEST_CHUNK_BYTES);
+    ASSERT_NOT_NULL(chunk, "chunk should not be NULL");
+    const ThumbnailScale scales[] = {THUMBNAIL_SCALE_EIGHTH, THUMBNAIL_SCALE_QUARTER};
+    uint64_t decodeMicros[2] = {0};
+    uint64_t encodeMicros[2] = {0};
+    uint64_t thumbnailBytes[2] = {0};
+    uint64_t frameBytes = 0;
+    uint32_t frameCount = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(directory)) != NULL) {
+        const size_t nameLength = strlen(entry->d_name);
+        if (nameLength < 4 || strcmp(&entry->d_name[nameLength - 4], ".jpg") != 0) continue;
+        snprintf(path, sizeof(path), "%s/%s", CONFIG_CAMERA_VIRTUAL_DEVICE_FRAMES_PATH, entry->d_name);
+        bool isThumbnailed = true;
+        for (uint32_t i = 0; i < 2; i++) {
+            FILE *file = fopen(path, "rb");
+            if (!file) break;
+            thumbnailer_begin(thumbnailer, scales[i]);
+            size_t bytesRead;
+            while ((bytesRead = fread(chunk, 1, TEST_CHUNK_BYTES, file)) > 0) {
+                if (i == 0) frameBytes += bytesRead;
+                const uint64_t startMicros = nowMicros();
+                thumbnailer_decode(thumbnailer, chunk, bytesRead);
+                decodeMicros[i] += nowMicros() - startMicros;
+            }
+            fclose(file);
+            const uint64_t startMicros = nowMicros();
+            JPEGEncoderImage image;
+            TestOutput output = {.bytes = NULL};
+            if (thumbnailer_getImage(thumbnailer, &image) != ERROR_NONE ||
+                jpegEncoder_encode(&image, JPEG_ENCODER_DEFAULT_QUALITY, testWriteCallback, &output) != ERROR_NONE) {
+                isThumbnailed = false;
+                break;
+            }
+            encodeMicros[i] += nowMicros() - startMicros;
+            thumbnailBytes[i] += output.length;
+            if (i == 0) {
+                width = image.width;
+                height = image.height;
+            }
+        }
+        if (isThumbnailed) frameCount++;
+    }
+    closedir(directory);
+    if (frameCount > 0) {
+        for (uint32_t i = 0; i < 2; i++) {
+            const float decodeMillis = (float) decodeMicros[i] / 1000.0F / (float) frameCount;
+            printf("1/%u: %u frames (%u KB each) in %.2f ms decode + %.2f ms encode per frame, %.1f MB/s, "
+                   "%u byte thumbnails\n", scales[i], frameCount, (uint32_t) (frameBytes / frameCount / 1024),
+                   decodeMillis, (float) encodeMicros[i] / 1000.0F / (float) frameCount,
+                   decodeMillis > 0.0F ? (float) frameBytes / frameCount / 1000.0F / decodeMillis : 0.0F,
+                   (uint32_t) (thumbnailBytes[i] / frameCount));
+        }
+        printf("1/8 thumbnails are %ux%u\n", width, height);
+    }
+    free(chunk);
+    thumbnailer_destroy(thumbnailer);
+}
@@ -0,0 +1,358 @@
+#include "Timelapse.h"
+#include "TimelapseScheduler.h"
+#include "Utils.h"
+#include "Logger.h"
+#include "Constants.h"
+#include "Settings.h"
+#include "ExternalStorage.h"
+#include "Battery.h"
+#include "TaskWatcher.h"
+#include "Thumbnail.h"
+#include <stdio.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define TIMELAPSE_TASK_NAME "timelapseTask"
+#define TIMELAPSE_TASK_STACK_SIZE 3000
+#define TIMELAPSE_TASK_STACK_MIN (TIMELAPSE_TASK_STACK_SIZE * 0.10)
+#define TIMELAPSE_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#define TIMELAPSE_IMAGE_BUFFER_SIZE 4096
+#define TIMELAPSE_SETTLE_FRAMES 2 // captured and thrown away after waking while exposure and white balance settle
+#define TIMELAPSE_RETRY_MILLIS 10000 // before trying again to start a timelapse that could not start
+#define TIMELAPSE_MAX_WAIT_MILLIS 60000 // pdMS_TO_TICKS overflows for waits of hours, longer waits are split
+#define MILLIS_PER_HOUR 3600000.0F
+
+private struct {
+    /** Guards schedule, isScheduleChanged and stats, which are shared with the caller's task */
+    SemaphoreHandle_t mutex;
+    /** Given when the schedule changes so the task stops waiting for the next shot */
+    SemaphoreHandle_t wakeSemaphore;
+    TimelapseSchedule schedule;
+    bool isScheduleChanged;
+    TimelapseStats stats;
+    struct {
+        TaskHandle_t handle;
+        bool isRunning;
+        /** NULL when no timelapse is running */
+        TimelapseScheduler *scheduler;
+        /** The timelapse's own size and quality, written again before every shot in case settings were applied */
+        CameraSettings settings;
+        /** Whether live capture was paused and the camera in standby before the timelapse, restored when it stops */
+        bool wasPaused;
+        bool wasStandby;
+        char dirPath[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+        char *imageBuffer;
+        /** Makes every shot's thumbnail from its bytes as they are saved, NULL when it could not be created */
+        ThumbnailGenerator *thumbnails;
+        uint64_t standbySinceMillis;
+    } task;
+} this;
+
+#define obtainMutex() xSemaphoreTake(this.mutex, portMAX_DELAY)
+#define releaseMutex() xSemaphoreGive(this.mutex)
+
+typedef struct TimelapseFileContext {
+    FILE *file;
+    size_t position;
+    bool isFailed;
+    ThumbnailGenerator *thumbnails;
+} TimelapseFileContext;
+
+private uint64_t timelapse_nowMillis() {
+    return (uint64_t) (esp_timer_get_time() / 1000);
+}
+
+private float timelapse_estimateMilliampHours(const uint32_t awakeMillis, const uint32_t standbyMillis) {
+    return (((float) awakeMillis * CONFIG_TIMELAPSE_ACTIVE_MILLIAMPS) +
+            ((float) standbyMillis * CONFIG_TIMELAPSE_STANDBY_MILLIAMPS)) / MILLIS_PER_HOUR;
+}
+
+private Error timelapse_validateSchedule(const TimelapseSchedule *schedule) {
+    require(schedule->intervalSeconds >= TIMELAPSE_MIN_INTERVAL_SECONDS, ERROR_OUT_OF_BOUNDS,
+            "Timelapse interval must be at least %u seconds, was %u",
+            TIMELAPSE_MIN_INTERVAL_SECONDS, schedule->intervalSeconds);
+    require(schedule->imageSize >= 0 && schedule->imageSize < CAMERA_IMAGE_SIZE_COUNT, ERROR_OUT_OF_BOUNDS,
+            "Unknown timelapse image size: %i", schedule->imageSize);
+    require(schedule->imageQuality >= CAMERA_IMAGE_QUALITY_LOW && schedule->imageQuality <= CAMERA_IMAGE_QUALITY_HIGH,
+            ERROR_OUT_OF_BOUNDS, "Unknown timelapse image quality: %i", schedule->imageQuality);
+    return ERROR_NONE;
+}
+
+private void timelapse_fileCallback(char *buffer, int bufferSize, void *userArg) {
+    TimelapseFileContext *context = (TimelapseFileContext *) userArg;
+    uint bytesWritten = 0;
+    if (externalStorage_writeFile(context->file, context->position, buffer, bufferSize, &bytesWritten) != ERROR_NONE ||
+        bytesWritten != (uint) bufferSize) {
+        context->isFailed = true;
+    }
+    context->position += bytesWritten;
+    if (context->thumbnails) thumbnail_addBytes(context->thumbnails, buffer, bufferSize);
+}
+
+private Error timelapse_createDir(typeof(this) *thisPtr) {
+    bool dirExists = false;
+    externalStorage_queryDirExists(TIMELAPSE_DIR, &dirExists);
+    if (!dirExists) throwIfError(externalStorage_createDir(TIMELAPSE_DIR), "Could not create %s", TIMELAPSE_DIR);
+    // numbered instead of timestamped, there is no wall clock and the uptime starts over every boot
+    uint32_t sequence = 0;
+    settings_getUInt32(SETTINGS_KEY_TIMELAPSE_SEQUENCE, &sequence);
+    sequence++;
+    settings_putUInt32(SETTINGS_KEY_TIMELAPSE_SEQUENCE, sequence);
+    snprintf(thisPtr->task.dirPath, sizeof(thisPtr->task.dirPath), "%s/%04u", TIMELAPSE_DIR, sequence);
+    throwIfError(externalStorage_createDir(thisPtr->task.dirPath), "Could not create %s", thisPtr->task.dirPath);
+    obtainMutex();
+    thisPtr->stats = (TimelapseStats) {.sequence = sequence};
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+private Error timelapse_start(typeof(this) *thisPtr, const TimelapseSchedule *schedule) {
+    require(externalStorage_hasSDCard(), ERROR_ILLEGAL_STATE, "Timelapse needs an SD card");
+    throwIfError(timelapse_createDir(thisPtr), "");
+    thisPtr->task.scheduler = timelapseScheduler_create(schedule->intervalSeconds * 1000, schedule->shotCount,
+                                                        timelapse_nowMillis());
+    requireNotNull(thisPtr->task.scheduler, ERROR_LIBRARY_FAILURE, "Could not create timelapse scheduler");
+
+    // the timelapse has the camera until it stops, live capture would wake the sensor and keep the CPU busy
+    thisPtr->task.wasPaused = camera_isLiveCapturePaused();
+    thisPtr->task.wasStandby = camera_isStandby();
+    camera_pauseLiveCapture(true);
+    thisPtr->task.settings = (CameraSettings) {
+            .fields = CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_IMAGE_QUALITY,
+            .imageSize = schedule->imageSize,
+            .imageQuality = schedule->imageQuality,
+    };
+    // only for the timelapse, camera_applySettings() writes the user's values back before it stores anything
+    camera_applyTransientSettings(&thisPtr->task.settings, NULL);
+    camera_setStandby(true);
+    thisPtr->task.standbySinceMillis = timelapse_nowMillis();
+    thisPtr->task.thumbnails = thumbnail_createGenerator(THUMBNAIL_SCALE_EIGHTH);
+    if (!thisPtr->task.thumbnails) WARN("Could not create thumbnail generator, shots will have no thumbnails");
+    obtainMutex();
+    thisPtr->stats.isRunning = true;
+    thisPtr->stats.shotsRemaining = schedule->shotCount;
+    releaseMutex();
+    INFO("Timelapse started in %s, a shot every %u s, %u shots", thisPtr->task.dirPath, schedule->intervalSeconds,
+         schedule->shotCount);
+    return ERROR_NONE;
+}
+
+private void timelapse_stop(typeof(this) *thisPtr) {
+    camera_setStandby(false);
+    camera_restoreTransientSettings();
+    if (thisPtr->task.wasStandby) camera_setStandby(true);
+    camera_pauseLiveCapture(thisPtr->task.wasPaused);
+    timelapseScheduler_destroy(thisPtr->task.scheduler);
+    thisPtr->task.scheduler = NULL;
+    thumbnail_destroyGenerator(thisPtr->task.thumbnails);
+    thisPtr->task.thumbnails = NULL;
+    obtainMutex();
+    thisPtr->stats.isRunning = false;
+    INFO("Timelapse stopped, %u shots taken, %u missed, %u failed, estimated %.2f mAh",
+         thisPtr->stats.shotsTaken, thisPtr->stats.shotsMissed, thisPtr->stats.shotsFailed,
+         thisPtr->stats.estimatedMilliampHours);
+    releaseMutex();
+}
+
+/** Wakes the sensor, captures and saves one shot and puts the sensor back into standby */
+private Error timelapse_takeShot(typeof(this) *thisPtr, TimelapseShotStats *shot) {
+    const uint64_t wakeMillis = timelapse_nowMillis();
+    shot->standbyMillis = (uint32_t) (wakeMillis - thisPtr->task.standbySinceMillis);
+    throwIfError(camera_setStandby(false), "Could not wake the camera");
+    // settings applied since the last shot wrote the user's size and quality back, unchanged registers are skipped
+    camera_applyTransientSettings(&thisPtr->task.settings, NULL);
+    uint32_t imageSize = 0;
+    for (int i = 0; i < TIMELAPSE_SETTLE_FRAMES; i++) {
+        camera_captureImage(&imageSize);
+    }
+    const uint64_t captureMillis = timelapse_nowMillis();
+    shot->wakeMillis = (uint32_t) (captureMillis - wakeMillis);
+    // opened as a still request, so a snapshot asked for meanwhile on the server reads out this shot's capture
+    CameraFrameCursor cursor;
+    Error err = camera_openFrame(0, &cursor);
+    const bool isOpen = err == ERROR_NONE;
+    const uint64_t writeMillis = timelapse_nowMillis();
+    shot->captureMillis = (uint32_t) (writeMillis - captureMillis);
+
+    TimelapseFileContext context = {.file = NULL, .thumbnails = thisPtr->task.thumbnails};
+    char path[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%05u.jpg", thisPtr->task.dirPath, shot->index);
+    if (err == ERROR_NONE) err = externalStorage_openFile(path, &context.file, FILE_MODE_WRITE);
+    if (err == ERROR_NONE) {
+        while (err == ERROR_NONE && !context.isFailed && !cursor.isComplete) {
+            size_t bytesRead = 0;
+            char *buffer = thisPtr->task.imageBuffer;
+            err = camera_readFrame(&cursor, (uint8_t *) buffer, TIMELAPSE_IMAGE_BUFFER_SIZE, &bytesRead);
+            if (err == ERROR_NONE && bytesRead > 0) timelapse_fileCallback(buffer, (int) bytesRead, &context);
+        }
+        externalStorage_closeFile(context.file);
+        if (err == ERROR_NONE && context.isFailed) err = ERROR_LIBRARY_FAILURE;
+        if (err != ERROR_NONE) externalStorage_deleteFile(path);
+    }
+    if (isOpen) camera_closeFrame(&cursor);
+    shot->bytes = context.position;
+    camera_setStandby(true);
+    thisPtr->task.standbySinceMillis = timelapse_nowMillis();
+    shot->writeMillis = (uint32_t) (thisPtr->task.standbySinceMillis - writeMillis);
+    // made from the bytes as they were saved, so only encoding and writing the thumbnail is left for standby
+    if (context.thumbnails && err == ERROR_NONE) {
+        thumbnail_save(context.thumbnails, path, NULL);
+        shot->thumbnailMillis = (uint32_t) (timelapse_nowMillis() - thisPtr->task.standbySinceMillis);
+    } else if (context.thumbnails) {
+        thumbnail_discard(context.thumbnails);
+    }
+    shot->estimatedMilliampHours = timelapse_estimateMilliampHours(
+            (uint32_t) (thisPtr->task.standbySinceMillis - wakeMillis), shot->standbyMillis);
+    shot->batteryVoltage = battery_getVoltage();
+    return err;
+}
+
+private void timelapse_recordShot(typeof(this) *thisPtr, const TimelapseShotStats *shot, const Error err) {
+    timelapseScheduler_recordShot(thisPtr->task.scheduler);
+    TimelapseSchedulerStats schedulerStats;
+    timelapseScheduler_getStats(thisPtr->task.scheduler, &schedulerStats);
+    obtainMutex();
+    TimelapseStats *stats = &thisPtr->stats;
+    if (err != ERROR_NONE) stats->shotsFailed++;
+    stats->shotsTaken = schedulerStats.shotsTaken - stats->shotsFailed;
+    stats->shotsMissed = schedulerStats.shotsMissed;
+    stats->shotsRemaining = schedulerStats.shotsRemaining;
+    stats->awakeMillis += shot->wakeMillis + shot->captureMillis + shot->writeMillis;
+    stats->standbyMillis += shot->standbyMillis;
+    stats->estimatedMilliampHours += shot->estimatedMilliampHours;
+    stats->lastShot = *shot;
+    releaseMutex();
+    if (err != ERROR_NONE) {
+        ERROR("Timelapse shot %u failed: %i", shot->index, err);
+    } else {
+        VERBOSE("Timelapse shot %u, %u bytes, wake: %u ms, capture: %u ms, write: %u ms, %.3f mAh, %.0f mV",
+                shot->index, shot->bytes, shot->wakeMillis, shot->captureMillis, shot->writeMillis,
+                shot->estimatedMilliampHours, shot->batteryVoltage);
+    }
+}
+
+/** A timelapse that took its last shot is disabled so it does not start over on the next boot */
+private void timelapse_finishSchedule(typeof(this) *thisPtr) {
+    obtainMutex();
+    const bool isFinished = !thisPtr->isScheduleChanged;
+    if (isFinished) thisPtr->schedule.isEnabled = false;
+    const TimelapseSchedule schedule = thisPtr->schedule;
+    releaseMutex();
+    if (isFinished) settings_putBlob(SETTINGS_KEY_TIMELAPSE_SCHEDULE, &schedule, sizeof(TimelapseSchedule));
+}
+
+private void timelapse_taskFunction(void *arg) {
+    typeof(this) *thisPtr = (typeof(this) *) arg;
+    uint32_t stackMinBytes = 0;
+    while (thisPtr->task.isRunning) {
+        if ((taskWatcher_getTaskStackMinFreeBytes(TIMELAPSE_TASK_NAME, &stackMinBytes) == ERROR_NONE) &&
+            stackMinBytes < TIMELAPSE_TASK_STACK_MIN) { // quit task if we run out of stack to avoid program crash
+            ERROR("Timelapse task ran out of stack, most bytes used: %u", stackMinBytes);
+            break;
+        }
+        obtainMutex();
+        const bool isScheduleChanged = thisPtr->isScheduleChanged;
+        thisPtr->isScheduleChanged = false;
+        const TimelapseSchedule schedule = thisPtr->schedule;
+        releaseMutex();
+        if (isScheduleChanged && thisPtr->task.scheduler) timelapse_stop(thisPtr);
+        if (!schedule.isEnabled) {
+            xSemaphoreTake(thisPtr->wakeSemaphore, portMAX_DELAY);
+            continue;
+        }
+        if (!thisPtr->task.scheduler && timelapse_start(thisPtr, &schedule) != ERROR_NONE) {
+            xSemaphoreTake(thisPtr->wakeSemaphore, pdMS_TO_TICKS(TIMELAPSE_RETRY_MILLIS));
+            continue;
+        }
+        uint32_t waitMillis = 0;
+        if (!timelapseScheduler_next(thisPtr->task.scheduler, timelapse_nowMillis(), &waitMillis)) {
+            timelapse_stop(thisPtr);
+            timelapse_finishSchedule(thisPtr);
+            continue;
+        }
+        if (waitMillis > 0) {
+            // the sensor is in standby and this task is blocked, the CPU idles until the shot or a schedule change
+            if (waitMillis > TIMELAPSE_MAX_WAIT_MILLIS) waitMillis = TIMELAPSE_MAX_WAIT_MILLIS;
+            xSemaphoreTake(thisPtr->wakeSemaphore, pdMS_TO_TICKS(waitMillis));
+            continue;
+        }
+        TimelapseShotStats shot = {.index = timelapseScheduler_getShotIndex(thisPtr->task.scheduler)};
+        const Error err = timelapse_takeShot(thisPtr, &shot);
+        timelapse_recordShot(thisPtr, &shot, err);
+    }
+    taskWatcher_restartTask(TIMELAPSE_TASK_NAME);
+}
+
+public Error timelapse_init() {
+    this.mutex = xSemaphoreCreateMutex();
+    requireNotNull(this.mutex, ERROR_LIBRARY_FAILURE, "Could not create timelapse mutex");
+    this.wakeSemaphore = xSemaphoreCreateBinary();
+    requireNotNull(this.wakeSemaphore, ERROR_LIBRARY_FAILURE, "Could not create timelapse wake semaphore");
+    this.task.imageBuffer = alloc(TIMELAPSE_IMAGE_BUFFER_SIZE);
+    requireNotNull(this.task.imageBuffer, ERROR_LIBRARY_FAILURE, "Could not allocate timelapse image buffer");
+
+    this.schedule = (TimelapseSchedule) {
+            .isEnabled = false,
+            .intervalSeconds = 60,
+            .imageSize = CAMERA_IMAGE_SIZE_DEFAULT,
+            .imageQuality = CAMERA_IMAGE_QUALITY_HIGH,
+            .shotCount = 0,
+    };
+    TimelapseSchedule storedSchedule;
+    size_t length = sizeof(TimelapseSchedule);
+    if (settings_getBlob(SETTINGS_KEY_TIMELAPSE_SCHEDULE, &storedSchedule, &length) == SETTINGS_ERROR_NONE &&
+        length == sizeof(TimelapseSchedule) && timelapse_validateSchedule(&storedSchedule) == ERROR_NONE) {
+        this.schedule = storedSchedule;
+    }
+    this.isScheduleChanged = true;
+
+    this.task.isRunning = true;
+    TaskInfo taskInfo = {
+            .name = TIMELAPSE_TASK_NAME,
+            .taskFunction = timelapse_taskFunction,
+            .stackBytes = TIMELAPSE_TASK_STACK_SIZE,
+            .taskParameter = &this,
+            .taskPriority = TIMELAPSE_TASK_PRIORITY,
+            .taskHandle = this.task.handle
+    };
+    taskWatcher_addTask(&taskInfo);
+    taskWatcher_startTask(TIMELAPSE_TASK_NAME);
+    return ERROR_NONE;
+}
+
+public Error timelapse_setSchedule(const TimelapseSchedule *schedule) {
+    requireArgNotNull(schedule);
+    requireNotNull(this.mutex, ERROR_NOT_INITIALIZED, "Timelapse was not initialized");
+    throwIfError(timelapse_validateSchedule(schedule), "");
+    const SettingsError settingsErr = settings_putBlob(SETTINGS_KEY_TIMELAPSE_SCHEDULE, schedule,
+                                                       sizeof(TimelapseSchedule));
+    if (settingsErr != SETTINGS_ERROR_NONE) {
+        WARN("Could not store timelapse schedule, it will not survive a restart: %i", settingsErr);
+    }
+    obtainMutex();
+    this.schedule = *schedule;
+    this.isScheduleChanged = true;
+    releaseMutex();
+    xSemaphoreGive(this.wakeSemaphore);
+    return ERROR_NONE;
+}
+
+public Error timelapse_getSchedule(TimelapseSchedule *schedule) {
+    requireArgNotNull(schedule);
+    requireNotNull(this.mutex, ERROR_NOT_INITIALIZED, "Timelapse was not initialized");
+    obtainMutex();
+    *schedule = this.schedule;
+    releaseMutex();
+    return ERROR_NONE;
+}
+
+public Error timelapse_getStats(TimelapseStats *stats) {
+    requireArgNotNull(stats);
+    requireNotNull(this.mutex, ERROR_NOT_INITIALIZED, "Timelapse was not initialized");
+    obtainMutex();
+    *stats = this.stats;
+    releaseMutex();
+    return ERROR_NONE;
+}
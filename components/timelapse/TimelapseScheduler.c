@@ -0,0 +1,76 @@
+#include "TimelapseScheduler.h"
+#include <stdlib.h>
+
+typedef struct TimelapseSchedulerData {
+    uint32_t intervalMillis;
+    uint32_t shotCount;
+    uint64_t startMillis;
+    /** Shot the next call to next returns, taken and missed shots are both behind it */
+    uint32_t shotIndex;
+    uint32_t shotsTaken;
+    uint32_t shotsMissed;
+} TimelapseSchedulerData;
+
+private bool timelapseScheduler_isFinished(const TimelapseSchedulerData *this) {
+    return this->shotCount > 0 && this->shotIndex >= this->shotCount;
+}
+
+public TimelapseScheduler *timelapseScheduler_create(const uint32_t intervalMillis, const uint32_t shotCount,
+                                                     const uint64_t startMillis) {
+    if (intervalMillis == 0) return NULL;
+    TimelapseSchedulerData *this = new(TimelapseSchedulerData);
+    if (!this) return NULL;
+    this->intervalMillis = intervalMillis;
+    this->shotCount = shotCount;
+    this->startMillis = startMillis;
+    return this;
+}
+
+public void timelapseScheduler_destroy(TimelapseScheduler *timelapseScheduler) {
+    delete(timelapseScheduler);
+}
+
+public bool timelapseScheduler_next(TimelapseScheduler *timelapseScheduler, const uint64_t nowMillis,
+                                    uint32_t *waitMillis) {
+    if (!timelapseScheduler || !waitMillis) return false;
+    TimelapseSchedulerData *this = (TimelapseSchedulerData *) timelapseScheduler;
+    if (timelapseScheduler_isFinished(this)) return false;
+    const uint64_t dueMillis = this->startMillis + ((uint64_t) this->shotIndex * this->intervalMillis);
+    if (nowMillis >= dueMillis) {
+        // every shot due before now except the latest is missed, the latest is late by less than an interval
+        uint64_t missed = (nowMillis - dueMillis) / this->intervalMillis;
+        if (this->shotCount > 0 && this->shotIndex + missed >= this->shotCount) {
+            missed = this->shotCount - this->shotIndex;
+        }
+        this->shotIndex += missed;
+        this->shotsMissed += missed;
+        *waitMillis = 0;
+        return !timelapseScheduler_isFinished(this);
+    }
+    *waitMillis = (uint32_t) (dueMillis - nowMillis);
+    return true;
+}
+
+public void timelapseScheduler_recordShot(TimelapseScheduler *timelapseScheduler) {
+    if (!timelapseScheduler) return;
+    TimelapseSchedulerData *this = (TimelapseSchedulerData *) timelapseScheduler;
+    if (timelapseScheduler_isFinished(this)) return;
+    this->shotIndex++;
+    this->shotsTaken++;
+}
+
+public uint32_t timelapseScheduler_getShotIndex(const TimelapseScheduler *timelapseScheduler) {
+    if (!timelapseScheduler) return 0;
+    return ((const TimelapseSchedulerData *) timelapseScheduler)->shotIndex;
+}
+
+public void timelapseScheduler_getStats(const TimelapseScheduler *timelapseScheduler,
+                                        TimelapseSchedulerStats *stats) {
+    if (!timelapseScheduler || !stats) return;
+    const TimelapseSchedulerData *this = (const TimelapseSchedulerData *) timelapseScheduler;
+    *stats = (TimelapseSchedulerStats) {
+            .shotsTaken = this->shotsTaken,
+            .shotsMissed = this->shotsMissed,
+            .shotsRemaining = this->shotCount > 0 ? this->shotCount - this->shotIndex : 0,
+    };
+}
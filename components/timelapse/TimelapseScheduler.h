@@ -0,0 +1,43 @@
+#ifndef ESP32_REMOTECAMERA_TIMELAPSESCHEDULER_H
+#define ESP32_REMOTECAMERA_TIMELAPSESCHEDULER_H
+
+#include "Utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * When each shot of a timelapse is due, shot i is due intervalMillis * i after the start so time spent taking shots
+ * never pushes later shots back, shots that could not be taken in time are missed instead of taken late in a rush.
+ * Only does arithmetic on the times it is given so it can be tested without a clock
+ */
+typedef void TimelapseScheduler;
+
+typedef struct TimelapseSchedulerStats {
+    uint32_t shotsTaken;
+    /** Shots skipped because the previous shot or a stall ran past when they were due */
+    uint32_t shotsMissed;
+    /** 0 when the timelapse has no end */
+    uint32_t shotsRemaining;
+} TimelapseSchedulerStats;
+
+/** shotCount of 0 takes shots forever, the first shot is due at startMillis */
+extern TimelapseScheduler *timelapseScheduler_create(const uint32_t intervalMillis, const uint32_t shotCount,
+                                                     const uint64_t startMillis);
+
+extern void timelapseScheduler_destroy(TimelapseScheduler *timelapseScheduler);
+
+/** Whether there is a next shot, waitMillis receives how long from nowMillis until it is due (0 when it is due now),
+ * a shot an interval or more overdue is missed for the one due after it */
+extern bool timelapseScheduler_next(TimelapseScheduler *timelapseScheduler, const uint64_t nowMillis,
+                                    uint32_t *waitMillis);
+
+/** The shot timelapseScheduler_next() returned was taken, or attempted, the next shot is the one after it */
+extern void timelapseScheduler_recordShot(TimelapseScheduler *timelapseScheduler);
+
+/** Index of the next shot, also how many shots have been taken or missed */
+extern uint32_t timelapseScheduler_getShotIndex(const TimelapseScheduler *timelapseScheduler);
+
+extern void timelapseScheduler_getStats(const TimelapseScheduler *timelapseScheduler,
+                                        TimelapseSchedulerStats *stats);
+
+#endif //ESP32_REMOTECAMERA_TIMELAPSESCHEDULER_H
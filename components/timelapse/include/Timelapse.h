@@ -0,0 +1,70 @@
+#ifndef ESP32_REMOTECAMERA_TIMELAPSE_H
+#define ESP32_REMOTECAMERA_TIMELAPSE_H
+
+#include "Error.h"
+#include "Camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/** On the SD card, every timelapse is saved to its own numbered directory in here */
+#define TIMELAPSE_DIR "timelapse"
+#define TIMELAPSE_MIN_INTERVAL_SECONDS 1
+
+typedef struct TimelapseSchedule {
+    bool isEnabled;
+    uint32_t intervalSeconds;
+    CameraImageSize imageSize;
+    CameraImageQuality imageQuality;
+    /** 0 to take shots until the schedule is disabled */
+    uint32_t shotCount;
+} TimelapseSchedule;
+
+typedef struct TimelapseShotStats {
+    uint32_t index;
+    /** How long the sensor was in standby before this shot */
+    uint32_t standbyMillis;
+    /** Waking the sensor and capturing frames for exposure and white balance to settle */
+    uint32_t wakeMillis;
+    uint32_t captureMillis;
+    /** Reading the JPEG out of the FIFO and writing it to the SD card */
+    uint32_t writeMillis;
+    /** Saving the shot's thumbnail, with the sensor back in standby */
+    uint32_t thumbnailMillis;
+    uint32_t bytes;
+    /** Charge used for the shot and the standby before it, estimated from CONFIG_TIMELAPSE_ACTIVE_MILLIAMPS and
+     * CONFIG_TIMELAPSE_STANDBY_MILLIAMPS */
+    float estimatedMilliampHours;
+    float batteryVoltage;
+} TimelapseShotStats;
+
+typedef struct TimelapseStats {
+    bool isRunning;
+    /** Number of the directory in TIMELAPSE_DIR the running or last timelapse saves to */
+    uint32_t sequence;
+    uint32_t shotsTaken;
+    /** Shots not taken because the previous shot ran past when they were due */
+    uint32_t shotsMissed;
+    /** Shots that could not be captured or saved */
+    uint32_t shotsFailed;
+    /** 0 when the timelapse has no end */
+    uint32_t shotsRemaining;
+    uint32_t awakeMillis;
+    uint32_t standbyMillis;
+    float estimatedMilliampHours;
+    /** All 0 until the first shot */
+    TimelapseShotStats lastShot;
+} TimelapseStats;
+
+/** Starts the timelapse task and the schedule stored in settings if it was enabled, call after camera_init() */
+extern Error timelapse_init();
+
+/** Validates and stores schedule in settings and starts, restarts or stops the timelapse to match it, while a
+ * timelapse runs it has the camera, live capture is paused and the sensor is in standby between shots, the
+ * camera's settings and live capture are restored when it stops */
+extern Error timelapse_setSchedule(const TimelapseSchedule *schedule);
+
+extern Error timelapse_getSchedule(TimelapseSchedule *schedule);
+
+extern Error timelapse_getStats(TimelapseStats *stats);
+
+#endif //ESP32_REMOTECAMERA_TIMELAPSE_H
@@ -0,0 +1,71 @@
+#include "unity.h"
+#include "TestUtils.h"
+#include "TimelapseScheduler.h"
+
+#define TEST_TAG "[TimelapseScheduler]"
+#define TEST(name) TEST_CASE(name, TEST_TAG)
+#define XTEST(name) XTEST_CASE(name, TEST_TAG)
+
+TEST("TimelapseScheduler shots are due every interval from the start") {
+    TimelapseScheduler *scheduler = timelapseScheduler_create(1000, 3, 5000);
+    ASSERT_NOT_NULL(scheduler, "scheduler should not be NULL");
+    uint32_t waitMillis = 0;
+    ASSERT(timelapseScheduler_next(scheduler, 4000, &waitMillis), "first shot should be due");
+    ASSERT_UINT_EQUAL(1000, waitMillis, "wait until the start was incorrect");
+    ASSERT(timelapseScheduler_next(scheduler, 5000, &waitMillis), "first shot should be due");
+    ASSERT_UINT_EQUAL(0, waitMillis, "first shot should be due now");
+    timelapseScheduler_recordShot(scheduler);
+    // the shot took 300 ms, the next is still due a whole interval after the first was due
+    ASSERT(timelapseScheduler_next(scheduler, 5300, &waitMillis), "second shot should be due");
+    ASSERT_UINT_EQUAL(700, waitMillis, "shot time should not push the next shot back");
+    timelapseScheduler_recordShot(scheduler);
+    ASSERT(timelapseScheduler_next(scheduler, 7000, &waitMillis), "third shot should be due");
+    timelapseScheduler_recordShot(scheduler);
+    ASSERT_FALSE(timelapseScheduler_next(scheduler, 8000, &waitMillis), "there should be no fourth shot");
+    TimelapseSchedulerStats stats;
+    timelapseScheduler_getStats(scheduler, &stats);
+    ASSERT_UINT_EQUAL(3, stats.shotsTaken, "shots taken was incorrect");
+    ASSERT_UINT_EQUAL(0, stats.shotsMissed, "no shot should be missed");
+    ASSERT_UINT_EQUAL(0, stats.shotsRemaining, "no shot should remain");
+    timelapseScheduler_destroy(scheduler);
+}
+
+TEST("TimelapseScheduler misses shots instead of catching up") {
+    TimelapseScheduler *scheduler = timelapseScheduler_create(1000, 10, 0);
+    uint32_t waitMillis = 0;
+    timelapseScheduler_next(scheduler, 0, &waitMillis);
+    timelapseScheduler_recordShot(scheduler);
+    // stalled until shot 3 was due 500 ms ago, shots 1 and 2 are missed and shot 3 is taken late
+    ASSERT(timelapseScheduler_next(scheduler, 3500, &waitMillis), "a shot should be due");
+    ASSERT_UINT_EQUAL(0, waitMillis, "the late shot should be due now");
+    ASSERT_UINT_EQUAL(3, timelapseScheduler_getShotIndex(scheduler), "overdue shots should be skipped");
+    timelapseScheduler_recordShot(scheduler);
+    ASSERT(timelapseScheduler_next(scheduler, 3600, &waitMillis), "a shot should be due");
+    ASSERT_UINT_EQUAL(400, waitMillis, "the shot after the late one should keep its time");
+    TimelapseSchedulerStats stats;
+    timelapseScheduler_getStats(scheduler, &stats);
+    ASSERT_UINT_EQUAL(2, stats.shotsTaken, "shots taken was incorrect");
+    ASSERT_UINT_EQUAL(2, stats.shotsMissed, "shots missed was incorrect");
+    ASSERT_UINT_EQUAL(6, stats.shotsRemaining, "shots remaining was incorrect");
+
+    ASSERT_FALSE(timelapseScheduler_next(scheduler, 20000, &waitMillis), "every remaining shot should be missed");
+    timelapseScheduler_getStats(scheduler, &stats);
+    ASSERT_UINT_EQUAL(8, stats.shotsMissed, "missed shots should stop at the shot count");
+    timelapseScheduler_destroy(scheduler);
+}
+
+TEST("TimelapseScheduler with no shot count never ends") {
+    ASSERT(timelapseScheduler_create(0, 1, 0) == NULL, "an interval of 0 should be rejected");
+    TimelapseScheduler *scheduler = timelapseScheduler_create(60000, 0, 0);
+    uint32_t waitMillis = 0;
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT(timelapseScheduler_next(scheduler, (uint64_t) i * 60000, &waitMillis), "a shot should always be due");
+        timelapseScheduler_recordShot(scheduler);
+    }
+    ASSERT(timelapseScheduler_next(scheduler, 100ULL * 24 * 60 * 60 * 1000, &waitMillis),
+           "a shot should be due after 100 days");
+    TimelapseSchedulerStats stats;
+    timelapseScheduler_getStats(scheduler, &stats);
+    ASSERT_UINT_EQUAL(0, stats.shotsRemaining, "an endless timelapse has no shots remaining");
+    timelapseScheduler_destroy(scheduler);
+}
@@ -8,10 +8,29 @@
 #include "cJSON.h"
 #include "Battery.h"
 #include "Camera.h"
+#include "Timelapse.h"
+#include "Thumbnail.h"
+#include "TaskWatcher.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <unistd.h>
 
 #define FILE_BUFFER_SIZE 4096
 #define CAMERA_IMAGE_BUFFER_SIZE 4096
 #define CAMERA_SETTINGS_JSON_BUFFER_SIZE 1024
+#define CAMERA_SNAPSHOT_MAX_AGE_MILLIS 500 // a live frame this recent is shared instead of capturing a new one
+#define CAMERA_SEND_TASK_NAME "cameraSendTask"
+#define CAMERA_SEND_TASK_STACK_SIZE 4000
+#define CAMERA_SEND_TASK_PRIORITY ((configMAX_PRIORITIES - 1)/2)
+#define CAMERA_SEND_TASK_TAKE_TIMEOUT_MILLIS 1000
+#define CAMERA_BURST_DIR "bursts" // on the SD card, every burst is saved to its own directory in here
+#define CAMERA_BURST_DEFAULT_FRAMES 4
+#define CAMERA_BURST_MAX_INTERVAL_MILLIS 1000 // a burst holds the camera and the server, slower series are a timelapse
+#define CAMERA_BURST_QUERY_BUFFER_SIZE 64
+#define CAMERA_VIDEO_BENCHMARK_DEFAULT_FRAMES 14
+#define CAMERA_SENSOR_PROFILE_BENCHMARK_DEFAULT_FRAMES 5
+#define THUMBNAIL_QUERY_BUFFER_SIZE (EXTERNAL_STORAGE_MAX_PATH_LENGTH + 32)
 
 typedef struct {
     int fd; // socket file descriptor, used by ESP-IDF to send Web Socket Frames
@@ -32,16 +51,24 @@ private struct {
     } logWebsocketData;
     struct {
         List *socketsList; // list of sockets, a socket is an int
+        /** Guards socketsList and every socket's bytesSent, shared by the camera task, cameraSendTask and the server */
+        SemaphoreHandle_t socketsMutex;
         uint8_t *imageBuffer;
         size_t imageBufferLength;
         size_t bytesRead;
         size_t bytesRemaining;
+        /** Pooled frames are sent from cameraSendTask so a slow socket never holds up the camera task */
+        uint32_t frameConsumer;
+        TaskHandle_t sendTaskHandle;
+        bool isSendTaskRunning;
     } cameraWebsocketData;
 } this;
 
 #define requestHandler(name, uri) private esp_err_t requestHandler_ ## name(httpd_req_t *request)
 #define allowCORS(request) httpd_resp_set_hdr(request, "Access-Control-Allow-Origin", "*")
 #define finishRequest(request) httpd_resp_send_chunk(request, NULL, 0)
+#define obtainCameraSocketsMutex() xSemaphoreTake(this.cameraWebsocketData.socketsMutex, portMAX_DELAY)
+#define releaseCameraSocketsMutex() xSemaphoreGive(this.cameraWebsocketData.socketsMutex)
 #define addEndpoint(_uri, _method, _handler) \
 do{                                       \
 httpd_uri_t uriHandler = {.uri= _uri, .method= _method, .handler= requestHandler_ ## _handler};\
@@ -70,6 +97,31 @@ private bool cameraSocketsListEquals(const ListItem *a, const ListItem *b) {
     }
 }
 
+/** Forget the camera socket at index, it no longer watches live capture, the sockets mutex must be held */
+private void removeCameraSocket(List *socketsList, const int index) {
+    CameraWebSocket *cameraWebSocket = list_getItem(socketsList, index);
+    if (!cameraWebSocket) return;
+    list_removeItemIndexed(socketsList, index);
+    INFO("Removed socket fd: %i", cameraWebSocket->fd);
+    delete(cameraWebSocket);
+    camera_unsubscribeLiveCapture();
+}
+
+/** The server closes every socket through this, so a camera socket stops live capture as soon as it is gone rather
+ * than on the next failed send */
+private void closeSocket(httpd_handle_t server, int socketNumber) {
+    List *socketsList = this.cameraWebsocketData.socketsList;
+    CameraWebSocket closing = {.fd = socketNumber};
+    obtainCameraSocketsMutex();
+    index_t foundIndex = list_indexOfItemFunction(socketsList, &closing, cameraSocketsListEquals);
+    if (foundIndex != LIST_INVALID_INDEX_CAPACITY) {
+        removeCameraSocket(socketsList, foundIndex);
+        list_shrink(socketsList);
+    }
+    releaseCameraSocketsMutex();
+    close(socketNumber); // the server leaves closing to close_fn when there is one
+}
+
 requestHandler(404, NULL) {
     allowCORS(request);
     INFO("URI: %s", request->uri);
@@ -219,12 +271,85 @@ requestHandler(apiBattery, "/api/battery") {
     return ESP_OK;
 }
 
-private void cameraReadCallback(char *buffer, int bufferSize, void *userArgs) {
-    httpd_req_t *request = (httpd_req_t *) userArgs;
-    esp_err_t err = httpd_resp_send_chunk(request, buffer, bufferSize);
-    if (err) {
-        ERROR("httpd_resp_send_chunk() returned: %i: %s", err, esp_err_to_name(err));
+#define cameraSettingsFromJSON(json, settings, name, field, member) \
+do{                                                        \
+cJSON *item = cJSON_GetObjectItemCaseSensitive(json, name); \
+if (cJSON_IsNumber(item)) {                                \
+(settings)->fields |= (field);                             \
+(settings)->member = item->valueint;                       \
+}                                                          \
+} while(0)
+
+#define cameraSettingsToJSON(object, settings, name, field, member) \
+if ((settings)->fields & (field)) cJSON_AddNumberToObject(object, name, (settings)->member)
+
+/** Reads "region": {x, y, width, height} in sensor pixels or "zoom": {x, y, factor} with the centre x and y as
+ * fractions (0 to 1) of the image into settings, returns false for a zoom the camera can't do */
+private bool cameraRegionFromJSON(const cJSON *json, CameraSettings *settings) {
+    cJSON *region = cJSON_GetObjectItemCaseSensitive(json, "region");
+    if (cJSON_IsObject(region)) {
+        cJSON *x = cJSON_GetObjectItemCaseSensitive(region, "x");
+        cJSON *y = cJSON_GetObjectItemCaseSensitive(region, "y");
+        cJSON *width = cJSON_GetObjectItemCaseSensitive(region, "width");
+        cJSON *height = cJSON_GetObjectItemCaseSensitive(region, "height");
+        if (cJSON_IsNumber(x) && cJSON_IsNumber(y) && cJSON_IsNumber(width) && cJSON_IsNumber(height)) {
+            settings->fields |= CAMERA_SETTINGS_FIELD_REGION;
+            settings->region = (CameraRegion) {.x = x->valueint, .y = y->valueint,
+                    .width = width->valueint, .height = height->valueint};
+        }
+    }
+    cJSON *zoom = cJSON_GetObjectItemCaseSensitive(json, "zoom");
+    if (cJSON_IsObject(zoom)) {
+        cJSON *x = cJSON_GetObjectItemCaseSensitive(zoom, "x");
+        cJSON *y = cJSON_GetObjectItemCaseSensitive(zoom, "y");
+        cJSON *factor = cJSON_GetObjectItemCaseSensitive(zoom, "factor");
+        if (cJSON_IsNumber(factor)) {
+            const float centreX = cJSON_IsNumber(x) ? (float) x->valuedouble : 0.5F;
+            const float centreY = cJSON_IsNumber(y) ? (float) y->valuedouble : 0.5F;
+            if (camera_zoomRegion(centreX, centreY, (float) factor->valuedouble, &settings->region) != ERROR_NONE) {
+                return false;
+            }
+            settings->fields |= CAMERA_SETTINGS_FIELD_REGION;
+        }
+    }
+    return true;
+}
+
+/** Responds with the settings that are known, in the same shape as the webclient's CameraSettings */
+private void sendCameraSettings(httpd_req_t *request, const CameraSettings *settings) {
+    cJSON *settingsObject = cJSON_CreateObject();
+    if (settingsObject == NULL) {
+        httpd_resp_send_500(request);
+        return;
+    }
+    cameraSettingsToJSON(settingsObject, settings, "imageSize", CAMERA_SETTINGS_FIELD_IMAGE_SIZE, imageSize);
+    cameraSettingsToJSON(settingsObject, settings, "saturation", CAMERA_SETTINGS_FIELD_SATURATION, saturation);
+    cameraSettingsToJSON(settingsObject, settings, "brightness", CAMERA_SETTINGS_FIELD_BRIGHTNESS, brightness);
+    cameraSettingsToJSON(settingsObject, settings, "contrast", CAMERA_SETTINGS_FIELD_CONTRAST, contrast);
+    cameraSettingsToJSON(settingsObject, settings, "hue", CAMERA_SETTINGS_FIELD_HUE, hue);
+    cameraSettingsToJSON(settingsObject, settings, "exposure", CAMERA_SETTINGS_FIELD_EXPOSURE, exposure);
+    cameraSettingsToJSON(settingsObject, settings, "sharpness", CAMERA_SETTINGS_FIELD_SHARPNESS, sharpness);
+    cameraSettingsToJSON(settingsObject, settings, "imageQuality", CAMERA_SETTINGS_FIELD_IMAGE_QUALITY,
+                         imageQuality);
+    cameraSettingsToJSON(settingsObject, settings, "sensorProfile", CAMERA_SETTINGS_FIELD_SENSOR_PROFILE,
+                         sensorProfile);
+    cJSON_AddNumberToObject(settingsObject, "videoProfile", camera_getVideoProfile());
+    if (settings->fields & CAMERA_SETTINGS_FIELD_REGION) {
+        cJSON *regionObject = cJSON_AddObjectToObject(settingsObject, "region");
+        cJSON_AddNumberToObject(regionObject, "x", settings->region.x);
+        cJSON_AddNumberToObject(regionObject, "y", settings->region.y);
+        cJSON_AddNumberToObject(regionObject, "width", settings->region.width);
+        cJSON_AddNumberToObject(regionObject, "height", settings->region.height);
+    }
+    const char *json = cJSON_PrintUnformatted(settingsObject);
+    cJSON_Delete(settingsObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return;
     }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
 }
 
 requestHandler(cameraSettings, "/api/cameraSettings") {
@@ -236,9 +361,20 @@ requestHandler(cameraSettings, "/api/cameraSettings") {
 
     cJSON *json = cJSON_ParseWithOpts(this.cameraSettingsJSONBuffer, NULL, true);
 
-    cJSON *imageSize = cJSON_GetObjectItemCaseSensitive(json, "imageSize");
-    if (cJSON_IsNumber(imageSize)) {
-        camera_setImageSize(imageSize->valueint);
+    CameraSettings settings = {.fields = 0};
+    cameraSettingsFromJSON(json, &settings, "imageSize", CAMERA_SETTINGS_FIELD_IMAGE_SIZE, imageSize);
+    cameraSettingsFromJSON(json, &settings, "saturation", CAMERA_SETTINGS_FIELD_SATURATION, saturation);
+    cameraSettingsFromJSON(json, &settings, "brightness", CAMERA_SETTINGS_FIELD_BRIGHTNESS, brightness);
+    cameraSettingsFromJSON(json, &settings, "contrast", CAMERA_SETTINGS_FIELD_CONTRAST, contrast);
+    cameraSettingsFromJSON(json, &settings, "hue", CAMERA_SETTINGS_FIELD_HUE, hue);
+    cameraSettingsFromJSON(json, &settings, "exposure", CAMERA_SETTINGS_FIELD_EXPOSURE, exposure);
+    cameraSettingsFromJSON(json, &settings, "sharpness", CAMERA_SETTINGS_FIELD_SHARPNESS, sharpness);
+    cameraSettingsFromJSON(json, &settings, "imageQuality", CAMERA_SETTINGS_FIELD_IMAGE_QUALITY, imageQuality);
+    cameraSettingsFromJSON(json, &settings, "sensorProfile", CAMERA_SETTINGS_FIELD_SENSOR_PROFILE, sensorProfile);
+    if (!cameraRegionFromJSON(json, &settings)) {
+        cJSON_Delete(json);
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Zoom out of range, no settings were applied");
+        return ESP_OK;
     }
 
     cJSON *minutesUntilStandby = cJSON_GetObjectItemCaseSensitive(json, "minutesUntilStandby");
@@ -246,65 +382,906 @@ requestHandler(cameraSettings, "/api/cameraSettings") {
         // TODO: 12-Nov-2022 @basshelal: Implement
     }
 
-    cJSON *saturation = cJSON_GetObjectItemCaseSensitive(json, "saturation");
-    if (cJSON_IsNumber(saturation)) {
-        camera_setSaturation(saturation->valueint);
+    // anything that can be rejected is checked or undone before the rest is applied, so a 400 means nothing changed
+    cJSON *liveCaptureMode = cJSON_GetObjectItemCaseSensitive(json, "liveCaptureMode");
+    const bool hasLiveCaptureMode = cJSON_IsNumber(liveCaptureMode);
+    const CameraLiveCaptureMode liveCaptureModeValue = hasLiveCaptureMode ? liveCaptureMode->valueint : 0;
+    if (hasLiveCaptureMode && liveCaptureModeValue != CAMERA_LIVE_CAPTURE_MODE_SERIAL &&
+        liveCaptureModeValue != CAMERA_LIVE_CAPTURE_MODE_PIPELINED) {
+        cJSON_Delete(json);
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Unknown live capture mode, no settings were applied");
+        return ESP_OK;
     }
 
-    cJSON *brightness = cJSON_GetObjectItemCaseSensitive(json, "brightness");
-    if (cJSON_IsNumber(brightness)) {
-        camera_setBrightness(brightness->valueint);
+    // a target of 0 hands image size and quality back to the user
+    cJSON *targetFps = cJSON_GetObjectItemCaseSensitive(json, "targetFps");
+    cJSON *targetKbps = cJSON_GetObjectItemCaseSensitive(json, "targetKbps");
+    const bool hasQualityTarget = cJSON_IsNumber(targetFps) || cJSON_IsNumber(targetKbps);
+    CameraQualityTarget qualityTarget;
+    if (hasQualityTarget) {
+        camera_getQualityTarget(&qualityTarget);
+        cJSON *target = cJSON_IsNumber(targetFps) ? targetFps : targetKbps;
+        qualityTarget.value = (float) target->valuedouble;
+        qualityTarget.mode = qualityTarget.value <= 0.0F ? CAMERA_QUALITY_TARGET_MODE_NONE :
+                             target == targetFps ? CAMERA_QUALITY_TARGET_MODE_FPS : CAMERA_QUALITY_TARGET_MODE_KBPS;
     }
 
-    cJSON *contrast = cJSON_GetObjectItemCaseSensitive(json, "contrast");
-    if (cJSON_IsNumber(contrast)) {
-        camera_setContrast(contrast->valueint);
+    const CameraVideoProfile previousVideoProfile = camera_getVideoProfile();
+    cJSON *videoProfile = cJSON_GetObjectItemCaseSensitive(json, "videoProfile");
+    if (cJSON_IsNumber(videoProfile) && camera_setVideoProfile(videoProfile->valueint) != ERROR_NONE) {
+        cJSON_Delete(json);
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Could not set video profile, no settings were applied");
+        return ESP_OK;
     }
+    if (camera_getVideoProfile() != CAMERA_VIDEO_PROFILE_NONE) { // the profile fixes them, the rest still apply
+        settings.fields &= ~(CAMERA_SETTINGS_FIELD_IMAGE_SIZE | CAMERA_SETTINGS_FIELD_REGION |
+                             CAMERA_SETTINGS_FIELD_SENSOR_PROFILE);
+    }
+
+    cJSON_Delete(json);
 
-    cJSON *hue = cJSON_GetObjectItemCaseSensitive(json, "hue");
-    if (cJSON_IsNumber(hue)) {
-        camera_setHue(hue->valueint);
+    // all register settings go to the camera in one batch between 2 live frames, instead of one lock per setting
+    CameraSettings effectiveSettings;
+    const Error err = camera_applySettings(&settings, &effectiveSettings);
+    if (err != ERROR_NONE && camera_getVideoProfile() != previousVideoProfile) {
+        camera_setVideoProfile(previousVideoProfile);
     }
+    if (err == ERROR_OUT_OF_BOUNDS) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Camera setting out of range, no settings were applied");
+        return ESP_OK;
+    } else if (err == ERROR_ILLEGAL_STATE) { // such as a region with the streaming sensor profile
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Camera settings conflict, no settings were applied");
+        return ESP_OK;
+    } else if (err != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Unknown error occurred applying camera settings");
+        return ESP_OK;
+    }
+    if (hasLiveCaptureMode) camera_setLiveCaptureMode(liveCaptureModeValue);
+    if (hasQualityTarget) camera_setQualityTarget(&qualityTarget);
+    sendCameraSettings(request, &effectiveSettings);
 
-    cJSON *exposure = cJSON_GetObjectItemCaseSensitive(json, "exposure");
-    if (cJSON_IsNumber(exposure)) {
-        camera_setExposure(exposure->valueint);
+    return ESP_OK;
+}
+
+requestHandler(getCameraSettings, "/api/cameraSettings") {
+    allowCORS(request);
+    CameraSettings settings;
+    camera_getSettings(&settings);
+    sendCameraSettings(request, &settings);
+    return ESP_OK;
+}
+
+requestHandler(apiCamera, "/api/camera") {
+    allowCORS(request);
+
+    CameraFrame *frame = NULL;
+    if (camera_acquireFrame(CAMERA_SNAPSHOT_MAX_AGE_MILLIS, &frame) == ERROR_NONE) {
+        httpd_resp_set_type(request, "image/jpeg");
+        esp_err_t espErr = httpd_resp_send(request, (const char *) frame->data, (ssize_t) frame->length);
+        if (espErr != ESP_OK) {
+            ERROR("httpd_resp_send() returned: %i: %s", espErr, esp_err_to_name(espErr));
+        }
+        camera_releaseFrame(frame);
+        return ESP_OK;
     }
 
-    cJSON *sharpness = cJSON_GetObjectItemCaseSensitive(json, "sharpness");
-    if (cJSON_IsNumber(sharpness)) {
-        camera_setSharpness(sharpness->valueint);
+    // frames at this image size are too large to pool, capture and stream one straight out of the FIFO, a timelapse
+    // shot captured while this waited is shared instead (other snapshots wait for this handler, there is 1 server task)
+    CameraFrameCursor cursor;
+    if (camera_openFrame(0, &cursor) != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Unknown error occurred capturing image");
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "image/jpeg");
+    Error err = ERROR_NONE;
+    esp_err_t espErr = ESP_OK;
+    while (err == ERROR_NONE && espErr == ESP_OK && !cursor.isComplete) {
+        size_t bytesRead = 0;
+        err = camera_readFrame(&cursor, (uint8_t *) this.imageBuffer, CAMERA_IMAGE_BUFFER_SIZE, &bytesRead);
+        if (err == ERROR_NONE && bytesRead > 0) espErr = httpd_resp_send_chunk(request, this.imageBuffer, bytesRead);
+    }
+    camera_closeFrame(&cursor); // as soon as the client is gone, the rest of the frame is never read
+    if (espErr != ESP_OK) {
+        ERROR("httpd_resp_send_chunk() returned: %i: %s", espErr, esp_err_to_name(espErr));
+    } else if (err == ERROR_NONE) {
+        finishRequest(request);
+    } else {
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Unknown error occurred capturing image");
     }
 
-    cJSON *imageQuality = cJSON_GetObjectItemCaseSensitive(json, "imageQuality");
-    if (cJSON_IsNumber(imageQuality)) {
-        camera_setImageQuality(imageQuality->valueint);
+    return ESP_OK;
+}
+
+private void addStatsSummaryToJSON(cJSON *object, const char *name, const CameraStatsSummary *summary) {
+    cJSON *summaryObject = cJSON_AddObjectToObject(object, name);
+    if (summaryObject == NULL) return;
+    cJSON_AddNumberToObject(summaryObject, "count", summary->count);
+    cJSON_AddNumberToObject(summaryObject, "min", summary->min);
+    cJSON_AddNumberToObject(summaryObject, "max", summary->max);
+    cJSON_AddNumberToObject(summaryObject, "mean", summary->mean);
+    cJSON_AddNumberToObject(summaryObject, "p50", summary->p50);
+    cJSON_AddNumberToObject(summaryObject, "p95", summary->p95);
+    cJSON_AddNumberToObject(summaryObject, "p99", summary->p99);
+}
+
+requestHandler(apiCameraStats, "/api/camera/stats") {
+    allowCORS(request);
+    /*{ captureMicros: Summary, readoutMicros: Summary, chunkMicros: Summary, frameMicros: Summary,
+     * frameBytes: Summary, framesCompleted: number, framesDropped: number, elapsedMillis: number,
+     * start: { isWarm: boolean, registersWritten: number, configureMillis: number, firstFrameMillis: number },
+     * liveDemand: { subscribers: number, isRunning: boolean, starts: number, runningMillis: number,
+     * idleMillis: number, dutyCyclePercent: number, lastWarmUpMillis: number, lingerMillis: number } }
+     * Summary is { count, min, max, mean, p50, p95, p99 }*/
+    CameraCaptureStats captureStats;
+    if (camera_getCaptureStats(&captureStats) != ERROR_NONE) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON *statsObject = cJSON_CreateObject();
+    if (statsObject == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    addStatsSummaryToJSON(statsObject, "captureMicros", &captureStats.captureMicros);
+    addStatsSummaryToJSON(statsObject, "readoutMicros", &captureStats.readoutMicros);
+    addStatsSummaryToJSON(statsObject, "chunkMicros", &captureStats.chunkMicros);
+    addStatsSummaryToJSON(statsObject, "frameMicros", &captureStats.frameMicros);
+    addStatsSummaryToJSON(statsObject, "frameBytes", &captureStats.frameBytes);
+    cJSON_AddNumberToObject(statsObject, "framesCompleted", captureStats.framesCompleted);
+    cJSON_AddNumberToObject(statsObject, "framesDropped", captureStats.framesDropped);
+    cJSON_AddNumberToObject(statsObject, "elapsedMillis", captureStats.elapsedMillis);
+    CameraStartStats startStats;
+    if (camera_getStartStats(&startStats) == ERROR_NONE) {
+        cJSON *startObject = cJSON_AddObjectToObject(statsObject, "start");
+        cJSON_AddBoolToObject(startObject, "isWarm", startStats.isWarm);
+        cJSON_AddNumberToObject(startObject, "registersWritten", startStats.registersWritten);
+        cJSON_AddNumberToObject(startObject, "configureMillis", startStats.configureMillis);
+        cJSON_AddNumberToObject(startObject, "firstFrameMillis", startStats.firstFrameMillis);
+    }
+    CameraLiveDemandStats liveDemandStats;
+    if (camera_getLiveDemandStats(&liveDemandStats) == ERROR_NONE) {
+        cJSON *liveDemandObject = cJSON_AddObjectToObject(statsObject, "liveDemand");
+        cJSON_AddNumberToObject(liveDemandObject, "subscribers", liveDemandStats.subscribers);
+        cJSON_AddBoolToObject(liveDemandObject, "isRunning", liveDemandStats.isRunning);
+        cJSON_AddNumberToObject(liveDemandObject, "starts", liveDemandStats.starts);
+        cJSON_AddNumberToObject(liveDemandObject, "runningMillis", liveDemandStats.runningMillis);
+        cJSON_AddNumberToObject(liveDemandObject, "idleMillis", liveDemandStats.idleMillis);
+        cJSON_AddNumberToObject(liveDemandObject, "dutyCyclePercent", liveDemandStats.dutyCyclePercent);
+        cJSON_AddNumberToObject(liveDemandObject, "lastWarmUpMillis", liveDemandStats.lastWarmUpMillis);
+        cJSON_AddNumberToObject(liveDemandObject, "lingerMillis", liveDemandStats.lingerMillis);
+    }
+    const char *json = cJSON_PrintUnformatted(statsObject);
+    cJSON_Delete(statsObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
     }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
 
-    cJSON_Delete(json);
+private const char *const CAMERA_REQUEST_CLASS_NAMES[CAMERA_REQUEST_CLASS_COUNT] = {
+        [CAMERA_REQUEST_CLASS_STILL] = "still",
+        [CAMERA_REQUEST_CLASS_LIVE] = "live",
+        [CAMERA_REQUEST_CLASS_SETTINGS] = "settings",
+        [CAMERA_REQUEST_CLASS_BURST] = "burst",
+};
 
-    httpd_resp_set_status(request, HTTPD_200);
-    finishRequest(request);
+requestHandler(apiCameraScheduler, "/api/camera/scheduler") {
+    allowCORS(request);
+    /*{ requestsRefused: number, classes: { still: Class, live: Class, settings: Class, burst: Class } }
+     * Class is { requests: number, coalesced: number, deadlinesMissed: number, waiting: number,
+     * queueMicros: Summary }*/
+    CameraSchedulerStats schedulerStats;
+    if (camera_getSchedulerStats(&schedulerStats) != ERROR_NONE) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON *schedulerObject = cJSON_CreateObject();
+    if (schedulerObject == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON_AddNumberToObject(schedulerObject, "requestsRefused", schedulerStats.requestsRefused);
+    cJSON *classesObject = cJSON_AddObjectToObject(schedulerObject, "classes");
+    for (uint i = 0; i < CAMERA_REQUEST_CLASS_COUNT && classesObject != NULL; i++) {
+        const CameraRequestClassStats *classStats = &schedulerStats.classes[i];
+        cJSON *classObject = cJSON_AddObjectToObject(classesObject, CAMERA_REQUEST_CLASS_NAMES[i]);
+        if (classObject == NULL) continue;
+        cJSON_AddNumberToObject(classObject, "requests", classStats->requests);
+        cJSON_AddNumberToObject(classObject, "coalesced", classStats->coalesced);
+        cJSON_AddNumberToObject(classObject, "deadlinesMissed", classStats->deadlinesMissed);
+        cJSON_AddNumberToObject(classObject, "waiting", classStats->waiting);
+        addStatsSummaryToJSON(classObject, "queueMicros", &classStats->queueMicros);
+    }
+    const char *json = cJSON_PrintUnformatted(schedulerObject);
+    cJSON_Delete(schedulerObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
 
+requestHandler(apiCameraStatsReset, "/api/camera/stats/reset") {
+    allowCORS(request);
+    if (camera_resetCaptureStats() != ERROR_NONE) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_sendstr(request, "");
     return ESP_OK;
 }
 
-requestHandler(apiCamera, "/api/camera") {
+requestHandler(apiCameraQuality, "/api/camera/quality") {
     allowCORS(request);
+    /*{ mode: number, target: number, action: number, reason: number, isAtLimit: boolean, imageSize: number,
+     * imageQuality: number, measuredFps: number, measuredKbps: number, measuredFrameBytes: number,
+     * framesDropped: number, stepCount: number }*/
+    CameraQualityTarget target;
+    CameraQualityDecision decision;
+    if (camera_getQualityTarget(&target) != ERROR_NONE || camera_getQualityDecision(&decision) != ERROR_NONE) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON *qualityObject = cJSON_CreateObject();
+    if (qualityObject == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON_AddNumberToObject(qualityObject, "mode", target.mode);
+    cJSON_AddNumberToObject(qualityObject, "target", target.value);
+    cJSON_AddNumberToObject(qualityObject, "action", decision.action);
+    cJSON_AddNumberToObject(qualityObject, "reason", decision.reason);
+    cJSON_AddBoolToObject(qualityObject, "isAtLimit", decision.isAtLimit);
+    cJSON_AddNumberToObject(qualityObject, "imageSize", decision.imageSize);
+    cJSON_AddNumberToObject(qualityObject, "imageQuality", decision.imageQuality);
+    cJSON_AddNumberToObject(qualityObject, "measuredFps", decision.measuredFps);
+    cJSON_AddNumberToObject(qualityObject, "measuredKbps", decision.measuredKbps);
+    cJSON_AddNumberToObject(qualityObject, "measuredFrameBytes", decision.measuredFrameBytes);
+    cJSON_AddNumberToObject(qualityObject, "framesDropped", decision.framesDropped);
+    cJSON_AddNumberToObject(qualityObject, "stepCount", decision.stepCount);
+    const char *json = cJSON_PrintUnformatted(qualityObject);
+    cJSON_Delete(qualityObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
 
-    uint32_t imageSize;
-    Error err = camera_captureImage(&imageSize);
-    INFO("Captured image size: %u", imageSize);
-    if (err == ERROR_NONE) {
-        httpd_resp_set_type(request, "image/jpeg");
-        camera_readImageBufferedWithCallback(this.imageBuffer, CAMERA_IMAGE_BUFFER_SIZE, imageSize,
-                                             cameraReadCallback, request);
-        finishRequest(request);
+private void cameraRegisterCallback(const uint16_t address, const uint8_t value, void *userArg) {
+    cJSON *registersObject = (cJSON *) userArg;
+    char key[8];
+    sprintf(key, "0x%04x", address);
+    cJSON_AddNumberToObject(registersObject, key, value);
+}
+
+typedef struct BurstFileContext {
+    const char *dirPath;
+    char path[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+    FILE *file;
+    size_t position;
+    uint32_t filesSaved;
+} BurstFileContext;
+
+/** Writes every burst frame to its own file in the burst's directory, a dropped frame's file is deleted */
+private void burstFileCallback(const CameraBurstFrame *frame, const uint8_t *segment, const size_t segmentLength,
+                               void *userArg) {
+    BurstFileContext *context = (BurstFileContext *) userArg;
+    if (context->file == NULL && segmentLength > 0) {
+        snprintf(context->path, sizeof(context->path), "%s/%02u.jpg", context->dirPath, frame->index);
+        if (externalStorage_openFile(context->path, &context->file, FILE_MODE_WRITE) != ERROR_NONE) {
+            context->file = NULL;
+        }
+        context->position = 0;
+    }
+    if (context->file == NULL) return;
+    if (segmentLength > 0) {
+        uint bytesWritten = 0;
+        externalStorage_writeFile(context->file, context->position, segment, segmentLength, &bytesWritten);
+        context->position += bytesWritten;
+    }
+    if (frame->isComplete || frame->isDropped) {
+        externalStorage_closeFile(context->file);
+        context->file = NULL;
+        if (frame->isDropped) {
+            externalStorage_deleteFile(context->path);
+        } else {
+            context->filesSaved++;
+        }
+    }
+}
+
+/** Creates a new directory for a burst's frames on the SD card, false when there is no SD card to save them to */
+private bool createBurstDir(char *dirPath, const size_t dirPathLength) {
+    if (!externalStorage_hasSDCard()) return false;
+    bool dirExists = false;
+    externalStorage_queryDirExists(CAMERA_BURST_DIR, &dirExists);
+    if (!dirExists) externalStorage_createDir(CAMERA_BURST_DIR);
+    snprintf(dirPath, dirPathLength, "%s/%lu", CAMERA_BURST_DIR, (unsigned long) esp_log_early_timestamp());
+    return externalStorage_createDir(dirPath) == ERROR_NONE;
+}
+
+/** Reads an unsigned number from the request's query string, defaultValue when it is not there */
+private uint32_t queryUInt(httpd_req_t *request, const char *key, const uint32_t defaultValue) {
+    char query[CAMERA_BURST_QUERY_BUFFER_SIZE];
+    char value[16];
+    if (httpd_req_get_url_query_str(request, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+        return defaultValue;
+    }
+    return (uint32_t) strtoul(value, NULL, 10);
+}
+
+requestHandler(apiCameraBurst, "/api/camera/burst") {
+    allowCORS(request);
+    /*{ frameCount: number, framesDropped: number, triggerCount: number, elapsedMillis: number, fps: number,
+     * directory: string | null, frames: [{ index: number, bytes: number, timestampMicros: number }] }*/
+    const uint32_t frameCount = queryUInt(request, "frames", CAMERA_BURST_DEFAULT_FRAMES);
+    const uint32_t intervalMillis = queryUInt(request, "interval", 0);
+    if (frameCount == 0 || frameCount > CAMERA_BURST_MAX_FRAMES) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Burst frames out of range");
+        return ESP_OK;
+    }
+    if (intervalMillis > CAMERA_BURST_MAX_INTERVAL_MILLIS) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Burst interval out of range");
+        return ESP_OK;
+    }
+
+    CameraBurst *burst = new(CameraBurst);
+    if (burst == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+
+    // without an SD card the burst is only timed, the frames are not kept anywhere
+    char dirPath[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+    BurstFileContext fileContext = {.dirPath = dirPath};
+    const bool isSaving = createBurstDir(dirPath, sizeof(dirPath));
+    const Error err = camera_captureBurst(frameCount, intervalMillis, isSaving ? burstFileCallback : NULL,
+                                          &fileContext, burst);
+    if (err != ERROR_NONE && burst->frameCount == 0) {
+        delete(burst);
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Unknown error occurred capturing burst");
+        return ESP_OK;
+    }
+    cJSON *burstObject = cJSON_CreateObject();
+    cJSON *framesArray = cJSON_AddArrayToObject(burstObject, "frames");
+    if (burstObject == NULL || framesArray == NULL) {
+        cJSON_Delete(burstObject);
+        delete(burst);
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON_AddNumberToObject(burstObject, "frameCount", burst->frameCount);
+    cJSON_AddNumberToObject(burstObject, "framesDropped", burst->framesDropped);
+    cJSON_AddNumberToObject(burstObject, "triggerCount", burst->triggerCount);
+    cJSON_AddNumberToObject(burstObject, "elapsedMillis", burst->elapsedMillis);
+    cJSON_AddNumberToObject(burstObject, "fps", burst->fps);
+    if (isSaving) {
+        cJSON_AddStringToObject(burstObject, "directory", dirPath);
     } else {
+        cJSON_AddNullToObject(burstObject, "directory");
+    }
+    for (uint32_t i = 0; i < burst->frameCount; i++) {
+        cJSON *frameObject = cJSON_CreateObject();
+        if (frameObject == NULL) continue;
+        cJSON_AddNumberToObject(frameObject, "index", burst->frames[i].index);
+        cJSON_AddNumberToObject(frameObject, "bytes", burst->frames[i].bytes);
+        cJSON_AddNumberToObject(frameObject, "timestampMicros", burst->frames[i].timestampMicros);
+        cJSON_AddItemToArray(framesArray, frameObject);
+    }
+    delete(burst);
+    const char *json = cJSON_PrintUnformatted(burstObject);
+    cJSON_Delete(burstObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
+
+private void addCaptureBenchmarkToJSON(cJSON *parent, const char *name, const CameraCaptureBenchmark *benchmark) {
+    cJSON *benchmarkObject = cJSON_AddObjectToObject(parent, name);
+    if (benchmarkObject == NULL) return;
+    cJSON_AddNumberToObject(benchmarkObject, "frameCount", benchmark->frameCount);
+    cJSON_AddNumberToObject(benchmarkObject, "bytesRead", benchmark->bytesRead);
+    cJSON_AddNumberToObject(benchmarkObject, "elapsedMillis", benchmark->elapsedMillis);
+    cJSON_AddNumberToObject(benchmarkObject, "fps", benchmark->fps);
+    cJSON_AddNumberToObject(benchmarkObject, "controlTransfers", benchmark->controlTransfers);
+}
+
+requestHandler(apiCameraVideoBenchmark, "/api/camera/video/benchmark") {
+    allowCORS(request);
+    /*{ profile: number, stillImageSize: number, directory: string | null,
+     * still: Benchmark, video: Benchmark }
+     * Benchmark is { frameCount, bytesRead, elapsedMillis, fps, controlTransfers }*/
+    const CameraVideoProfile profile = queryUInt(request, "profile", CAMERA_VIDEO_PROFILE_720P);
+    const uint32_t frameCount = queryUInt(request, "frames", CAMERA_VIDEO_BENCHMARK_DEFAULT_FRAMES);
+    const bool isRecording = queryUInt(request, "record", 0) != 0;
+    const uint32_t maxFrameCount = isRecording ? CAMERA_BURST_MAX_FRAMES / 2 : CAMERA_VIDEO_BENCHMARK_MAX_FRAMES;
+    if (frameCount == 0 || frameCount > maxFrameCount) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Video benchmark frames out of range");
+        return ESP_OK;
+    }
+
+    // recording saves every frame to the SD card like a burst, else the frames stream to the live consumers
+    char dirPath[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+    BurstFileContext fileContext = {.dirPath = dirPath};
+    const bool isSaving = isRecording && createBurstDir(dirPath, sizeof(dirPath));
+    if (isRecording && !isSaving) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "No SD card to record to");
+        return ESP_OK;
+    }
+
+    CameraVideoBenchmark benchmark;
+    const Error err = camera_benchmarkVideo(profile, frameCount, isSaving ? burstFileCallback : NULL, &fileContext,
+                                            &benchmark);
+    if (err == ERROR_ILLEGAL_ARGUMENT || err == ERROR_OUT_OF_BOUNDS) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Video profile or frames out of range");
+        return ESP_OK;
+    } else if (err != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Unknown error occurred benchmarking video");
+        return ESP_OK;
+    }
+    cJSON *benchmarkObject = cJSON_CreateObject();
+    if (benchmarkObject == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON_AddNumberToObject(benchmarkObject, "profile", benchmark.profile);
+    cJSON_AddNumberToObject(benchmarkObject, "stillImageSize", benchmark.stillImageSize);
+    if (isSaving) {
+        cJSON_AddStringToObject(benchmarkObject, "directory", dirPath);
+    } else {
+        cJSON_AddNullToObject(benchmarkObject, "directory");
+    }
+    addCaptureBenchmarkToJSON(benchmarkObject, "still", &benchmark.still);
+    addCaptureBenchmarkToJSON(benchmarkObject, "video", &benchmark.video);
+    const char *json = cJSON_PrintUnformatted(benchmarkObject);
+    cJSON_Delete(benchmarkObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
+
+requestHandler(apiCameraSensorProfileBenchmark, "/api/camera/profiles/benchmark") {
+    allowCORS(request);
+    /*{ results: [{ profile: number, imageSize: number, frameCount: number, captureMillis: number, fifoBytes: number,
+     * fps: number }] }*/
+    const uint32_t frameCount = queryUInt(request, "frames", CAMERA_SENSOR_PROFILE_BENCHMARK_DEFAULT_FRAMES);
+    if (frameCount == 0 || frameCount > CAMERA_SENSOR_PROFILE_BENCHMARK_MAX_FRAMES) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Sensor profile benchmark frames out of range");
+        return ESP_OK;
+    }
+    const size_t resultCount = CAMERA_SENSOR_PROFILE_COUNT * CAMERA_IMAGE_SIZE_COUNT;
+    CameraSensorProfileBenchmark *results = alloc(resultCount * sizeof(CameraSensorProfileBenchmark));
+    if (results == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    const Error err = camera_benchmarkSensorProfiles(frameCount, results);
+    if (err == ERROR_ILLEGAL_ARGUMENT || err == ERROR_OUT_OF_BOUNDS) {
+        delete(results);
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Frames out of range");
+        return ESP_OK;
+    } else if (err != ERROR_NONE) {
+        delete(results);
         httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "Unknown error occurred capturing image");
+                            "Unknown error occurred benchmarking sensor profiles");
+        return ESP_OK;
+    }
+    cJSON *benchmarkObject = cJSON_CreateObject();
+    cJSON *resultsArray = cJSON_AddArrayToObject(benchmarkObject, "results");
+    if (benchmarkObject == NULL || resultsArray == NULL) {
+        cJSON_Delete(benchmarkObject);
+        delete(results);
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    for (size_t i = 0; i < resultCount; i++) {
+        cJSON *resultObject = cJSON_CreateObject();
+        if (resultObject == NULL) continue;
+        cJSON_AddNumberToObject(resultObject, "profile", results[i].profile);
+        cJSON_AddNumberToObject(resultObject, "imageSize", results[i].imageSize);
+        cJSON_AddNumberToObject(resultObject, "frameCount", results[i].frameCount);
+        cJSON_AddNumberToObject(resultObject, "captureMillis", results[i].captureMillis);
+        cJSON_AddNumberToObject(resultObject, "fifoBytes", results[i].fifoBytes);
+        cJSON_AddNumberToObject(resultObject, "fps", results[i].fps);
+        cJSON_AddItemToArray(resultsArray, resultObject);
+    }
+    delete(results);
+    const char *json = cJSON_PrintUnformatted(benchmarkObject);
+    cJSON_Delete(benchmarkObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
+
+requestHandler(apiCameraSPICalibrate, "/api/camera/spi/calibrate") {
+    allowCORS(request);
+    /*{ steps: [{ clockHz: number, isRegisterOk: boolean, isFrameOk: boolean, frameBytes: number,
+     * readoutMBps: number }], isTestBarStable: boolean, fastestReliableHz: number, clockHz: number }*/
+    CameraSPIClockCalibration calibration;
+    if (camera_calibrateSPIClock(&calibration) != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Unknown error occurred calibrating SPI clock");
+        return ESP_OK;
+    }
+    cJSON *calibrationObject = cJSON_CreateObject();
+    if (calibrationObject == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON *stepsArray = cJSON_AddArrayToObject(calibrationObject, "steps");
+    for (uint i = 0; i < calibration.stepCount; i++) {
+        cJSON *stepObject = cJSON_CreateObject();
+        if (stepObject == NULL) continue;
+        cJSON_AddNumberToObject(stepObject, "clockHz", calibration.steps[i].clockHz);
+        cJSON_AddBoolToObject(stepObject, "isRegisterOk", calibration.steps[i].isRegisterOk);
+        cJSON_AddBoolToObject(stepObject, "isFrameOk", calibration.steps[i].isFrameOk);
+        cJSON_AddNumberToObject(stepObject, "frameBytes", calibration.steps[i].frameBytes);
+        cJSON_AddNumberToObject(stepObject, "readoutMBps", calibration.steps[i].readoutMBps);
+        cJSON_AddItemToArray(stepsArray, stepObject);
+    }
+    cJSON_AddBoolToObject(calibrationObject, "isTestBarStable", calibration.isTestBarStable);
+    cJSON_AddNumberToObject(calibrationObject, "fastestReliableHz", calibration.fastestReliableHz);
+    cJSON_AddNumberToObject(calibrationObject, "clockHz", calibration.clockHz);
+    const char *json = cJSON_PrintUnformatted(calibrationObject);
+    cJSON_Delete(calibrationObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
+
+/** Responds with the motion detection options and stats */
+private void sendCameraMotion(httpd_req_t *request) {
+    /*{ isEnabled: boolean, threshold: number, triggerPercent: number, backgroundShift: number, quietFrames: number,
+     * zones: [{ left: number, top: number, width: number, height: number }],
+     * stats: { isMotion: boolean, framesAnalysed: number, framesFailed: number, motionEvents: number, score: number,
+     * zoneScores: [number], mapWidth: number, mapHeight: number, frameMicros: Summary } }*/
+    CameraMotionOptions options;
+    CameraMotionStats stats;
+    cJSON *motionObject = cJSON_CreateObject();
+    if (motionObject == NULL || camera_getMotionDetection(&options) != ERROR_NONE ||
+        camera_getMotionStats(&stats) != ERROR_NONE) {
+        cJSON_Delete(motionObject);
+        httpd_resp_send_500(request);
+        return;
+    }
+    cJSON_AddBoolToObject(motionObject, "isEnabled", options.isEnabled);
+    cJSON_AddNumberToObject(motionObject, "threshold", options.threshold);
+    cJSON_AddNumberToObject(motionObject, "triggerPercent", options.triggerPercent);
+    cJSON_AddNumberToObject(motionObject, "backgroundShift", options.backgroundShift);
+    cJSON_AddNumberToObject(motionObject, "quietFrames", options.quietFrames);
+    cJSON *zonesArray = cJSON_AddArrayToObject(motionObject, "zones");
+    for (uint32_t i = 0; i < options.zoneCount; i++) {
+        cJSON *zoneObject = cJSON_CreateObject();
+        cJSON_AddNumberToObject(zoneObject, "left", options.zones[i].left);
+        cJSON_AddNumberToObject(zoneObject, "top", options.zones[i].top);
+        cJSON_AddNumberToObject(zoneObject, "width", options.zones[i].width);
+        cJSON_AddNumberToObject(zoneObject, "height", options.zones[i].height);
+        cJSON_AddItemToArray(zonesArray, zoneObject);
+    }
+    cJSON *statsObject = cJSON_AddObjectToObject(motionObject, "stats");
+    cJSON_AddBoolToObject(statsObject, "isMotion", stats.isMotion);
+    cJSON_AddNumberToObject(statsObject, "framesAnalysed", stats.framesAnalysed);
+    cJSON_AddNumberToObject(statsObject, "framesFailed", stats.framesFailed);
+    cJSON_AddNumberToObject(statsObject, "motionEvents", stats.motionEvents);
+    cJSON_AddNumberToObject(statsObject, "score", stats.score);
+    cJSON *zoneScoresArray = cJSON_AddArrayToObject(statsObject, "zoneScores");
+    for (uint32_t i = 0; i < (options.zoneCount > 0 ? options.zoneCount : 1); i++) {
+        cJSON_AddItemToArray(zoneScoresArray, cJSON_CreateNumber(stats.zoneScores[i]));
+    }
+    cJSON_AddNumberToObject(statsObject, "mapWidth", stats.mapWidth);
+    cJSON_AddNumberToObject(statsObject, "mapHeight", stats.mapHeight);
+    addStatsSummaryToJSON(statsObject, "frameMicros", &stats.frameMicros);
+    const char *json = cJSON_PrintUnformatted(motionObject);
+    cJSON_Delete(motionObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+}
+
+requestHandler(getCameraMotion, "/api/camera/motion") {
+    allowCORS(request);
+    sendCameraMotion(request);
+    return ESP_OK;
+}
+
+requestHandler(cameraMotion, "/api/camera/motion") {
+    allowCORS(request);
+
+    memset(this.cameraSettingsJSONBuffer, 0, CAMERA_SETTINGS_JSON_BUFFER_SIZE);
+    httpd_req_recv(request, this.cameraSettingsJSONBuffer, CAMERA_SETTINGS_JSON_BUFFER_SIZE);
+    cJSON *json = cJSON_ParseWithOpts(this.cameraSettingsJSONBuffer, NULL, true);
+
+    // fields left out keep their current values
+    CameraMotionOptions options;
+    camera_getMotionDetection(&options);
+    cJSON *isEnabled = cJSON_GetObjectItemCaseSensitive(json, "isEnabled");
+    if (cJSON_IsBool(isEnabled)) options.isEnabled = cJSON_IsTrue(isEnabled);
+    cJSON *threshold = cJSON_GetObjectItemCaseSensitive(json, "threshold");
+    if (cJSON_IsNumber(threshold)) options.threshold = threshold->valueint;
+    cJSON *triggerPercent = cJSON_GetObjectItemCaseSensitive(json, "triggerPercent");
+    if (cJSON_IsNumber(triggerPercent)) options.triggerPercent = triggerPercent->valueint;
+    cJSON *backgroundShift = cJSON_GetObjectItemCaseSensitive(json, "backgroundShift");
+    if (cJSON_IsNumber(backgroundShift)) options.backgroundShift = backgroundShift->valueint;
+    cJSON *quietFrames = cJSON_GetObjectItemCaseSensitive(json, "quietFrames");
+    if (cJSON_IsNumber(quietFrames)) options.quietFrames = quietFrames->valueint;
+    cJSON *zones = cJSON_GetObjectItemCaseSensitive(json, "zones");
+    bool isValid = true;
+    if (cJSON_IsArray(zones)) {
+        options.zoneCount = cJSON_GetArraySize(zones);
+        isValid = options.zoneCount <= CAMERA_MOTION_MAX_ZONES;
+        for (uint32_t i = 0; isValid && i < options.zoneCount; i++) {
+            cJSON *zone = cJSON_GetArrayItem(zones, (int) i);
+            cJSON *left = cJSON_GetObjectItemCaseSensitive(zone, "left");
+            cJSON *top = cJSON_GetObjectItemCaseSensitive(zone, "top");
+            cJSON *width = cJSON_GetObjectItemCaseSensitive(zone, "width");
+            cJSON *height = cJSON_GetObjectItemCaseSensitive(zone, "height");
+            isValid = cJSON_IsNumber(left) && cJSON_IsNumber(top) && cJSON_IsNumber(width) && cJSON_IsNumber(height) &&
+                      left->valueint >= 0 && top->valueint >= 0 && width->valueint >= 0 && height->valueint >= 0 &&
+                      left->valueint <= 100 && top->valueint <= 100 && width->valueint <= 100 &&
+                      height->valueint <= 100;
+            if (isValid) {
+                options.zones[i] = (CameraMotionZone) {
+                        .left = left->valueint, .top = top->valueint,
+                        .width = width->valueint, .height = height->valueint
+                };
+            }
+        }
     }
+    cJSON_Delete(json);
 
+    if (!isValid || camera_setMotionDetection(&options) != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Invalid motion detection options");
+        return ESP_OK;
+    }
+    sendCameraMotion(request);
+    return ESP_OK;
+}
+
+/** Responds with the timelapse schedule and the stats of the running or last timelapse */
+private void sendTimelapse(httpd_req_t *request) {
+    /*{ isEnabled: boolean, intervalSeconds: number, imageSize: number, imageQuality: number, shotCount: number,
+     * stats: { isRunning: boolean, sequence: number, shotsTaken: number, shotsMissed: number, shotsFailed: number,
+     * shotsRemaining: number, awakeMillis: number, standbyMillis: number, estimatedMilliampHours: number,
+     * lastShot: { index: number, standbyMillis: number, wakeMillis: number, captureMillis: number,
+     * writeMillis: number, thumbnailMillis: number, bytes: number, estimatedMilliampHours: number,
+     * batteryVoltage: number } } }*/
+    TimelapseSchedule schedule;
+    TimelapseStats stats;
+    cJSON *timelapseObject = cJSON_CreateObject();
+    if (timelapseObject == NULL || timelapse_getSchedule(&schedule) != ERROR_NONE ||
+        timelapse_getStats(&stats) != ERROR_NONE) {
+        cJSON_Delete(timelapseObject);
+        httpd_resp_send_500(request);
+        return;
+    }
+    cJSON_AddBoolToObject(timelapseObject, "isEnabled", schedule.isEnabled);
+    cJSON_AddNumberToObject(timelapseObject, "intervalSeconds", schedule.intervalSeconds);
+    cJSON_AddNumberToObject(timelapseObject, "imageSize", schedule.imageSize);
+    cJSON_AddNumberToObject(timelapseObject, "imageQuality", schedule.imageQuality);
+    cJSON_AddNumberToObject(timelapseObject, "shotCount", schedule.shotCount);
+    cJSON *statsObject = cJSON_AddObjectToObject(timelapseObject, "stats");
+    cJSON_AddBoolToObject(statsObject, "isRunning", stats.isRunning);
+    cJSON_AddNumberToObject(statsObject, "sequence", stats.sequence);
+    cJSON_AddNumberToObject(statsObject, "shotsTaken", stats.shotsTaken);
+    cJSON_AddNumberToObject(statsObject, "shotsMissed", stats.shotsMissed);
+    cJSON_AddNumberToObject(statsObject, "shotsFailed", stats.shotsFailed);
+    cJSON_AddNumberToObject(statsObject, "shotsRemaining", stats.shotsRemaining);
+    cJSON_AddNumberToObject(statsObject, "awakeMillis", stats.awakeMillis);
+    cJSON_AddNumberToObject(statsObject, "standbyMillis", stats.standbyMillis);
+    cJSON_AddNumberToObject(statsObject, "estimatedMilliampHours", stats.estimatedMilliampHours);
+    cJSON *lastShotObject = cJSON_AddObjectToObject(statsObject, "lastShot");
+    cJSON_AddNumberToObject(lastShotObject, "index", stats.lastShot.index);
+    cJSON_AddNumberToObject(lastShotObject, "standbyMillis", stats.lastShot.standbyMillis);
+    cJSON_AddNumberToObject(lastShotObject, "wakeMillis", stats.lastShot.wakeMillis);
+    cJSON_AddNumberToObject(lastShotObject, "captureMillis", stats.lastShot.captureMillis);
+    cJSON_AddNumberToObject(lastShotObject, "writeMillis", stats.lastShot.writeMillis);
+    cJSON_AddNumberToObject(lastShotObject, "thumbnailMillis", stats.lastShot.thumbnailMillis);
+    cJSON_AddNumberToObject(lastShotObject, "bytes", stats.lastShot.bytes);
+    cJSON_AddNumberToObject(lastShotObject, "estimatedMilliampHours", stats.lastShot.estimatedMilliampHours);
+    cJSON_AddNumberToObject(lastShotObject, "batteryVoltage", stats.lastShot.batteryVoltage);
+    const char *json = cJSON_PrintUnformatted(timelapseObject);
+    cJSON_Delete(timelapseObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+}
+
+requestHandler(getTimelapse, "/api/timelapse") {
+    allowCORS(request);
+    sendTimelapse(request);
+    return ESP_OK;
+}
+
+requestHandler(timelapse, "/api/timelapse") {
+    allowCORS(request);
+
+    memset(this.cameraSettingsJSONBuffer, 0, CAMERA_SETTINGS_JSON_BUFFER_SIZE);
+    httpd_req_recv(request, this.cameraSettingsJSONBuffer, CAMERA_SETTINGS_JSON_BUFFER_SIZE);
+    cJSON *json = cJSON_ParseWithOpts(this.cameraSettingsJSONBuffer, NULL, true);
+
+    // fields left out keep their current values
+    TimelapseSchedule schedule;
+    timelapse_getSchedule(&schedule);
+    cJSON *isEnabled = cJSON_GetObjectItemCaseSensitive(json, "isEnabled");
+    if (cJSON_IsBool(isEnabled)) schedule.isEnabled = cJSON_IsTrue(isEnabled);
+    cJSON *intervalSeconds = cJSON_GetObjectItemCaseSensitive(json, "intervalSeconds");
+    if (cJSON_IsNumber(intervalSeconds)) schedule.intervalSeconds = intervalSeconds->valueint;
+    cJSON *imageSize = cJSON_GetObjectItemCaseSensitive(json, "imageSize");
+    if (cJSON_IsNumber(imageSize)) schedule.imageSize = imageSize->valueint;
+    cJSON *imageQuality = cJSON_GetObjectItemCaseSensitive(json, "imageQuality");
+    if (cJSON_IsNumber(imageQuality)) schedule.imageQuality = imageQuality->valueint;
+    cJSON *shotCount = cJSON_GetObjectItemCaseSensitive(json, "shotCount");
+    if (cJSON_IsNumber(shotCount)) schedule.shotCount = shotCount->valueint;
+    cJSON_Delete(json);
+
+    const Error err = timelapse_setSchedule(&schedule);
+    if (err == ERROR_OUT_OF_BOUNDS) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Timelapse schedule out of range");
+        return ESP_OK;
+    } else if (err != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Unknown error occurred setting timelapse");
+        return ESP_OK;
+    }
+    sendTimelapse(request);
+    return ESP_OK;
+}
+
+/** Responds with the thumbnail of the JPEG on the SD card at the query's path, made and saved next to it the first
+ * time it is asked for, scale is 8 (the default) or 4 */
+requestHandler(apiThumbnail, "/api/thumbnail") {
+    allowCORS(request);
+    char query[THUMBNAIL_QUERY_BUFFER_SIZE];
+    char imagePath[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+    char value[16];
+    if (httpd_req_get_url_query_str(request, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "path", imagePath, sizeof(imagePath)) != ESP_OK || strstr(imagePath, "..")) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Thumbnail needs the path of an image");
+        return ESP_OK;
+    }
+    const uint32_t scale = httpd_query_key_value(query, "scale", value, sizeof(value)) == ESP_OK ?
+                           (uint32_t) strtoul(value, NULL, 10) : THUMBNAIL_SCALE_EIGHTH;
+    char thumbnailPath[EXTERNAL_STORAGE_MAX_PATH_LENGTH];
+    if (thumbnail_getPath(imagePath, scale, thumbnailPath, sizeof(thumbnailPath)) != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Thumbnail scale must be 8 or 4");
+        return ESP_OK;
+    }
+    bool exists = false;
+    if (externalStorage_hasSDCard()) externalStorage_queryFileExists(imagePath, &exists);
+    if (!exists) {
+        httpd_resp_send_err(request, HTTPD_404_NOT_FOUND, "Image could not be located");
+        return ESP_OK;
+    }
+    externalStorage_queryFileExists(thumbnailPath, &exists);
+    if (!exists && thumbnail_generate(imagePath, scale, NULL) != ERROR_NONE) {
+        httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Could not make thumbnail");
+        return ESP_OK;
+    }
+    FILE *file;
+    if (externalStorage_openFile(thumbnailPath, &file, FILE_MODE_READ) != ERROR_NONE) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "image/jpeg");
+    size_t position = 0;
+    uint bytesRead = 0;
+    do {
+        if (externalStorage_readFile(file, position, this.imageBuffer, CAMERA_IMAGE_BUFFER_SIZE,
+                                     &bytesRead) != ERROR_NONE) {
+            break;
+        }
+        if (bytesRead > 0 && httpd_resp_send_chunk(request, this.imageBuffer, (ssize_t) bytesRead) != ESP_OK) break;
+        position += bytesRead;
+    } while (bytesRead > 0);
+    externalStorage_closeFile(file);
+    finishRequest(request);
+    return ESP_OK;
+}
+
+requestHandler(apiThumbnailStats, "/api/thumbnail/stats") {
+    allowCORS(request);
+    /*{ thumbnailsSaved: number, thumbnailsFailed: number, sourceBytes: number, readMillis: number,
+     * decodeMillis: number, encodeMillis: number, decodeKBPerSecond: number,
+     * lastThumbnail: { width: number, height: number, sourceBytes: number, bytes: number, readMicros: number,
+     * decodeMicros: number, encodeMicros: number } }*/
+    ThumbnailStats stats;
+    if (thumbnail_getStats(&stats) != ERROR_NONE) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON *statsObject = cJSON_CreateObject();
+    if (statsObject == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    cJSON_AddNumberToObject(statsObject, "thumbnailsSaved", stats.thumbnailsSaved);
+    cJSON_AddNumberToObject(statsObject, "thumbnailsFailed", stats.thumbnailsFailed);
+    cJSON_AddNumberToObject(statsObject, "sourceBytes", stats.sourceBytes);
+    cJSON_AddNumberToObject(statsObject, "readMillis", stats.readMillis);
+    cJSON_AddNumberToObject(statsObject, "decodeMillis", stats.decodeMillis);
+    cJSON_AddNumberToObject(statsObject, "encodeMillis", stats.encodeMillis);
+    cJSON_AddNumberToObject(statsObject, "decodeKBPerSecond",
+                            stats.decodeMillis > 0 ? (float) stats.sourceBytes / (float) stats.decodeMillis : 0);
+    cJSON *lastObject = cJSON_AddObjectToObject(statsObject, "lastThumbnail");
+    cJSON_AddNumberToObject(lastObject, "width", stats.lastThumbnail.width);
+    cJSON_AddNumberToObject(lastObject, "height", stats.lastThumbnail.height);
+    cJSON_AddNumberToObject(lastObject, "sourceBytes", stats.lastThumbnail.sourceBytes);
+    cJSON_AddNumberToObject(lastObject, "bytes", stats.lastThumbnail.bytes);
+    cJSON_AddNumberToObject(lastObject, "readMicros", stats.lastThumbnail.readMicros);
+    cJSON_AddNumberToObject(lastObject, "decodeMicros", stats.lastThumbnail.decodeMicros);
+    cJSON_AddNumberToObject(lastObject, "encodeMicros", stats.lastThumbnail.encodeMicros);
+    const char *json = cJSON_PrintUnformatted(statsObject);
+    cJSON_Delete(statsObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
+    return ESP_OK;
+}
+
+requestHandler(apiCameraRegisters, "/api/camera/registers") {
+    allowCORS(request);
+    /*{ "0x3008": number, ... }*/
+    cJSON *registersObject = cJSON_CreateObject();
+    if (registersObject == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    if (camera_forEachKnownRegister(cameraRegisterCallback, registersObject) != ERROR_NONE) {
+        cJSON_Delete(registersObject);
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    const char *json = cJSON_PrintUnformatted(registersObject);
+    cJSON_Delete(registersObject);
+    if (json == NULL) {
+        httpd_resp_send_500(request);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(request, "application/json");
+    httpd_resp_sendstr(request, json);
+    delete(json);
     return ESP_OK;
 }
 
@@ -339,17 +1316,40 @@ requestHandler(wsCamera, "/ws/camera") {
     CameraWebSocket *cameraWebSocket = new(CameraWebSocket);
     cameraWebSocket->fd = socketNumber;
     cameraWebSocket->bytesSent = 0;
+    obtainCameraSocketsMutex();
     index_t foundIndex = list_indexOfItemFunction(this.cameraWebsocketData.socketsList, cameraWebSocket,
                                                   cameraSocketsListEquals);
     if (foundIndex == LIST_INVALID_INDEX_CAPACITY) {
         INFO("New socket fd: %i", socketNumber);
         list_addItem(this.cameraWebsocketData.socketsList, cameraWebSocket);
+        camera_subscribeLiveCapture();
     } else {
         delete(cameraWebSocket);
     }
+    releaseCameraSocketsMutex();
     if (request->method == HTTP_GET) {
         return ESP_OK;
     }
+    // a text message from the live player moves the region (or zoom) without a round trip through /api
+    httpd_ws_frame_t websocketFrame = {.type = HTTPD_WS_TYPE_TEXT};
+    esp_err_t err = httpd_ws_recv_frame(request, &websocketFrame, 0);
+    if (err != ESP_OK) return err;
+    if (websocketFrame.type != HTTPD_WS_TYPE_TEXT || websocketFrame.len == 0 ||
+        websocketFrame.len >= CAMERA_SETTINGS_JSON_BUFFER_SIZE) {
+        return ESP_OK;
+    }
+    memset(this.cameraSettingsJSONBuffer, 0, CAMERA_SETTINGS_JSON_BUFFER_SIZE);
+    websocketFrame.payload = (uint8_t *) this.cameraSettingsJSONBuffer;
+    err = httpd_ws_recv_frame(request, &websocketFrame, websocketFrame.len);
+    if (err != ESP_OK) return err;
+    cJSON *json = cJSON_ParseWithOpts(this.cameraSettingsJSONBuffer, NULL, true);
+    CameraSettings settings = {.fields = 0};
+    const bool isValid = cameraRegionFromJSON(json, &settings);
+    cJSON_Delete(json);
+    // the player can send one of these every few frames, so it is not kept in flash like /api/cameraSettings is
+    if (!isValid || (settings.fields != 0 && camera_applyTransientSettings(&settings, NULL) != ERROR_NONE)) {
+        WARN("Could not apply region from camera websocket: %s", this.cameraSettingsJSONBuffer);
+    }
     return ESP_OK;
 }
 
@@ -413,14 +1413,13 @@ private void sendLiveImageToWebsocketClients(void *arg) {
     const size_t bytesRemaining = websocketData.bytesRemaining;
     const bool isFinalFrame = bytesRemaining == 0;
     const bool isFirstFrame = bytesRead == bufferLength;
+    obtainCameraSocketsMutex();
     for (int i = 0; i < list_getSize(websocketData.socketsList); i++) {
         CameraWebSocket *cameraWebSocket = list_getItem(websocketData.socketsList, i);
         if (!cameraWebSocket) continue;
         int socketNumber = cameraWebSocket->fd;
         if (httpd_ws_get_fd_info(this.server, socketNumber) != HTTPD_WS_CLIENT_WEBSOCKET) {
-            list_removeItemIndexed(websocketData.socketsList, i);
-            delete(cameraWebSocket);
-            INFO("Removed socket fd: %i", socketNumber);
+            removeCameraSocket(websocketData.socketsList, i);
             continue;
         }
         size_t bytesSent = cameraWebSocket->bytesSent;
@@ -434,11 +1433,7 @@ private void sendLiveImageToWebsocketClients(void *arg) {
             };
             esp_err_t err = httpd_ws_send_frame_async(this.server, socketNumber, &websocketFrame);
             if (err) {
-                if (err == ESP_ERR_INVALID_ARG) {
-                    list_removeItemIndexed(websocketData.socketsList, i);
-                    delete(cameraWebSocket);
-                    INFO("Removed socket fd: %i", socketNumber);
-                }
+                if (err == ESP_ERR_INVALID_ARG) removeCameraSocket(websocketData.socketsList, i);
             } else {
                 if (isFinalFrame) {
                     cameraWebSocket->bytesSent = 0;
@@ -449,6 +1444,7 @@ private void sendLiveImageToWebsocketClients(void *arg) {
         }
     }
     list_shrink(websocketData.socketsList);
+    releaseCameraSocketsMutex();
 }
 
 private void cameraLiveCaptureCallback(uint8_t *buffer, size_t bufferLength,
@@ -461,6 +1457,45 @@ private void cameraLiveCaptureCallback(uint8_t *buffer, size_t bufferLength,
     sendLiveImageToWebsocketClients(&this.cameraWebsocketData);
 }
 
+/** Sends the whole frame as one binary message to every camera socket that is not in the middle of a streamed one */
+private void sendLiveFrameToWebsocketClients(CameraFrame *frame) {
+    List *socketsList = this.cameraWebsocketData.socketsList;
+    obtainCameraSocketsMutex();
+    for (int i = 0; i < list_getSize(socketsList); i++) {
+        CameraWebSocket *cameraWebSocket = list_getItem(socketsList, i);
+        if (!cameraWebSocket) continue;
+        int socketNumber = cameraWebSocket->fd;
+        if (httpd_ws_get_fd_info(this.server, socketNumber) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            removeCameraSocket(socketsList, i);
+            continue;
+        }
+        if (cameraWebSocket->bytesSent != 0) continue;
+        httpd_ws_frame_t websocketFrame = {
+                .type = HTTPD_WS_TYPE_BINARY,
+                .payload = (uint8_t *) frame->data,
+                .len = frame->length,
+        };
+        esp_err_t err = httpd_ws_send_frame_async(this.server, socketNumber, &websocketFrame);
+        if (err == ESP_ERR_INVALID_ARG) removeCameraSocket(socketsList, i);
+    }
+    list_shrink(socketsList);
+    releaseCameraSocketsMutex();
+}
+
+private void cameraSendTaskFunction(void *arg) {
+    typeof(this.cameraWebsocketData) *websocketDataPtr = ((typeof(this.cameraWebsocketData) *) arg);
+    while (websocketDataPtr->isSendTaskRunning) {
+        CameraFrame *frame = NULL;
+        if (camera_takeFrame(websocketDataPtr->frameConsumer, CAMERA_SEND_TASK_TAKE_TIMEOUT_MILLIS,
+                             &frame) != ERROR_NONE) {
+            continue;
+        }
+        sendLiveFrameToWebsocketClients(frame);
+        camera_releaseFrame(frame);
+    }
+    taskWatcher_restartTask(CAMERA_SEND_TASK_NAME);
+}
+
 public Error webserver_init() {
     if (this.isInitialized) {
         WARN("WebServer has already been initialized");
@@ -471,6 +1506,18 @@ public Error webserver_init() {
 
     config.max_uri_handlers = 128;
     config.uri_match_fn = httpd_uri_match_wildcard;
+    config.close_fn = closeSocket;
+
+    // the sockets must exist before the server can open or close any of them
+    ListOptions socketsListOptions = LIST_DEFAULT_OPTIONS;
+    socketsListOptions.isGrowable = true;
+    socketsListOptions.isShrinkable = false;
+    socketsListOptions.capacity = CONFIG_LWIP_MAX_SOCKETS;
+    this.logWebsocketData.socketsList = list_createWithOptions(&socketsListOptions);
+    this.cameraWebsocketData.socketsList = list_createWithOptions(&socketsListOptions);
+    this.cameraWebsocketData.socketsMutex = xSemaphoreCreateMutex();
+    requireNotNull(this.cameraWebsocketData.socketsMutex, ERROR_LIBRARY_FAILURE,
+                   "Could not create camera sockets mutex");
 
     INFO("Starting Web Server on port: '%d'", config.server_port);
 
@@ -483,7 +1530,23 @@ public Error webserver_init() {
     addEndpoint("/api/log", HTTP_GET, apiLog);
     addEndpoint("/api/battery", HTTP_GET, apiBattery);
     addEndpoint("/api/camera", HTTP_GET, apiCamera);
+    addEndpoint("/api/camera/registers", HTTP_GET, apiCameraRegisters);
+    addEndpoint("/api/camera/quality", HTTP_GET, apiCameraQuality);
+    addEndpoint("/api/camera/burst", HTTP_GET, apiCameraBurst);
+    addEndpoint("/api/camera/video/benchmark", HTTP_GET, apiCameraVideoBenchmark);
+    addEndpoint("/api/camera/profiles/benchmark", HTTP_GET, apiCameraSensorProfileBenchmark);
+    addEndpoint("/api/camera/spi/calibrate", HTTP_POST, apiCameraSPICalibrate);
+    addEndpoint("/api/camera/stats", HTTP_GET, apiCameraStats);
+    addEndpoint("/api/camera/stats/reset", HTTP_POST, apiCameraStatsReset);
+    addEndpoint("/api/camera/scheduler", HTTP_GET, apiCameraScheduler);
+    addEndpoint("/api/camera/motion", HTTP_GET, getCameraMotion);
+    addEndpoint("/api/camera/motion", HTTP_POST, cameraMotion);
     addEndpoint("/api/cameraSettings", HTTP_POST, cameraSettings);
+    addEndpoint("/api/cameraSettings", HTTP_GET, getCameraSettings);
+    addEndpoint("/api/timelapse", HTTP_GET, getTimelapse);
+    addEndpoint("/api/timelapse", HTTP_POST, timelapse);
+    addEndpoint("/api/thumbnail", HTTP_GET, apiThumbnail);
+    addEndpoint("/api/thumbnail/stats", HTTP_GET, apiThumbnailStats);
     addEndpoint("/files/*", HTTP_GET, files);
     addEndpoint("/", HTTP_GET, pages);
     httpd_uri_t logWebsocketHandler = {
@@ -509,14 +1572,23 @@ public Error webserver_init() {
     this.cameraSettingsJSONBuffer = alloc(CAMERA_SETTINGS_JSON_BUFFER_SIZE);
     this.logList = log_getLogList();
     logList_addOnAppendCallback(this.logList, logListOnAppendCallback);
-    ListOptions socketsListOptions = LIST_DEFAULT_OPTIONS;
-    socketsListOptions.isGrowable = true;
-    socketsListOptions.isShrinkable = false;
-    socketsListOptions.capacity = CONFIG_LWIP_MAX_SOCKETS;
-    this.logWebsocketData.socketsList = list_createWithOptions(&socketsListOptions);
-    this.cameraWebsocketData.socketsList = list_createWithOptions(&socketsListOptions);
 
     camera_setCameraLiveCaptureCallback(cameraLiveCaptureCallback);
+    if (camera_addFrameConsumer(&this.cameraWebsocketData.frameConsumer) == ERROR_NONE) {
+        this.cameraWebsocketData.isSendTaskRunning = true;
+        TaskInfo taskInfo = {
+                .name = CAMERA_SEND_TASK_NAME,
+                .taskFunction = cameraSendTaskFunction,
+                .stackBytes = CAMERA_SEND_TASK_STACK_SIZE,
+                .taskParameter = &this.cameraWebsocketData,
+                .taskPriority = CAMERA_SEND_TASK_PRIORITY,
+                .taskHandle = this.cameraWebsocketData.sendTaskHandle
+        };
+        taskWatcher_addTask(&taskInfo);
+        taskWatcher_startTask(CAMERA_SEND_TASK_NAME);
+    } else {
+        ERROR("Could not add a camera frame consumer, live frames will not be sent");
+    }
 
     this.isInitialized = true;
 
@@ -7,6 +7,8 @@
 #include "ExternalStorage.h"
 #include "TaskWatcher.h"
 #include "Camera.h"
+#include "Timelapse.h"
+#include "Thumbnail.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -18,12 +20,14 @@ private void setup() {
     taskWatcher_init();
     wifi_init();
     wifi_connect(WIFI_MODE_STA);
-    webserver_init();
     ExternalStorageOptions externalStorageOptions = EXTERNAL_STORAGE_DEFAULT_OPTIONS;
     externalStorageOptions.startAutoMountTask = true;
     externalStorage_init(&externalStorageOptions);
     battery_init();
     camera_init();
+    thumbnail_init();
+    timelapse_init();
+    webserver_init(); // serves all of the above, the camera must exist before the server takes its frames
 }
 
 attr(__used__) attr(__noreturn__)
@@ -0,0 +1,61 @@
+#include "unity.h"
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * Runs every TEST_CASE linked in, or only those whose tag is given as an argument such as "[JPEGScanner]", exits
+ * with the number of tests that failed so ctest sees any failure
+ */
+
+#define HOST_TEST_MAX_TESTS 1024
+
+typedef struct HostTest {
+    const char *name;
+    const char *tag;
+    UnityTestFunction function;
+    const char *file;
+} HostTest;
+
+static HostTest tests[HOST_TEST_MAX_TESTS];
+static int testCount;
+static jmp_buf testJump;
+
+void unity_registerTest(const char *name, const char *tag, UnityTestFunction function, const char *file) {
+    if (testCount == HOST_TEST_MAX_TESTS) {
+        fprintf(stderr, "More than %i tests, raise HOST_TEST_MAX_TESTS\n", HOST_TEST_MAX_TESTS);
+        exit(EXIT_FAILURE);
+    }
+    tests[testCount++] = (HostTest) {.name = name, .tag = tag, .function = function, .file = file};
+}
+
+void unity_fail(const char *file, const int line, const char *message) {
+    printf("  %s:%i: %s\n", file, line, message);
+    longjmp(testJump, 1);
+}
+
+static bool isSelected(const HostTest *test, const int tagCount, char **tags) {
+    if (tagCount == 0) return true;
+    for (int i = 0; i < tagCount; i++) {
+        if (strcmp(test->tag, tags[i]) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    int testsRun = 0;
+    int testsFailed = 0;
+    for (int i = 0; i < testCount; i++) {
+        if (!isSelected(&tests[i], argc - 1, argv + 1)) continue;
+        bool isPassed = false;
+        if (setjmp(testJump) == 0) {
+            tests[i].function();
+            isPassed = true;
+        }
+        printf("%s %s %s\n", isPassed ? "PASS" : "FAIL", tests[i].tag, tests[i].name);
+        testsRun++;
+        if (!isPassed) testsFailed++;
+    }
+    printf("%i tests, %i failures\n", testsRun, testsFailed);
+    return testsFailed;
+}
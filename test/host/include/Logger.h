@@ -0,0 +1,52 @@
+#ifndef ESP32_REMOTECAMERA_LOGGER_H
+#define ESP32_REMOTECAMERA_LOGGER_H
+
+/**
+ * Host stand-in for the logger component, which needs esp_log and FreeRTOS. The log macros print to stderr, the
+ * error macros are the same as the logger's own
+ */
+
+#include "Constants.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_HOST(level, message, ...) \
+fprintf(stderr, level" %s:%d "message"\n", __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
+
+#define ERROR(message, ...) LOG_HOST("E", message, ##__VA_ARGS__)
+#define WARN(message, ...) LOG_HOST("W", message, ##__VA_ARGS__)
+#define INFO(message, ...) LOG_HOST("I", message, ##__VA_ARGS__)
+#define VERBOSE(message, ...) EMPTY_MACRO_STATEMENT
+
+#define throw(error, message, ...) \
+do{                                \
+ERROR(message, ##__VA_ARGS__);     \
+return error;                      \
+}while(0)
+
+#define throwIfError(func, message, ...) \
+do{                                      \
+int error = func;\
+if (error != 0) {                                     \
+throw(error, message, ##__VA_ARGS__);                \
+}}while(0)
+
+#define throwLibCError(functionName, errno) \
+throw(ERROR_LIBRARY_FAILURE, #functionName" returned: %i: %s", err, strerror(err))
+
+#define throwLibCErrorMessage(functionName, errno, message, ...) \
+throw(ERROR_LIBRARY_FAILURE, #functionName" returned: %i: %s " message, err, strerror(err), ##__VA_ARGS__)
+
+#define require(condition, error, message, ...) \
+do{                                                  \
+if (!(condition)) {                                  \
+throw(error, message, ##__VA_ARGS__);                \
+}}while(0)
+
+#define requireNotNull(pointer, error, message, ...) require(pointer != NULL, error, message, ##__VA_ARGS__)
+
+#define requireArgNotNull(element) \
+requireNotNull(element, ERROR_NULL_ARGUMENT, #element" cannot be NULL")
+
+#endif //ESP32_REMOTECAMERA_LOGGER_H
@@ -0,0 +1,57 @@
+#ifndef ESP32_REMOTECAMERA_HOST_UNITY_H
+#define ESP32_REMOTECAMERA_HOST_UNITY_H
+
+/**
+ * Host stand-in for the ESP-IDF unity component, only what TestUtils.h builds on. TEST_CASE registers the test with
+ * HostTestRunner.c before main() runs, as ESP-IDF's TEST_CASE registers it with its test menu, and a failed
+ * assertion prints where it failed and jumps out of the test, as Unity's does, so it works in helper functions too
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+typedef void (*UnityTestFunction)(void);
+
+extern void unity_registerTest(const char *name, const char *tag, UnityTestFunction function, const char *file);
+
+__attribute__((noreturn))
+extern void unity_fail(const char *file, const int line, const char *message);
+
+#define UNITY_TEST_CONCAT_(a, b) a##b
+#define UNITY_TEST_CONCAT(a, b) UNITY_TEST_CONCAT_(a, b)
+#define UNITY_TEST_UID(what) UNITY_TEST_CONCAT(what, __LINE__)
+
+#define TEST_CASE(name, tag)                                                                   \
+static void UNITY_TEST_UID(test_func_)(void);                                                  \
+__attribute__((constructor)) static void UNITY_TEST_UID(test_register_)(void) {                \
+unity_registerTest(name, tag, UNITY_TEST_UID(test_func_), __FILE__);                           \
+}                                                                                              \
+static void UNITY_TEST_UID(test_func_)(void)
+
+#define UNITY_TEST_ASSERT(condition, line, message) \
+do{if (!(condition)) unity_fail(__FILE__, line, message);}while(0)
+
+#define UNITY_TEST_ASSERT_NOT_NULL(pointer, line, message) UNITY_TEST_ASSERT((pointer) != NULL, line, message)
+
+#define UNITY_TEST_ASSERT_NULL(pointer, line, message) UNITY_TEST_ASSERT((pointer) == NULL, line, message)
+
+#define UNITY_TEST_ASSERT_EQUAL_INT(expected, actual, line, message) \
+do{long long expected_ = (expected), actual_ = (actual);             \
+if (expected_ != actual_) {                                          \
+printf("  Expected %lld was %lld\n", expected_, actual_);            \
+unity_fail(__FILE__, line, message);                                 \
+}}while(0)
+
+#define UNITY_TEST_ASSERT_EQUAL_UINT(expected, actual, line, message) \
+do{unsigned long long expected_ = (expected), actual_ = (actual);     \
+if (expected_ != actual_) {                                           \
+printf("  Expected %llu was %llu\n", expected_, actual_);             \
+unity_fail(__FILE__, line, message);                                  \
+}}while(0)
+
+#define UNITY_TEST_ASSERT_EQUAL_STRING(expected, actual, line, message) \
+UNITY_TEST_ASSERT(strcmp(expected, actual) == 0, line, message)
+
+#define TEST_IGNORE() return
+
+#endif //ESP32_REMOTECAMERA_HOST_UNITY_H